@@ -51,6 +51,7 @@ AppConfig::AppConfig(QSettings* settings) :
 	m_Port(24800),
 	m_Interface(),
 	m_LogLevel(0),
+	m_LogLineLimit(10000),
 	m_AutoStart(false),
 	m_AutoHide(false),
 	m_AutoStartPrompt(false),
@@ -151,6 +152,7 @@ void AppConfig::loadSettings()
 	m_LogLevel = settings().value("logLevel", 2).toInt();
 	m_LogToFile = settings().value("logToFile", false).toBool();
 	m_LogFilename = settings().value("logFilename", synergyLogDir() + "synergy.log").toString();
+	m_LogLineLimit = settings().value("logLineLimit", 10000).toInt();
 	m_AutoStart = settings().value("autoStart", false).toBool();
 	m_AutoHide = settings().value("autoHide", true).toBool();
 	m_AutoStartPrompt = settings().value("autoStartPrompt", true).toBool();
@@ -167,6 +169,7 @@ void AppConfig::saveSettings()
 	settings().setValue("logLevel", m_LogLevel);
 	settings().setValue("logToFile", m_LogToFile);
 	settings().setValue("logFilename", m_LogFilename);
+	settings().setValue("logLineLimit", m_LogLineLimit);
 	settings().setValue("autoStart", m_AutoStart);
 	settings().setValue("autoHide", m_AutoHide);
 	settings().setValue("autoStartPrompt", m_AutoStartPrompt);
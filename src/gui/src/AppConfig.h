@@ -48,6 +48,7 @@ class AppConfig
 		int logLevel() const { return m_LogLevel; }
 		bool logToFile() const { return m_LogToFile; }
 		const QString& logFilename() const { return m_LogFilename; }
+		int logLineLimit() const { return m_LogLineLimit; }
 		QString logLevelText() const;
 		bool autoStart() const { return m_AutoStart; }
 		bool autoHide() const { return m_AutoHide; }
@@ -72,6 +73,7 @@ class AppConfig
 		void setLogLevel(int i) { m_LogLevel = i; }
 		void setLogToFile(bool b) { m_LogToFile = b; }
 		void setLogFilename(const QString& s) { m_LogFilename = s; }
+		void setLogLineLimit(int i) { m_LogLineLimit = i; }
 		void setAutoStart(bool b);
 		void setAutoHide(bool b) { m_AutoHide = b; }
 		void setAutoStartPrompt(bool b) { m_AutoStartPrompt = b; }
@@ -90,6 +92,7 @@ class AppConfig
 		int m_LogLevel;
 		bool m_LogToFile;
 		QString m_LogFilename;
+		int m_LogLineLimit;
 		bool m_AutoStart;
 		bool m_AutoHide;
 		bool m_AutoStartPrompt;
@@ -28,6 +28,8 @@ enum qIpcMessageType {
 	kIpcLogLine,
 	kIpcCommand,
 	kIpcShutdown,
+	kIpcLogBatch,
+	kIpcMetrics,
 };
 
 enum qIpcClientType {
@@ -38,5 +40,7 @@ enum qIpcClientType {
 
 extern const char*		kIpcMsgHello;
 extern const char*		kIpcMsgLogLine;
+extern const char*		kIpcMsgLogBatch;
 extern const char*		kIpcMsgCommand;
 extern const char*		kIpcMsgShutdown;
+extern const char*		kIpcMsgMetrics;
@@ -34,6 +34,7 @@ m_Enabled(false)
 
 	m_Reader = new IpcReader(m_Socket);
 	connect(m_Reader, SIGNAL(readLogLine(const QString&)), this, SLOT(handleReadLogLine(const QString&)));
+	connect(m_Reader, SIGNAL(readMetrics(const QString&)), this, SIGNAL(readMetrics(const QString&)));
 }
 
 IpcClient::~IpcClient()
@@ -50,6 +50,7 @@ private slots:
 
 signals:
 	void readLogLine(const QString& text);
+	void readMetrics(const QString& text);
 	void infoMessage(const QString& text);
 	void errorMessage(const QString& text);
 
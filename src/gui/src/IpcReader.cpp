@@ -22,6 +22,7 @@
 #include <iostream>
 #include <QMutex>
 #include <QByteArray>
+#include <QStringList>
 
 IpcReader::IpcReader(QTcpSocket* socket) :
 m_Socket(socket)
@@ -34,78 +35,81 @@ IpcReader::~IpcReader()
 
 void IpcReader::start()
 {
+	m_Buffer.clear();
 	connect(m_Socket, SIGNAL(readyRead()), this, SLOT(read()));
 }
 
 void IpcReader::stop()
 {
 	disconnect(m_Socket, SIGNAL(readyRead()), this, SLOT(read()));
+	m_Buffer.clear();
 }
 
 void IpcReader::read()
 {
 	QMutexLocker locker(&m_Mutex);
-	std::cout << "ready read" << std::endl;
 
-	while (m_Socket->bytesAvailable()) {
-		std::cout << "bytes available" << std::endl;
-
-		char codeBuf[5];
-		readStream(codeBuf, 4);
-		codeBuf[4] = 0;
-		std::cout << "ipc read: " << codeBuf << std::endl;
-
-		if (memcmp(codeBuf, kIpcMsgLogLine, 4) == 0) {
-			std::cout << "reading log line" << std::endl;
-
-			char lenBuf[4];
-			readStream(lenBuf, 4);
-			int len = bytesToInt(lenBuf, 4);
-
-			char* data = new char[len];
-			readStream(data, len);
-			QString line = QString::fromUtf8(data, len);
-			delete data;
-
-			readLogLine(line);
-		}
-		else {
+	// take whatever has arrived without waiting for more, then parse all
+	// of the complete messages in one pass.  an incomplete message is
+	// kept until the rest of it arrives.
+	m_Buffer.append(m_Socket->readAll());
+
+	QStringList lines;
+	const char* data = m_Buffer.constData();
+	int size = m_Buffer.size();
+	int offset = 0;
+	bool invalid = false;
+	while (size - offset >= 8) {
+		const char* code = data + offset;
+		int len = bytesToInt(data + offset + 4, 4);
+		bool logLine  = (memcmp(code, kIpcMsgLogLine, 4) == 0);
+		bool logBatch = (memcmp(code, kIpcMsgLogBatch, 4) == 0);
+		bool metrics  = (memcmp(code, kIpcMsgMetrics, 4) == 0);
+		if ((!logLine && !logBatch && !metrics) || len < 0) {
 			std::cerr << "aborting, message invalid" << std::endl;
-			return;
+			invalid = true;
+			break;
 		}
-	}
-
-	std::cout << "read done" << std::endl;
-}
-
-bool IpcReader::readStream(char* buffer, int length)
-{
-	std::cout << "reading stream" << std::endl;
-
-	int read = 0;
-	while (read < length) {
-		int ask = length - read;
-		if (m_Socket->bytesAvailable() < ask) {
-			std::cout << "buffer too short, waiting" << std::endl;
-			m_Socket->waitForReadyRead(-1);
+		if (size - offset - 8 < len) {
+			// wait for the rest of the message
+			break;
 		}
 
-		int got = m_Socket->read(buffer, ask);
-		read += got;
-
-		std::cout << "> ask=" << ask << " got=" << got
-			<< " read=" << read << std::endl;
-
-		if (got == -1) {
-			std::cout << "socket ended, aborting" << std::endl;
-			return false;
+		const char* payload = data + offset + 8;
+		if (logLine) {
+			lines.append(QString::fromUtf8(payload, len));
+		}
+		else if (metrics) {
+			readMetrics(QString::fromUtf8(payload, len));
 		}
-		else if (length - read > 0) {
-			std::cout << "more remains, seek to " << got << std::endl;
-			buffer += got;
+		else {
+			// each line in a batch is prefixed with its length
+			int i = 0;
+			while (len - i >= 4) {
+				int lineLen = bytesToInt(payload + i, 4);
+				if (lineLen < 0 || len - i - 4 < lineLen) {
+					std::cerr << "log batch invalid" << std::endl;
+					break;
+				}
+				lines.append(QString::fromUtf8(payload + i + 4, lineLen));
+				i += 4 + lineLen;
+			}
 		}
+		offset += 8 + len;
+	}
+	if (invalid) {
+		// the stream is out of step so nothing after this can be
+		// parsed.  drop the connection rather than show garbage.
+		m_Buffer.clear();
+		m_Socket->abort();
+	}
+	else {
+		m_Buffer.remove(0, offset);
+	}
+
+	if (!lines.isEmpty()) {
+		readLogLine(lines.join("\n"));
 	}
-	return true;
 }
 
 int IpcReader::bytesToInt(const char *buffer, int size)
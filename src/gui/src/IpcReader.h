@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QByteArray>
 
 class QTcpSocket;
 
@@ -34,10 +35,13 @@ public:
 	void stop();
 
 signals:
+	// text holds all of the log lines read in one go, separated by '\n'.
 	void readLogLine(const QString& text);
 
+	// text holds a node's metrics, one name=value per line.
+	void readMetrics(const QString& text);
+
 private:
-	bool readStream(char* buffer, int length);
 	int bytesToInt(const char* buffer, int size);
 
 private slots:
@@ -46,4 +50,7 @@ private slots:
 private:
 	QTcpSocket* m_Socket;
 	QMutex m_Mutex;
+
+	// bytes received but not yet parsed, i.e. an incomplete message.
+	QByteArray m_Buffer;
 };
@@ -48,6 +48,9 @@ static const char synergyConfigName[] = "synergy.conf";
 static const QString synergyConfigFilter(QObject::tr("Synergy Configurations (*.conf);;All files (*.*)"));
 #endif
 
+// how long log lines are collected before they're added to the log view.
+static const int logFlushInterval = 100;
+
 static const char* synergyIconFiles[] =
 {
 	":/res/icons/16x16/synergy-disconnected.png",
@@ -75,6 +78,10 @@ MainWindow::MainWindow(QSettings& settings, AppConfig& appConfig) :
 	loadSettings();
 	initConnections();
 
+	// the log view keeps at most this many lines, dropping the oldest.
+	int logLineLimit = appConfig.logLineLimit();
+	m_pLogOutput->document()->setMaximumBlockCount(logLineLimit > 0 ? logLineLimit : 0);
+
 	m_pUpdateIcon->hide();
 	m_pUpdateLabel->hide();
 	m_versionChecker.setApp(appPath(appConfig.synergycName()));
@@ -245,6 +252,10 @@ void MainWindow::initConnections()
 	connect(m_pActionStopSynergy, SIGNAL(triggered()), this, SLOT(stopSynergy()));
 	connect(m_pActionQuit, SIGNAL(triggered()), qApp, SLOT(quit()));
 	connect(&m_versionChecker, SIGNAL(updateFound(const QString&)), this, SLOT(updateFound(const QString&)));
+
+	m_LogFlushTimer.setSingleShot(true);
+	m_LogFlushTimer.setInterval(logFlushInterval);
+	connect(&m_LogFlushTimer, SIGNAL(timeout()), this, SLOT(flushLog()));
 }
 
 void MainWindow::saveSettings()
@@ -329,12 +340,35 @@ void MainWindow::appendLogError(const QString& text)
 
 void MainWindow::appendLogRaw(const QString& text)
 {
+	// lines are queued and added to the log view in one go by flushLog,
+	// so that a burst of log lines only updates the view once.
 	foreach(QString line, text.split(QRegExp("\r|\n|\r\n"))) {
 		if (!line.isEmpty()) {
-			m_pLogOutput->append(line);
+			m_PendingLog.append(line);
 			updateStateFromLogLine(line);
 		}
 	}
+
+	// don't queue lines that the log view would drop anyway.
+	int logLineLimit = appConfig().logLineLimit();
+	if (logLineLimit > 0 && m_PendingLog.size() > logLineLimit) {
+		m_PendingLog.erase(m_PendingLog.begin(),
+			m_PendingLog.begin() + (m_PendingLog.size() - logLineLimit));
+	}
+
+	if (!m_PendingLog.isEmpty() && !m_LogFlushTimer.isActive()) {
+		m_LogFlushTimer.start();
+	}
+}
+
+void MainWindow::flushLog()
+{
+	if (m_PendingLog.isEmpty()) {
+		return;
+	}
+
+	m_pLogOutput->append(m_PendingLog.join("\n"));
+	m_PendingLog.clear();
 }
 
 void MainWindow::updateStateFromLogLine(const QString &line)
@@ -356,7 +390,8 @@ void MainWindow::updateStateFromLogLine(const QString &line)
 
 void MainWindow::clearLog()
 {
-    m_pLogOutput->clear();
+	m_PendingLog.clear();
+	m_pLogOutput->clear();
 }
 
 void MainWindow::startSynergy()
@@ -25,6 +25,8 @@
 #include <QSettings>
 #include <QProcess>
 #include <QThread>
+#include <QTimer>
+#include <QStringList>
 
 #include "ui_MainWindowBase.h"
 
@@ -114,6 +116,7 @@ class MainWindow : public QMainWindow, public Ui::MainWindowBase
 		void logError();
 		void updateFound(const QString& version);
 		void refreshApplyButton();
+		void flushLog();
 
 	protected:
 		QSettings& settings() { return m_Settings; }
@@ -157,6 +160,8 @@ class MainWindow : public QMainWindow, public Ui::MainWindowBase
 		IpcClient m_IpcClient;
 		bool m_ElevateProcess;
 		bool m_SuppressElevateWarning;
+		QStringList m_PendingLog;
+		QTimer m_LogFlushTimer;
 
 private slots:
 	void on_m_pButtonApply_clicked();
@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <cstring>
 
 //
@@ -100,3 +101,16 @@ CArchFileUnix::concatPath(const std::string& prefix,
 	path += suffix;
 	return path;
 }
+
+bool
+CArchFileUnix::getFileStatus(const std::string& pathname,
+				UInt32& mtime, UInt32& size)
+{
+	struct stat info;
+	if (stat(pathname.c_str(), &info) != 0) {
+		return false;
+	}
+	mtime = static_cast<UInt32>(info.st_mtime);
+	size  = static_cast<UInt32>(info.st_size);
+	return true;
+}
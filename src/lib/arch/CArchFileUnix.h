@@ -35,6 +35,8 @@ public:
 	virtual std::string	getSystemDirectory();
 	virtual std::string	concatPath(const std::string& prefix,
 							const std::string& suffix);
+	virtual bool		getFileStatus(const std::string& pathname,
+							UInt32& mtime, UInt32& size);
 };
 
 #endif
@@ -21,6 +21,8 @@
 #include <shlobj.h>
 #include <tchar.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 //
 // CArchFileWindows
@@ -134,3 +136,16 @@ CArchFileWindows::concatPath(const std::string& prefix,
 	path += suffix;
 	return path;
 }
+
+bool
+CArchFileWindows::getFileStatus(const std::string& pathname,
+				UInt32& mtime, UInt32& size)
+{
+	struct _stat info;
+	if (_stat(pathname.c_str(), &info) != 0) {
+		return false;
+	}
+	mtime = static_cast<UInt32>(info.st_mtime);
+	size  = static_cast<UInt32>(info.st_size);
+	return true;
+}
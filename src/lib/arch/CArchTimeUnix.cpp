@@ -45,6 +45,14 @@ CArchTimeUnix::~CArchTimeUnix()
 double
 CArchTimeUnix::time()
 {
+#if defined(CLOCK_MONOTONIC)
+	// use a clock that isn't affected by changes to the system time
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+	}
+#endif
+
 	struct timeval t;
 	gettimeofday(&t, NULL);
 	return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
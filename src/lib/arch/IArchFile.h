@@ -20,6 +20,7 @@
 #define IARCHFILE_H
 
 #include "IInterface.h"
+#include "BasicTypes.h"
 #include "stdstring.h"
 
 //! Interface for architecture dependent file system operations
@@ -62,6 +63,15 @@ public:
 							const std::string& prefix,
 							const std::string& suffix) = 0;
 
+	//! Get file status
+	/*!
+	Gets the last modification time, in seconds since the epoch, and
+	the size in bytes of the file named by \c pathname.  Returns false
+	if the file doesn't exist or cannot be queried.
+	*/
+	virtual bool		getFileStatus(const std::string& pathname,
+							UInt32& mtime, UInt32& size) = 0;
+
 	//@}
 };
 
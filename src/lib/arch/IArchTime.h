@@ -34,7 +34,9 @@ public:
 	//! Get the current time
 	/*!
 	Returns the number of seconds since some arbitrary starting time.
-	This should return as high a precision as reasonable.
+	This should return as high a precision as reasonable.  It is not
+	the time of day and may not even be the same across processes;
+	only the difference between two times is meaningful.
 	*/
 	virtual double		time() = 0;
 
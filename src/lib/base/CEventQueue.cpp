@@ -18,6 +18,7 @@
 
 #include "CEventQueue.h"
 #include "CLog.h"
+#include "CMetrics.h"
 #include "CSimpleEventQueueBuffer.h"
 #include "CStopwatch.h"
 #include "IEventJob.h"
@@ -31,13 +32,18 @@ interrupt(CArch::ESignal, void*)
 	EVENTQUEUE->addEvent(CEvent(CEvent::kQuit));
 }
 
+// the next event type.  types registered with registerTypeOnce() are
+// cached in static variables so they're numbered once per process, not
+// per queue, or a type cached by an earlier queue could alias a type
+// registered with a later one.
+static CEvent::Type		s_nextType = CEvent::kLast;
+
 
 //
 // CEventQueue
 //
 
-CEventQueue::CEventQueue() :
-	m_nextType(CEvent::kLast)
+CEventQueue::CEventQueue()
 {
 	setInstance(this);
 	m_mutex = ARCH->newMutex();
@@ -71,10 +77,10 @@ CEvent::Type
 CEventQueue::registerType(const char* name)
 {
 	CArchMutexLock lock(m_mutex);
-	m_typeMap.insert(std::make_pair(m_nextType, name));
-	m_nameMap.insert(std::make_pair(name, m_nextType));
-	LOG((CLOG_DEBUG1 "registered event type %s as %d", name, m_nextType));
-	return m_nextType++;
+	m_typeMap.insert(std::make_pair(s_nextType, name));
+	m_nameMap.insert(std::make_pair(name, s_nextType));
+	LOG((CLOG_DEBUG1 "registered event type %s as %d", name, s_nextType));
+	return s_nextType++;
 }
 
 CEvent::Type
@@ -82,10 +88,10 @@ CEventQueue::registerTypeOnce(CEvent::Type& type, const char* name)
 {
 	CArchMutexLock lock(m_mutex);
 	if (type == CEvent::kUnknown) {
-		m_typeMap.insert(std::make_pair(m_nextType, name));
-		m_nameMap.insert(std::make_pair(name, m_nextType));
-		LOG((CLOG_DEBUG1 "registered event type %s as %d", name, m_nextType));
-		type = m_nextType++;
+		m_typeMap.insert(std::make_pair(s_nextType, name));
+		m_nameMap.insert(std::make_pair(name, s_nextType));
+		LOG((CLOG_DEBUG1 "registered event type %s as %d", name, s_nextType));
+		type = s_nextType++;
 	}
 	return type;
 }
@@ -213,6 +219,7 @@ CEventQueue::dispatchEvent(const CEvent& event)
 		job = getHandler(CEvent::kUnknown, target);
 	}
 	if (job != NULL) {
+		CMetrics::add(CMetrics::kEventsDispatched, 1.0);
 		job->run(event);
 		return true;
 	}
@@ -399,6 +406,8 @@ CEventQueue::saveEvent(const CEvent& event)
 
 	// save data
 	m_events[id] = event;
+	CMetrics::set(CMetrics::kEventQueueDepth,
+							static_cast<double>(m_events.size()));
 	return id;
 }
 
@@ -414,6 +423,8 @@ CEventQueue::removeEvent(UInt32 eventID)
 	// get data
 	CEvent event = index->second;
 	m_events.erase(index);
+	CMetrics::set(CMetrics::kEventQueueDepth,
+							static_cast<double>(m_events.size()));
 
 	// save old id for reuse
 	m_oldEventIDs.push_back(eventID);
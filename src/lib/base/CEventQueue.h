@@ -108,7 +108,6 @@ private:
 	CArchMutex			m_mutex;
 
 	// registered events
-	CEvent::Type		m_nextType;
 	CTypeMap			m_typeMap;
 	CNameMap			m_nameMap;
 
@@ -0,0 +1,124 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CLatencyHistogram.h"
+#include <cstring>
+
+//
+// CLatencyHistogram
+//
+
+CLatencyHistogram::CLatencyHistogram()
+{
+	reset();
+}
+
+void
+CLatencyHistogram::add(UInt32 value)
+{
+	++m_counts[getBucket(value)];
+	++m_count;
+	m_sum += value;
+	if (value > m_max) {
+		m_max = value;
+	}
+}
+
+void
+CLatencyHistogram::reset()
+{
+	memset(m_counts, 0, sizeof(m_counts));
+	m_count = 0;
+	m_max   = 0;
+	m_sum   = 0.0;
+}
+
+UInt32
+CLatencyHistogram::getCount() const
+{
+	return m_count;
+}
+
+UInt32
+CLatencyHistogram::getMax() const
+{
+	return m_max;
+}
+
+double
+CLatencyHistogram::getMean() const
+{
+	return (m_count == 0) ? 0.0 : m_sum / m_count;
+}
+
+UInt32
+CLatencyHistogram::getPercentile(double percent) const
+{
+	if (m_count == 0) {
+		return 0;
+	}
+
+	// number of values at or below the percentile, at least one
+	UInt32 target = static_cast<UInt32>(percent * m_count / 100.0 + 0.5);
+	if (target == 0) {
+		target = 1;
+	}
+
+	UInt32 n = 0;
+	for (UInt32 i = 0; i < kNumBuckets; ++i) {
+		n += m_counts[i];
+		if (n >= target) {
+			UInt32 value = getBucketMax(i);
+			return (value < m_max) ? value : m_max;
+		}
+	}
+	return m_max;
+}
+
+UInt32
+CLatencyHistogram::getBucket(UInt32 value)
+{
+	// small values get a bucket each
+	if (value < kSubBuckets) {
+		return value;
+	}
+
+	// find the highest set bit
+	UInt32 bit = 0;
+	for (UInt32 v = value; v > 1; v >>= 1) {
+		++bit;
+	}
+
+	// the bits below the highest set bit choose the sub-bucket
+	UInt32 shift = bit - kSubBucketBits;
+	UInt32 sub   = (value >> shift) - kSubBuckets;
+	return (shift + 1) * kSubBuckets + sub;
+}
+
+UInt32
+CLatencyHistogram::getBucketMax(UInt32 bucket)
+{
+	if (bucket < kSubBuckets) {
+		return bucket;
+	}
+
+	UInt32 shift = bucket / kSubBuckets - 1;
+	UInt32 sub   = bucket % kSubBuckets;
+	UInt32 min   = (kSubBuckets + sub) << shift;
+	return min + ((1u << shift) - 1);
+}
@@ -0,0 +1,85 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CLATENCYHISTOGRAM_H
+#define CLATENCYHISTOGRAM_H
+
+#include "BasicTypes.h"
+
+//! Latency histogram
+/*!
+Counts latencies in log-linear buckets, in the style of an HDR
+histogram:  each power of two is split into 8 buckets so any value
+can be recovered to within 12.5% while adding a value stays a few
+integer operations.  Values are unitless;  CLatencyTrace uses
+microseconds.
+*/
+class CLatencyHistogram {
+public:
+	CLatencyHistogram();
+
+	//! @name manipulators
+	//@{
+
+	//! Add value
+	void				add(UInt32 value);
+
+	//! Discard all values
+	void				reset();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get number of values
+	UInt32				getCount() const;
+
+	//! Get largest value
+	UInt32				getMax() const;
+
+	//! Get mean value
+	double				getMean() const;
+
+	//! Get percentile
+	/*!
+	Returns the value that \p percent percent of the values are less
+	than or equal to, rounded up to the end of its bucket (but never
+	more than the largest value).  Returns 0 if there are no values.
+	*/
+	UInt32				getPercentile(double percent) const;
+
+	//@}
+
+private:
+	static UInt32		getBucket(UInt32 value);
+	static UInt32		getBucketMax(UInt32 bucket);
+
+private:
+	enum {
+		kSubBucketBits = 3,
+		kSubBuckets    = 1 << kSubBucketBits,
+		kNumBuckets    = (32 - kSubBucketBits + 1) * kSubBuckets
+	};
+
+	UInt32				m_counts[kNumBuckets];
+	UInt32				m_count;
+	UInt32				m_max;
+	double				m_sum;
+};
+
+#endif
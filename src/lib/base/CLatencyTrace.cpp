@@ -0,0 +1,195 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CLatencyTrace.h"
+#include "CArch.h"
+#include "CLog.h"
+
+//
+// CLatencyTrace
+//
+
+bool					CLatencyTrace::s_enabled  = false;
+CArchMutex				CLatencyTrace::s_mutex    = NULL;
+UInt32					CLatencyTrace::s_nextID   = 1;
+UInt32					CLatencyTrace::s_id       = 0;
+CLatencyTrace::EStage	CLatencyTrace::s_stage    = CLatencyTrace::kCapture;
+double					CLatencyTrace::s_time     = 0.0;
+double					CLatencyTrace::s_readTime = 0.0;
+CLatencyHistogram		CLatencyTrace::s_histograms[kNumStages];
+
+void
+CLatencyTrace::setEnabled(bool enabled)
+{
+	// the mutex is never destroyed since the socket multiplexer thread
+	// may still be using it at exit
+	if (enabled && s_mutex == NULL) {
+		s_mutex = ARCH->newMutex();
+	}
+	s_enabled = enabled;
+}
+
+void
+CLatencyTrace::begin(EStage stage)
+{
+	if (!s_enabled) {
+		return;
+	}
+
+	double now = ARCH->time();
+	CArchMutexLock lock(s_mutex);
+	s_id    = s_nextID++;
+	s_stage = stage;
+	s_time  = now;
+	if (s_nextID == 0) {
+		s_nextID = 1;
+	}
+}
+
+void
+CLatencyTrace::receive(UInt32 id)
+{
+	if (!s_enabled) {
+		return;
+	}
+
+	CArchMutexLock lock(s_mutex);
+	s_id    = id;
+	s_stage = kSocketRead;
+	s_time  = s_readTime;
+}
+
+void
+CLatencyTrace::mark(EStage stage)
+{
+	if (!s_enabled) {
+		return;
+	}
+
+	double now = ARCH->time();
+	CArchMutexLock lock(s_mutex);
+
+	// note when we last read so a trace continued from the primary
+	// can start there
+	if (stage == kSocketRead) {
+		s_readTime = now;
+		return;
+	}
+
+	if (s_id == 0 || stage != s_stage + 1) {
+		return;
+	}
+
+	// record time since the last stage
+	double elapsed = now - s_time;
+	s_histograms[stage].add(elapsed <= 0.0 ? 0 :
+						static_cast<UInt32>(elapsed * 1.0e6 + 0.5));
+	s_stage = stage;
+	s_time  = now;
+
+	// finish trace at the last stage on this computer
+	if (stage == kSocketWrite || stage == kInject) {
+		s_id = 0;
+	}
+}
+
+void
+CLatencyTrace::reset()
+{
+	if (s_mutex == NULL) {
+		return;
+	}
+
+	CArchMutexLock lock(s_mutex);
+	s_id = 0;
+	for (UInt32 i = 0; i < kNumStages; ++i) {
+		s_histograms[i].reset();
+	}
+}
+
+void
+CLatencyTrace::dump()
+{
+	if (s_mutex == NULL) {
+		return;
+	}
+
+	// copy the histograms so we don't log with the mutex locked
+	CLatencyHistogram histograms[kNumStages];
+	{
+		CArchMutexLock lock(s_mutex);
+		for (UInt32 i = 0; i < kNumStages; ++i) {
+			histograms[i] = s_histograms[i];
+		}
+	}
+
+	LOG((CLOG_INFO "latency per stage in microseconds:"));
+	for (UInt32 i = 0; i < kNumStages; ++i) {
+		const CLatencyHistogram& h = histograms[i];
+		if (h.getCount() == 0) {
+			continue;
+		}
+		LOG((CLOG_INFO "%-12s n=%u mean=%.0f p50=%u p90=%u p99=%u max=%u",
+			getStageName(static_cast<EStage>(i)), h.getCount(), h.getMean(),
+			h.getPercentile(50.0), h.getPercentile(90.0),
+			h.getPercentile(99.0), h.getMax()));
+	}
+}
+
+bool
+CLatencyTrace::isEnabled()
+{
+	return s_enabled;
+}
+
+UInt32
+CLatencyTrace::getID()
+{
+	if (!s_enabled) {
+		return 0;
+	}
+
+	CArchMutexLock lock(s_mutex);
+	return s_id;
+}
+
+CLatencyHistogram
+CLatencyTrace::getHistogram(EStage stage)
+{
+	if (s_mutex == NULL) {
+		return CLatencyHistogram();
+	}
+
+	CArchMutexLock lock(s_mutex);
+	return s_histograms[stage];
+}
+
+const char*
+CLatencyTrace::getStageName(EStage stage)
+{
+	static const char* s_names[] = {
+		"capture",
+		"dispatch",
+		"encode",
+		"socket-write",
+		"socket-read",
+		"parse",
+		"inject"
+	};
+	return s_names[stage];
+}
@@ -0,0 +1,129 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CLATENCYTRACE_H
+#define CLATENCYTRACE_H
+
+#include "CLatencyHistogram.h"
+#include "IArchMultithread.h"
+
+//! Input latency tracing
+/*!
+Measures how long mouse motion spends in each stage between being
+captured on the primary screen and injected on a secondary screen.
+A trace starts when motion is captured (or, on a secondary screen,
+when the server says which trace the next message belongs to) and
+each later stage records the time since the previous stage in that
+stage's histogram.  Only one trace is followed at a time so newer
+motion replaces a trace that hasn't finished.  Stages on different
+computers are never compared since their clocks differ.
+
+Tracing is off by default and costs a flag test per stage when off.
+*/
+class CLatencyTrace {
+public:
+	enum EStage {
+		// primary screen
+		kCapture,
+		kDispatch,
+		kEncode,
+		kSocketWrite,
+
+		// secondary screen
+		kSocketRead,
+		kParse,
+		kInject,
+
+		kNumStages
+	};
+
+	//! @name manipulators
+	//@{
+
+	//! Enable or disable tracing
+	static void			setEnabled(bool enabled);
+
+	//! Start trace
+	/*!
+	Starts a new trace at stage \p stage, abandoning any unfinished
+	trace.
+	*/
+	static void			begin(EStage stage);
+
+	//! Continue trace
+	/*!
+	Continues trace \p id from the primary screen, starting at the
+	time of the last socket read.
+	*/
+	static void			receive(UInt32 id);
+
+	//! Record stage
+	/*!
+	Records that the current trace reached stage \p stage.  This is
+	ignored unless \p stage follows the trace's last stage.  The last
+	stage on each computer finishes the trace.  \c kSocketRead only
+	records the time, for use by \c receive().
+	*/
+	static void			mark(EStage stage);
+
+	//! Discard all measurements
+	static void			reset();
+
+	//! Log measurements
+	/*!
+	Logs each stage's latency percentiles.
+	*/
+	static void			dump();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if tracing is enabled
+	static bool			isEnabled();
+
+	//! Get current trace
+	/*!
+	Returns the id of the unfinished trace or 0 if there isn't one.
+	*/
+	static UInt32		getID();
+
+	//! Get stage histogram
+	/*!
+	Returns a copy of the latency histogram of stage \p stage, in
+	microseconds.
+	*/
+	static CLatencyHistogram	getHistogram(EStage stage);
+
+	//@}
+
+private:
+	static const char*	getStageName(EStage);
+
+private:
+	static bool			s_enabled;
+	static CArchMutex	s_mutex;
+	static UInt32		s_nextID;
+	static UInt32		s_id;
+	static EStage		s_stage;
+	static double		s_time;
+	static double		s_readTime;
+	static CLatencyHistogram	s_histograms[kNumStages];
+};
+
+#endif
@@ -0,0 +1,345 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CMetrics.h"
+#include "CStringUtil.h"
+#include "CArch.h"
+#include "CLog.h"
+#include <cstring>
+
+//
+// CMetrics::CHistogram
+//
+
+CMetrics::CHistogram::CHistogram() :
+	m_count(0),
+	m_max(0),
+	m_sum(0.0)
+{
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+void
+CMetrics::CHistogram::add(UInt32 value)
+{
+	// bucket 0 holds 0, bucket n holds [2^(n-1), 2^n)
+	UInt32 bucket = 0;
+	for (UInt32 v = value; v != 0; v >>= 1) {
+		++bucket;
+	}
+	++m_counts[bucket];
+	++m_count;
+	m_sum += value;
+	if (value > m_max) {
+		m_max = value;
+	}
+}
+
+UInt32
+CMetrics::CHistogram::getCount() const
+{
+	return m_count;
+}
+
+UInt32
+CMetrics::CHistogram::getMax() const
+{
+	return m_max;
+}
+
+double
+CMetrics::CHistogram::getMean() const
+{
+	return (m_count == 0) ? 0.0 : m_sum / m_count;
+}
+
+UInt32
+CMetrics::CHistogram::getPercentile(double percent) const
+{
+	if (m_count == 0) {
+		return 0;
+	}
+
+	// number of values at or below the percentile, at least one
+	UInt32 target = static_cast<UInt32>(percent * m_count / 100.0 + 0.5);
+	if (target == 0) {
+		target = 1;
+	}
+
+	UInt32 count = 0;
+	for (UInt32 i = 0; i < kNumBuckets; ++i) {
+		count += m_counts[i];
+		if (count >= target) {
+			UInt32 end = (i == 0) ? 0 : (0xffffffffu >> (32 - i));
+			return (end < m_max) ? end : m_max;
+		}
+	}
+	return m_max;
+}
+
+
+//
+// CMetrics::CConnection
+//
+
+CMetrics::CConnection::CConnection() :
+	m_messagesSent(0.0),
+	m_messagesReceived(0.0),
+	m_bytesSent(0.0),
+	m_bytesReceived(0.0),
+	m_smoothedRoundTrip(0.0),
+	m_registered(false),
+	m_outputSize(NULL),
+	m_outputSizeContext(NULL)
+{
+	// do nothing
+}
+
+CMetrics::CConnection::~CConnection()
+{
+	if (m_registered) {
+		CArchMutexLock lock(s_mutex);
+		s_connections.erase(this);
+	}
+}
+
+void
+CMetrics::CConnection::setName(const CString& name)
+{
+	if (!s_enabled) {
+		m_name = name;
+		return;
+	}
+
+	CArchMutexLock lock(s_mutex);
+	m_name = name;
+	if (!m_registered) {
+		s_connections.insert(this);
+		m_registered = true;
+	}
+}
+
+void
+CMetrics::CConnection::addSent(UInt32 size)
+{
+	if (s_enabled) {
+		m_messagesSent += 1.0;
+		m_bytesSent    += size;
+	}
+}
+
+void
+CMetrics::CConnection::addReceived(UInt32 size)
+{
+	if (s_enabled) {
+		m_messagesReceived += 1.0;
+		m_bytesReceived    += size;
+	}
+}
+
+void
+CMetrics::CConnection::addClipboardSent(UInt32 size)
+{
+	if (s_enabled) {
+		m_clipboardSent.add(size);
+	}
+}
+
+void
+CMetrics::CConnection::addClipboardReceived(UInt32 size)
+{
+	if (s_enabled) {
+		m_clipboardReceived.add(size);
+	}
+}
+
+void
+CMetrics::CConnection::addRoundTrip(double rtt, double smoothed)
+{
+	if (s_enabled) {
+		// microseconds so a fast LAN doesn't round to nothing
+		m_roundTrip.add(static_cast<UInt32>(rtt * 1.0e6));
+		m_smoothedRoundTrip = smoothed;
+	}
+}
+
+void
+CMetrics::CConnection::setOutputSize(OutputSizeFunc func, const void* context)
+{
+	if (s_mutex == NULL) {
+		m_outputSize        = func;
+		m_outputSizeContext = context;
+		return;
+	}
+
+	// lock so the function isn't removed while format() is calling it
+	CArchMutexLock lock(s_mutex);
+	m_outputSize        = func;
+	m_outputSizeContext = context;
+}
+
+CString
+CMetrics::CConnection::format() const
+{
+	const char* name = m_name.c_str();
+	CString result;
+	result += CStringUtil::print("%s.messages-sent=%.0f\n",
+							name, m_messagesSent);
+	result += CStringUtil::print("%s.messages-received=%.0f\n",
+							name, m_messagesReceived);
+	result += CStringUtil::print("%s.bytes-sent=%.0f\n",
+							name, m_bytesSent);
+	result += CStringUtil::print("%s.bytes-received=%.0f\n",
+							name, m_bytesReceived);
+	result += CStringUtil::print(
+		"%s.clipboard-sent=n:%u mean:%.0f p50:%u p99:%u max:%u\n",
+		name, m_clipboardSent.getCount(), m_clipboardSent.getMean(),
+		m_clipboardSent.getPercentile(50.0),
+		m_clipboardSent.getPercentile(99.0), m_clipboardSent.getMax());
+	result += CStringUtil::print(
+		"%s.clipboard-received=n:%u mean:%.0f p50:%u p99:%u max:%u\n",
+		name, m_clipboardReceived.getCount(), m_clipboardReceived.getMean(),
+		m_clipboardReceived.getPercentile(50.0),
+		m_clipboardReceived.getPercentile(99.0),
+		m_clipboardReceived.getMax());
+	if (m_roundTrip.getCount() > 0) {
+		result += CStringUtil::print(
+			"%s.round-trip-us=n:%u mean:%.0f p50:%u p99:%u max:%u\n",
+			name, m_roundTrip.getCount(), m_roundTrip.getMean(),
+			m_roundTrip.getPercentile(50.0),
+			m_roundTrip.getPercentile(99.0), m_roundTrip.getMax());
+		result += CStringUtil::print("%s.smoothed-round-trip-ms=%.1f\n",
+							name, m_smoothedRoundTrip * 1000.0);
+	}
+	if (m_outputSize != NULL) {
+		result += CStringUtil::print("%s.output-queue=%u\n",
+							name, m_outputSize(m_outputSizeContext));
+	}
+	return result;
+}
+
+
+//
+// CMetrics
+//
+
+bool					CMetrics::s_enabled = false;
+CArchMutex				CMetrics::s_mutex   = NULL;
+CArchMutex				CMetrics::s_valueMutex = NULL;
+double					CMetrics::s_values[kNumMetrics];
+CMetrics::CConnections	CMetrics::s_connections;
+
+void
+CMetrics::setEnabled(bool enabled)
+{
+	// the mutexes are never destroyed since the socket multiplexer
+	// thread may still be using them at exit
+	if (enabled && s_mutex == NULL) {
+		s_mutex      = ARCH->newMutex();
+		s_valueMutex = ARCH->newMutex();
+	}
+	s_enabled = enabled;
+}
+
+void
+CMetrics::add(EMetric metric, double n)
+{
+	if (s_enabled) {
+		CArchMutexLock lock(s_valueMutex);
+		s_values[metric] += n;
+	}
+}
+
+void
+CMetrics::set(EMetric metric, double value)
+{
+	if (s_enabled) {
+		CArchMutexLock lock(s_valueMutex);
+		s_values[metric] = value;
+	}
+}
+
+void
+CMetrics::dump()
+{
+	if (s_mutex == NULL) {
+		return;
+	}
+
+	// log a line at a time so each gets the usual prefix
+	CString metrics = format();
+	CString::size_type start = 0;
+	CString::size_type end   = metrics.find('\n');
+	while (end != CString::npos) {
+		LOG((CLOG_INFO "metric: %s",
+			metrics.substr(start, end - start).c_str()));
+		start = end + 1;
+		end   = metrics.find('\n', start);
+	}
+}
+
+bool
+CMetrics::isEnabled()
+{
+	return s_enabled;
+}
+
+double
+CMetrics::get(EMetric metric)
+{
+	if (s_valueMutex == NULL) {
+		return s_values[metric];
+	}
+	CArchMutexLock lock(s_valueMutex);
+	return s_values[metric];
+}
+
+CString
+CMetrics::format()
+{
+	CString result;
+	for (UInt32 i = 0; i < kNumMetrics; ++i) {
+		EMetric metric = static_cast<EMetric>(i);
+		result += CStringUtil::print("%s=%.0f\n",
+							getName(metric), get(metric));
+	}
+
+	// the connections sample their output queues, which takes the
+	// sockets' locks, so don't hold s_valueMutex here
+	if (s_mutex != NULL) {
+		CArchMutexLock lock(s_mutex);
+		for (CConnections::const_iterator i = s_connections.begin();
+								i != s_connections.end(); ++i) {
+			result += (*i)->format();
+		}
+	}
+	return result;
+}
+
+const char*
+CMetrics::getName(EMetric metric)
+{
+	static const char* s_names[] = {
+		"socket.bytes-sent",
+		"socket.bytes-received",
+		"events.dispatched",
+		"socket.output-queue",
+		"events.queue-depth"
+	};
+	return s_names[metric];
+}
@@ -0,0 +1,221 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CMETRICS_H
+#define CMETRICS_H
+
+#include "BasicTypes.h"
+#include "CString.h"
+#include "IArchMultithread.h"
+#include "stdset.h"
+
+//! Metrics registry
+/*!
+Counts what the client and server are doing so it can be logged or sent
+to the GUI.  There are global counters and gauges, indexed by EMetric,
+and per connection counters and histograms, kept in CConnection objects
+that are in the registry while they have a name.
+
+Metrics are off by default.  Updating a global metric costs a flag test
+when off and a locked add when on, since the socket multiplexer thread
+and the main thread both update them.  Connection metrics are updated
+by one thread at a time and aren't locked.  Adding and removing
+connections and formatting take a separate lock.  Counts are doubles so
+they don't wrap.
+*/
+class CMetrics {
+public:
+	enum EMetric {
+		// counters
+		kSocketBytesSent,
+		kSocketBytesReceived,
+		kEventsDispatched,
+
+		// gauges
+		kSocketOutputQueue,
+		kEventQueueDepth,
+
+		kNumMetrics
+	};
+
+	//! Histogram
+	/*!
+	Counts values in power of two buckets.
+	*/
+	class CHistogram {
+	public:
+		CHistogram();
+
+		//! Add value
+		void			add(UInt32 value);
+
+		//! Get number of values
+		UInt32			getCount() const;
+
+		//! Get largest value
+		UInt32			getMax() const;
+
+		//! Get mean value
+		double			getMean() const;
+
+		//! Get percentile
+		/*!
+		Returns the end of the bucket holding the value that \p percent
+		percent of the values are less than or equal to, but never more
+		than the largest value.  Returns 0 if there are no values.
+		*/
+		UInt32			getPercentile(double percent) const;
+
+	private:
+		enum { kNumBuckets = 33 };
+
+		UInt32			m_counts[kNumBuckets];
+		UInt32			m_count;
+		UInt32			m_max;
+		double			m_sum;
+	};
+
+	//! Connection metrics
+	class CConnection {
+	public:
+		//! Output queue size function
+		typedef UInt32		(*OutputSizeFunc)(const void* context);
+
+		CConnection();
+		~CConnection();
+
+		//! @name manipulators
+		//@{
+
+		//! Name connection
+		/*!
+		Names the connection and, if metrics are enabled, adds it to the
+		registry.
+		*/
+		void			setName(const CString& name);
+
+		//! Record message sent
+		void			addSent(UInt32 size);
+
+		//! Record message received
+		void			addReceived(UInt32 size);
+
+		//! Record clipboard sent
+		void			addClipboardSent(UInt32 size);
+
+		//! Record clipboard received
+		void			addClipboardReceived(UInt32 size);
+
+		//! Record round trip
+		/*!
+		Records a measured round trip time of \p rtt seconds and the
+		smoothed round trip time \p smoothed used for timeouts.
+		*/
+		void			addRoundTrip(double rtt, double smoothed);
+
+		//! Set output queue size function
+		/*!
+		Sets the function that returns the number of bytes waiting to
+		be sent on the connection to \p func, called with \p context.
+		It's called when the metrics are formatted, so the queue is
+		sampled rather than tracked.  It must not lock anything that's
+		held while updating a global metric.  Pass NULL to remove it.
+		*/
+		void			setOutputSize(OutputSizeFunc func,
+							const void* context);
+
+		//@}
+		//! @name accessors
+		//@{
+
+		//! Format metrics
+		/*!
+		Returns the connection's metrics as lines of \c name=value.
+		*/
+		CString			format() const;
+
+		//@}
+
+	public:
+		CString			m_name;
+		double			m_messagesSent;
+		double			m_messagesReceived;
+		double			m_bytesSent;
+		double			m_bytesReceived;
+		CHistogram		m_clipboardSent;
+		CHistogram		m_clipboardReceived;
+		CHistogram		m_roundTrip;
+		double			m_smoothedRoundTrip;
+
+	private:
+		bool			m_registered;
+		OutputSizeFunc	m_outputSize;
+		const void*		m_outputSizeContext;
+	};
+
+	//! @name manipulators
+	//@{
+
+	//! Enable or disable metrics
+	static void			setEnabled(bool enabled);
+
+	//! Add to metric
+	/*!
+	Adds \p n, which may be negative for gauges, to metric \p metric.
+	*/
+	static void			add(EMetric metric, double n);
+
+	//! Set gauge
+	static void			set(EMetric metric, double value);
+
+	//! Log metrics
+	static void			dump();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if metrics are enabled
+	static bool			isEnabled();
+
+	//! Get metric
+	static double		get(EMetric metric);
+
+	//! Format metrics
+	/*!
+	Returns all metrics, global then per connection, as lines of
+	\c name=value.
+	*/
+	static CString		format();
+
+	//@}
+
+private:
+	static const char*	getName(EMetric);
+
+private:
+	typedef std::set<CConnection*> CConnections;
+
+	static bool			s_enabled;
+	static CArchMutex	s_mutex;
+	static CArchMutex	s_valueMutex;
+	static double		s_values[kNumMetrics];
+	static CConnections	s_connections;
+};
+
+#endif
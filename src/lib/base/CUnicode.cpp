@@ -20,10 +20,390 @@
 #include "CArch.h"
 #include <cstring>
 
+// vectorized ASCII runs.  SSE2 is used when the compiler targets it
+// (always on x64) and AVX2 when the CPU has it, checked at run time.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#	if defined(__SSE2__) || defined(_M_X64) || \
+		(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define UNICODE_SSE2 1
+#		include <emmintrin.h>
+#	endif
+#	if defined(__GNUC__) && !defined(__clang__) && \
+		(__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#		define UNICODE_AVX2 1
+#	elif defined(__clang__) && defined(__has_attribute)
+#		if __has_attribute(target)
+#			define UNICODE_AVX2 1
+#		endif
+#	elif defined(_MSC_VER) && _MSC_VER >= 1700
+#		define UNICODE_AVX2 1
+#	endif
+#	if UNICODE_AVX2
+#		include <immintrin.h>
+#		if defined(_MSC_VER)
+#			include <intrin.h>
+#			define AVX2_TARGET
+#		else
+#			define AVX2_TARGET __attribute__((target("avx2")))
+#		endif
+#	endif
+#endif
+
 //
 // local utility functions
 //
 
+#if UNICODE_SSE2 || UNICODE_AVX2
+
+// index of the lowest set bit of a non-zero mask
+inline
+static
+UInt32
+lowestBit(UInt32 mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<UInt32>(index);
+#else
+	return static_cast<UInt32>(__builtin_ctz(mask));
+#endif
+}
+
+#endif
+
+#if UNICODE_AVX2
+
+static
+bool
+hasAVX2()
+{
+#if defined(_MSC_VER)
+	// AVX2 needs the OS to save the ymm registers too
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	if ((info[2] & 0x18000000) != 0x18000000 || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return ((info[1] & 0x20) != 0);
+#else
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("avx2") != 0);
+#endif
+}
+
+// checked once.  racing threads all store the same value.
+static int				s_avx2 = -1;
+
+inline
+static
+bool
+useAVX2()
+{
+	if (s_avx2 == -1) {
+		s_avx2 = hasAVX2() ? 1 : 0;
+	}
+	return (s_avx2 == 1);
+}
+
+AVX2_TARGET
+static
+UInt32
+asciiLengthAVX2(const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+	for (; n - i >= 32; i += 32) {
+		__m256i v = _mm256_loadu_si256(
+							reinterpret_cast<const __m256i*>(src + i));
+		UInt32 mask = static_cast<UInt32>(_mm256_movemask_epi8(v));
+		if (mask != 0) {
+			return i + lowestBit(mask);
+		}
+	}
+	return i;
+}
+
+AVX2_TARGET
+static
+UInt32
+widenASCIIAVX2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	UInt32 i = 0;
+	for (; n - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i),
+							_mm256_cvtepu8_epi16(v));
+	}
+	return i;
+}
+
+AVX2_TARGET
+static
+UInt32
+narrowASCII16AVX2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	const __m256i high = _mm256_set1_epi16(static_cast<short>(0xff80));
+	UInt32 i = 0;
+	for (; n - i >= 32; i += 32) {
+		__m256i a = _mm256_loadu_si256(
+							reinterpret_cast<const __m256i*>(src + 2 * i));
+		__m256i b = _mm256_loadu_si256(
+							reinterpret_cast<const __m256i*>(src + 2 * i + 32));
+		if (!_mm256_testz_si256(_mm256_or_si256(a, b), high)) {
+			break;
+		}
+		// packing works within each 128 bit lane so put the lanes back
+		// in order afterwards
+		__m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+	}
+	return i;
+}
+
+AVX2_TARGET
+static
+UInt32
+narrowASCII32AVX2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	const __m256i high  = _mm256_set1_epi32(static_cast<int>(0xffffff80));
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	UInt32 i = 0;
+	for (; n - i >= 32; i += 32) {
+		const __m256i* p = reinterpret_cast<const __m256i*>(src + 4 * i);
+		__m256i a = _mm256_loadu_si256(p);
+		__m256i b = _mm256_loadu_si256(p + 1);
+		__m256i c = _mm256_loadu_si256(p + 2);
+		__m256i d = _mm256_loadu_si256(p + 3);
+		__m256i t = _mm256_or_si256(_mm256_or_si256(a, b),
+									_mm256_or_si256(c, d));
+		if (!_mm256_testz_si256(t, high)) {
+			break;
+		}
+		__m256i v = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+										_mm256_packs_epi32(c, d));
+		v = _mm256_permutevar8x32_epi32(v, order);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+	}
+	return i;
+}
+
+#endif
+
+#if UNICODE_SSE2
+
+static
+UInt32
+asciiLengthSSE2(const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+	for (; n - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		UInt32 mask = static_cast<UInt32>(_mm_movemask_epi8(v));
+		if (mask != 0) {
+			return i + lowestBit(mask);
+		}
+	}
+	return i;
+}
+
+static
+UInt32
+widenASCIISSE2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	UInt32 i = 0;
+	for (; n - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i* p = reinterpret_cast<__m128i*>(dst + 2 * i);
+		_mm_storeu_si128(p,     _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128(p + 1, _mm_unpackhi_epi8(v, zero));
+	}
+	return i;
+}
+
+static
+UInt32
+narrowASCII16SSE2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	const __m128i high = _mm_set1_epi16(static_cast<short>(0xff80));
+	const __m128i zero = _mm_setzero_si128();
+	UInt32 i = 0;
+	for (; n - i >= 16; i += 16) {
+		const __m128i* p = reinterpret_cast<const __m128i*>(src + 2 * i);
+		__m128i a = _mm_loadu_si128(p);
+		__m128i b = _mm_loadu_si128(p + 1);
+		__m128i t = _mm_and_si128(_mm_or_si128(a, b), high);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(t, zero)) != 0xffff) {
+			break;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+							_mm_packus_epi16(a, b));
+	}
+	return i;
+}
+
+static
+UInt32
+narrowASCII32SSE2(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	const __m128i high = _mm_set1_epi32(static_cast<int>(0xffffff80));
+	const __m128i zero = _mm_setzero_si128();
+	UInt32 i = 0;
+	for (; n - i >= 16; i += 16) {
+		const __m128i* p = reinterpret_cast<const __m128i*>(src + 4 * i);
+		__m128i a = _mm_loadu_si128(p);
+		__m128i b = _mm_loadu_si128(p + 1);
+		__m128i c = _mm_loadu_si128(p + 2);
+		__m128i d = _mm_loadu_si128(p + 3);
+		__m128i t = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b),
+										_mm_or_si128(c, d)), high);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(t, zero)) != 0xffff) {
+			break;
+		}
+		__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b),
+										_mm_packs_epi32(c, d));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+	}
+	return i;
+}
+
+#endif
+
+// returns the number of bytes before the first non-ASCII byte
+inline
+static
+UInt32
+asciiLength(const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+#if UNICODE_AVX2
+	if (useAVX2()) {
+		i = asciiLengthAVX2(src, n);
+	}
+	else
+#endif
+	{
+#if UNICODE_SSE2
+		i = asciiLengthSSE2(src, n);
+#endif
+	}
+	while (i < n && src[i] < 0x80) {
+		++i;
+	}
+	return i;
+}
+
+// writes the n ASCII bytes at src to dst as native endian 16 bit words
+inline
+static
+void
+widenASCII(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	UInt32 i = 0;
+#if UNICODE_AVX2
+	if (useAVX2()) {
+		i = widenASCIIAVX2(src, n, dst);
+	}
+	else
+#endif
+	{
+#if UNICODE_SSE2
+		i = widenASCIISSE2(src, n, dst);
+#endif
+	}
+	for (; i < n; ++i) {
+		UInt16 c = src[i];
+		memcpy(dst + 2 * i, &c, 2);
+	}
+}
+
+// copies the native endian 16 bit words at src to dst as bytes up to
+// the first word that isn't ASCII.  returns the number copied.
+inline
+static
+UInt32
+narrowASCII16(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	UInt32 i = 0;
+#if UNICODE_AVX2
+	if (useAVX2()) {
+		i = narrowASCII16AVX2(src, n, dst);
+	}
+	else
+#endif
+	{
+#if UNICODE_SSE2
+		i = narrowASCII16SSE2(src, n, dst);
+#endif
+	}
+	for (; i < n; ++i) {
+		UInt16 c;
+		memcpy(&c, src + 2 * i, 2);
+		if (c >= 0x80) {
+			break;
+		}
+		dst[i] = static_cast<UInt8>(c);
+	}
+	return i;
+}
+
+// as narrowASCII16() but for 32 bit words
+inline
+static
+UInt32
+narrowASCII32(const UInt8* src, UInt32 n, UInt8* dst)
+{
+	UInt32 i = 0;
+#if UNICODE_AVX2
+	if (useAVX2()) {
+		i = narrowASCII32AVX2(src, n, dst);
+	}
+	else
+#endif
+	{
+#if UNICODE_SSE2
+		i = narrowASCII32SSE2(src, n, dst);
+#endif
+	}
+	for (; i < n; ++i) {
+		UInt32 c;
+		memcpy(&c, src + 4 * i, 4);
+		if (c >= 0x80) {
+			break;
+		}
+		dst[i] = static_cast<UInt8>(c);
+	}
+	return i;
+}
+
+// shrinks a string that was sized for the worst case to \p size,
+// giving back the memory if most of it is unused
+static
+void
+trim(CString& dst, size_t size)
+{
+	if (size < dst.size() / 2) {
+		CString(dst.data(), size).swap(dst);
+	}
+	else {
+		dst.resize(size);
+	}
+}
+
+// returns a pointer to the first byte of a string with at least one byte
+inline
+static
+UInt8*
+getBuffer(CString& dst)
+{
+	return reinterpret_cast<UInt8*>(&dst[0]);
+}
+
 inline
 static
 UInt16
@@ -99,11 +479,16 @@ UInt32					CUnicode::s_replacement = 0x0000fffd;
 bool
 CUnicode::isUTF8(const CString& src)
 {
-	// convert and test each character
+	// skip runs of ASCII and test each other character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	for (UInt32 n = (UInt32)src.size(); n > 0; ) {
-		if (fromUTF8(data, n) == s_invalid) {
-			return false;
+		UInt32 ascii = asciiLength(data, n);
+		data += ascii;
+		n    -= ascii;
+		while (n > 0 && data[0] >= 0x80) {
+			if (fromUTF8(data, n) == s_invalid) {
+				return false;
+			}
 		}
 	}
 	return true;
@@ -115,26 +500,39 @@ CUnicode::UTF8ToUCS2(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// each input byte makes at most one output character
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(2 * n);
+	if (n == 0) {
+		return dst;
+	}
+	dst.resize(2 * n);
+	UInt8* out = getBuffer(dst);
 
-	// convert each character
+	// copy runs of ASCII and convert each other character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
-		UInt32 c = fromUTF8(data, n);
-		if (c == s_invalid) {
-			c = s_replacement;
-		}
-		else if (c >= 0x00010000) {
-			setError(errors);
-			c = s_replacement;
+		UInt32 ascii = asciiLength(data, n);
+		widenASCII(data, ascii, out);
+		data += ascii;
+		n    -= ascii;
+		out  += 2 * ascii;
+		while (n > 0 && data[0] >= 0x80) {
+			UInt32 c = fromUTF8(data, n);
+			if (c == s_invalid) {
+				c = s_replacement;
+			}
+			else if (c >= 0x00010000) {
+				setError(errors);
+				c = s_replacement;
+			}
+			UInt16 ucs2 = static_cast<UInt16>(c);
+			memcpy(out, &ucs2, 2);
+			out += 2;
 		}
-		UInt16 ucs2 = static_cast<UInt16>(c);
-		dst.append(reinterpret_cast<const char*>(&ucs2), 2);
 	}
 
+	trim(dst, out - getBuffer(dst));
 	return dst;
 }
 
@@ -168,35 +566,50 @@ CUnicode::UTF8ToUTF16(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// each input byte makes at most one output word;  characters
+	// that need two words take four bytes in UTF-8.
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(2 * n);
+	if (n == 0) {
+		return dst;
+	}
+	dst.resize(2 * n);
+	UInt8* out = getBuffer(dst);
 
-	// convert each character
+	// copy runs of ASCII and convert each other character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
-		UInt32 c = fromUTF8(data, n);
-		if (c == s_invalid) {
-			c = s_replacement;
-		}
-		else if (c >= 0x00110000) {
-			setError(errors);
-			c = s_replacement;
-		}
-		if (c < 0x00010000) {
-			UInt16 ucs2 = static_cast<UInt16>(c);
-			dst.append(reinterpret_cast<const char*>(&ucs2), 2);
-		}
-		else {
-			c -= 0x00010000;
-			UInt16 utf16h = static_cast<UInt16>((c >> 10) + 0xd800);
-			UInt16 utf16l = static_cast<UInt16>((c & 0x03ff) + 0xdc00);
-			dst.append(reinterpret_cast<const char*>(&utf16h), 2);
-			dst.append(reinterpret_cast<const char*>(&utf16l), 2);
+		UInt32 ascii = asciiLength(data, n);
+		widenASCII(data, ascii, out);
+		data += ascii;
+		n    -= ascii;
+		out  += 2 * ascii;
+		while (n > 0 && data[0] >= 0x80) {
+			UInt32 c = fromUTF8(data, n);
+			if (c == s_invalid) {
+				c = s_replacement;
+			}
+			else if (c >= 0x00110000) {
+				setError(errors);
+				c = s_replacement;
+			}
+			if (c < 0x00010000) {
+				UInt16 ucs2 = static_cast<UInt16>(c);
+				memcpy(out, &ucs2, 2);
+				out += 2;
+			}
+			else {
+				c -= 0x00010000;
+				UInt16 utf16h = static_cast<UInt16>((c >> 10) + 0xd800);
+				UInt16 utf16l = static_cast<UInt16>((c & 0x03ff) + 0xdc00);
+				memcpy(out,     &utf16h, 2);
+				memcpy(out + 2, &utf16l, 2);
+				out += 4;
+			}
 		}
 	}
 
+	trim(dst, out - getBuffer(dst));
 	return dst;
 }
 
@@ -380,9 +793,13 @@ CUnicode::wideCharToUTF8(const wchar_t* src, UInt32 size, bool* errors)
 CString
 CUnicode::doUCS2ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
+	// each character takes at most 3 bytes
 	CString dst;
-	dst.reserve(n);
+	if (n == 0) {
+		return dst;
+	}
+	dst.resize(3 * n);
+	UInt8* out = getBuffer(dst);
 
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
@@ -404,21 +821,36 @@ CUnicode::doUCS2ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
-	// convert each character
-	for (; n > 0; data += 2, --n) {
-		UInt32 c = decode16(data, byteSwapped);
-		toUTF8(dst, c, errors);
+	// copy runs of ASCII and convert each other character
+	while (n > 0) {
+		if (!byteSwapped) {
+			UInt32 ascii = narrowASCII16(data, n, out);
+			data += 2 * ascii;
+			n    -= ascii;
+			out  += ascii;
+		}
+		for (; n > 0 && (byteSwapped || decode16(data, false) >= 0x80);
+								data += 2, --n) {
+			UInt32 c = decode16(data, byteSwapped);
+			toUTF8(out, c, errors);
+		}
 	}
 
+	trim(dst, out - getBuffer(dst));
 	return dst;
 }
 
 CString
 CUnicode::doUCS4ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
+	// each character takes at most 6 bytes.  size for 4 (anything in
+	// UTF-16 range) and grow if we find anything bigger.
 	CString dst;
-	dst.reserve(n);
+	if (n == 0) {
+		return dst;
+	}
+	dst.resize(4 * n);
+	UInt8* out = getBuffer(dst);
 
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
@@ -440,21 +872,40 @@ CUnicode::doUCS4ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
-	// convert each character
-	for (; n > 0; data += 4, --n) {
-		UInt32 c = decode32(data, byteSwapped);
-		toUTF8(dst, c, errors);
+	// copy runs of ASCII and convert each other character
+	while (n > 0) {
+		if (!byteSwapped) {
+			UInt32 ascii = narrowASCII32(data, n, out);
+			data += 4 * ascii;
+			n    -= ascii;
+			out  += ascii;
+		}
+		for (; n > 0 && (byteSwapped || decode32(data, false) >= 0x80);
+								data += 4, --n) {
+			UInt32 c = decode32(data, byteSwapped);
+			if (c >= 0x00110000) {
+				size_t used = out - getBuffer(dst);
+				dst.resize(used + 6 * n);
+				out = getBuffer(dst) + used;
+			}
+			toUTF8(out, c, errors);
+		}
 	}
 
+	trim(dst, out - getBuffer(dst));
 	return dst;
 }
 
 CString
 CUnicode::doUTF16ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
+	// each word makes at most 3 bytes
 	CString dst;
-	dst.reserve(n);
+	if (n == 0) {
+		return dst;
+	}
+	dst.resize(3 * n);
+	UInt8* out = getBuffer(dst);
 
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
@@ -476,38 +927,49 @@ CUnicode::doUTF16ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
-	// convert each character
-	for (; n > 0; data += 2, --n) {
-		UInt32 c = decode16(data, byteSwapped);
-		if (c < 0x0000d800 || c > 0x0000dfff) {
-			toUTF8(dst, c, errors);
-		}
-		else if (n == 1) {
-			// error -- missing second word
-			setError(errors);
-			toUTF8(dst, s_replacement, NULL);
+	// copy runs of ASCII and convert each other character
+	while (n > 0) {
+		if (!byteSwapped) {
+			UInt32 ascii = narrowASCII16(data, n, out);
+			data += 2 * ascii;
+			n    -= ascii;
+			out  += ascii;
 		}
-		else if (c >= 0x0000d800 && c <= 0x0000dbff) {
-			UInt32 c2 = decode16(data, byteSwapped);
-			data += 2;
-			--n;
-			if (c2 < 0x0000dc00 || c2 > 0x0000dfff) {
-				// error -- [d800,dbff] not followed by [dc00,dfff]
+		for (; n > 0 && (byteSwapped || decode16(data, false) >= 0x80);
+								data += 2, --n) {
+			UInt32 c = decode16(data, byteSwapped);
+			if (c < 0x0000d800 || c > 0x0000dfff) {
+				toUTF8(out, c, errors);
+			}
+			else if (n == 1) {
+				// error -- missing second word
 				setError(errors);
-				toUTF8(dst, s_replacement, NULL);
+				toUTF8(out, s_replacement, NULL);
+			}
+			else if (c >= 0x0000d800 && c <= 0x0000dbff) {
+				UInt32 c2 = decode16(data + 2, byteSwapped);
+				if (c2 < 0x0000dc00 || c2 > 0x0000dfff) {
+					// error -- [d800,dbff] not followed by [dc00,dfff].
+					// the second word is converted on its own.
+					setError(errors);
+					toUTF8(out, s_replacement, NULL);
+				}
+				else {
+					c = (((c - 0x0000d800) << 10) | (c2 - 0x0000dc00)) + 0x00010000;
+					toUTF8(out, c, errors);
+					data += 2;
+					--n;
+				}
 			}
 			else {
-				c = (((c - 0x0000d800) << 10) | (c2 - 0x0000dc00)) + 0x00010000;
-				toUTF8(dst, c, errors);
+				// error -- [dc00,dfff] without leading [d800,dbff]
+				setError(errors);
+				toUTF8(out, s_replacement, NULL);
 			}
 		}
-		else {
-			// error -- [dc00,dfff] without leading [d800,dbff]
-			setError(errors);
-			toUTF8(dst, s_replacement, NULL);
-		}
 	}
 
+	trim(dst, out - getBuffer(dst));
 	return dst;
 }
 
@@ -627,25 +1089,25 @@ CUnicode::fromUTF8(const UInt8*& data, UInt32& n)
 	case 4:
 		c = ((static_cast<UInt32>(data[0]) & 0x07) << 18) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[3]) & 0x3f)      );
 		break;
 
 	case 5:
 		c = ((static_cast<UInt32>(data[0]) & 0x03) << 24) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 18) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) << 12) |
+			((static_cast<UInt32>(data[3]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[4]) & 0x3f)      );
 		break;
 
 	case 6:
 		c = ((static_cast<UInt32>(data[0]) & 0x01) << 30) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 24) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 18) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) << 18) |
+			((static_cast<UInt32>(data[3]) & 0x3f) << 12) |
+			((static_cast<UInt32>(data[4]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[5]) & 0x3f)      );
 		break;
 
 	default:
@@ -730,7 +1192,14 @@ void
 CUnicode::toUTF8(CString& dst, UInt32 c, bool* errors)
 {
 	UInt8 data[6];
+	UInt8* end = data;
+	toUTF8(end, c, errors);
+	dst.append(reinterpret_cast<char*>(data), end - data);
+}
 
+void
+CUnicode::toUTF8(UInt8*& dst, UInt32 c, bool* errors)
+{
 	// handle characters outside the valid range
 	if ((c >= 0x0000d800 && c <= 0x0000dfff) || c >= 0x80000000) {
 		setError(errors);
@@ -739,43 +1208,43 @@ CUnicode::toUTF8(CString& dst, UInt32 c, bool* errors)
 
 	// convert to UTF-8
 	if (c < 0x00000080) {
-		data[0] = static_cast<UInt8>(c);
-		dst.append(reinterpret_cast<char*>(data), 1);
+		dst[0] = static_cast<UInt8>(c);
+		dst += 1;
 	}
 	else if (c < 0x00000800) {
-		data[0] = static_cast<UInt8>(((c >>  6) & 0x0000001f) + 0xc0);
-		data[1] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 2);
+		dst[0] = static_cast<UInt8>(((c >>  6) & 0x0000001f) + 0xc0);
+		dst[1] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
+		dst += 2;
 	}
 	else if (c < 0x00010000) {
-		data[0] = static_cast<UInt8>(((c >> 12) & 0x0000000f) + 0xe0);
-		data[1] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
-		data[2] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 3);
+		dst[0] = static_cast<UInt8>(((c >> 12) & 0x0000000f) + 0xe0);
+		dst[1] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
+		dst[2] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
+		dst += 3;
 	}
 	else if (c < 0x00200000) {
-		data[0] = static_cast<UInt8>(((c >> 18) & 0x00000007) + 0xf0);
-		data[1] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
-		data[2] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
-		data[3] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 4);
+		dst[0] = static_cast<UInt8>(((c >> 18) & 0x00000007) + 0xf0);
+		dst[1] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
+		dst[2] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
+		dst[3] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
+		dst += 4;
 	}
 	else if (c < 0x04000000) {
-		data[0] = static_cast<UInt8>(((c >> 24) & 0x00000003) + 0xf8);
-		data[1] = static_cast<UInt8>(((c >> 18) & 0x0000003f) + 0x80);
-		data[2] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
-		data[3] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
-		data[4] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 5);
+		dst[0] = static_cast<UInt8>(((c >> 24) & 0x00000003) + 0xf8);
+		dst[1] = static_cast<UInt8>(((c >> 18) & 0x0000003f) + 0x80);
+		dst[2] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
+		dst[3] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
+		dst[4] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
+		dst += 5;
 	}
 	else if (c < 0x80000000) {
-		data[0] = static_cast<UInt8>(((c >> 30) & 0x00000001) + 0xfc);
-		data[1] = static_cast<UInt8>(((c >> 24) & 0x0000003f) + 0x80);
-		data[2] = static_cast<UInt8>(((c >> 18) & 0x0000003f) + 0x80);
-		data[3] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
-		data[4] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
-		data[5] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 6);
+		dst[0] = static_cast<UInt8>(((c >> 30) & 0x00000001) + 0xfc);
+		dst[1] = static_cast<UInt8>(((c >> 24) & 0x0000003f) + 0x80);
+		dst[2] = static_cast<UInt8>(((c >> 18) & 0x0000003f) + 0x80);
+		dst[3] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
+		dst[4] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
+		dst[5] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
+		dst += 6;
 	}
 	else {
 		assert(0 && "character out of range");
@@ -138,6 +138,7 @@ private:
 	// convert characters to/from UTF8
 	static UInt32		fromUTF8(const UInt8*& src, UInt32& size);
 	static void			toUTF8(CString& dst, UInt32 c, bool* errors);
+	static void			toUTF8(UInt8*& dst, UInt32 c, bool* errors);
 
 private:
 	static UInt32		s_invalid;
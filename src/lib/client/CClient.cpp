@@ -71,6 +71,10 @@ CClient::CClient(IEventQueue& eventQueue,
 	assert(m_socketFactory != NULL);
 	assert(m_screen        != NULL);
 
+	for (UInt32 i = 0; i < 4; ++i) {
+		m_sessionShape[i] = 0;
+	}
+
 	// register suspend/resume event handlers
 	m_eventQueue.adoptHandler(IScreen::getSuspendEvent(),
 							getEventTarget(),
@@ -188,6 +192,47 @@ CClient::handshakeComplete()
 	sendEvent(getConnectedEvent(), NULL);
 }
 
+void
+CClient::setSession(const CString& token, bool resumed)
+{
+	m_sessionToken = token;
+	saveSessionShape();
+
+	// the server has forgotten what we sent it in a new session
+	if (!resumed) {
+		resetClipboardState();
+		m_sessionOptions.clear();
+	}
+}
+
+bool
+CClient::takeSessionToken(CString& token)
+{
+	if (m_sessionToken.empty()) {
+		return false;
+	}
+	token = m_sessionToken;
+	m_sessionToken.erase();
+
+	// the server must get our info if it's changed
+	SInt32 x, y, w, h;
+	m_screen->getShape(x, y, w, h);
+	return (x == m_sessionShape[0] && y == m_sessionShape[1] &&
+			w == m_sessionShape[2] && h == m_sessionShape[3]);
+}
+
+void
+CClient::beginBatch()
+{
+	m_screen->beginBatch();
+}
+
+void
+CClient::endBatch()
+{
+	m_screen->endBatch();
+}
+
 bool
 CClient::isConnected() const
 {
@@ -206,6 +251,12 @@ CClient::getServerAddress() const
 	return m_serverAddress;
 }
 
+const COptionsList&
+CClient::getSessionOptions() const
+{
+	return m_sessionOptions;
+}
+
 CEvent::Type
 CClient::getConnectedEvent()
 {
@@ -357,12 +408,15 @@ void
 CClient::resetOptions()
 {
 	m_screen->resetOptions();
+	m_sessionOptions.clear();
 }
 
 void
 CClient::setOptions(const COptionsList& options)
 {
 	m_screen->setOptions(options);
+	m_sessionOptions.insert(m_sessionOptions.end(),
+							options.begin(), options.end());
 }
 
 void
@@ -445,6 +499,23 @@ CClient::sendConnectionFailedEvent(const char* msg)
 	EVENTQUEUE->addEvent(event);
 }
 
+void
+CClient::resetClipboardState()
+{
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		m_ownClipboard[id]  = false;
+		m_sentClipboard[id] = false;
+		m_timeClipboard[id] = 0;
+	}
+}
+
+void
+CClient::saveSessionShape()
+{
+	m_screen->getShape(m_sessionShape[0], m_sessionShape[1],
+							m_sessionShape[2], m_sessionShape[3]);
+}
+
 void
 CClient::setupConnecting()
 {
@@ -579,11 +650,10 @@ CClient::handleConnected(const CEvent&, void*)
 	cleanupConnecting();
 	setupConnection();
 
-	// reset clipboard state
-	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
-		m_ownClipboard[id]  = false;
-		m_sentClipboard[id] = false;
-		m_timeClipboard[id] = 0;
+	// reset clipboard state unless we might resume our session, in
+	// which case we'll reset it if the server starts a new session
+	if (m_sessionToken.empty()) {
+		resetClipboardState();
 	}
 }
 
@@ -639,6 +709,7 @@ CClient::handleShapeChanged(const CEvent&, void*)
 {
 	LOG((CLOG_DEBUG "resolution changed"));
 	m_server->onInfoChanged();
+	saveSessionShape();
 }
 
 void
@@ -717,10 +788,12 @@ CClient::handleResume(const CEvent&, void*)
 {
 	LOG((CLOG_INFO "resume"));
 	m_suspended = false;
-	if (m_connectOnResume) {
-		m_connectOnResume = false;
-		connect();
-	}
+
+	// the network has probably changed while we were suspended so
+	// retry now if we're not connected rather than waiting for the
+	// next scheduled retry.  does nothing if connected or connecting.
+	m_connectOnResume = false;
+	connect();
 }
 
 void
@@ -84,6 +84,36 @@ public:
 	*/
 	void				handshakeComplete();
 
+	//! Set session
+	/*!
+	Sets the token of the session the server started or resumed.  When
+	\p resumed is false the server has no memory of anything sent to it
+	so the clipboard state is discarded.
+	*/
+	void				setSession(const CString& token, bool resumed);
+
+	//! Take session token
+	/*!
+	Gets the token of the previous session into \p token so the session
+	can be resumed and forgets it, so a token is only tried once.
+	Returns false if there's no session or the screen info has changed
+	since the server last got it.
+	*/
+	bool				takeSessionToken(CString& token);
+
+	//! Begin a batch of messages
+	/*!
+	Input synthesized for the messages up to the matching endBatch()
+	is delivered all at once by endBatch().
+	*/
+	void				beginBatch();
+
+	//! End a batch of messages
+	/*!
+	Delivers the input synthesized since the matching beginBatch().
+	*/
+	void				endBatch();
+
 	//@}
 	//! @name accessors
 	//@{
@@ -108,6 +138,12 @@ public:
 	*/
 	CNetworkAddress		getServerAddress() const;
 
+	//! Get session options
+	/*!
+	Returns the options the server has set in this session.
+	*/
+	const COptionsList&	getSessionOptions() const;
+
 	//! Get connected event type
 	/*!
 	Returns the connected event type.  This is sent when the client has
@@ -169,6 +205,8 @@ private:
 	void				sendClipboard(ClipboardID);
 	void				sendEvent(CEvent::Type, void*);
 	void				sendConnectionFailedEvent(const char* msg);
+	void				resetClipboardState();
+	void				saveSessionShape();
 	void				setupConnecting();
 	void				setupConnection();
 	void				setupScreen();
@@ -207,6 +245,9 @@ private:
 	bool					m_sentClipboard[kClipboardEnd];
 	IClipboard::Time		m_timeClipboard[kClipboardEnd];
 	CString					m_dataClipboard[kClipboardEnd];
+	CString					m_sessionToken;
+	SInt32					m_sessionShape[4];
+	COptionsList			m_sessionOptions;
 	IEventQueue&			m_eventQueue;
 
 	static CEvent::Type	s_connectedEvent;
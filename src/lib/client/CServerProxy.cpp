@@ -24,12 +24,46 @@
 #include "ProtocolTypes.h"
 #include "IStream.h"
 #include "CLog.h"
+#include "CArch.h"
+#include "CLatencyTrace.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
 #include "XBase.h"
 #include <memory>
 #include <cstring>
 
+//
+// CInputBatch
+//
+
+// batches the client's faked input while it's active and delivers it
+// when ended or destroyed, so a message that throws can't leave the
+// screen batching forever.
+class CInputBatch {
+public:
+	CInputBatch(CClient* client) : m_client(client), m_active(false) { }
+	~CInputBatch() { end(); }
+
+	void				begin()
+	{
+		m_client->beginBatch();
+		m_active = true;
+	}
+
+	void				end()
+	{
+		if (m_active) {
+			m_active = false;
+			m_client->endBatch();
+		}
+	}
+
+private:
+	CClient*			m_client;
+	bool				m_active;
+};
+
+
 //
 // CServerProxy
 //
@@ -37,6 +71,8 @@
 CServerProxy::CServerProxy(CClient* client, synergy::IStream* stream, IEventQueue& eventQueue) :
 	m_client(client),
 	m_stream(stream),
+	m_packet(NULL),
+	m_packetSize(0),
 	m_seqNum(0),
 	m_compressMouse(false),
 	m_compressMouseRelative(false),
@@ -45,8 +81,10 @@ CServerProxy::CServerProxy(CClient* client, synergy::IStream* stream, IEventQueu
 	m_dxMouse(0),
 	m_dyMouse(0),
 	m_ignoreMouse(false),
+	m_keepAliveRate(0.0),
 	m_keepAliveAlarm(0.0),
 	m_keepAliveAlarmTimer(NULL),
+	m_keepAliveTime(0.0),
 	m_parser(&CServerProxy::parseHandshakeMessage),
 	m_eventQueue(eventQueue)
 {
@@ -63,6 +101,10 @@ CServerProxy::CServerProxy(CClient* client, synergy::IStream* stream, IEventQueu
 							new TMethodEventJob<CServerProxy>(this,
 								&CServerProxy::handleData));
 
+	// count the messages to and from the server
+	m_metrics.setName("server");
+	m_stream->setMetrics(&m_metrics);
+
 	// send heartbeat
 	setKeepAliveRate(kKeepAliveRate);
 }
@@ -72,6 +114,7 @@ CServerProxy::~CServerProxy()
 	setKeepAliveRate(-1.0);
 	m_eventQueue.removeHandler(m_stream->getInputReadyEvent(),
 							m_stream->getEventTarget());
+	m_stream->setMetrics(NULL);
 }
 
 void
@@ -94,23 +137,71 @@ CServerProxy::resetKeepAliveAlarm()
 void
 CServerProxy::setKeepAliveRate(double rate)
 {
-	m_keepAliveAlarm = rate * kKeepAlivesUntilDeath;
+	// a new rate makes the old delays meaningless
+	m_keepAliveRate  = rate;
+	m_keepAliveTime  = 0.0;
+	m_keepAliveDelay.reset();
+	m_keepAliveAlarm = m_keepAliveDelay.getTimeout(rate);
 	resetKeepAliveAlarm();
 }
 
+bool
+CServerProxy::readf(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result;
+	if (m_packet != NULL) {
+		result = CProtocolUtil::vreadf(m_packet, m_packetSize, fmt, args);
+	}
+	else {
+		result = CProtocolUtil::vreadf(m_stream, fmt, args);
+	}
+	va_end(args);
+	return result;
+}
+
 void
 CServerProxy::handleData(const CEvent&, void*)
 {
-	// handle messages until there are no more.  first read message code.
-	UInt8 code[4];
-	UInt32 n = m_stream->read(code, 4);
-	while (n != 0) {
+	// handle messages until there are no more.  the first is handled
+	// right away but if more follow then the input they synthesize is
+	// batched and delivered after the last.  disconnecting deletes us
+	// so the batch keeps its own pointer to the client.
+	CInputBatch batch(m_client);
+	UInt32 numMessages = 0;
+	for (;;) {
+		// first get the message code.  parse whole packets in place if
+		// the stream will lend them to us, otherwise read the stream.
+		UInt8 buffer[4];
+		const UInt8* code;
+		UInt32 n;
+		m_packet = reinterpret_cast<const UInt8*>(
+							m_stream->borrowPacket(m_packetSize));
+		if (m_packet != NULL) {
+			n             = (m_packetSize < 4) ? m_packetSize : 4;
+			code          = m_packet;
+			m_packet     += n;
+			m_packetSize -= n;
+		}
+		else {
+			n    = m_stream->read(buffer, 4);
+			code = buffer;
+			if (n == 0) {
+				break;
+			}
+		}
+
 		// verify we got an entire code
 		if (n != 4) {
 			LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
+			batch.end();
 			m_client->disconnect("incomplete message from server");
 			return;
 		}
+		if (++numMessages == 2) {
+			batch.begin();
+		}
 
 		// parse message
 		LOG((CLOG_DEBUG2 "msg from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
@@ -120,15 +211,13 @@ CServerProxy::handleData(const CEvent&, void*)
 
 		case kUnknown:
 			LOG((CLOG_ERR "invalid message from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
+			batch.end();
 			m_client->disconnect("invalid message from server");
 			return;
 
 		case kDisconnect:
 			return;
 		}
-
-		// next message
-		n = m_stream->read(code, 4);
 	}
 
 	flushCompressedMouse();
@@ -138,13 +227,25 @@ CServerProxy::EResult
 CServerProxy::parseHandshakeMessage(const UInt8* code)
 {
 	if (memcmp(code, kMsgQInfo, 4) == 0) {
-		queryInfo();
+		// resume our previous session instead of sending our info if
+		// we can
+		if (!resumeSession()) {
+			queryInfo();
+		}
 	}
 
 	else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
 		infoAcknowledgment();
 	}
 
+	else if (memcmp(code, kMsgDSession, 4) == 0) {
+		if (setSession()) {
+			// handshake is complete
+			m_parser = &CServerProxy::parseMessage;
+			m_client->handshakeComplete();
+		}
+	}
+
 	else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
 		setOptions();
 
@@ -158,9 +259,7 @@ CServerProxy::parseHandshakeMessage(const UInt8* code)
 	}
 
 	else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-		// echo keep alives and reset alarm
-		CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-		resetKeepAliveAlarm();
+		keepAlive();
 	}
 
 	else if (memcmp(code, kMsgCNoop, 4) == 0) {
@@ -176,8 +275,7 @@ CServerProxy::parseHandshakeMessage(const UInt8* code)
 
 	else if (memcmp(code, kMsgEIncompatible, 4) == 0) {
 		SInt32 major, minor;
-		CProtocolUtil::readf(m_stream,
-						kMsgEIncompatible + 4, &major, &minor);
+		readf(kMsgEIncompatible + 4, &major, &minor);
 		LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
 		m_client->disconnect("server has incompatible version");
 		return kDisconnect;
@@ -214,6 +312,10 @@ CServerProxy::parseMessage(const UInt8* code)
 		mouseMove();
 	}
 
+	else if (memcmp(code, kMsgDTrace, 4) == 0) {
+		trace();
+	}
+
 	else if (memcmp(code, kMsgDMouseRelMove, 4) == 0) {
 		mouseRelativeMove();
 	}
@@ -243,9 +345,7 @@ CServerProxy::parseMessage(const UInt8* code)
 	}
 
 	else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-		// echo keep alives and reset alarm
-		CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-		resetKeepAliveAlarm();
+		keepAlive();
 	}
 
 	else if (memcmp(code, kMsgCNoop, 4) == 0) {
@@ -363,6 +463,7 @@ CServerProxy::onClipboardChanged(ClipboardID id, const IClipboard* clipboard)
 	CString data = IClipboard::marshall(clipboard);
 	LOG((CLOG_DEBUG1 "sending clipboard %d seqnum=%d, size=%d", id, m_seqNum, data.size()));
 	CProtocolUtil::writef(m_stream, kMsgDClipboard, id, m_seqNum, &data);
+	m_metrics.addClipboardSent(static_cast<UInt32>(data.size()));
 }
 
 void
@@ -531,7 +632,7 @@ CServerProxy::enter()
 	SInt16 x, y;
 	UInt16 mask;
 	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+	readf(kMsgCEnter + 4, &x, &y, &seqNum, &mask);
 	LOG((CLOG_DEBUG1 "recv enter, %d,%d %d %04x", x, y, seqNum, mask));
 
 	// discard old compressed mouse motion, if any
@@ -565,8 +666,9 @@ CServerProxy::setClipboard()
 	ClipboardID id;
 	UInt32 seqNum;
 	CString data;
-	CProtocolUtil::readf(m_stream, kMsgDClipboard + 4, &id, &seqNum, &data);
+	readf(kMsgDClipboard + 4, &id, &seqNum, &data);
 	LOG((CLOG_DEBUG "recv clipboard %d size=%d", id, data.size()));
+	m_metrics.addClipboardReceived(static_cast<UInt32>(data.size()));
 
 	// validate
 	if (id >= kClipboardEnd) {
@@ -575,7 +677,7 @@ CServerProxy::setClipboard()
 
 	// forward
 	CClipboard clipboard;
-	clipboard.unmarshall(data, 0);
+	clipboard.unmarshall(CClipboardBlob::adopt(data), 0);
 	m_client->setClipboard(id, &clipboard);
 }
 
@@ -585,7 +687,7 @@ CServerProxy::grabClipboard()
 	// parse
 	ClipboardID id;
 	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+	readf(kMsgCClipboard + 4, &id, &seqNum);
 	LOG((CLOG_DEBUG "recv grab clipboard %d", id));
 
 	// validate
@@ -605,7 +707,7 @@ CServerProxy::keyDown()
 
 	// parse
 	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+	readf(kMsgDKeyDown + 4, &id, &mask, &button);
 	LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
@@ -628,8 +730,7 @@ CServerProxy::keyRepeat()
 
 	// parse
 	UInt16 id, mask, count, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
-								&id, &mask, &count, &button);
+	readf(kMsgDKeyRepeat + 4, &id, &mask, &count, &button);
 	LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
 	// translate
@@ -652,7 +753,7 @@ CServerProxy::keyUp()
 
 	// parse
 	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
+	readf(kMsgDKeyUp + 4, &id, &mask, &button);
 	LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
@@ -675,7 +776,7 @@ CServerProxy::mouseDown()
 
 	// parse
 	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
+	readf(kMsgDMouseDown + 4, &id);
 	LOG((CLOG_DEBUG1 "recv mouse down id=%d", id));
 
 	// forward
@@ -690,7 +791,7 @@ CServerProxy::mouseUp()
 
 	// parse
 	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseUp + 4, &id);
+	readf(kMsgDMouseUp + 4, &id);
 	LOG((CLOG_DEBUG1 "recv mouse up id=%d", id));
 
 	// forward
@@ -703,7 +804,8 @@ CServerProxy::mouseMove()
 	// parse
 	bool ignore;
 	SInt16 x, y;
-	CProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+	readf(kMsgDMouseMove + 4, &x, &y);
+	CLatencyTrace::mark(CLatencyTrace::kParse);
 
 	// note if we should ignore the move
 	ignore = m_ignoreMouse;
@@ -736,7 +838,7 @@ CServerProxy::mouseRelativeMove()
 	// parse
 	bool ignore;
 	SInt16 dx, dy;
-	CProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+	readf(kMsgDMouseRelMove + 4, &dx, &dy);
 
 	// note if we should ignore the move
 	ignore = m_ignoreMouse;
@@ -768,7 +870,7 @@ CServerProxy::mouseWheel()
 
 	// parse
 	SInt16 xDelta, yDelta;
-	CProtocolUtil::readf(m_stream, kMsgDMouseWheel + 4, &xDelta, &yDelta);
+	readf(kMsgDMouseWheel + 4, &xDelta, &yDelta);
 	LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
 
 	// forward
@@ -781,7 +883,7 @@ CServerProxy::gameDeviceButtons()
 	// parse
 	GameDeviceID id;
 	GameDeviceButton buttons;
-	CProtocolUtil::readf(m_stream, kMsgDGameButtons + 4, &id, &buttons);
+	readf(kMsgDGameButtons + 4, &id, &buttons);
 	LOG((CLOG_DEBUG2 "recv game device id=%d buttons=%d", id, buttons));
 
 	// forward
@@ -794,7 +896,7 @@ CServerProxy::gameDeviceSticks()
 	// parse
 	GameDeviceID id;
 	SInt16 x1, y1, x2, y2;
-	CProtocolUtil::readf(m_stream, kMsgDGameSticks + 4, &id, &x1, &y1, &x2, &y2);
+	readf(kMsgDGameSticks + 4, &id, &x1, &y1, &x2, &y2);
 	LOG((CLOG_DEBUG2 "recv game device sticks id=%d s1=%+d,%+d s2=%+d,%+d", id, x1, y1, x2, y2));
 
 	// forward
@@ -807,7 +909,7 @@ CServerProxy::gameDeviceTriggers()
 	// parse
 	GameDeviceID id;
 	UInt8 t1, t2;
-	CProtocolUtil::readf(m_stream, kMsgDGameTriggers + 4, &id, &t1, &t2);
+	readf(kMsgDGameTriggers + 4, &id, &t1, &t2);
 	LOG((CLOG_DEBUG2 "recv game device triggers id=%d t1=%d t2=%d", id, t1, t2));
 
 	// forward
@@ -829,7 +931,7 @@ CServerProxy::screensaver()
 {
 	// parse
 	SInt8 on;
-	CProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+	readf(kMsgCScreenSaver + 4, &on);
 	LOG((CLOG_DEBUG1 "recv screen saver on=%d", on));
 
 	// forward
@@ -859,12 +961,17 @@ CServerProxy::setOptions()
 {
 	// parse
 	COptionsList options;
-	CProtocolUtil::readf(m_stream, kMsgDSetOptions + 4, &options);
+	readf(kMsgDSetOptions + 4, &options);
 	LOG((CLOG_DEBUG1 "recv set options size=%d", options.size()));
 
 	// forward
 	m_client->setOptions(options);
+	applyOptions(options);
+}
 
+void
+CServerProxy::applyOptions(const COptionsList& options)
+{
 	// update modifier table
 	for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
 		KeyModifierID id = kKeyModifierIDNull;
@@ -907,6 +1014,70 @@ CServerProxy::queryInfo()
 	sendInfo(info);
 }
 
+bool
+CServerProxy::resumeSession()
+{
+	CString token;
+	if (!m_client->takeSessionToken(token)) {
+		return false;
+	}
+	LOG((CLOG_DEBUG1 "resume session"));
+	CProtocolUtil::writef(m_stream, kMsgDResume, &token);
+	return true;
+}
+
+bool
+CServerProxy::setSession()
+{
+	// parse
+	CString token;
+	SInt8 resumed;
+	readf(kMsgDSession + 4, &token, &resumed);
+	LOG((CLOG_DEBUG1 "recv session resumed=%d", resumed));
+
+	// forward
+	m_client->setSession(token, resumed != 0);
+
+	// we're a new proxy so reapply the options of the resumed session
+	if (resumed != 0) {
+		applyOptions(m_client->getSessionOptions());
+	}
+	return (resumed != 0);
+}
+
+void
+CServerProxy::trace()
+{
+	// parse
+	UInt32 id;
+	readf(kMsgDTrace + 4, &id);
+	LOG((CLOG_DEBUG2 "recv trace %u", id));
+
+	// the next message continues the trace
+	CLatencyTrace::receive(id);
+}
+
+void
+CServerProxy::keepAlive()
+{
+	// echo keep alives so the server can time the round trip
+	CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+
+	// the server sends keep alives every m_keepAliveRate seconds so
+	// any longer gap is how late this one is
+	double now = ARCH->time();
+	if (m_keepAliveTime > 0.0 && m_keepAliveRate > 0.0) {
+		double delay = (now - m_keepAliveTime) - m_keepAliveRate;
+		m_keepAliveDelay.addSample(delay < 0.0 ? 0.0 : delay);
+		m_keepAliveAlarm = m_keepAliveDelay.getTimeout(m_keepAliveRate);
+		LOG((CLOG_DEBUG2 "keep alive %.1f ms late, timeout %.1f s", delay * 1000.0, m_keepAliveAlarm));
+	}
+	m_keepAliveTime = now;
+
+	// reset alarm
+	resetKeepAliveAlarm();
+}
+
 void
 CServerProxy::infoAcknowledgment()
 {
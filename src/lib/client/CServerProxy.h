@@ -23,6 +23,9 @@
 #include "KeyTypes.h"
 #include "CEvent.h"
 #include "GameDeviceTypes.h"
+#include "OptionTypes.h"
+#include "CMetrics.h"
+#include "CKeepAliveEstimator.h"
 
 class CClient;
 class CClientInfo;
@@ -67,9 +70,15 @@ private:
 
 	void				sendInfo(const CClientInfo&);
 
+	// apply options that affect the proxy
+	void				applyOptions(const COptionsList&);
+
 	void				resetKeepAliveAlarm();
 	void				setKeepAliveRate(double);
 
+	// read the rest of the current message.  see CProtocolUtil::readf().
+	bool				readf(const char* fmt, ...);
+
 	// modifier key translation
 	KeyID				translateKey(KeyID) const;
 	KeyModifierMask		translateModifierMask(KeyModifierMask) const;
@@ -100,6 +109,10 @@ private:
 	void				setOptions();
 	void				queryInfo();
 	void				infoAcknowledgment();
+	bool				resumeSession();
+	bool				setSession();
+	void				trace();
+	void				keepAlive();
 
 private:
 	typedef EResult (CServerProxy::*MessageParser)(const UInt8*);
@@ -107,6 +120,10 @@ private:
 	CClient*			m_client;
 	synergy::IStream*			m_stream;
 
+	// the unparsed part of the packet borrowed from m_stream, if any
+	const UInt8*		m_packet;
+	UInt32				m_packetSize;
+
 	UInt32				m_seqNum;
 
 	bool				m_compressMouse;
@@ -118,11 +135,17 @@ private:
 
 	KeyModifierID		m_modifierTranslationTable[kKeyModifierIDLast];
 
+	double				m_keepAliveRate;
 	double				m_keepAliveAlarm;
 	CEventQueueTimer*	m_keepAliveAlarmTimer;
 
+	// time the last keep alive arrived, or 0, and how late they arrive
+	double				m_keepAliveTime;
+	CKeepAliveEstimator	m_keepAliveDelay;
+
 	MessageParser		m_parser;
 	IEventQueue&		m_eventQueue;
+	CMetrics::CConnection	m_metrics;
 };
 
 #endif
@@ -97,6 +97,12 @@ CStreamFilter::getSize() const
 	return getStream()->getSize();
 }
 
+UInt32
+CStreamFilter::getOutputSize() const
+{
+	return getStream()->getOutputSize();
+}
+
 synergy::IStream*
 CStreamFilter::getStream() const
 {
@@ -31,6 +31,30 @@ CEvent::Type			IStream::s_outputErrorEvent    = CEvent::kUnknown;
 CEvent::Type			IStream::s_inputShutdownEvent  = CEvent::kUnknown;
 CEvent::Type			IStream::s_outputShutdownEvent = CEvent::kUnknown;
 
+const void*
+IStream::borrowPacket(UInt32&)
+{
+	return NULL;
+}
+
+void
+IStream::releasePacket()
+{
+	// do nothing
+}
+
+void
+IStream::setMetrics(CMetrics::CConnection*)
+{
+	// do nothing
+}
+
+UInt32
+IStream::getOutputSize() const
+{
+	return 0;
+}
+
 CEvent::Type
 IStream::getInputReadyEvent()
 {
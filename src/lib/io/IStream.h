@@ -22,6 +22,7 @@
 #include "IInterface.h"
 #include "CEvent.h"
 #include "IEventQueue.h"
+#include "CMetrics.h"
 
 class IEventQueue;
 
@@ -87,6 +88,33 @@ public:
 	*/
 	virtual void		shutdownOutput() = 0;
 
+	//! Borrow next packet
+	/*!
+	Streams that carry packets can lend the caller the next whole packet
+	in place instead of copying it out with \c read().  Returns a pointer
+	to the packet and sets \p size to its size, or returns NULL if no
+	whole packet is available.  Any previously borrowed packet is
+	released first.  The caller must not modify the packet and must not
+	use it after the next call to \c borrowPacket(), \c releasePacket(),
+	\c read(), \c close() or the stream's next input ready event.  The
+	default returns NULL for streams that don't carry packets.
+	*/
+	virtual const void*	borrowPacket(UInt32& size);
+
+	//! Release borrowed packet
+	/*!
+	Discards the packet returned by the last \c borrowPacket(), if any.
+	*/
+	virtual void		releasePacket();
+
+	//! Set connection metrics
+	/*!
+	Streams that carry messages count the messages they send and
+	receive in \p metrics, which may be NULL to stop counting.  The
+	default does nothing.
+	*/
+	virtual void		setMetrics(CMetrics::CConnection* metrics);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -115,6 +143,15 @@ public:
 	*/
 	virtual UInt32		getSize() const = 0;
 
+	//! Get bytes waiting to be sent
+	/*!
+	Returns the number of bytes written to the stream that haven't been
+	sent yet.  A growing backlog means the peer or the network can't
+	keep up.  The default returns zero for streams that don't buffer
+	output.
+	*/
+	virtual UInt32		getOutputSize() const;
+
 	//! Get input ready event type
 	/*!
 	Returns the input ready event type.  A stream sends this event
@@ -21,8 +21,8 @@
 
 #include "IInterface.h"
 
-using namespace synergy;
 namespace synergy { class IStream; }
+using namespace synergy;
 
 //! Stream filter factory interface
 /*!
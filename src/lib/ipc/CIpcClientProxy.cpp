@@ -114,6 +114,9 @@ CIpcClientProxy::handleData(const CEvent&, void*)
 		else if (memcmp(code, kIpcMsgCommand, 4) == 0) {
 			m = parseCommand();
 		}
+		else if (memcmp(code, kIpcMsgMetrics, 4) == 0) {
+			m = parseMetrics();
+		}
 		else {
 			LOG((CLOG_ERR "invalid ipc message"));
 			disconnect();
@@ -147,7 +150,21 @@ CIpcClientProxy::send(const CIpcMessage& message)
 		CProtocolUtil::writef(&m_stream, kIpcMsgLogLine, &logLine);
 		break;
 	}
+
+	case kIpcLogBatch: {
+		const CIpcLogBatchMessage& lbm = static_cast<const CIpcLogBatchMessage&>(message);
+		CString data = lbm.data();
+		CProtocolUtil::writef(&m_stream, kIpcMsgLogBatch, &data);
+		break;
+	}
 			
+	case kIpcMetrics: {
+		const CIpcMetricsMessage& mm = static_cast<const CIpcMetricsMessage&>(message);
+		CString metrics = mm.metrics();
+		CProtocolUtil::writef(&m_stream, kIpcMsgMetrics, &metrics);
+		break;
+	}
+
 	case kIpcShutdown:
 		CProtocolUtil::writef(&m_stream, kIpcMsgShutdown);
 		break;
@@ -181,6 +198,16 @@ CIpcClientProxy::parseCommand()
 	return new CIpcCommandMessage(command, elevate != 0);
 }
 
+CIpcMetricsMessage*
+CIpcClientProxy::parseMetrics()
+{
+	CString metrics;
+	CProtocolUtil::readf(&m_stream, kIpcMsgMetrics + 4, &metrics);
+
+	// must be deleted by event handler.
+	return new CIpcMetricsMessage(metrics);
+}
+
 void
 CIpcClientProxy::disconnect()
 {
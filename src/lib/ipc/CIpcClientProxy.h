@@ -26,6 +26,7 @@ namespace synergy { class IStream; }
 class CIpcMessage;
 class CIpcCommandMessage;
 class CIpcHelloMessage;
+class CIpcMetricsMessage;
 
 class CIpcClientProxy {
 	friend class CIpcServer;
@@ -49,6 +50,7 @@ private:
 	void				handleWriteError(const CEvent&, void*);
 	CIpcHelloMessage*	parseHello();
 	CIpcCommandMessage*	parseCommand();
+	CIpcMetricsMessage*	parseMetrics();
 	void				disconnect();
 	
 private:
@@ -28,18 +28,27 @@
 #include "CThread.h"
 #include "TMethodJob.h"
 #include "XArch.h"
+#include <cstring>
 
-// limit number of log lines sent in one message.
-#define MAX_SEND 100
+// limit number of bytes of log lines sent in one message.
+#define MAX_SEND_BYTES (64 * 1024)
+
+// limit time (in seconds) a log line waits for others to join its batch.
+#define MAX_SEND_LATENCY 0.05
+
+// limit number of full batches kept while no gui is connected.
+#define MAX_BUFFER_BATCHES 64
 
 CIpcLogOutputter::CIpcLogOutputter(CIpcServer& ipcServer) :
 m_ipcServer(ipcServer),
+m_batch(new CIpcLogBatchMessage),
 m_bufferMutex(ARCH->newMutex()),
 m_sending(false),
 m_running(true),
 m_notifyCond(ARCH->newCondVar()),
 m_notifyMutex(ARCH->newMutex()),
-m_bufferWaiting(false)
+m_bufferWaiting(false),
+m_batchWaiting(false)
 {
 	m_bufferThread = new CThread(new TMethodJob<CIpcLogOutputter>(
 		this, &CIpcLogOutputter::bufferThread));
@@ -54,6 +63,12 @@ CIpcLogOutputter::~CIpcLogOutputter()
 	ARCH->closeMutex(m_bufferMutex);
 	delete m_bufferThread;
 
+	delete m_batch;
+	for (CBatchList::iterator i = m_fullBatches.begin();
+							i != m_fullBatches.end(); ++i) {
+		delete *i;
+	}
+
 	ARCH->closeCondVar(m_notifyCond);
 	ARCH->closeMutex(m_notifyMutex);
 }
@@ -97,16 +112,48 @@ CIpcLogOutputter::write(ELevel, const char* text, bool force)
 		}
 	}
 
-	appendBuffer(text);
-	notifyBuffer();
+	// while the buffer thread is holding back a batch, only wake it
+	// when the batch is full.
+	bool full = appendBuffer(text);
+	if (m_bufferWaiting || full) {
+		notifyBuffer();
+	}
 	return true;
 }
 
-void
-CIpcLogOutputter::appendBuffer(const CString& text)
+bool
+CIpcLogOutputter::appendBuffer(const char* text)
 {
 	CArchMutexLock lock(m_bufferMutex);
-	m_buffer.push(text);
+
+	m_batch->append(text, static_cast<UInt32>(strlen(text)));
+	if (m_batch->data().size() < MAX_SEND_BYTES) {
+		return false;
+	}
+
+	// start a new batch.  if nobody is reading, drop the oldest batch
+	// rather than letting the buffer grow forever.
+	m_fullBatches.push_back(m_batch);
+	m_batch = new CIpcLogBatchMessage;
+	if (m_fullBatches.size() > MAX_BUFFER_BATCHES) {
+		delete m_fullBatches.front();
+		m_fullBatches.pop_front();
+	}
+	return true;
+}
+
+bool
+CIpcLogOutputter::isBufferEmpty()
+{
+	CArchMutexLock lock(m_bufferMutex);
+	return (m_fullBatches.empty() && m_batch->empty());
+}
+
+bool
+CIpcLogOutputter::hasFullBatch()
+{
+	CArchMutexLock lock(m_bufferMutex);
+	return !m_fullBatches.empty();
 }
 
 void
@@ -120,9 +167,18 @@ CIpcLogOutputter::bufferThread(void*)
 
 			if (m_ipcServer.hasClients(kIpcClientGui)) {
 
-				// buffer is sent in chunks, so keep sending until it's
+				// buffer is sent in batches, so keep sending until it's
 				// empty (or the program has stopped in the meantime).
-				while (m_running && !m_buffer.empty()) {
+				while (m_running && !isBufferEmpty()) {
+
+					// give more lines a chance to join a partly full batch.
+					if (!hasFullBatch()) {
+						m_batchWaiting = true;
+						ARCH->waitCondVar(m_notifyCond, m_notifyMutex,
+							MAX_SEND_LATENCY);
+						m_batchWaiting = false;
+					}
+
 					sendBuffer();
 				}
 			}
@@ -147,37 +203,32 @@ CIpcLogOutputter::bufferThread(void*)
 void
 CIpcLogOutputter::notifyBuffer()
 {
-	if (!m_bufferWaiting) {
+	if (!m_bufferWaiting && !m_batchWaiting) {
 		return;
 	}
 	CArchMutexLock lock(m_notifyMutex);
 	ARCH->broadcastCondVar(m_notifyCond);
 }
 
-CString
-CIpcLogOutputter::getChunk(size_t count)
-{
-	CArchMutexLock lock(m_bufferMutex);
-
-	if (m_buffer.size() < count) {
-		count = m_buffer.size();
-	}
-
-	CString chunk;
-	for (size_t i = 0; i < count; i++) {
-		chunk.append(m_buffer.front());
-		chunk.append("\n");
-		m_buffer.pop();
-	}
-	return chunk;
-}
-
 void
 CIpcLogOutputter::sendBuffer()
 {
-	CIpcLogLineMessage message(getChunk(MAX_SEND));
+	CIpcLogBatchMessage* batch;
+	{
+		CArchMutexLock lock(m_bufferMutex);
+		if (!m_fullBatches.empty()) {
+			batch = m_fullBatches.front();
+			m_fullBatches.pop_front();
+		}
+		else {
+			batch = m_batch;
+			m_batch = new CIpcLogBatchMessage;
+		}
+	}
 
 	m_sending = true;
-	m_ipcServer.send(message, kIpcClientGui);
+	m_ipcServer.send(*batch, kIpcClientGui);
 	m_sending = false;
+
+	delete batch;
 }
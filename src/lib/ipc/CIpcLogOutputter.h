@@ -20,16 +20,19 @@
 
 #include "ILogOutputter.h"
 #include "CArch.h"
-#include <queue>
+#include <deque>
 #include "IArchMultithread.h"
 
 class CIpcServer;
 class CEvent;
 class CIpcClientProxy;
+class CIpcLogBatchMessage;
 
 //! Write log to GUI over IPC
 /*!
-This outputter writes output to the GUI via IPC.
+This outputter writes output to the GUI via IPC.  Log lines are
+collected into batches which are sent when they're full or when the
+oldest line has waited long enough, whichever comes first.
 */
 class CIpcLogOutputter : public ILogOutputter {
 public:
@@ -50,15 +53,17 @@ public:
 
 private:
 	void				bufferThread(void*);
-	CString				getChunk(size_t count);
 	void				sendBuffer();
-	void				appendBuffer(const CString& text);
+	bool				appendBuffer(const char* text);
+	bool				isBufferEmpty();
+	bool				hasFullBatch();
 
 private:
-	typedef std::queue<CString> CBuffer;
+	typedef std::deque<CIpcLogBatchMessage*> CBatchList;
 
 	CIpcServer&			m_ipcServer;
-	CBuffer				m_buffer;
+	CIpcLogBatchMessage*	m_batch;
+	CBatchList			m_fullBatches;
 	CArchMutex			m_bufferMutex;
 	bool				m_sending;
 	CThread*			m_bufferThread;
@@ -66,6 +71,7 @@ private:
 	CArchCond			m_notifyCond;
 	CArchMutex			m_notifyMutex;
 	bool				m_bufferWaiting;
+	bool				m_batchWaiting;
 	IArchMultithread::ThreadID
 						m_bufferThreadId;
 };
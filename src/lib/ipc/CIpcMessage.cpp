@@ -57,6 +57,67 @@ CIpcLogLineMessage::~CIpcLogLineMessage()
 {
 }
 
+CIpcLogBatchMessage::CIpcLogBatchMessage() :
+CIpcMessage(kIpcLogBatch)
+{
+}
+
+CIpcLogBatchMessage::CIpcLogBatchMessage(const CString& data) :
+CIpcMessage(kIpcLogBatch),
+m_data(data)
+{
+}
+
+CIpcLogBatchMessage::~CIpcLogBatchMessage()
+{
+}
+
+void
+CIpcLogBatchMessage::append(const char* line, UInt32 length)
+{
+	m_data += static_cast<char>((length >> 24) & 0xff);
+	m_data += static_cast<char>((length >> 16) & 0xff);
+	m_data += static_cast<char>((length >>  8) & 0xff);
+	m_data += static_cast<char>( length        & 0xff);
+	m_data.append(line, length);
+}
+
+bool
+CIpcLogBatchMessage::getLine(UInt32& offset,
+				const char*& line, UInt32& length) const
+{
+	UInt32 size = static_cast<UInt32>(m_data.size());
+	if (offset > size || size - offset < 4) {
+		return false;
+	}
+
+	const UInt8* buffer =
+		reinterpret_cast<const UInt8*>(m_data.data() + offset);
+	UInt32 n = (static_cast<UInt32>(buffer[0]) << 24) |
+			   (static_cast<UInt32>(buffer[1]) << 16) |
+			   (static_cast<UInt32>(buffer[2]) <<  8) |
+				static_cast<UInt32>(buffer[3]);
+	if (size - offset - 4 < n) {
+		// truncated
+		return false;
+	}
+
+	line    = m_data.data() + offset + 4;
+	length  = n;
+	offset += 4 + n;
+	return true;
+}
+
+CIpcMetricsMessage::CIpcMetricsMessage(const CString& metrics) :
+CIpcMessage(kIpcMetrics),
+m_metrics(metrics)
+{
+}
+
+CIpcMetricsMessage::~CIpcMetricsMessage()
+{
+}
+
 CIpcCommandMessage::CIpcCommandMessage(const CString& command, bool elevate) :
 CIpcMessage(kIpcCommand),
 m_command(command),
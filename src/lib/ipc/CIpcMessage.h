@@ -68,6 +68,56 @@ private:
 	CString				m_logLine;
 };
 
+//! Batch of log lines
+/*!
+Holds many log lines in a single buffer, each prefixed with its length,
+so lines can be added and read back without allocating per line.
+*/
+class CIpcLogBatchMessage : public CIpcMessage {
+public:
+	CIpcLogBatchMessage();
+	CIpcLogBatchMessage(const CString& data);
+	virtual ~CIpcLogBatchMessage();
+
+	//! Adds a log line.
+	void				append(const char* line, UInt32 length);
+
+	//! Gets the next log line.
+	/*!
+	Sets \p line and \p length to the log line at \p offset, which
+	should start at 0, and advances \p offset to the next line.  Returns
+	false if there are no more lines.  The line points into the
+	message and isn't NUL terminated.
+	*/
+	bool				getLine(UInt32& offset,
+							const char*& line, UInt32& length) const;
+
+	//! Gets the encoded log lines.
+	const CString&		data() const { return m_data; }
+
+	//! Returns true if there are no log lines.
+	bool				empty() const { return m_data.empty(); }
+
+private:
+	CString				m_data;
+};
+
+//! Metrics
+/*!
+A snapshot of a node's metrics, as formatted by CMetrics::format().
+*/
+class CIpcMetricsMessage : public CIpcMessage {
+public:
+	CIpcMetricsMessage(const CString& metrics);
+	virtual ~CIpcMetricsMessage();
+
+	//! Gets the metrics.
+	const CString&		metrics() const { return m_metrics; }
+
+private:
+	CString				m_metrics;
+};
+
 class CIpcCommandMessage : public CIpcMessage {
 public:
 	CIpcCommandMessage(const CString& command, bool elevate);
@@ -57,9 +57,15 @@ CIpcServerProxy::handleData(const CEvent&, void*)
 		if (memcmp(code, kIpcMsgLogLine, 4) == 0) {
 			m = parseLogLine();
 		}
+		else if (memcmp(code, kIpcMsgLogBatch, 4) == 0) {
+			m = parseLogBatch();
+		}
 		else if (memcmp(code, kIpcMsgShutdown, 4) == 0) {
 			m = new CIpcShutdownMessage();
 		}
+		else if (memcmp(code, kIpcMsgMetrics, 4) == 0) {
+			m = parseMetrics();
+		}
 		else {
 			LOG((CLOG_ERR "invalid ipc message"));
 			disconnect();
@@ -95,6 +101,13 @@ CIpcServerProxy::send(const CIpcMessage& message)
 		break;
 	}
 
+	case kIpcMetrics: {
+		const CIpcMetricsMessage& mm = static_cast<const CIpcMetricsMessage&>(message);
+		CString metrics = mm.metrics();
+		CProtocolUtil::writef(&m_stream, kIpcMsgMetrics, &metrics);
+		break;
+	}
+
 	default:
 		LOG((CLOG_ERR "ipc message not supported: %d", message.type()));
 		break;
@@ -111,6 +124,27 @@ CIpcServerProxy::parseLogLine()
 	return new CIpcLogLineMessage(logLine);
 }
 
+CIpcLogBatchMessage*
+CIpcServerProxy::parseLogBatch()
+{
+	// the lines stay in the one buffer they were read into.
+	CString data;
+	CProtocolUtil::readf(&m_stream, kIpcMsgLogBatch + 4, &data);
+	
+	// must be deleted by event handler.
+	return new CIpcLogBatchMessage(data);
+}
+
+CIpcMetricsMessage*
+CIpcServerProxy::parseMetrics()
+{
+	CString metrics;
+	CProtocolUtil::readf(&m_stream, kIpcMsgMetrics + 4, &metrics);
+
+	// must be deleted by event handler.
+	return new CIpcMetricsMessage(metrics);
+}
+
 void
 CIpcServerProxy::disconnect()
 {
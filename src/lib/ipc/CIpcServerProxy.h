@@ -23,6 +23,8 @@
 namespace synergy { class IStream; }
 class CIpcMessage;
 class CIpcLogLineMessage;
+class CIpcLogBatchMessage;
+class CIpcMetricsMessage;
 
 class CIpcServerProxy {
 	friend class CIpcClient;
@@ -36,6 +38,8 @@ private:
 
 	void				handleData(const CEvent&, void*);
 	CIpcLogLineMessage*	parseLogLine();
+	CIpcLogBatchMessage*	parseLogBatch();
+	CIpcMetricsMessage*	parseMetrics();
 	void				disconnect();
 
 	//! Raised when the client receives a message from the server.
@@ -20,5 +20,7 @@
 
 const char*				kIpcMsgHello		= "IHEL%1i";
 const char*				kIpcMsgLogLine		= "ILOG%s";
+const char*				kIpcMsgLogBatch		= "ILGB%s";
 const char*				kIpcMsgCommand		= "ICMD%s%1i";
 const char*				kIpcMsgShutdown		= "ISDN";
+const char*				kIpcMsgMetrics		= "IMET%s";
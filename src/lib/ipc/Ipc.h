@@ -26,6 +26,8 @@ enum EIpcMessage {
 	kIpcLogLine,
 	kIpcCommand,
 	kIpcShutdown,
+	kIpcLogBatch,
+	kIpcMetrics,
 };
 
 enum EIpcClientType {
@@ -42,11 +44,19 @@ extern const char*		kIpcMsgHello;
 // $1 = aggregate log lines collected from synergys/c or the daemon itself.
 extern const char*		kIpcMsgLogLine;
 
+// log batch: daemon -> gui
+// $1 = log lines, each prefixed with its 4 byte length.
+extern const char*		kIpcMsgLogBatch;
+
 // command: gui -> daemon
 // $1 = command; the command for the daemon to launch, typically the full
 // path to synergys/c. $2 = true when process must be elevated on ms windows.
 extern const char*		kIpcMsgCommand;
 
+// metrics: node -> daemon -> gui
+// $1 = the node's metrics, one name=value per line.
+extern const char*		kIpcMsgMetrics;
+
 // shutdown: daemon -> node
 // the daemon tells synergys/c to shut down gracefully.
 extern const char*		kIpcMsgShutdown;
@@ -169,6 +169,10 @@ CNetworkAddress::resolve()
 bool
 CNetworkAddress::operator==(const CNetworkAddress& addr) const
 {
+	// unresolved addresses are only equal to each other
+	if (m_address == NULL || addr.m_address == NULL) {
+		return (m_address == addr.m_address);
+	}
 	return ARCH->isEqualAddr(m_address, addr.m_address);
 }
 
@@ -23,6 +23,8 @@
 #include "XSocket.h"
 #include "CLock.h"
 #include "CLog.h"
+#include "CLatencyTrace.h"
+#include "CMetrics.h"
 #include "IEventQueue.h"
 #include "IEventJob.h"
 #include "CArch.h"
@@ -160,10 +162,32 @@ CTCPSocket::write(const void* buffer, UInt32 n)
 		if (n == 0) {
 			return;
 		}
+		CLatencyTrace::mark(CLatencyTrace::kSocketWrite);
 
-		// copy data to the output buffer
+		// if nothing is waiting to be written then try writing directly
+		// rather than handing off to the multiplexer thread.  leave any
+		// error for the multiplexer to handle when it retries the write.
+		const UInt8* data = reinterpret_cast<const UInt8*>(buffer);
 		wasEmpty = (m_outputBuffer.getSize() == 0);
-		m_outputBuffer.write(buffer, n);
+		if (wasEmpty && m_connected) {
+			try {
+				UInt32 written = (UInt32)ARCH->writeSocket(m_socket, data, n);
+				CMetrics::add(CMetrics::kSocketBytesSent, written);
+				data += written;
+				n    -= written;
+			}
+			catch (XArchNetwork&) {
+				// ignore
+			}
+			if (n == 0) {
+				sendEvent(getOutputFlushedEvent());
+				return;
+			}
+		}
+
+		// copy the rest of the data to the output buffer
+		m_outputBuffer.write(data, n);
+		CMetrics::add(CMetrics::kSocketOutputQueue, n);
 
 		// there's data to write
 		m_flushed = false;
@@ -252,6 +276,13 @@ CTCPSocket::getSize() const
 	return m_inputBuffer.getSize();
 }
 
+UInt32
+CTCPSocket::getOutputSize() const
+{
+	CLock lock(&m_mutex);
+	return m_outputBuffer.getSize();
+}
+
 void
 CTCPSocket::connect(const CNetworkAddress& addr)
 {
@@ -379,6 +410,8 @@ CTCPSocket::onInputShutdown()
 void
 CTCPSocket::onOutputShutdown()
 {
+	CMetrics::add(CMetrics::kSocketOutputQueue,
+							-static_cast<double>(m_outputBuffer.getSize()));
 	m_outputBuffer.pop(m_outputBuffer.getSize());
 	m_writable = false;
 
@@ -464,6 +497,9 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 			// discard written data
 			if (n > 0) {
 				m_outputBuffer.pop(n);
+				CMetrics::add(CMetrics::kSocketBytesSent, n);
+				CMetrics::add(CMetrics::kSocketOutputQueue,
+							-static_cast<double>(n));
 				if (m_outputBuffer.getSize() == 0) {
 					sendEvent(getOutputFlushedEvent());
 					m_flushed = true;
@@ -504,11 +540,14 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 			UInt8 buffer[4096];
 			size_t n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
 			if (n > 0) {
+				CLatencyTrace::mark(CLatencyTrace::kSocketRead);
 				bool wasEmpty = (m_inputBuffer.getSize() == 0);
 
 				// slurp up as much as possible
 				do {
 					m_inputBuffer.write(buffer, (UInt32)n);
+					CMetrics::add(CMetrics::kSocketBytesReceived,
+							static_cast<double>(n));
 					n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
 				} while (n > 0);
 
@@ -52,6 +52,7 @@ public:
 	virtual void		shutdownOutput();
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
+	virtual UInt32		getOutputSize() const;
 
 	// IDataSocket overrides
 	virtual void		connect(const CNetworkAddress&);
@@ -0,0 +1,185 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CHeadlessKeyState.h"
+#include "CLog.h"
+
+// the keys on the headless keyboard besides the printable characters
+static const KeyID		s_keys[] = {
+	kKeyBackSpace, kKeyTab, kKeyReturn, kKeyEscape, kKeyDelete,
+	kKeyHome, kKeyLeft, kKeyUp, kKeyRight, kKeyDown,
+	kKeyPageUp, kKeyPageDown, kKeyEnd, kKeyInsert,
+	kKeyF1, kKeyF2, kKeyF3, kKeyF4, kKeyF5, kKeyF6,
+	kKeyF7, kKeyF8, kKeyF9, kKeyF10, kKeyF11, kKeyF12,
+	kKeyShift_L, kKeyControl_L, kKeyAlt_L, kKeyMeta_L, kKeySuper_L,
+	kKeyCapsLock
+};
+
+// buttons below this are unused, as on X11
+static const KeyButton	s_firstButton = 8;
+
+//
+// CHeadlessKeyState
+//
+
+CHeadlessKeyState::CHeadlessKeyState() :
+	m_numFakedKeys(0)
+{
+	init();
+}
+
+CHeadlessKeyState::CHeadlessKeyState(IEventQueue& eventQueue, CKeyMap& keyMap) :
+	CKeyState(eventQueue, keyMap),
+	m_numFakedKeys(0)
+{
+	init();
+}
+
+CHeadlessKeyState::~CHeadlessKeyState()
+{
+	// do nothing
+}
+
+void
+CHeadlessKeyState::init()
+{
+	KeyButton button = s_firstButton;
+	for (KeyID id = 0x20; id < 0x7f; ++id) {
+		addKey(id, button++);
+	}
+	for (size_t i = 0; i < sizeof(s_keys) / sizeof(s_keys[0]); ++i) {
+		addKey(s_keys[i], button++);
+	}
+}
+
+void
+CHeadlessKeyState::addKey(KeyID id, KeyButton button)
+{
+	m_keyToButton[id] = button;
+
+	CKeyMap::KeyItem item;
+	item.m_id        = id;
+	item.m_generates = 0;
+	item.m_lock      = false;
+	CKeyMap::initModifierKey(item);
+	if (item.m_generates != 0) {
+		m_buttonToModifier[button] = item.m_generates;
+	}
+}
+
+void
+CHeadlessKeyState::pressKey(KeyButton button, bool down)
+{
+	if (down) {
+		m_pressed.insert(button);
+	}
+	else {
+		m_pressed.erase(button);
+	}
+	onKey(button, down, pollActiveModifiers());
+}
+
+KeyButton
+CHeadlessKeyState::mapKeyToButton(KeyID id) const
+{
+	CKeyToButtonMap::const_iterator i = m_keyToButton.find(id);
+	if (i == m_keyToButton.end()) {
+		return 0;
+	}
+	return i->second;
+}
+
+UInt32
+CHeadlessKeyState::getNumFakedKeys() const
+{
+	return m_numFakedKeys;
+}
+
+bool
+CHeadlessKeyState::fakeCtrlAltDel()
+{
+	LOG((CLOG_DEBUG1 "injected ctrl+alt+del"));
+	return true;
+}
+
+KeyModifierMask
+CHeadlessKeyState::pollActiveModifiers() const
+{
+	KeyModifierMask mask = 0;
+	for (KeyButtonSet::const_iterator i = m_pressed.begin();
+								i != m_pressed.end(); ++i) {
+		CButtonToModifierMap::const_iterator j = m_buttonToModifier.find(*i);
+		if (j != m_buttonToModifier.end()) {
+			mask |= j->second;
+		}
+	}
+	return mask;
+}
+
+SInt32
+CHeadlessKeyState::pollActiveGroup() const
+{
+	return 0;
+}
+
+void
+CHeadlessKeyState::pollPressedKeys(KeyButtonSet& pressedKeys) const
+{
+	pressedKeys.insert(m_pressed.begin(), m_pressed.end());
+}
+
+void
+CHeadlessKeyState::getKeyMap(CKeyMap& keyMap)
+{
+	CKeyMap::KeyItem item;
+	item.m_group     = 0;
+	item.m_required  = 0;
+	item.m_sensitive = 0;
+	item.m_dead      = false;
+	item.m_client    = 0;
+	for (CKeyToButtonMap::const_iterator i = m_keyToButton.begin();
+								i != m_keyToButton.end(); ++i) {
+		item.m_id        = i->first;
+		item.m_button    = i->second;
+		item.m_generates = 0;
+		item.m_lock      = false;
+		CKeyMap::initModifierKey(item);
+		keyMap.addKeyEntry(item);
+	}
+}
+
+void
+CHeadlessKeyState::fakeKey(const Keystroke& keystroke)
+{
+	switch (keystroke.m_type) {
+	case Keystroke::kButton:
+		LOG((CLOG_DEBUG1 "injected key %03x %s", keystroke.m_data.m_button.m_button, keystroke.m_data.m_button.m_press ? "down" : "up"));
+		if (keystroke.m_data.m_button.m_press) {
+			m_pressed.insert(keystroke.m_data.m_button.m_button);
+		}
+		else {
+			m_pressed.erase(keystroke.m_data.m_button.m_button);
+		}
+		++m_numFakedKeys;
+		break;
+
+	case Keystroke::kGroup:
+		// there's only one group
+		break;
+	}
+}
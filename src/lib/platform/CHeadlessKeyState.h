@@ -0,0 +1,89 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CHEADLESSKEYSTATE_H
+#define CHEADLESSKEYSTATE_H
+
+#include "CKeyState.h"
+#include "stdmap.h"
+
+//! Headless key state
+/*!
+A key state with a fixed keyboard:  one button for each printable ASCII
+character, the common editing and cursor keys and the left modifiers.
+Faked keystrokes are recorded instead of being sent anywhere.
+*/
+class CHeadlessKeyState : public CKeyState {
+public:
+	CHeadlessKeyState();
+	CHeadlessKeyState(IEventQueue& eventQueue, CKeyMap& keyMap);
+	~CHeadlessKeyState();
+
+	//! @name manipulators
+	//@{
+
+	//! Press or release a key
+	/*!
+	Sets the state of \p button as if the user pressed or released it,
+	updating the active modifiers to match.
+	*/
+	void				pressKey(KeyButton button, bool down);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Map a key to a button
+	/*!
+	Returns the button that generates \p id or 0 if there isn't one.
+	*/
+	KeyButton			mapKeyToButton(KeyID id) const;
+
+	//! Get number of faked keystrokes
+	UInt32				getNumFakedKeys() const;
+
+	//@}
+
+	// IKeyState overrides
+	virtual bool		fakeCtrlAltDel();
+	virtual KeyModifierMask
+						pollActiveModifiers() const;
+	virtual SInt32		pollActiveGroup() const;
+	virtual void		pollPressedKeys(KeyButtonSet& pressedKeys) const;
+
+protected:
+	// CKeyState overrides
+	virtual void		getKeyMap(CKeyMap& keyMap);
+	virtual void		fakeKey(const Keystroke& keystroke);
+
+private:
+	void				init();
+	void				addKey(KeyID id, KeyButton button);
+
+private:
+	typedef std::map<KeyID, KeyButton> CKeyToButtonMap;
+	typedef std::map<KeyButton, KeyModifierMask> CButtonToModifierMap;
+
+	CKeyToButtonMap		m_keyToButton;
+	CButtonToModifierMap
+						m_buttonToModifier;
+	KeyButtonSet		m_pressed;
+	UInt32				m_numFakedKeys;
+};
+
+#endif
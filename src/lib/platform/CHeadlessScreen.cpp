@@ -0,0 +1,706 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CHeadlessScreen.h"
+#include "CHeadlessKeyState.h"
+#include "CKeyMap.h"
+#include "XScreen.h"
+#include "CLog.h"
+#include "CLatencyTrace.h"
+#include "IEventQueue.h"
+#include "TMethodEventJob.h"
+#include "stdfstream.h"
+#include "stdsstream.h"
+#include <cstdlib>
+
+// the size of the pretend display
+static const SInt32		s_width  = 1920;
+static const SInt32		s_height = 1080;
+
+// the most injected events to remember
+static const size_t		s_maxInjectedEvents = 100000;
+
+// modifiers that don't affect hot keys
+static const KeyModifierMask	s_hotKeyIgnoredMask =
+	KeyModifierCapsLock | KeyModifierNumLock | KeyModifierScrollLock;
+
+//
+// CHeadlessScreen
+//
+
+CHeadlessScreen::CHeadlessScreen(bool isPrimary,
+				const char* scriptFile, IEventQueue& eventQueue) :
+	CPlatformScreen(eventQueue),
+	m_isPrimary(isPrimary),
+	m_isOnScreen(m_isPrimary),
+	m_w(s_width), m_h(s_height),
+	m_xCursor(s_width / 2), m_yCursor(s_height / 2),
+	m_sequenceNumber(0),
+	m_nextHotKeyID(1),
+	m_keyState(NULL),
+	m_clipboardTime(0),
+	m_nextCommand(0),
+	m_scriptTimer(NULL),
+	m_numMotions(0),
+	m_numButtons(0),
+	m_numWheels(0),
+	m_eventQueue(eventQueue)
+{
+	for (size_t i = 0; i < sizeof(m_buttons) / sizeof(m_buttons[0]); ++i) {
+		m_buttons[i] = false;
+	}
+
+	if (scriptFile != NULL) {
+		std::ifstream stream(scriptFile);
+		if (!stream.is_open()) {
+			LOG((CLOG_ERR "cannot open script \"%s\"", scriptFile));
+			throw XScreenOpenFailure();
+		}
+		loadScript(stream);
+	}
+
+	m_keyState = new CHeadlessKeyState(m_eventQueue, m_keyMap);
+	updateKeyMap();
+	updateKeyState();
+
+	LOG((CLOG_DEBUG "headless screen shape: %dx%d %s", m_w, m_h, m_isPrimary ? "(primary)" : ""));
+	LOG((CLOG_DEBUG "script has %d commands", (int)m_script.size()));
+}
+
+CHeadlessScreen::~CHeadlessScreen()
+{
+	if (m_scriptTimer != NULL) {
+		m_eventQueue.removeHandler(CEvent::kTimer, m_scriptTimer);
+		m_eventQueue.deleteTimer(m_scriptTimer);
+	}
+	delete m_keyState;
+}
+
+void
+CHeadlessScreen::clearInjectedEvents()
+{
+	m_injectedEvents.clear();
+}
+
+const CHeadlessScreen::CInjectedEventList&
+CHeadlessScreen::getInjectedEvents() const
+{
+	return m_injectedEvents;
+}
+
+void
+CHeadlessScreen::enable()
+{
+	// start the script.  the events it generates are only queued so
+	// nobody sees them until everything has finished starting up.
+	if (m_scriptTimer == NULL) {
+		m_nextCommand = 0;
+		runScript();
+	}
+
+	if (!m_isPrimary) {
+		fakeMouseMove(m_w / 2, m_h / 2);
+	}
+}
+
+void
+CHeadlessScreen::disable()
+{
+	// stop the script
+	if (m_scriptTimer != NULL) {
+		m_eventQueue.removeHandler(CEvent::kTimer, m_scriptTimer);
+		m_eventQueue.deleteTimer(m_scriptTimer);
+		m_scriptTimer = NULL;
+	}
+
+	LOG((CLOG_INFO "headless screen injected %d motions, %d button events, %d wheel events, %d keystrokes", m_numMotions, m_numButtons, m_numWheels, m_keyState->getNumFakedKeys()));
+}
+
+void
+CHeadlessScreen::enter()
+{
+	m_isOnScreen = true;
+}
+
+bool
+CHeadlessScreen::leave()
+{
+	if (m_isPrimary) {
+		warpCursor(m_w / 2, m_h / 2);
+	}
+	m_isOnScreen = false;
+	return true;
+}
+
+bool
+CHeadlessScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+	if (clipboard != NULL) {
+		LOG((CLOG_DEBUG1 "injected clipboard %d", id));
+		return CClipboard::copy(&m_clipboard[id], clipboard, ++m_clipboardTime);
+	}
+	else {
+		// assert clipboard ownership
+		if (!m_clipboard[id].open(++m_clipboardTime)) {
+			return false;
+		}
+		m_clipboard[id].empty();
+		m_clipboard[id].close();
+		return true;
+	}
+}
+
+void
+CHeadlessScreen::checkClipboards()
+{
+	// do nothing, we're always up to date
+}
+
+void
+CHeadlessScreen::openScreensaver(bool)
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::closeScreensaver()
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::screensaver(bool)
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::resetOptions()
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::setOptions(const COptionsList&)
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::setSequenceNumber(UInt32 seqNum)
+{
+	m_sequenceNumber = seqNum;
+}
+
+bool
+CHeadlessScreen::isPrimary() const
+{
+	return m_isPrimary;
+}
+
+void*
+CHeadlessScreen::getEventTarget() const
+{
+	return const_cast<CHeadlessScreen*>(this);
+}
+
+bool
+CHeadlessScreen::getClipboard(ClipboardID id, IClipboard* clipboard) const
+{
+	assert(clipboard != NULL);
+
+	return CClipboard::copy(clipboard, &m_clipboard[id],
+							m_clipboard[id].getTime());
+}
+
+void
+CHeadlessScreen::getShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h) const
+{
+	x = 0;
+	y = 0;
+	w = m_w;
+	h = m_h;
+}
+
+void
+CHeadlessScreen::getCursorPos(SInt32& x, SInt32& y) const
+{
+	x = m_xCursor;
+	y = m_yCursor;
+}
+
+void
+CHeadlessScreen::reconfigure(UInt32)
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::warpCursor(SInt32 x, SInt32 y)
+{
+	m_xCursor = x;
+	m_yCursor = y;
+}
+
+UInt32
+CHeadlessScreen::registerHotKey(KeyID key, KeyModifierMask mask)
+{
+	if (key == kKeyNone && mask == 0) {
+		return 0;
+	}
+
+	// only one hot key per combination, like the real screens
+	CHotKeyItem item(key, mask & ~s_hotKeyIgnoredMask);
+	if (m_hotKeyToIDMap.count(item) > 0) {
+		LOG((CLOG_WARN "hot key %04x mask %04x is already registered", key, mask));
+		return 0;
+	}
+
+	UInt32 id = m_nextHotKeyID++;
+	m_hotKeys.insert(std::make_pair(id, item));
+	m_hotKeyToIDMap.insert(std::make_pair(item, id));
+	LOG((CLOG_DEBUG "registered hotkey %04x mask %04x as id %d", key, mask, id));
+	return id;
+}
+
+void
+CHeadlessScreen::unregisterHotKey(UInt32 id)
+{
+	CHotKeyMap::iterator i = m_hotKeys.find(id);
+	if (i == m_hotKeys.end()) {
+		return;
+	}
+	m_hotKeyToIDMap.erase(i->second);
+	m_pressedHotKeys.erase(i->second.first);
+	m_hotKeys.erase(i);
+	LOG((CLOG_DEBUG "unregistered hotkey id %d", id));
+}
+
+void
+CHeadlessScreen::fakeInputBegin()
+{
+	// do nothing
+}
+
+void
+CHeadlessScreen::fakeInputEnd()
+{
+	// do nothing
+}
+
+SInt32
+CHeadlessScreen::getJumpZoneSize() const
+{
+	return 1;
+}
+
+bool
+CHeadlessScreen::isAnyMouseButtonDown() const
+{
+	for (size_t i = 1; i < sizeof(m_buttons) / sizeof(m_buttons[0]); ++i) {
+		if (m_buttons[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+CHeadlessScreen::getCursorCenter(SInt32& x, SInt32& y) const
+{
+	x = m_w / 2;
+	y = m_h / 2;
+}
+
+void
+CHeadlessScreen::fakeMouseButton(ButtonID button, bool press)
+{
+	LOG((CLOG_DEBUG1 "injected button %d %s", button, press ? "down" : "up"));
+	if (button < sizeof(m_buttons) / sizeof(m_buttons[0])) {
+		m_buttons[button] = press;
+	}
+	++m_numButtons;
+	addInjectedEvent(press ? CInjectedEvent::kButtonDown :
+							CInjectedEvent::kButtonUp, 0, 0, button);
+}
+
+void
+CHeadlessScreen::fakeMouseMove(SInt32 x, SInt32 y) const
+{
+	LOG((CLOG_DEBUG1 "injected move %d,%d", x, y));
+	m_xCursor = x;
+	m_yCursor = y;
+	++m_numMotions;
+	addInjectedEvent(CInjectedEvent::kMotion, x, y);
+	CLatencyTrace::mark(CLatencyTrace::kInject);
+}
+
+void
+CHeadlessScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
+{
+	fakeMouseMove(m_xCursor + dx, m_yCursor + dy);
+}
+
+void
+CHeadlessScreen::fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const
+{
+	LOG((CLOG_DEBUG1 "injected wheel %+d,%+d", xDelta, yDelta));
+	++m_numWheels;
+	addInjectedEvent(CInjectedEvent::kWheel, xDelta, yDelta);
+}
+
+void
+CHeadlessScreen::fakeKeyDown(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+	addInjectedEvent(CInjectedEvent::kKeyDown, 0, 0,
+							kButtonNone, id, mask, button);
+	CPlatformScreen::fakeKeyDown(id, mask, button);
+}
+
+bool
+CHeadlessScreen::fakeKeyRepeat(KeyID id, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	addInjectedEvent(CInjectedEvent::kKeyRepeat, count, 0,
+							kButtonNone, id, mask, button);
+	return CPlatformScreen::fakeKeyRepeat(id, mask, count, button);
+}
+
+bool
+CHeadlessScreen::fakeKeyUp(KeyButton button)
+{
+	addInjectedEvent(CInjectedEvent::kKeyUp, 0, 0,
+							kButtonNone, kKeyNone, 0, button);
+	return CPlatformScreen::fakeKeyUp(button);
+}
+
+void
+CHeadlessScreen::handleSystemEvent(const CEvent&, void*)
+{
+	// do nothing, there are no system events
+}
+
+void
+CHeadlessScreen::updateButtons()
+{
+	// do nothing
+}
+
+IKeyState*
+CHeadlessScreen::getKeyState() const
+{
+	return m_keyState;
+}
+
+void
+CHeadlessScreen::loadScript(std::istream& stream)
+{
+	bool hasWait = false;
+	UInt32 lineNumber = 0;
+	std::string line;
+	while (std::getline(stream, line)) {
+		++lineNumber;
+
+		// skip blank lines and comments
+		std::string::size_type i = line.find_first_not_of(" \t\r");
+		if (i == std::string::npos || line[i] == '#') {
+			continue;
+		}
+
+		CCommand command;
+		if (!parseCommand(line.substr(i), command)) {
+			LOG((CLOG_ERR "invalid script command on line %d: %s", lineNumber, line.c_str()));
+			throw XScreenOpenFailure();
+		}
+
+		// looping without waiting would never give the event loop a turn
+		if (command.m_type == CCommand::kWait) {
+			hasWait = true;
+		}
+		else if (command.m_type == CCommand::kLoop && !hasWait) {
+			LOG((CLOG_ERR "script loops without waiting on line %d", lineNumber));
+			throw XScreenOpenFailure();
+		}
+
+		m_script.push_back(command);
+	}
+}
+
+bool
+CHeadlessScreen::parseCommand(const CString& line, CCommand& command) const
+{
+	std::istringstream s(line);
+	CString name;
+	s >> name;
+
+	command.m_x    = 0;
+	command.m_y    = 0;
+	command.m_time = 0.0;
+	command.m_key  = kKeyNone;
+
+	if (name == "wait") {
+		command.m_type = CCommand::kWait;
+		s >> command.m_time;
+		if (!s || command.m_time <= 0.0) {
+			return false;
+		}
+	}
+	else if (name == "move" || name == "rmove" || name == "wheel") {
+		command.m_type = (name == "move")  ? CCommand::kMove :
+						 (name == "rmove") ? CCommand::kRelativeMove :
+											 CCommand::kWheel;
+		s >> command.m_x >> command.m_y;
+		if (!s) {
+			return false;
+		}
+	}
+	else if (name == "down" || name == "up") {
+		command.m_type = (name == "down") ? CCommand::kButtonDown :
+											CCommand::kButtonUp;
+		s >> command.m_x;
+		if (!s || command.m_x < kButtonLeft ||
+			command.m_x >= (SInt32)(sizeof(m_buttons) / sizeof(m_buttons[0]))) {
+			return false;
+		}
+	}
+	else if (name == "keydown" || name == "keyup") {
+		command.m_type = (name == "keydown") ? CCommand::kKeyDown :
+											   CCommand::kKeyUp;
+		CString key;
+		s >> key;
+		if (!CKeyMap::parseKey(key, command.m_key) ||
+			command.m_key == kKeyNone) {
+			return false;
+		}
+	}
+	else if (name == "clipboard") {
+		command.m_type = CCommand::kClipboard;
+		std::getline(s >> std::ws, command.m_text);
+		return true;
+	}
+	else if (name == "loop") {
+		command.m_type = CCommand::kLoop;
+	}
+	else {
+		return false;
+	}
+
+	// no trailing junk
+	CString extra;
+	return !(s >> extra);
+}
+
+void
+CHeadlessScreen::runScript()
+{
+	while (m_nextCommand < m_script.size()) {
+		const CCommand& command = m_script[m_nextCommand++];
+		switch (command.m_type) {
+		case CCommand::kWait:
+			m_scriptTimer = m_eventQueue.newOneShotTimer(command.m_time, NULL);
+			m_eventQueue.adoptHandler(CEvent::kTimer, m_scriptTimer,
+							new TMethodEventJob<CHeadlessScreen>(this,
+								&CHeadlessScreen::handleScriptTimer));
+			return;
+
+		case CCommand::kLoop:
+			m_nextCommand = 0;
+			break;
+
+		default:
+			runCommand(command);
+			break;
+		}
+	}
+	if (!m_script.empty()) {
+		LOG((CLOG_DEBUG "script finished"));
+	}
+}
+
+void
+CHeadlessScreen::runCommand(const CCommand& command)
+{
+	switch (command.m_type) {
+	case CCommand::kMove:
+		onMouseMove(command.m_x, command.m_y);
+		break;
+
+	case CCommand::kRelativeMove:
+		onMouseMove(m_xCursor + command.m_x, m_yCursor + command.m_y);
+		break;
+
+	case CCommand::kButtonDown:
+	case CCommand::kButtonUp:
+		onMouseButton(static_cast<ButtonID>(command.m_x),
+							command.m_type == CCommand::kButtonDown);
+		break;
+
+	case CCommand::kWheel:
+		sendEvent(getWheelEvent(), CWheelInfo::alloc(command.m_x, command.m_y));
+		break;
+
+	case CCommand::kKeyDown:
+	case CCommand::kKeyUp:
+		onKey(command.m_key, command.m_type == CCommand::kKeyDown);
+		break;
+
+	case CCommand::kClipboard:
+		onClipboard(command.m_text);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void
+CHeadlessScreen::handleScriptTimer(const CEvent&, void*)
+{
+	m_eventQueue.removeHandler(CEvent::kTimer, m_scriptTimer);
+	m_eventQueue.deleteTimer(m_scriptTimer);
+	m_scriptTimer = NULL;
+	runScript();
+}
+
+void
+CHeadlessScreen::onMouseMove(SInt32 x, SInt32 y)
+{
+	LOG((CLOG_DEBUG2 "script: move %d,%d", x, y));
+	CLatencyTrace::begin(CLatencyTrace::kCapture);
+
+	SInt32 dx = x - m_xCursor;
+	SInt32 dy = y - m_yCursor;
+	m_xCursor = x;
+	m_yCursor = y;
+
+	if (m_isOnScreen) {
+		sendEvent(getMotionOnPrimaryEvent(), CMotionInfo::alloc(x, y));
+	}
+	else if (dx != 0 || dy != 0) {
+		sendEvent(getMotionOnSecondaryEvent(), CMotionInfo::alloc(dx, dy));
+	}
+}
+
+void
+CHeadlessScreen::onMouseButton(ButtonID button, bool press)
+{
+	LOG((CLOG_DEBUG1 "script: button %d %s", button, press ? "down" : "up"));
+	m_buttons[button] = press;
+	KeyModifierMask mask = m_keyState->getActiveModifiers();
+	if (press) {
+		sendEvent(getButtonDownEvent(), CButtonInfo::alloc(button, mask));
+	}
+	else {
+		sendEvent(getButtonUpEvent(), CButtonInfo::alloc(button, mask));
+	}
+}
+
+void
+CHeadlessScreen::onKey(KeyID key, bool press)
+{
+	KeyButton button = m_keyState->mapKeyToButton(key);
+	if (button == 0) {
+		LOG((CLOG_WARN "script: no button for key %04x", key));
+		return;
+	}
+	LOG((CLOG_DEBUG1 "script: key %04x %s", key, press ? "down" : "up"));
+
+	// like a real key event the mask is the state before the key
+	KeyModifierMask mask = m_keyState->getActiveModifiers();
+	m_keyState->pressKey(button, press);
+	if (!onHotKey(key, mask, press)) {
+		m_keyState->sendKeyEvent(getEventTarget(),
+							press, false, key, mask, 1, button);
+	}
+}
+
+bool
+CHeadlessScreen::onHotKey(KeyID key, KeyModifierMask mask, bool press)
+{
+	// the hot key is released when its key is, whatever the modifiers
+	UInt32 id;
+	if (press) {
+		CHotKeyToIDMap::const_iterator i =
+			m_hotKeyToIDMap.find(CHotKeyItem(key, mask & ~s_hotKeyIgnoredMask));
+		if (i == m_hotKeyToIDMap.end()) {
+			return false;
+		}
+		id = i->second;
+		m_pressedHotKeys[key] = id;
+	}
+	else {
+		CPressedHotKeyMap::iterator i = m_pressedHotKeys.find(key);
+		if (i == m_pressedHotKeys.end()) {
+			return false;
+		}
+		id = i->second;
+		m_pressedHotKeys.erase(i);
+	}
+
+	LOG((CLOG_DEBUG1 "script: hot key %d %s", id, press ? "down" : "up"));
+	sendEvent(press ? getHotKeyDownEvent() : getHotKeyUpEvent(),
+							CHotKeyInfo::alloc(id));
+	return true;
+}
+
+void
+CHeadlessScreen::onClipboard(const CString& text)
+{
+	LOG((CLOG_DEBUG1 "script: clipboard \"%s\"", text.c_str()));
+	CClipboard& clipboard = m_clipboard[kClipboardClipboard];
+	clipboard.open(++m_clipboardTime);
+	clipboard.empty();
+	clipboard.add(IClipboard::kText, text);
+	clipboard.close();
+	sendClipboardEvent(getClipboardGrabbedEvent(), kClipboardClipboard);
+}
+
+void
+CHeadlessScreen::sendEvent(CEvent::Type type, void* data)
+{
+	m_eventQueue.addEvent(CEvent(type, getEventTarget(), data));
+}
+
+void
+CHeadlessScreen::sendClipboardEvent(CEvent::Type type, ClipboardID id)
+{
+	CClipboardInfo* info   = (CClipboardInfo*)malloc(sizeof(CClipboardInfo));
+	info->m_id             = id;
+	info->m_sequenceNumber = m_sequenceNumber;
+	sendEvent(type, info);
+}
+
+void
+CHeadlessScreen::addInjectedEvent(CInjectedEvent::EType type,
+				SInt32 x, SInt32 y, ButtonID button,
+				KeyID key, KeyModifierMask mask, KeyButton keyButton) const
+{
+	if (m_injectedEvents.size() >= s_maxInjectedEvents) {
+		m_injectedEvents.pop_front();
+	}
+
+	CInjectedEvent event;
+	event.m_type      = type;
+	event.m_x         = x;
+	event.m_y         = y;
+	event.m_button    = button;
+	event.m_key       = key;
+	event.m_mask      = mask;
+	event.m_keyButton = keyButton;
+	m_injectedEvents.push_back(event);
+}
@@ -0,0 +1,256 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CHEADLESSSCREEN_H
+#define CHEADLESSSCREEN_H
+
+#include "CPlatformScreen.h"
+#include "CClipboard.h"
+#include "CKeyMap.h"
+#include "CString.h"
+#include "stddeque.h"
+#include "stdmap.h"
+#include "stdvector.h"
+#include "stdistream.h"
+
+class CEventQueueTimer;
+class CHeadlessKeyState;
+
+//! Implementation of IPlatformScreen without a display
+/*!
+A screen that needs no display server, for benchmarking and soak
+testing synergys and synergyc.  Local input comes from a script and
+injected input is recorded (logged at DEBUG1 and kept in a list, see
+getInjectedEvents()) instead of being sent anywhere.  The clipboards are
+kept in memory.  Scripted keys that match a registered hot key post hot
+key events instead of key events.
+
+A script has one command per line;  blank lines and lines starting
+with \c # are ignored:
+\verbatim
+  wait <seconds>           pause the script (seconds > 0)
+  move <x> <y>             move the mouse to x,y
+  rmove <dx> <dy>          move the mouse by dx,dy
+  down <button>            press a mouse button
+  up <button>              release a mouse button
+  wheel <dx> <dy>          turn the mouse wheel
+  keydown <key>            press a key (named as in the config file)
+  keyup <key>              release a key
+  clipboard <text>         take the clipboard, holding text
+  loop                     run the script again from the start
+\endverbatim
+The script starts when the screen is enabled.
+*/
+class CHeadlessScreen : public CPlatformScreen {
+public:
+	//! Injected input
+	class CInjectedEvent {
+	public:
+		enum EType {
+			kMotion,
+			kButtonDown,
+			kButtonUp,
+			kWheel,
+			kKeyDown,
+			kKeyRepeat,
+			kKeyUp
+		};
+
+		EType			m_type;
+		//! Position for kMotion, deltas for kWheel, count in m_x for kKeyRepeat
+		SInt32			m_x;
+		SInt32			m_y;
+		//! Button for kButtonDown and kButtonUp
+		ButtonID		m_button;
+		//! Key and modifiers for kKeyDown and kKeyRepeat
+		KeyID			m_key;
+		KeyModifierMask	m_mask;
+		//! Server's key button for the key events
+		KeyButton		m_keyButton;
+	};
+	typedef std::deque<CInjectedEvent> CInjectedEventList;
+
+	CHeadlessScreen(bool isPrimary, const char* scriptFile, IEventQueue& eventQueue);
+	virtual ~CHeadlessScreen();
+
+	//! @name manipulators
+	//@{
+
+	//! Forget the injected input
+	void				clearInjectedEvents();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get the injected input
+	/*!
+	Returns the input injected since the screen was created or
+	clearInjectedEvents() was last called, oldest first.  Only the most
+	recent events are kept so a long soak test doesn't grow without
+	bound.
+	*/
+	const CInjectedEventList&
+						getInjectedEvents() const;
+
+	//@}
+
+	// IScreen overrides
+	virtual void*		getEventTarget() const;
+	virtual bool		getClipboard(ClipboardID id, IClipboard*) const;
+	virtual void		getShape(SInt32& x, SInt32& y,
+							SInt32& width, SInt32& height) const;
+	virtual void		getCursorPos(SInt32& x, SInt32& y) const;
+
+	// IPrimaryScreen overrides
+	virtual void		reconfigure(UInt32 activeSides);
+	virtual void		warpCursor(SInt32 x, SInt32 y);
+	virtual UInt32		registerHotKey(KeyID key, KeyModifierMask mask);
+	virtual void		unregisterHotKey(UInt32 id);
+	virtual void		fakeInputBegin();
+	virtual void		fakeInputEnd();
+	virtual SInt32		getJumpZoneSize() const;
+	virtual bool		isAnyMouseButtonDown() const;
+	virtual void		getCursorCenter(SInt32& x, SInt32& y) const;
+	virtual void		gameDeviceTimingResp(UInt16 freq) { }
+	virtual void		gameDeviceFeedback(GameDeviceID id, UInt16 m1, UInt16 m2) { }
+
+	// ISecondaryScreen overrides
+	virtual void		fakeMouseButton(ButtonID id, bool press);
+	virtual void		fakeMouseMove(SInt32 x, SInt32 y) const;
+	virtual void		fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const;
+	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const;
+	virtual void		fakeKeyDown(KeyID id, KeyModifierMask mask,
+							KeyButton button);
+	virtual bool		fakeKeyRepeat(KeyID id, KeyModifierMask mask,
+							SInt32 count, KeyButton button);
+	virtual bool		fakeKeyUp(KeyButton button);
+	virtual void		fakeGameDeviceButtons(GameDeviceID id, GameDeviceButton buttons) const { }
+	virtual void		fakeGameDeviceSticks(GameDeviceID id, SInt16 x1, SInt16 y1, SInt16 x2, SInt16 y2) const { }
+	virtual void		fakeGameDeviceTriggers(GameDeviceID id, UInt8 t1, UInt8 t2) const { }
+	virtual void		queueGameDeviceTimingReq() const { }
+
+	// IPlatformScreen overrides
+	virtual void		enable();
+	virtual void		disable();
+	virtual void		enter();
+	virtual bool		leave();
+	virtual bool		setClipboard(ClipboardID, const IClipboard*);
+	virtual void		checkClipboards();
+	virtual void		openScreensaver(bool notify);
+	virtual void		closeScreensaver();
+	virtual void		screensaver(bool activate);
+	virtual void		resetOptions();
+	virtual void		setOptions(const COptionsList& options);
+	virtual void		setSequenceNumber(UInt32);
+	virtual bool		isPrimary() const;
+
+protected:
+	// IPlatformScreen overrides
+	virtual void		handleSystemEvent(const CEvent&, void*);
+	virtual void		updateButtons();
+	virtual IKeyState*	getKeyState() const;
+
+private:
+	class CCommand {
+	public:
+		enum EType {
+			kWait,
+			kMove,
+			kRelativeMove,
+			kButtonDown,
+			kButtonUp,
+			kWheel,
+			kKeyDown,
+			kKeyUp,
+			kClipboard,
+			kLoop
+		};
+
+		EType			m_type;
+		SInt32			m_x;
+		SInt32			m_y;
+		double			m_time;
+		KeyID			m_key;
+		CString			m_text;
+	};
+	typedef std::vector<CCommand> CCommandList;
+
+	typedef std::pair<KeyID, KeyModifierMask> CHotKeyItem;
+	typedef std::map<UInt32, CHotKeyItem> CHotKeyMap;
+	typedef std::map<CHotKeyItem, UInt32> CHotKeyToIDMap;
+	typedef std::map<KeyID, UInt32> CPressedHotKeyMap;
+
+	// parse a script.  throws XScreenOpenFailure if it's not valid.
+	void				loadScript(std::istream&);
+	bool				parseCommand(const CString& line, CCommand&) const;
+
+	// run the script until it waits or ends
+	void				runScript();
+	void				runCommand(const CCommand&);
+	void				handleScriptTimer(const CEvent&, void*);
+
+	// generate local input
+	void				onMouseMove(SInt32 x, SInt32 y);
+	void				onMouseButton(ButtonID, bool press);
+	void				onKey(KeyID, bool press);
+	bool				onHotKey(KeyID, KeyModifierMask, bool press);
+	void				onClipboard(const CString& text);
+
+	// event sending
+	void				sendEvent(CEvent::Type, void* = NULL);
+	void				sendClipboardEvent(CEvent::Type, ClipboardID);
+
+	// record injected input
+	void				addInjectedEvent(CInjectedEvent::EType,
+							SInt32 x = 0, SInt32 y = 0,
+							ButtonID = kButtonNone, KeyID = kKeyNone,
+							KeyModifierMask = 0, KeyButton = 0) const;
+
+private:
+	bool				m_isPrimary;
+	bool				m_isOnScreen;
+	SInt32				m_w, m_h;
+	mutable SInt32		m_xCursor, m_yCursor;
+	bool				m_buttons[kButtonExtra0 + 2];
+	UInt32				m_sequenceNumber;
+	UInt32				m_nextHotKeyID;
+	CHotKeyMap			m_hotKeys;
+	CHotKeyToIDMap		m_hotKeyToIDMap;
+	CPressedHotKeyMap	m_pressedHotKeys;
+
+	CHeadlessKeyState*	m_keyState;
+	CKeyMap				m_keyMap;
+	CClipboard			m_clipboard[kClipboardEnd];
+	IClipboard::Time	m_clipboardTime;
+
+	CCommandList		m_script;
+	size_t				m_nextCommand;
+	CEventQueueTimer*	m_scriptTimer;
+
+	// injected input
+	mutable CInjectedEventList
+						m_injectedEvents;
+	mutable UInt32		m_numMotions;
+	UInt32				m_numButtons;
+	mutable UInt32		m_numWheels;
+
+	IEventQueue&		m_eventQueue;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include "CXWindowsClipboardUTF8Converter.h"
 #include "CXWindowsClipboardHTMLConverter.h"
 #include "CXWindowsClipboardBMPConverter.h"
+#include "CXWindowsClipboardPNGConverter.h"
 #include "CXWindowsUtil.h"
 #include "CThread.h"
 #include "CLog.h"
@@ -29,7 +30,54 @@
 #include "CArch.h"
 #include "stdvector.h"
 #include <cstdio>
+#include <cstring>
 #include <X11/Xatom.h>
+#if HAVE_POLL
+#	include <poll.h>
+#else
+#	if HAVE_SYS_SELECT_H
+#		include <sys/select.h>
+#	endif
+#	if HAVE_SYS_TIME_H
+#		include <sys/time.h>
+#	endif
+#	if HAVE_SYS_TYPES_H
+#		include <sys/types.h>
+#	endif
+#endif
+
+//
+// wait for X events
+//
+
+static
+void
+waitForEvent(Display* display, double dtimeout)
+{
+	// xlib's queue is empty so an event can only arrive on the X
+	// connection.  XPending() flushed our requests.
+#if HAVE_POLL
+	struct pollfd pfds[1];
+	pfds[0].fd     = ConnectionNumber(display);
+	pfds[0].events = POLLIN;
+	poll(pfds, 1, static_cast<int>(1000.0 * dtimeout) + 1);
+#else
+	struct timeval timeout;
+	timeout.tv_sec  = static_cast<int>(dtimeout);
+	timeout.tv_usec = static_cast<int>(1.0e+6 *
+							(dtimeout - timeout.tv_sec));
+
+	fd_set rfds;
+	FD_ZERO(&rfds);
+	FD_SET(ConnectionNumber(display), &rfds);
+	select(ConnectionNumber(display) + 1,
+						SELECT_TYPE_ARG234 &rfds,
+						SELECT_TYPE_ARG234 NULL,
+						SELECT_TYPE_ARG234 NULL,
+						SELECT_TYPE_ARG5   &timeout);
+#endif
+}
+
 
 //
 // CXWindowsClipboard
@@ -76,6 +124,7 @@ CXWindowsClipboard::CXWindowsClipboard(Display* display,
 	// add converters, most desired first
 	m_converters.push_back(new CXWindowsClipboardHTMLConverter(m_display,
 								"text/html"));
+	m_converters.push_back(new CXWindowsClipboardPNGConverter(m_display));
 	m_converters.push_back(new CXWindowsClipboardBMPConverter(m_display));
 	m_converters.push_back(new CXWindowsClipboardUTF8Converter(m_display,
 								"text/plain;charset=UTF-8"));
@@ -90,6 +139,15 @@ CXWindowsClipboard::CXWindowsClipboard(Display* display,
 	m_converters.push_back(new CXWindowsClipboardTextConverter(m_display,
 								"STRING"));
 
+	// get a property for each conversion we might have in progress at
+	// once.  we request at most one target per converter.
+	m_atomsData.push_back(m_atomData);
+	for (size_t i = 1; i < m_converters.size(); ++i) {
+		char name[32];
+		sprintf(name, "CLIP_TEMPORARY_%d", static_cast<int>(i));
+		m_atomsData.push_back(XInternAtom(m_display, name, False));
+	}
+
 	// we have no data
 	clearCache();
 }
@@ -477,6 +535,15 @@ CXWindowsClipboard::fillCache() const
 	}
 }
 
+bool
+CXWindowsClipboard::isFormatAdded(IClipboard::EFormat format) const
+{
+	if (format == kBitmap && m_added[kPNG] && !m_data[kPNG].empty()) {
+		return true;
+	}
+	return m_added[format];
+}
+
 void
 CXWindowsClipboard::doFillCache()
 {
@@ -515,48 +582,73 @@ CXWindowsClipboard::icccmFillCache()
 	const UInt32 numTargets = data.size() / sizeof(Atom);
 	LOG((CLOG_DEBUG "  available targets: %s", CXWindowsUtil::atomsToString(m_display, targets, numTargets).c_str()));
 
-	// try each converter in order (because they're in order of
-	// preference).
+	// see if the owner offers a PNG.  if so there's no point fetching
+	// a bitmap until we know the PNG conversion failed.
+	bool hasPNG = false;
 	for (ConverterList::const_iterator index = m_converters.begin();
 								index != m_converters.end(); ++index) {
-		IXWindowsClipboardConverter* converter = *index;
+		if ((*index)->getFormat() == kPNG) {
+			for (UInt32 i = 0; i < numTargets; ++i) {
+				if ((*index)->getAtom() == targets[i]) {
+					hasPNG = true;
+				}
+			}
+		}
+	}
 
-		// skip already handled targets
-		if (m_added[converter->getFormat()]) {
-			continue;
+	// the converters are in order of preference.  fetch every format at
+	// once, each from the most preferred target we haven't tried yet.
+	// a format whose target the owner can't convert falls back to its
+	// next target in the next round.  note that we just ask for each
+	// converter's target rather than checking TARGETS.  i've seen
+	// clipboard owners that don't report all the targets they support.
+	std::vector<bool> tried(m_converters.size(), false);
+	for (;;) {
+		bool requested[kNumFormats];
+		for (SInt32 format = 0; format < kNumFormats; ++format) {
+			requested[format] = false;
 		}
 
-		// see if atom is in target list
-		Atom target = None;
-		// XXX -- just ask for the converter's target to see if it's
-		// available rather than checking TARGETS.  i've seen clipboard
-		// owners that don't report all the targets they support.
-		target = converter->getAtom();
-		/*
-		for (UInt32 i = 0; i < numTargets; ++i) {
-			if (converter->getAtom() == targets[i]) {
-				target = targets[i];
-				break;
+		std::vector<IXWindowsClipboardConverter*> converters;
+		std::vector<Atom> requestTargets;
+		for (UInt32 i = 0; i < m_converters.size(); ++i) {
+			IXWindowsClipboardConverter* converter = m_converters[i];
+			IClipboard::EFormat format = converter->getFormat();
+
+			// skip already handled targets and formats
+			if (tried[i] || requested[format] || isFormatAdded(format)) {
+				continue;
+			}
+			if (format == kBitmap && hasPNG && requested[kPNG]) {
+				continue;
 			}
+
+			tried[i]          = true;
+			requested[format] = true;
+			converters.push_back(converter);
+			requestTargets.push_back(converter->getAtom());
 		}
-		*/
-		if (target == None) {
-			continue;
+		if (converters.empty()) {
+			break;
 		}
 
 		// get the data
-		Atom actualTarget;
-		CString targetData;
-		if (!icccmGetSelection(target, &actualTarget, &targetData)) {
-			LOG((CLOG_DEBUG1 "  no data for target %s", CXWindowsUtil::atomToString(m_display, target).c_str()));
-			continue;
+		std::vector<Atom> actualTargets;
+		std::vector<CString> targetData;
+		icccmGetSelections(requestTargets, actualTargets, targetData);
+
+		// add to clipboard and note we've done it.  the converters are
+		// still in order of preference so a PNG is added before we see
+		// a bitmap we no longer need.
+		for (UInt32 i = 0; i < converters.size(); ++i) {
+			IClipboard::EFormat format = converters[i]->getFormat();
+			if (actualTargets[i] == None || isFormatAdded(format)) {
+				continue;
+			}
+			m_data[format]  = converters[i]->toIClipboard(targetData[i]);
+			m_added[format] = true;
+			LOG((CLOG_DEBUG "  added format %d for target %s (%u %s)", format, CXWindowsUtil::atomToString(m_display, requestTargets[i]).c_str(), targetData[i].size(), targetData[i].size() == 1 ? "byte" : "bytes"));
 		}
-
-		// add to clipboard and note we've done it
-		IClipboard::EFormat format = converter->getFormat();
-		m_data[format]  = converter->toIClipboard(targetData);
-		m_added[format] = true;
-		LOG((CLOG_DEBUG "  added format %d for target %s (%u %s)", format, CXWindowsUtil::atomToString(m_display, target).c_str(), targetData.size(), targetData.size() == 1 ? "byte" : "bytes"));
 	}
 }
 
@@ -582,6 +674,37 @@ CXWindowsClipboard::icccmGetSelection(Atom target,
 	return true;
 }
 
+void
+CXWindowsClipboard::icccmGetSelections(const std::vector<Atom>& targets,
+				std::vector<Atom>& actualTargets,
+				std::vector<CString>& data) const
+{
+	assert(targets.size() <= m_atomsData.size());
+
+	// request all the conversions at once, each on its own property
+	std::vector<CICCCMGetClipboard> getters;
+	std::vector<CICCCMGetClipboard*> getterPtrs;
+	getters.reserve(targets.size());
+	for (UInt32 i = 0; i < targets.size(); ++i) {
+		getters.push_back(CICCCMGetClipboard(m_window, m_time, m_atomsData[i]));
+		getterPtrs.push_back(&getters.back());
+	}
+	CICCCMGetClipboard::readClipboards(m_display, m_selection,
+								getterPtrs, targets, actualTargets, data);
+
+	for (UInt32 i = 0; i < targets.size(); ++i) {
+		if (getters[i].isFailed()) {
+			LOG((CLOG_DEBUG1 "can't get data for selection target %s", CXWindowsUtil::atomToString(m_display, targets[i]).c_str()));
+			LOGC(getters[i].m_error, (CLOG_WARN "ICCCM violation by clipboard owner"));
+			actualTargets[i] = None;
+			data[i]          = "";
+		}
+		else if (actualTargets[i] == None) {
+			LOG((CLOG_DEBUG1 "selection conversion failed for target %s", CXWindowsUtil::atomToString(m_display, targets[i]).c_str()));
+		}
+	}
+}
+
 IClipboard::Time
 CXWindowsClipboard::icccmGetTime() const
 {
@@ -657,11 +780,11 @@ CXWindowsClipboard::motifOwnsClipboard() const
 	// get the Motif clipboard header property from the root window
 	Atom target;
 	SInt32 format;
-	CString data;
+	CXWindowsUtil::CPropertyData data;
 	Window root = RootWindow(m_display, DefaultScreen(m_display));
 	if (!CXWindowsUtil::getWindowProperty(m_display, root,
 								m_atomMotifClipHeader,
-								&data, &target, &format, False)) {
+								data, &target, &format, False)) {
 		return false;
 	}
 
@@ -686,11 +809,11 @@ CXWindowsClipboard::motifFillCache()
 	// get the Motif clipboard header property from the root window
 	Atom target;
 	SInt32 format;
-	CString data;
+	CXWindowsUtil::CPropertyData data;
 	Window root = RootWindow(m_display, DefaultScreen(m_display));
 	if (!CXWindowsUtil::getWindowProperty(m_display, root,
 								m_atomMotifClipHeader,
-								&data, &target, &format, False)) {
+								data, &target, &format, False)) {
 		return;
 	}
 
@@ -707,9 +830,8 @@ CXWindowsClipboard::motifFillCache()
 	char name[18 + 20];
 	sprintf(name, "_MOTIF_CLIP_ITEM_%d", header->m_item);
     Atom atomItem = XInternAtom(m_display, name, False);
-	data = "";
 	if (!CXWindowsUtil::getWindowProperty(m_display, root,
-								atomItem, &data,
+								atomItem, data,
 								&target, &format, False)) {
 		return;
 	}
@@ -765,7 +887,7 @@ CXWindowsClipboard::motifFillCache()
 		IXWindowsClipboardConverter* converter = *index;
 
 		// skip already handled targets
-		if (m_added[converter->getFormat()]) {
+		if (isFormatAdded(converter->getFormat())) {
 			continue;
 		}
 
@@ -1247,10 +1369,12 @@ CXWindowsClipboard::CICCCMGetClipboard::CICCCMGetClipboard(
 	m_requestor(requestor),
 	m_time(time),
 	m_property(property),
+	m_target(None),
 	m_incr(false),
 	m_failed(false),
 	m_done(false),
 	m_reading(false),
+	m_progress(0.0),
 	m_data(NULL),
 	m_actualTarget(NULL),
 	m_error(false)
@@ -1270,74 +1394,122 @@ CXWindowsClipboard::CICCCMGetClipboard::readClipboard(Display* display,
 	assert(actualTarget != NULL);
 	assert(data         != NULL);
 
-	LOG((CLOG_DEBUG1 "request selection=%s, target=%s, window=%x", CXWindowsUtil::atomToString(display, selection).c_str(), CXWindowsUtil::atomToString(display, target).c_str(), m_requestor));
-
-	m_atomNone = XInternAtom(display, "NONE", False);
-	m_atomIncr = XInternAtom(display, "INCR", False);
+	std::vector<CICCCMGetClipboard*> getters(1, this);
+	std::vector<Atom> targets(1, target);
+	std::vector<Atom> actualTargets;
+	std::vector<CString> targetData;
+	readClipboards(display, selection, getters, targets,
+								actualTargets, targetData);
+	*actualTarget = actualTargets[0];
+	data->swap(targetData[0]);
+	return !m_failed;
+}
 
-	// save output pointers
-	m_actualTarget = actualTarget;
-	m_data         = data;
+void
+CXWindowsClipboard::CICCCMGetClipboard::readClipboards(Display* display,
+				Atom selection,
+				const std::vector<CICCCMGetClipboard*>& getters,
+				const std::vector<Atom>& targets,
+				std::vector<Atom>& actualTargets,
+				std::vector<CString>& data)
+{
+	assert(!getters.empty());
+	assert(getters.size() == targets.size());
 
-	// assume failure
-	*m_actualTarget = None;
-	*m_data         = "";
+	// all getters use the same requestor window
+	const Window requestor = getters[0]->m_requestor;
 
-	// delete target property
-	XDeleteProperty(display, m_requestor, m_property);
+	// the output goes straight into the caller's vectors so these
+	// must not reallocate once the requests are made
+	actualTargets.assign(targets.size(), None);
+	data.assign(targets.size(), CString());
 
 	// select window for property changes
 	XWindowAttributes attr;
-	XGetWindowAttributes(display, m_requestor, &attr);
-	XSelectInput(display, m_requestor,
+	XGetWindowAttributes(display, requestor, &attr);
+	XSelectInput(display, requestor,
 								attr.your_event_mask | PropertyChangeMask);
 
-	// request data conversion
-	XConvertSelection(display, selection, target,
-								m_property, m_requestor, m_time);
+	// request all the data conversions.  the selection owner works
+	// through them while we read the ones it's already converted.
+	for (UInt32 i = 0; i < getters.size(); ++i) {
+		assert(getters[i]->m_requestor == requestor);
+		getters[i]->requestClipboard(display, selection, targets[i],
+								&actualTargets[i], &data[i]);
+	}
 
 	// synchronize with server before we start following timeout countdown
 	XSync(display, False);
 
 	// Xlib inexplicably omits the ability to wait for an event with
 	// a timeout.  (it's inexplicable because there's no portable way
-	// to do it.)  we'll poll until we have what we're looking for or
-	// a timeout expires.  we use a timeout so we don't get locked up
-	// by badly behaved selection owners.
+	// to do it.)  we'll wait on the connection ourselves until we have
+	// what we're looking for or every conversion has timed out.  we use
+	// a timeout so we don't get locked up by badly behaved selection
+	// owners and a timeout per conversion so a target the owner never
+	// answers doesn't cost us the ones it does.
 	XEvent xevent;
 	std::vector<XEvent> events;
-	CStopwatch timeout(true);
+	CStopwatch timer(true);
 	static const double s_timeout = 0.25;	// FIXME -- is this too short?
-	bool noWait = false;
-	while (!m_done && !m_failed) {
-		// fail if timeout has expired
-		if (timeout.getTime() >= s_timeout) {
-			m_failed = true;
+	for (;;) {
+		// fail conversions that haven't made progress in time and see
+		// how long until the next one would time out
+		const double now = timer.getTime();
+		double wait      = -1.0;
+		for (UInt32 i = 0; i < getters.size(); ++i) {
+			CICCCMGetClipboard* getter = getters[i];
+			if (getter->m_done || getter->m_failed) {
+				continue;
+			}
+			const double left = getter->m_progress + s_timeout - now;
+			if (left <= 0.0) {
+				LOG((CLOG_DEBUG1 "request for target %s timed out", CXWindowsUtil::atomToString(display, getter->m_target).c_str()));
+				getter->m_failed = true;
+			}
+			else if (wait < 0.0 || left < wait) {
+				wait = left;
+			}
+		}
+		if (wait < 0.0) {
+			// nothing left to wait for
 			break;
 		}
 
-		// process events if any otherwise sleep
-		if (noWait || XPending(display) > 0) {
-			while (!m_done && !m_failed && (noWait || XPending(display) > 0)) {
-				XNextEvent(display, &xevent);
-				if (!processEvent(display, &xevent)) {
-					// not processed so save it
-					events.push_back(xevent);
-				}
-				else {
-					// reset timer since we've made some progress
-					timeout.reset();
-
-					// don't sleep anymore, just block waiting for events.
-					// we're assuming here that the clipboard owner will
-					// complete the protocol correctly.  if we continue to
-					// sleep we'll get very bad performance.
-					noWait = true;
+		// wait for an event if there isn't one already
+		if (XPending(display) == 0) {
+			waitForEvent(display, wait);
+			continue;
+		}
+
+		// process the event.  an event is for at most one getter except
+		// our window being destroyed, which fails them all.
+		XNextEvent(display, &xevent);
+		bool processed = false;
+		for (UInt32 i = 0; i < getters.size(); ++i) {
+			CICCCMGetClipboard* getter = getters[i];
+			if (getter->m_done || getter->m_failed) {
+				continue;
+			}
+			if (getter->processEvent(display, &xevent)) {
+				// reset timer since we've made some progress
+				getter->m_progress = timer.getTime();
+				processed          = true;
+			}
+		}
+		if (processed) {
+			// the owner answers requests in turn so a request it hasn't
+			// answered yet may just be waiting on the one it has.  don't
+			// time out those while the owner is making progress.
+			for (UInt32 i = 0; i < getters.size(); ++i) {
+				if (!getters[i]->m_reading) {
+					getters[i]->m_progress = timer.getTime();
 				}
 			}
 		}
 		else {
-			ARCH->sleep(0.01);
+			// not processed so save it
+			events.push_back(xevent);
 		}
 	}
 
@@ -1347,11 +1519,55 @@ CXWindowsClipboard::CICCCMGetClipboard::readClipboard(Display* display,
 	}
 
 	// restore mask
-	XSelectInput(display, m_requestor, attr.your_event_mask);
+	XSelectInput(display, requestor, attr.your_event_mask);
 
 	// return success or failure
-	LOG((CLOG_DEBUG1 "request %s", m_failed ? "failed" : "succeeded"));
-	return !m_failed;
+	for (UInt32 i = 0; i < getters.size(); ++i) {
+		LOG((CLOG_DEBUG1 "request for target %s %s", CXWindowsUtil::atomToString(display, targets[i]).c_str(), getters[i]->m_failed ? "failed" : "succeeded"));
+	}
+}
+
+bool
+CXWindowsClipboard::CICCCMGetClipboard::isFailed() const
+{
+	return m_failed;
+}
+
+void
+CXWindowsClipboard::CICCCMGetClipboard::requestClipboard(Display* display,
+				Atom selection, Atom target, Atom* actualTarget, CString* data)
+{
+	assert(actualTarget != NULL);
+	assert(data         != NULL);
+
+	LOG((CLOG_DEBUG1 "request selection=%s, target=%s, window=%x", CXWindowsUtil::atomToString(display, selection).c_str(), CXWindowsUtil::atomToString(display, target).c_str(), m_requestor));
+
+	m_atomNone = XInternAtom(display, "NONE", False);
+	m_atomIncr = XInternAtom(display, "INCR", False);
+
+	// start over
+	m_target   = target;
+	m_incr     = false;
+	m_failed   = false;
+	m_done     = false;
+	m_reading  = false;
+	m_progress = 0.0;
+	m_error    = false;
+
+	// save output pointers
+	m_actualTarget = actualTarget;
+	m_data         = data;
+
+	// assume failure
+	*m_actualTarget = None;
+	*m_data         = "";
+
+	// delete target property
+	XDeleteProperty(display, m_requestor, m_property);
+
+	// request data conversion
+	XConvertSelection(display, selection, target,
+								m_property, m_requestor, m_time);
 }
 
 bool
@@ -1370,10 +1586,15 @@ CXWindowsClipboard::CICCCMGetClipboard::processEvent(
 		return false;
 
 	case SelectionNotify:
+		// other getters may be waiting on the same requestor.  they
+		// use other properties but a refusal only has the target.
 		if (xevent->xselection.requestor == m_requestor) {
 			// done if we can't convert
 			if (xevent->xselection.property == None ||
 				xevent->xselection.property == m_atomNone) {
+				if (xevent->xselection.target != m_target) {
+					return false;
+				}
 				m_done = true;
 				return true;
 			}
@@ -1433,8 +1654,18 @@ CXWindowsClipboard::CICCCMGetClipboard::processEvent(
 		else {
 			m_incr   = true;
 
+			// the INCR data is a lower bound on the size of the data.
+			// make room for that much up front so the chunks don't
+			// keep growing the buffer.  don't trust it too far.
+			UInt32 size = 0;
+			if (m_data->size() - oldSize >= sizeof(size)) {
+				memcpy(&size, m_data->data() + oldSize, sizeof(size));
+			}
+			static const UInt32 s_maxReserve = 128 * 1024 * 1024;
+
 			// discard INCR data
 			*m_data = "";
+			m_data->reserve(size < s_maxReserve ? size : s_maxReserve);
 		}
 	}
 
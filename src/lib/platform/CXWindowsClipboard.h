@@ -131,6 +131,10 @@ private:
 	void				fillCache() const;
 	void				doFillCache();
 
+	// returns true if the format is already cached.  a bitmap counts as
+	// cached once we have a PNG;  it's the same image, only bigger.
+	bool				isFormatAdded(IClipboard::EFormat) const;
+
 	//
 	// helper classes
 	//
@@ -148,13 +152,32 @@ private:
 							Atom selection, Atom target,
 							Atom* actualTarget, CString* data);
 
+		// convert the given selection to targets[i] using getters[i]
+		// for every i at once.  each getter must use its own property.
+		// each conversion times out on its own so a slow one doesn't
+		// hold up the others.  on return actualTargets[i] and data[i]
+		// are set as by readClipboard() and getters[i]->isFailed()
+		// is true iff readClipboard() would've returned false.
+		static void		readClipboards(Display* display, Atom selection,
+							const std::vector<CICCCMGetClipboard*>& getters,
+							const std::vector<Atom>& targets,
+							std::vector<Atom>& actualTargets,
+							std::vector<CString>& data);
+
+		// true iff the last conversion failed or timed out
+		bool			isFailed() const;
+
 	private:
+		void			requestClipboard(Display* display,
+							Atom selection, Atom target,
+							Atom* actualTarget, CString* data);
 		bool			processEvent(Display* display, XEvent* event);
 
 	private:
 		Window			m_requestor;
 		Time			m_time;
 		Atom			m_property;
+		Atom			m_target;
 		bool			m_incr;
 		bool			m_failed;
 		bool			m_done;
@@ -166,6 +189,9 @@ private:
 		// true iff we've received the selection notify
 		bool			m_reading;
 
+		// time of the last progress on the conversion
+		double			m_progress;
+
 		// the converted selection data
 		CString*		m_data;
 
@@ -254,6 +280,9 @@ private:
 	void				icccmFillCache();
 	bool				icccmGetSelection(Atom target,
 							Atom* actualTarget, CString* data) const;
+	void				icccmGetSelections(const std::vector<Atom>& targets,
+							std::vector<Atom>& actualTargets,
+							std::vector<CString>& data) const;
 	Time				icccmGetTime() const;
 
 	// motif interoperability methods
@@ -320,6 +349,7 @@ private:
 	Atom				m_atomAtom;
 	Atom				m_atomAtomPair;
 	Atom				m_atomData;
+	std::vector<Atom>	m_atomsData;
 	Atom				m_atomINCR;
 	Atom				m_atomMotifClipLock;
 	Atom				m_atomMotifClipHeader;
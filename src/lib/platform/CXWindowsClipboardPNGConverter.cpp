@@ -0,0 +1,69 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CXWindowsClipboardPNGConverter.h"
+
+//
+// CXWindowsClipboardPNGConverter
+//
+
+CXWindowsClipboardPNGConverter::CXWindowsClipboardPNGConverter(
+				Display* display) :
+	m_atom(XInternAtom(display, "image/png", False))
+{
+	// do nothing
+}
+
+CXWindowsClipboardPNGConverter::~CXWindowsClipboardPNGConverter()
+{
+	// do nothing
+}
+
+IClipboard::EFormat
+CXWindowsClipboardPNGConverter::getFormat() const
+{
+	return IClipboard::kPNG;
+}
+
+Atom
+CXWindowsClipboardPNGConverter::getAtom() const
+{
+	return m_atom;
+}
+
+int
+CXWindowsClipboardPNGConverter::getDataSize() const
+{
+	return 8;
+}
+
+CString
+CXWindowsClipboardPNGConverter::fromIClipboard(const CString& png) const
+{
+	return png;
+}
+
+CString
+CXWindowsClipboardPNGConverter::toIClipboard(const CString& png) const
+{
+	// make sure it's a PNG file
+	static const char s_signature[] = "\x89PNG\r\n\x1a\n";
+	if (png.size() < 8 || png.compare(0, 8, s_signature, 8) != 0) {
+		return CString();
+	}
+	return png;
+}
@@ -0,0 +1,45 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CXWINDOWSCLIPBOARDPNGCONVERTER_H
+#define CXWINDOWSCLIPBOARDPNGCONVERTER_H
+
+#include "CXWindowsClipboard.h"
+
+//! Convert to/from PNG image
+/*!
+PNG data is passed through unchanged.
+*/
+class CXWindowsClipboardPNGConverter :
+				public IXWindowsClipboardConverter {
+public:
+	CXWindowsClipboardPNGConverter(Display* display);
+	virtual ~CXWindowsClipboardPNGConverter();
+
+	// IXWindowsClipboardConverter overrides
+	virtual IClipboard::EFormat
+						getFormat() const;
+	virtual Atom		getAtom() const;
+	virtual int			getDataSize() const;
+	virtual CString		fromIClipboard(const CString&) const;
+	virtual CString		toIClipboard(const CString&) const;
+
+private:
+	Atom				m_atom;
+};
+
+#endif
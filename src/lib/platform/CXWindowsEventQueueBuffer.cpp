@@ -54,13 +54,13 @@ CXWindowsEventQueueBuffer::CXWindowsEventQueueBuffer(
 				Display* display, Window window) :
 	m_display(display),
 	m_window(window),
+	m_preferUser(false),
 	m_waiting(false)
 {
 	assert(m_display != NULL);
 	assert(m_window  != None);
 
-	m_userEvent = XInternAtom(m_display, "SYNERGY_USER_EVENT", False);
-	// set up for pipe hack
+	// set up the pipe that wakes the waiting thread for user events
 	int result = pipe(m_pipefd);
 	assert(result == 0);
 
@@ -73,7 +73,7 @@ CXWindowsEventQueueBuffer::CXWindowsEventQueueBuffer(
 
 CXWindowsEventQueueBuffer::~CXWindowsEventQueueBuffer()
 {
-	// release pipe hack resources
+	// release the wake pipe
 	close(m_pipefd[0]);
 	close(m_pipefd[1]);
 }
@@ -83,33 +83,32 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 {
 	CThread::testCancel();
 
-	// clear out the pipe in preparation for waiting.
-
-	char buf[16];
-	ssize_t read_response = read(m_pipefd[0], buf, 15);
-	
-	// with linux automake, warnings are treated as errors by default
-	if (read_response < 0)
-	{
-		// todo: handle read response
-	}
+	// clear out the pipe in preparation for waiting
+	drainPipe();
 
 	{
 		CLock lock(&m_mutex);
 		// we're now waiting for events
 		m_waiting = true;
 
-		// push out pending events
-		flush();
+		// push out pending requests
+		XFlush(m_display);
 	}
-	// calling flush may have queued up a new event.
+
+	// XFlush() may have queued up a new event and XPending() (in
+	// isEmpty()) reads anything the X server already sent.  either way
+	// xlib has it and the fd won't be readable for it, so don't wait.
+	// user events posted before m_waiting was set are found here too.
 	if (!CXWindowsEventQueueBuffer::isEmpty()) {
+		CLock lock(&m_mutex);
+		m_waiting = false;
 		CThread::testCancel();
 		return;
 	}
 
-	// use poll() to wait for a message from the X server or for timeout.
-	// this is a good deal more efficient than polling and sleeping.
+	// now xlib's queue is empty so an X event can only arrive on the X
+	// connection and a user event comes with a byte on the pipe.  so
+	// block on both until the real timeout.
 #if HAVE_POLL
 	struct pollfd pfds[2];
 	pfds[0].fd     = ConnectionNumber(m_display);
@@ -118,8 +117,7 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 	pfds[1].events = POLLIN;
 	int timeout    = (dtimeout < 0.0) ? -1 :
 						static_cast<int>(1000.0 * dtimeout);
-	int remaining  =  timeout;
-	int retval     =  0;
+	poll(pfds, 2, timeout);
 #else
 	struct timeval timeout;
 	struct timeval* timeoutPtr;
@@ -138,52 +136,20 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 	FD_ZERO(&rfds);
 	FD_SET(ConnectionNumber(m_display), &rfds);
 	FD_SET(m_pipefd[0], &rfds);
- 	int nfds;
- 	if (ConnectionNumber(m_display) > m_pipefd[0]) {
- 		nfds = ConnectionNumber(m_display) + 1;
- 	}
- 	else {
- 		nfds = m_pipefd[0] + 1;
- 	}
-#endif
-	// It's possible that the X server has queued events locally
-	// in xlib's event buffer and not pushed on to the fd. Hence we
-	// can't simply monitor the fd as we may never be woken up.
-	// ie addEvent calls flush, XFlush may not send via the fd hence
-	// there is an event waiting to be sent but we must exit the poll
-	// before it can.
-	// Instead we poll for a brief period of time (so if events
-	// queued locally in the xlib buffer can be processed)
-	// and continue doing this until timeout is reached.
-	// The human eye can notice 60hz (ansi) which is 16ms, however
-	// we want to give the cpu a chance s owe up this to 25ms
-#define TIMEOUT_DELAY 25
-
-	while( ((dtimeout < 0.0) || (remaining > 0)) && QLength(m_display)==0 && retval==0){
-#if HAVE_POLL
-	retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
- 	if (pfds[1].revents & POLLIN) {
- 		ssize_t read_response = read(m_pipefd[0], buf, 15);
-		
-		// with linux automake, warnings are treated as errors by default
-		if (read_response < 0)
-		{
-			// todo: handle read response
-		}
+	int nfds;
+	if (ConnectionNumber(m_display) > m_pipefd[0]) {
+		nfds = ConnectionNumber(m_display) + 1;
+	}
+	else {
+		nfds = m_pipefd[0] + 1;
+	}
 
- 	}
-#else
-	retval = select(nfds,
+	select(nfds,
 						SELECT_TYPE_ARG234 &rfds,
 						SELECT_TYPE_ARG234 NULL,
 						SELECT_TYPE_ARG234 NULL,
-						SELECT_TYPE_ARG5   TIMEOUT_DELAY);
-	if (FD_SET(m_pipefd[0], &rfds)) {
-		read(m_pipefd[0], buf, 15);
-	}
+						SELECT_TYPE_ARG5   timeoutPtr);
 #endif
-	    remaining-=TIMEOUT_DELAY;
-	}
 
 	{
 		// we're no longer waiting for events
@@ -199,56 +165,43 @@ CXWindowsEventQueueBuffer::getEvent(CEvent& event, UInt32& dataID)
 {
 	CLock lock(&m_mutex);
 
-	// push out pending events
-	flush();
-
-	// get next event
-	XNextEvent(m_display, &m_event);
-
-	// process event
-	if (m_event.xany.type == ClientMessage &&
-		m_event.xclient.message_type == m_userEvent) {
-		dataID = static_cast<UInt32>(m_event.xclient.data.l[0]);
+	// take user and X events in turn when both are waiting so neither
+	// can starve the other
+	if (!m_userEvents.empty() &&
+		(m_preferUser || XPending(m_display) == 0)) {
+		m_preferUser = false;
+		dataID       = m_userEvents.front();
+		m_userEvents.pop_front();
 		return kUser;
 	}
-	else {
-		event = CEvent(CEvent::kSystem,
-							IEventQueue::getSystemTarget(), &m_event);
-		return kSystem;
+	m_preferUser = true;
+
+	// don't block if there's nothing at all
+	if (XPending(m_display) == 0) {
+		return kNone;
 	}
+
+	XNextEvent(m_display, &m_event);
+	event = CEvent(CEvent::kSystem,
+							IEventQueue::getSystemTarget(), &m_event);
+	return kSystem;
 }
 
 bool
 CXWindowsEventQueueBuffer::addEvent(UInt32 dataID)
 {
-	// prepare a message
-	XEvent xevent;
-	xevent.xclient.type         = ClientMessage;
-	xevent.xclient.window       = m_window;
-	xevent.xclient.message_type = m_userEvent;
-	xevent.xclient.format       = 32;
-	xevent.xclient.data.l[0]    = static_cast<long>(dataID);
-
-	// save the message
 	CLock lock(&m_mutex);
-	m_postedEvents.push_back(xevent);
+	m_userEvents.push_back(dataID);
 
-	// if we're currently waiting for an event then send saved events to
-	// the X server now.  if we're not waiting then some other thread
-	// might be using the display connection so we can't safely use it
-	// too.
+	// wake the thread waiting on the X connection.  if nobody's waiting
+	// the next waitForEvent() sees the event before it blocks.
 	if (m_waiting) {
-		flush();
-		// Send a character through the round-trip pipe to wake a thread
-		// that is waiting for a ConnectionNumber() socket to be readable.
-		// The flush call can read incoming data from the socket and put
-		// it in Xlib's input buffer.  That sneaks it past the other thread.
 		ssize_t write_response = write(m_pipefd[1], "!", 1);
 
 		// with linux automake, warnings are treated as errors by default
 		if (write_response < 0)
 		{
-			// todo: handle read response
+			// todo: handle write response
 		}
 	}
 
@@ -259,7 +212,7 @@ bool
 CXWindowsEventQueueBuffer::isEmpty() const
 {
 	CLock lock(&m_mutex);
-	return (XPending(m_display) == 0 );
+	return (m_userEvents.empty() && XPending(m_display) == 0);
 }
 
 CEventQueueTimer*
@@ -275,14 +228,12 @@ CXWindowsEventQueueBuffer::deleteTimer(CEventQueueTimer* timer) const
 }
 
 void
-CXWindowsEventQueueBuffer::flush()
+CXWindowsEventQueueBuffer::drainPipe()
 {
-	// note -- m_mutex must be locked on entry
-
-	// flush the posted event list to the X server
-	for (size_t i = 0; i < m_postedEvents.size(); ++i) {
-		XSendEvent(m_display, m_window, False, 0, &m_postedEvents[i]);
+	// the pipe is non-blocking so this stops when it's empty.  the
+	// bytes mean nothing, they only wake a waiting thread.
+	char buf[16];
+	while (read(m_pipefd[0], buf, sizeof(buf)) > 0) {
+		// do nothing
 	}
-	XFlush(m_display);
-	m_postedEvents.clear();
 }
@@ -21,7 +21,7 @@
 
 #include "IEventQueueBuffer.h"
 #include "CMutex.h"
-#include "stdvector.h"
+#include "stddeque.h"
 #if X_DISPLAY_MISSING
 #	error X11 is required to build synergy
 #else
@@ -29,6 +29,12 @@
 #endif
 
 //! Event queue buffer for X11
+/*!
+Real X events come from the X connection but user events stay in the
+process:  they're queued here and a byte on a pipe wakes the thread
+waiting on the X connection, so they never round trip through the X
+server.
+*/
 class CXWindowsEventQueueBuffer : public IEventQueueBuffer {
 public:
 	CXWindowsEventQueueBuffer(Display*, Window);
@@ -44,17 +50,17 @@ public:
 	virtual void		deleteTimer(CEventQueueTimer*) const;
 
 private:
-	void				flush();
+	void				drainPipe();
 
 private:
-	typedef std::vector<XEvent> CEventList;
+	typedef std::deque<UInt32> CUserEventList;
 
 	CMutex				m_mutex;
 	Display*			m_display;
 	Window				m_window;
-	Atom				m_userEvent;
 	XEvent				m_event;
-	CEventList			m_postedEvents;
+	CUserEventList		m_userEvents;
+	bool				m_preferUser;
 	bool				m_waiting;
 	int				m_pipefd[2];
 };
@@ -40,7 +40,8 @@ static const size_t ModifiersFromXDefaultSize = 32;
 
 CXWindowsKeyState::CXWindowsKeyState(Display* display, bool useXKB) :
 	m_display(display),
-	m_modifierFromX(ModifiersFromXDefaultSize)
+	m_modifierFromX(ModifiersFromXDefaultSize),
+	m_flush(true)
 {
 	init(display, useXKB);
 }
@@ -50,7 +51,8 @@ CXWindowsKeyState::CXWindowsKeyState(
 	IEventQueue& eventQueue, CKeyMap& keyMap) :
 	CKeyState(eventQueue, keyMap),
 	m_display(display),
-	m_modifierFromX(ModifiersFromXDefaultSize)
+	m_modifierFromX(ModifiersFromXDefaultSize),
+	m_flush(true)
 {
 	init(display, useXKB);
 }
@@ -104,6 +106,12 @@ CXWindowsKeyState::setAutoRepeat(const XKeyboardState& state)
 	m_keyboardState = state;
 }
 
+void
+CXWindowsKeyState::setFlush(bool flush)
+{
+	m_flush = flush;
+}
+
 KeyModifierMask
 CXWindowsKeyState::mapModifiersFromX(unsigned int state) const
 {
@@ -288,7 +296,9 @@ CXWindowsKeyState::fakeKey(const Keystroke& keystroke)
 		}
 		break;
 	}
-	XFlush(m_display);
+	if (m_flush) {
+		XFlush(m_display);
+	}
 }
 
 void
@@ -72,6 +72,14 @@ public:
 	*/
 	void				setAutoRepeat(const XKeyboardState&);
 
+	//! Set flushing
+	/*!
+	If \p flush is true (the default) then every faked key is flushed to
+	the X server immediately.  Otherwise faked keys are only queued and
+	the caller must flush the display.
+	*/
+	void				setFlush(bool flush);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -157,6 +165,9 @@ private:
 
 	// autorepeat state
 	XKeyboardState		m_keyboardState;
+
+	// true if faked keys are flushed immediately
+	bool				m_flush;
 };
 
 #endif
@@ -27,12 +27,14 @@
 #include "XScreen.h"
 #include "XArch.h"
 #include "CLog.h"
+#include "CLatencyTrace.h"
 #include "CStopwatch.h"
 #include "CStringUtil.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 #if X_DISPLAY_MISSING
 #	error X11 is required to build synergy
 #else
@@ -66,6 +68,9 @@
 #	ifdef HAVE_XI2
 #		include <X11/extensions/XInput2.h>
 #	endif
+#	if HAVE_X11_XLIB_XCB_H
+#		include <X11/Xlib-xcb.h>
+#	endif
 #endif
 #include "CArch.h"
 
@@ -109,7 +114,9 @@ CXWindowsScreen::CXWindowsScreen(const char* displayName, bool isPrimary, bool d
 	m_screensaver(NULL),
 	m_screensaverNotify(false),
 	m_xtestIsXineramaUnaware(true),
+	m_fakeBatch(0),
 	m_preserveFocus(false),
+	m_motionTimer(NULL),
 	m_xkb(false),
 	m_xi2detected(false),
 	m_xrandr(false),
@@ -152,8 +159,8 @@ CXWindowsScreen::CXWindowsScreen(const char* displayName, bool isPrimary, bool d
 
 	// primary/secondary screen only initialization
 	if (m_isPrimary) {
-		// start watching for events on other windows
-		selectEvents(m_root);
+		// XI2 raw motion comes from the root window wherever the pointer
+		// is.  without it we have to watch for motion on every window.
 		m_xi2detected = detectXI2();
 
 		if (m_xi2detected) {
@@ -163,7 +170,9 @@ CXWindowsScreen::CXWindowsScreen(const char* displayName, bool isPrimary, bool d
 		} else
 		{
 			// start watching for events on other windows
+			CStopwatch stopwatch;
 			selectEvents(m_root);
+			LOG((CLOG_DEBUG1 "selected events on all windows in %.3f ms", 1000.0 * stopwatch.getTime()));
 		}
 
 		// prepare to use input methods
@@ -183,6 +192,9 @@ CXWindowsScreen::CXWindowsScreen(const char* displayName, bool isPrimary, bool d
 	m_eventQueue.adoptHandler(CEvent::kSystem, IEventQueue::getSystemTarget(),
 							new TMethodEventJob<CXWindowsScreen>(this,
 								&CXWindowsScreen::handleSystemEvent));
+	m_eventQueue.adoptHandler(CEvent::kTimer, &m_motion,
+							new TMethodEventJob<CXWindowsScreen>(this,
+								&CXWindowsScreen::handleMotionTimer));
 
 	// install the platform event queue
 	m_eventQueue.adoptBuffer(new CXWindowsEventQueueBuffer(m_display, m_window));
@@ -195,6 +207,10 @@ CXWindowsScreen::~CXWindowsScreen()
 
 	m_eventQueue.adoptBuffer(NULL);
 	m_eventQueue.removeHandler(CEvent::kSystem, IEventQueue::getSystemTarget());
+	m_eventQueue.removeHandler(CEvent::kTimer, &m_motion);
+	if (m_motionTimer != NULL) {
+		m_eventQueue.deleteTimer(m_motionTimer);
+	}
 	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 		delete m_clipboard[id];
 	}
@@ -261,6 +277,7 @@ CXWindowsScreen::disable()
 void
 CXWindowsScreen::enter()
 {
+	flushPacedMotion();
 	screensaver(false);
 
 	// release input context focus
@@ -320,6 +337,7 @@ CXWindowsScreen::enter()
 bool
 CXWindowsScreen::leave()
 {
+	flushPacedMotion();
 	if (!m_isPrimary) {
 		// restore the previous keyboard auto-repeat state.  if the user
 		// changed the auto-repeat configuration while on the client then
@@ -440,6 +458,9 @@ CXWindowsScreen::resetOptions()
 {
 	m_xtestIsXineramaUnaware = true;
 	m_preserveFocus = false;
+	flushPacedMotion();
+	m_motion.setRate(0.0);
+	m_motion.setInterpolate(false);
 }
 
 void
@@ -454,6 +475,16 @@ CXWindowsScreen::setOptions(const COptionsList& options)
 			m_preserveFocus = (options[i + 1] != 0);
 			LOG((CLOG_DEBUG1 "Preserve Focus = %s", m_preserveFocus ? "true" : "false"));
 		}
+		else if (options[i] == kOptionMotionRate && !m_isPrimary) {
+			// only faked motion is paced
+			flushPacedMotion();
+			m_motion.setRate(static_cast<double>(options[i + 1]));
+			LOG((CLOG_DEBUG1 "motion rate %d Hz", options[i + 1]));
+		}
+		else if (options[i] == kOptionMotionInterpolate) {
+			m_motion.setInterpolate(options[i + 1] != 0);
+			LOG((CLOG_DEBUG1 "motion interpolate %s", (options[i + 1] != 0) ? "true" : "false"));
+		}
 	}
 }
 
@@ -528,6 +559,9 @@ CXWindowsScreen::reconfigure(UInt32)
 void
 CXWindowsScreen::warpCursor(SInt32 x, SInt32 y)
 {
+	// paced motion is moot after a warp
+	m_motion.reset();
+
 	// warp mouse
 	warpCursorNoFlush(x, y);
 
@@ -817,38 +851,37 @@ CXWindowsScreen::getCursorCenter(SInt32& x, SInt32& y) const
 void
 CXWindowsScreen::fakeMouseButton(ButtonID button, bool press)
 {
+	flushPacedMotion();
 	const unsigned int xButton = mapButtonToX(button);
 	if (xButton != 0) {
 		XTestFakeButtonEvent(m_display, xButton,
 							press ? True : False, CurrentTime);
-		XFlush(m_display);
+		flushFakeInput();
 	}
 }
 
 void
 CXWindowsScreen::fakeMouseMove(SInt32 x, SInt32 y) const
 {
-	if (m_xinerama && m_xtestIsXineramaUnaware) {
-		XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
+	if (m_motion.isEnabled()) {
+		m_motion.move(x, y);
+		schedulePacedMotion();
 	}
 	else {
-		XTestFakeMotionEvent(m_display, DefaultScreen(m_display),
-							x, y, CurrentTime);
+		injectMouseMove(x, y);
 	}
-	XFlush(m_display);
 }
 
 void
 CXWindowsScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
 {
-	// FIXME -- ignore xinerama for now
-	if (false && m_xinerama && m_xtestIsXineramaUnaware) {
-//		XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
+	if (m_motion.isEnabled()) {
+		m_motion.moveRelative(dx, dy);
+		schedulePacedMotion();
 	}
 	else {
-		XTestFakeRelativeMotionEvent(m_display, dx, dy, CurrentTime);
+		injectMouseRelativeMove(dx, dy);
 	}
-	XFlush(m_display);
 }
 
 void
@@ -858,6 +891,7 @@ CXWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
 	if (yDelta == 0) {
 		return;
 	}
+	flushPacedMotion();
 
 	// choose button depending on rotation direction
 	const unsigned int xButton = mapButtonToX(static_cast<ButtonID>(
@@ -894,7 +928,128 @@ CXWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
 		XTestFakeButtonEvent(m_display, xButton, True, CurrentTime);
 		XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
-	XFlush(m_display);
+	flushFakeInput();
+}
+
+void
+CXWindowsScreen::fakeBatchBegin()
+{
+	if (m_fakeBatch++ == 0) {
+		m_keyState->setFlush(false);
+	}
+}
+
+void
+CXWindowsScreen::fakeBatchEnd()
+{
+	assert(m_fakeBatch > 0);
+
+	if (--m_fakeBatch == 0) {
+		m_keyState->setFlush(true);
+		XFlush(m_display);
+	}
+}
+
+void
+CXWindowsScreen::fakeKeyDown(KeyID id, KeyModifierMask mask,
+				KeyButton button)
+{
+	flushPacedMotion();
+	CPlatformScreen::fakeKeyDown(id, mask, button);
+}
+
+bool
+CXWindowsScreen::fakeKeyRepeat(KeyID id, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	flushPacedMotion();
+	return CPlatformScreen::fakeKeyRepeat(id, mask, count, button);
+}
+
+bool
+CXWindowsScreen::fakeKeyUp(KeyButton button)
+{
+	flushPacedMotion();
+	return CPlatformScreen::fakeKeyUp(button);
+}
+
+void
+CXWindowsScreen::flushFakeInput() const
+{
+	if (m_fakeBatch == 0) {
+		XFlush(m_display);
+	}
+}
+
+void
+CXWindowsScreen::injectMouseMove(SInt32 x, SInt32 y) const
+{
+	if (m_xinerama && m_xtestIsXineramaUnaware) {
+		XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
+	}
+	else {
+		XTestFakeMotionEvent(m_display, DefaultScreen(m_display),
+							x, y, CurrentTime);
+	}
+	flushFakeInput();
+	CLatencyTrace::mark(CLatencyTrace::kInject);
+}
+
+void
+CXWindowsScreen::injectMouseRelativeMove(SInt32 dx, SInt32 dy) const
+{
+	// FIXME -- ignore xinerama for now
+	if (false && m_xinerama && m_xtestIsXineramaUnaware) {
+//		XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
+	}
+	else {
+		XTestFakeRelativeMotionEvent(m_display, dx, dy, CurrentTime);
+	}
+	flushFakeInput();
+}
+
+void
+CXWindowsScreen::injectMotion(const CMotionScheduler::CMotion& motion) const
+{
+	if (motion.m_absolute) {
+		injectMouseMove(motion.m_x, motion.m_y);
+	}
+	else {
+		injectMouseRelativeMove(motion.m_x, motion.m_y);
+	}
+}
+
+void
+CXWindowsScreen::schedulePacedMotion() const
+{
+	const double now = ARCH->time();
+	CMotionScheduler::CMotion motion;
+	if (m_motion.next(now, motion)) {
+		injectMotion(motion);
+	}
+
+	// the rest waits for the next frame
+	if (m_motion.hasPending() && m_motionTimer == NULL) {
+		m_motionTimer = m_eventQueue.newOneShotTimer(
+								m_motion.getDelay(now), &m_motion);
+	}
+}
+
+void
+CXWindowsScreen::flushPacedMotion() const
+{
+	CMotionScheduler::CMotion motion;
+	if (m_motion.flush(ARCH->time(), motion)) {
+		injectMotion(motion);
+	}
+}
+
+void
+CXWindowsScreen::handleMotionTimer(const CEvent&, void*)
+{
+	m_eventQueue.deleteTimer(m_motionTimer);
+	m_motionTimer = NULL;
+	schedulePacedMotion();
 }
 
 Display*
@@ -1263,8 +1418,12 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 				cookie->type == GenericEvent &&
 				cookie->extension == xi_opcode) {
 			if (cookie->evtype == XI_RawMotion) {
+				// the pointer is wherever the last of a burst of raw
+				// motions left it so only ask once
+				XFreeEventData(m_display, cookie);
+				skipRawMotion();
+
 				// Get current pointer's position
-				Window root, child;
 				XMotionEvent xmotion;
 				xmotion.type = MotionNotify;
 				xmotion.send_event = False; // Raw motion
@@ -1280,7 +1439,6 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 						&xmotion.y,
 						&msk);
 					onMouseMove(xmotion);
-					XFreeEventData(m_display, cookie);
 					return;
 			}
         		XFreeEventData(m_display, cookie);
@@ -1291,7 +1449,7 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 	// handle the event ourself
 	switch (xevent->type) {
 	case CreateNotify:
-		if (m_isPrimary) {
+		if (m_isPrimary && !m_xi2detected) {
 			// select events on new window
 			selectEvents(xevent->xcreatewindow.window);
 		}
@@ -1393,7 +1551,9 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 
 	case MotionNotify:
 		if (m_isPrimary) {
-			onMouseMove(xevent->xmotion);
+			XMotionEvent xmotion = xevent->xmotion;
+			coalesceMotion(xmotion);
+			onMouseMove(xmotion);
 		}
 		return;
 
@@ -1583,6 +1743,7 @@ void
 CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 {
 	LOG((CLOG_DEBUG2 "event: MotionNotify %d,%d", xmotion.x_root, xmotion.y_root));
+	CLatencyTrace::begin(CLatencyTrace::kCapture);
 
 	// compute motion delta (relative to the last known
 	// mouse position)
@@ -1648,6 +1809,36 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 	}
 }
 
+void
+CXWindowsScreen::coalesceMotion(XMotionEvent& xmotion)
+{
+	// a sent motion marks the end of a warp;  onMouseMove() needs it
+	if (xmotion.send_event) {
+		return;
+	}
+
+	// only the latest position matters, on the primary screen and
+	// (since deltas are taken from the last position) off it.  stop at
+	// anything else, including a warp marker, so buttons and keys
+	// still happen where they did.
+	UInt32 n = 0;
+	XEvent xevent;
+	while (XEventsQueued(m_display, QueuedAfterReading) > 0) {
+		XPeekEvent(m_display, &xevent);
+		if (xevent.type != MotionNotify ||
+			xevent.xmotion.send_event ||
+			xevent.xmotion.window != xmotion.window) {
+			break;
+		}
+		XNextEvent(m_display, &xevent);
+		xmotion = xevent.xmotion;
+		++n;
+	}
+	if (n > 0) {
+		LOG((CLOG_DEBUG2 "coalesced %d motion events", n));
+	}
+}
+
 Cursor
 CXWindowsScreen::createBlankCursor() const
 {
@@ -1788,25 +1979,70 @@ CXWindowsScreen::doSelectEvents(Window w) const
 	// that already do or are top-level windows or don't propagate
 	// pointer events.  or maybe an option to simply poll the mouse.
 
-	// we don't want to adjust our grab window
-	if (w == m_window) {
-		return;
-	}
+	// walk the tree a level at a time so the queries for a whole level
+	// can go out together.
+	CWindowList windows(1, w);
+	CWindowList children;
+	while (!windows.empty()) {
+		// we don't want to adjust our grab window
+		windows.erase(std::remove(windows.begin(), windows.end(), m_window),
+							windows.end());
+
+		// select events of interest.  do this before querying the tree
+		// so we'll get notifications of children created after the
+		// query so we won't miss them.
+		for (CWindowList::const_iterator i = windows.begin();
+								i != windows.end(); ++i) {
+			XSelectInput(m_display, *i,
+							PointerMotionMask | SubstructureNotifyMask);
+		}
 
-	// select events of interest.  do this before querying the tree so
-	// we'll get notifications of children created after the XQueryTree()
-	// so we won't miss them.
-	XSelectInput(m_display, w, PointerMotionMask | SubstructureNotifyMask);
+		// move on to the children
+		children.clear();
+		getChildren(windows, children);
+		windows.swap(children);
+	}
+}
 
-	// recurse on child windows
-	Window rw, pw, *cw;
-	unsigned int nc;
-	if (XQueryTree(m_display, w, &rw, &pw, &cw, &nc)) {
-		for (unsigned int i = 0; i < nc; ++i) {
-			doSelectEvents(cw[i]);
+void
+CXWindowsScreen::getChildren(const CWindowList& windows,
+				CWindowList& children) const
+{
+#if HAVE_X11_XLIB_XCB_H
+	// XQueryTree() waits for each reply.  xcb lets us send every query
+	// first and then collect the replies so the level costs one round
+	// trip instead of one per window.  windows destroyed since we found
+	// them just return an error.
+	xcb_connection_t* xcb = XGetXCBConnection(m_display);
+	std::vector<xcb_query_tree_cookie_t> cookies;
+	cookies.reserve(windows.size());
+	for (CWindowList::const_iterator i = windows.begin();
+								i != windows.end(); ++i) {
+		cookies.push_back(xcb_query_tree(xcb, static_cast<xcb_window_t>(*i)));
+	}
+	for (size_t i = 0; i < cookies.size(); ++i) {
+		xcb_generic_error_t* error = NULL;
+		xcb_query_tree_reply_t* reply =
+			xcb_query_tree_reply(xcb, cookies[i], &error);
+		if (reply != NULL) {
+			const xcb_window_t* cw = xcb_query_tree_children(reply);
+			int nc = xcb_query_tree_children_length(reply);
+			children.insert(children.end(), cw, cw + nc);
+			free(reply);
 		}
-		XFree(cw);
+		free(error);
 	}
+#else
+	for (CWindowList::const_iterator i = windows.begin();
+								i != windows.end(); ++i) {
+		Window rw, pw, *cw;
+		unsigned int nc;
+		if (XQueryTree(m_display, *i, &rw, &pw, &cw, &nc)) {
+			children.insert(children.end(), cw, cw + nc);
+			XFree(cw);
+		}
+	}
+#endif
 }
 
 KeyID
@@ -2068,9 +2304,20 @@ CXWindowsScreen::CHotKeyItem::operator<(const CHotKeyItem& x) const
 bool
 CXWindowsScreen::detectXI2()
 {
+#ifdef HAVE_XI2
 	int event, error;
-	return XQueryExtension(m_display,
-			"XInputExtension", &xi_opcode, &event, &error);
+	if (!XQueryExtension(m_display,
+			"XInputExtension", &xi_opcode, &event, &error)) {
+		return false;
+	}
+
+	// the server may only have XInput 1
+	int major = 2, minor = 0;
+	return (XIQueryVersion(m_display, &major, &minor) == Success);
+#else
+	// without XI2 support we can't use raw motion
+	return false;
+#endif
 }
 
 #ifdef HAVE_XI2
@@ -2089,4 +2336,26 @@ CXWindowsScreen::selectXIRawMotion()
 	XISelectEvents(m_display, DefaultRootWindow(m_display), &mask, 1);
 	free(mask.mask);
 }
+
+UInt32
+CXWindowsScreen::skipRawMotion()
+{
+	// the event type is in the cookie without fetching its data
+	UInt32 n = 0;
+	XEvent xevent;
+	while (XEventsQueued(m_display, QueuedAfterReading) > 0) {
+		XPeekEvent(m_display, &xevent);
+		if (xevent.xcookie.type != GenericEvent ||
+			xevent.xcookie.extension != xi_opcode ||
+			xevent.xcookie.evtype != XI_RawMotion) {
+			break;
+		}
+		XNextEvent(m_display, &xevent);
+		++n;
+	}
+	if (n > 0) {
+		LOG((CLOG_DEBUG2 "coalesced %d raw motion events", n));
+	}
+	return n;
+}
 #endif
@@ -28,7 +28,9 @@
 #	include <X11/Xlib.h>
 #endif
 #include "CKeyMap.h"
+#include "CMotionScheduler.h"
 
+class CEventQueueTimer;
 class CXWindowsClipboard;
 class CXWindowsKeyState;
 class CXWindowsScreenSaver;
@@ -68,11 +70,20 @@ public:
 	virtual void		fakeMouseMove(SInt32 x, SInt32 y) const;
 	virtual void		fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const;
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const;
+	virtual void		fakeBatchBegin();
+	virtual void		fakeBatchEnd();
 	virtual void		fakeGameDeviceButtons(GameDeviceID id, GameDeviceButton buttons) const { }
 	virtual void		fakeGameDeviceSticks(GameDeviceID id, SInt16 x1, SInt16 y1, SInt16 x2, SInt16 y2) const { }
 	virtual void		fakeGameDeviceTriggers(GameDeviceID id, UInt8 t1, UInt8 t2) const { }
 	virtual void		queueGameDeviceTimingReq() const { }
 
+	// IKeyState overrides
+	virtual void		fakeKeyDown(KeyID id, KeyModifierMask mask,
+							KeyButton button);
+	virtual bool		fakeKeyRepeat(KeyID id, KeyModifierMask mask,
+							SInt32 count, KeyButton button);
+	virtual bool		fakeKeyUp(KeyButton button);
+
 	// IPlatformScreen overrides
 	virtual void		enable();
 	virtual void		disable();
@@ -140,12 +151,24 @@ private:
 	void				onMouseRelease(const XButtonEvent&);
 	void				onMouseMove(const XMotionEvent&);
 
+	// replace a motion event with the last of the plain motion events
+	// queued right behind it and discard the rest
+	void				coalesceMotion(XMotionEvent&);
+
 	bool				detectXI2();
 #ifdef HAVE_XI2
 	void				selectXIRawMotion();
+
+	// discard raw motion events queued right behind the current one
+	UInt32				skipRawMotion();
 #endif
 	void				selectEvents(Window) const;
 	void				doSelectEvents(Window) const;
+
+	// append the children of all of \p windows to \p children
+	typedef std::vector<Window> CWindowList;
+	void				getChildren(const CWindowList& windows,
+							CWindowList& children) const;
 
 	KeyID				mapKeyFromX(XKeyEvent*) const;
 	ButtonID			mapButtonFromX(const XButtonEvent*) const;
@@ -153,6 +176,23 @@ private:
 
 	void				warpCursorNoFlush(SInt32 x, SInt32 y);
 
+	// flush faked input unless batching
+	void				flushFakeInput() const;
+
+	// fake mouse motion right away
+	void				injectMouseMove(SInt32 x, SInt32 y) const;
+	void				injectMouseRelativeMove(SInt32 dx, SInt32 dy) const;
+	void				injectMotion(const CMotionScheduler::CMotion&) const;
+
+	// fake paced mouse motion that's due and set a timer for the rest
+	void				schedulePacedMotion() const;
+
+	// fake all paced mouse motion now.  call before faking input that
+	// must come after the motion.
+	void				flushPacedMotion() const;
+
+	void				handleMotionTimer(const CEvent&, void*);
+
 	void				refreshKeyboard(XEvent*);
 
 	static Bool			findKeyEvent(Display*, XEvent* xevent, XPointer arg);
@@ -233,10 +273,19 @@ private:
 	bool				m_xtestIsXineramaUnaware;
 	bool				m_xinerama;
 
+	// nesting depth of batches of faked input.  faked input is only
+	// flushed to the X server at the end of the outermost batch.
+	UInt32				m_fakeBatch;
+
 	// stuff to work around lost focus issues on certain systems
 	// (ie: a MythTV front-end).
 	bool				m_preserveFocus;
 
+	// paces faked mouse motion to the display's refresh rate.  the
+	// timer is set while paced motion is waiting for the next frame.
+	mutable CMotionScheduler	m_motion;
+	mutable CEventQueueTimer*	m_motionTimer;
+
 	// XKB extension stuff
 	bool				m_xkb;
 	int					m_xkbEventBase;
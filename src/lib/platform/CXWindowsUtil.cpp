@@ -1305,46 +1305,35 @@ CXWindowsUtil::getWindowProperty(Display* display, Window window,
 
 	// read the property
 	bool okay = true;
-	const long length = XMaxRequestSize(display);
+	long length = XMaxRequestSize(display);
 	long offset = 0;
 	unsigned long bytesLeft = 1;
 	while (bytesLeft != 0) {
 		// get more data
-		unsigned long numItems;
 		unsigned char* rawData;
-		if (XGetWindowProperty(display, window, property,
-								offset, length, False, AnyPropertyType,
-								&actualType, &actualDatumSize,
-								&numItems, &bytesLeft, &rawData) != Success ||
-			actualType == None || actualDatumSize == 0) {
+		unsigned long numBytes;
+		if (!readWindowProperty(display, window, property, offset, length,
+								&rawData, &numBytes, &bytesLeft,
+								&actualType, &actualDatumSize)) {
 			// failed
 			okay = false;
 			break;
 		}
 
-		// compute bytes read and advance offset
-		unsigned long numBytes;
-		switch (actualDatumSize) {
-		case 8:
-		default:
-			numBytes = numItems;
-			offset  += numItems / 4;
-			break;
-
-		case 16:
-			numBytes = 2 * numItems;
-			offset  += numItems / 2;
-			break;
-
-		case 32:
-			numBytes = 4 * numItems;
-			offset  += numItems;
-			break;
-		}
-
 		// append data
 		if (data != NULL) {
-			data->append((char*)rawData, numBytes);
+			// the first read tells us how big the property is.  make
+			// room for all of it and read the rest in one more request
+			// rather than growing the string chunk by chunk.
+			if (offset == 0 && bytesLeft != 0) {
+				const CString::size_type needed =
+								data->size() + numBytes + bytesLeft;
+				if (data->capacity() < needed) {
+					data->reserve(needed);
+				}
+				length = static_cast<long>((bytesLeft + 3) / 4);
+			}
+			data->append(reinterpret_cast<char*>(rawData), numBytes);
 		}
 		else {
 			// data is not required so don't try to get any more
@@ -1353,6 +1342,9 @@ CXWindowsUtil::getWindowProperty(Display* display, Window window,
 
 		// done with returned data
 		XFree(rawData);
+
+		// advance offset
+		offset += static_cast<long>(numBytes / 4);
 	}
 
 	// delete the property if requested
@@ -1378,6 +1370,102 @@ CXWindowsUtil::getWindowProperty(Display* display, Window window,
 	}
 }
 
+bool
+CXWindowsUtil::getWindowProperty(Display* display, Window window,
+				Atom property, CPropertyData& data, Atom* type,
+				SInt32* format, bool deleteProperty)
+{
+	assert(display != NULL);
+
+	Atom actualType;
+	int actualDatumSize;
+
+	// ignore errors.  XGetWindowProperty() will report failure.
+	CXWindowsUtil::CErrorLock lock(display);
+
+	// read the property.  if it didn't fit in one request then read
+	// the whole thing again in one request big enough for all of it so
+	// we end up with a single buffer.
+	bool okay = true;
+	long length = XMaxRequestSize(display);
+	for (;;) {
+		unsigned char* rawData;
+		unsigned long numBytes;
+		unsigned long bytesLeft;
+		if (!readWindowProperty(display, window, property, 0, length,
+								&rawData, &numBytes, &bytesLeft,
+								&actualType, &actualDatumSize)) {
+			// failed
+			data.adopt(NULL, 0);
+			okay = false;
+			break;
+		}
+		data.adopt(rawData, static_cast<UInt32>(numBytes));
+		if (bytesLeft == 0) {
+			break;
+		}
+		length = static_cast<long>((numBytes + bytesLeft + 3) / 4);
+	}
+
+	// delete the property if requested
+	if (deleteProperty) {
+		XDeleteProperty(display, window, property);
+	}
+
+	// save property info
+	if (type != NULL) {
+		*type = actualType;
+	}
+	if (format != NULL) {
+		*format = static_cast<SInt32>(actualDatumSize);
+	}
+
+	if (okay) {
+		LOG((CLOG_DEBUG2 "read property %d on window 0x%08x: bytes=%d", property, window, data.size()));
+		return true;
+	}
+	else {
+		LOG((CLOG_DEBUG2 "can't read property %d on window 0x%08x", property, window));
+		return false;
+	}
+}
+
+bool
+CXWindowsUtil::readWindowProperty(Display* display, Window window,
+				Atom property, long offset, long length,
+				unsigned char** rawData, unsigned long* numBytes,
+				unsigned long* bytesLeft, Atom* type, int* format)
+{
+	unsigned long numItems;
+	if (XGetWindowProperty(display, window, property,
+								offset, length, False, AnyPropertyType,
+								type, format,
+								&numItems, bytesLeft, rawData) != Success) {
+		return false;
+	}
+	if (*type == None || *format == 0) {
+		XFree(*rawData);
+		return false;
+	}
+
+	// compute bytes read
+	switch (*format) {
+	case 8:
+	default:
+		*numBytes = numItems;
+		break;
+
+	case 16:
+		*numBytes = 2 * numItems;
+		break;
+
+	case 32:
+		*numBytes = 4 * numItems;
+		break;
+	}
+	return true;
+}
+
 bool
 CXWindowsUtil::setWindowProperty(Display* display, Window window,
 				Atom property, const void* vdata, UInt32 size,
@@ -1782,3 +1870,42 @@ CXWindowsUtil::CErrorLock::saveHandler(Display*, XErrorEvent* e, void* flag)
 	LOG((CLOG_DEBUG1 "flagging X error: %d", e->error_code));
 	*reinterpret_cast<bool*>(flag) = true;
 }
+
+
+//
+// CXWindowsUtil::CPropertyData
+//
+
+CXWindowsUtil::CPropertyData::CPropertyData() :
+	m_data(NULL),
+	m_size(0)
+{
+	// do nothing
+}
+
+CXWindowsUtil::CPropertyData::~CPropertyData()
+{
+	adopt(NULL, 0);
+}
+
+const char*
+CXWindowsUtil::CPropertyData::data() const
+{
+	return reinterpret_cast<const char*>(m_data);
+}
+
+UInt32
+CXWindowsUtil::CPropertyData::size() const
+{
+	return m_size;
+}
+
+void
+CXWindowsUtil::CPropertyData::adopt(unsigned char* data, UInt32 size)
+{
+	if (m_data != NULL) {
+		XFree(m_data);
+	}
+	m_data = data;
+	m_size = size;
+}
@@ -33,6 +33,7 @@
 class CXWindowsUtil {
 public:
 	typedef std::vector<KeySym> KeySyms;
+	class CPropertyData;
 
 	//! Get property
 	/*!
@@ -47,6 +48,17 @@ public:
 							CString* data, Atom* type,
 							SInt32* format, bool deleteProperty);
 
+	//! Get property without copying
+	/*!
+	Same as getWindowProperty() above except it \b replaces \c data
+	with the property data and leaves it in the buffer Xlib read it
+	into.  Use this to look at a property without copying it.
+	*/
+	static bool			getWindowProperty(Display*,
+							Window window, Atom property,
+							CPropertyData& data, Atom* type,
+							SInt32* format, bool deleteProperty);
+
 	//! Set property
 	/*!
 	Sets property \c property on \c window to \c size bytes of data from
@@ -168,6 +180,44 @@ public:
 		static CErrorLock*	s_top;
 	};
 
+	//! X11 property data
+	/*!
+	Holds property data in the buffer Xlib returned it in and frees the
+	buffer in the d'tor.  The data is the same bytes getWindowProperty()
+	would append to a CString.
+	*/
+	class CPropertyData {
+	public:
+		CPropertyData();
+		~CPropertyData();
+
+		//! Get data
+		/*!
+		Returns the property data or NULL if there is none.
+		*/
+		const char*		data() const;
+
+		//! Get size
+		/*!
+		Returns the size of the property data in bytes.
+		*/
+		UInt32			size() const;
+
+	private:
+		friend class CXWindowsUtil;
+
+		// free the current buffer and take ownership of \c data
+		void			adopt(unsigned char* data, UInt32 size);
+
+		// not implemented
+		CPropertyData(const CPropertyData&);
+		CPropertyData&	operator=(const CPropertyData&);
+
+	private:
+		unsigned char*	m_data;
+		UInt32			m_size;
+	};
+
 private:
 	class CPropertyNotifyPredicateInfo {
 	public:
@@ -178,6 +228,17 @@ private:
 	static Bool			propertyNotifyPredicate(Display*,
 							XEvent* xevent, XPointer arg);
 
+	// read up to \c length 32-bit units of a property starting at
+	// \c offset 32-bit units.  on success \c *rawData must be freed
+	// with XFree() and \c *numBytes is the number of bytes read.
+	static bool			readWindowProperty(Display*,
+							Window window, Atom property,
+							long offset, long length,
+							unsigned char** rawData,
+							unsigned long* numBytes,
+							unsigned long* bytesLeft,
+							Atom* type, int* format);
+
 	static void			initKeyMaps();
 
 private:
@@ -54,3 +54,21 @@ CBaseClientProxy::getName() const
 {
 	return m_name;
 }
+
+void
+CBaseClientProxy::resumeClipboard(ClipboardID, const CString&)
+{
+	// do nothing
+}
+
+bool
+CBaseClientProxy::getSession(CClientSession&) const
+{
+	return false;
+}
+
+bool
+CBaseClientProxy::isSessionResumed() const
+{
+	return false;
+}
@@ -22,6 +22,8 @@
 #include "IClient.h"
 #include "CString.h"
 
+class CClientSession;
+
 //! Generic proxy for client or primary
 class CBaseClientProxy : public IClient {
 public:
@@ -40,6 +42,14 @@ public:
 	*/
 	void				setJumpCursorPos(SInt32 x, SInt32 y);
 
+	//! Resume clipboard
+	/*!
+	Tells the proxy of a client that resumed its session that the
+	client already has clipboard \p id with data hash \p hash so
+	it needn't be sent again.  The default does nothing.
+	*/
+	virtual void		resumeClipboard(ClipboardID id, const CString& hash);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -50,6 +60,22 @@ public:
 	*/
 	void				getJumpCursorPos(SInt32& x, SInt32& y) const;
 
+	//! Get session
+	/*!
+	Fills in \p session with the state needed to resume the client's
+	session if it reconnects and returns true.  Returns false if the
+	client can't resume sessions, which is the default.
+	*/
+	virtual bool		getSession(CClientSession& session) const;
+
+	//! Test if session was resumed
+	/*!
+	Returns true if the client resumed its previous session when it
+	connected.  getSession() then returns the resumed session.  The
+	default returns false.
+	*/
+	virtual bool		isSessionResumed() const;
+
 	//@}
 
 	// IScreen
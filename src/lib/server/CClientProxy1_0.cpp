@@ -17,10 +17,12 @@
  */
 
 #include "CClientProxy1_0.h"
+#include "CPNGDecoder.h"
 #include "CProtocolUtil.h"
 #include "XSynergy.h"
 #include "IStream.h"
 #include "CLog.h"
+#include "CLatencyTrace.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
 #include <cstring>
@@ -32,7 +34,9 @@
 CClientProxy1_0::CClientProxy1_0(const CString& name, synergy::IStream* stream) :
 	CClientProxy(name, stream),
 	m_heartbeatTimer(NULL),
-	m_parser(&CClientProxy1_0::parseHandshakeMessage)
+	m_parser(&CClientProxy1_0::parseHandshakeMessage),
+	m_packet(NULL),
+	m_packetSize(0)
 {
 	// install event handlers
 	EVENTQUEUE->adoptHandler(stream->getInputReadyEvent(),
@@ -55,6 +59,10 @@ CClientProxy1_0::CClientProxy1_0(const CString& name, synergy::IStream* stream)
 							new TMethodEventJob<CClientProxy1_0>(this,
 								&CClientProxy1_0::handleFlatline, NULL));
 
+	// count the messages to and from the client
+	m_metrics.setName("client." + name);
+	stream->setMetrics(&m_metrics);
+
 	setHeartbeatRate(kHeartRate, kHeartRate * kHeartBeatsUntilDeath);
 
 	LOG((CLOG_DEBUG1 "querying client \"%s\" info", getName().c_str()));
@@ -64,6 +72,7 @@ CClientProxy1_0::CClientProxy1_0(const CString& name, synergy::IStream* stream)
 CClientProxy1_0::~CClientProxy1_0()
 {
 	removeHandlers();
+	getStream()->setMetrics(NULL);
 }
 
 void
@@ -132,10 +141,29 @@ CClientProxy1_0::setHeartbeatRate(double, double alarm)
 void
 CClientProxy1_0::handleData(const CEvent&, void*)
 {
-	// handle messages until there are no more.  first read message code.
-	UInt8 code[4];
-	UInt32 n = getStream()->read(code, 4);
-	while (n != 0) {
+	// handle messages until there are no more
+	for (;;) {
+		// first get the message code.  parse whole packets in place if
+		// the stream will lend them to us, otherwise read the stream.
+		UInt8 buffer[4];
+		const UInt8* code;
+		UInt32 n;
+		m_packet = reinterpret_cast<const UInt8*>(
+							getStream()->borrowPacket(m_packetSize));
+		if (m_packet != NULL) {
+			n             = (m_packetSize < 4) ? m_packetSize : 4;
+			code          = m_packet;
+			m_packet     += n;
+			m_packetSize -= n;
+		}
+		else {
+			n    = getStream()->read(buffer, 4);
+			code = buffer;
+			if (n == 0) {
+				break;
+			}
+		}
+
 		// verify we got an entire code
 		if (n != 4) {
 			LOG((CLOG_ERR "incomplete message from \"%s\": %d bytes", getName().c_str(), n));
@@ -150,9 +178,6 @@ CClientProxy1_0::handleData(const CEvent&, void*)
 			disconnect();
 			return;
 		}
-
-		// next message
-		n = getStream()->read(code, 4);
 	}
 
 	// restart heartbeat timer
@@ -168,17 +193,57 @@ CClientProxy1_0::parseHandshakeMessage(const UInt8* code)
 		return true;
 	}
 	else if (memcmp(code, kMsgDInfo, 4) == 0) {
-		// future messages get parsed by parseMessage
-		m_parser = &CClientProxy1_0::parseMessage;
 		if (recvInfo()) {
-			EVENTQUEUE->addEvent(CEvent(getReadyEvent(), getEventTarget()));
-			addHeartbeatTimer();
+			handshakeComplete();
 			return true;
 		}
 	}
 	return false;
 }
 
+void
+CClientProxy1_0::handshakeComplete()
+{
+	// future messages get parsed by parseMessage
+	m_parser = &CClientProxy1_0::parseMessage;
+	EVENTQUEUE->addEvent(CEvent(getReadyEvent(), getEventTarget()));
+	addHeartbeatTimer();
+}
+
+void
+CClientProxy1_0::setInfo(const CClientInfo& info)
+{
+	m_info = info;
+}
+
+bool
+CClientProxy1_0::isClipboardDirty(ClipboardID id) const
+{
+	return m_clipboard[id].m_dirty;
+}
+
+bool
+CClientProxy1_0::readf(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result;
+	if (m_packet != NULL) {
+		result = CProtocolUtil::vreadf(m_packet, m_packetSize, fmt, args);
+	}
+	else {
+		result = CProtocolUtil::vreadf(getStream(), fmt, args);
+	}
+	va_end(args);
+	return result;
+}
+
+CMetrics::CConnection&
+CClientProxy1_0::getMetrics()
+{
+	return m_metrics;
+}
+
 bool
 CClientProxy1_0::parseMessage(const UInt8* code)
 {
@@ -278,12 +343,41 @@ CClientProxy1_0::setClipboard(ClipboardID id, const IClipboard* clipboard)
 		m_clipboard[id].m_dirty = false;
 		CClipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
 
-		CString data = m_clipboard[id].m_clipboard.marshall();
+		// the copy shares the source's data so this only builds a new
+		// buffer if the source hasn't been marshalled yet
+		CClipboardBlob data = marshallClipboard(m_clipboard[id].m_clipboard);
 		LOG((CLOG_DEBUG "send clipboard %d to \"%s\" size=%d", id, getName().c_str(), data.size()));
-		CProtocolUtil::writef(getStream(), kMsgDClipboard, id, 0, &data);
+		CProtocolUtil::writef(getStream(), kMsgDClipboardBytes, id, 0,
+								data.size(),
+								reinterpret_cast<const UInt8*>(data.data()));
+		m_metrics.addClipboardSent(data.size());
 	}
 }
 
+CClipboardBlob
+CClientProxy1_0::marshallClipboard(const CClipboard& clipboard) const
+{
+	clipboard.open(0);
+	bool png = clipboard.has(IClipboard::kPNG);
+	clipboard.close();
+	if (!png) {
+		return clipboard.marshallBlob();
+	}
+
+	// the client would ignore the PNG so send it a bitmap instead.
+	// every proxy's clipboard shares the server's PNG so it's only
+	// decoded once per change, and only if an old client needs it.
+	CClipboard legacy;
+	CClipboard::copy(&legacy, &clipboard);
+	legacy.open(0);
+	if (CPNGDecoder::addBitmap(&legacy)) {
+		LOG((CLOG_DEBUG "converted PNG clipboard to a bitmap for \"%s\"", getName().c_str()));
+	}
+	legacy.remove(IClipboard::kPNG);
+	legacy.close();
+	return legacy.marshallBlob();
+}
+
 void
 CClientProxy1_0::grabClipboard(ClipboardID id)
 {
@@ -340,6 +434,7 @@ void
 CClientProxy1_0::mouseMove(SInt32 xAbs, SInt32 yAbs)
 {
 	LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+	CLatencyTrace::mark(CLatencyTrace::kEncode);
 	CProtocolUtil::writef(getStream(), kMsgDMouseMove, xAbs, yAbs);
 }
 
@@ -409,7 +504,12 @@ CClientProxy1_0::setOptions(const COptionsList& options)
 {
 	LOG((CLOG_DEBUG1 "send set options to \"%s\" size=%d", getName().c_str(), options.size()));
 	CProtocolUtil::writef(getStream(), kMsgDSetOptions, &options);
+	applyOptions(options);
+}
 
+void
+CClientProxy1_0::applyOptions(const COptionsList& options)
+{
 	// check options
 	for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
 		if (options[i] == kOptionHeartbeat) {
@@ -429,7 +529,7 @@ CClientProxy1_0::recvInfo()
 {
 	// parse the message
 	SInt16 x, y, w, h, dummy1, mx, my;
-	if (!CProtocolUtil::readf(getStream(), kMsgDInfo + 4,
+	if (!readf(kMsgDInfo + 4,
 							&x, &y, &w, &h, &dummy1, &mx, &my)) {
 		return false;
 	}
@@ -465,11 +565,11 @@ CClientProxy1_0::recvClipboard()
 	ClipboardID id;
 	UInt32 seqNum;
 	CString data;
-	if (!CProtocolUtil::readf(getStream(),
-							kMsgDClipboard + 4, &id, &seqNum, &data)) {
+	if (!readf(kMsgDClipboard + 4, &id, &seqNum, &data)) {
 		return false;
 	}
 	LOG((CLOG_DEBUG "received client \"%s\" clipboard %d seqnum=%d, size=%d", getName().c_str(), id, seqNum, data.size()));
+	m_metrics.addClipboardReceived(static_cast<UInt32>(data.size()));
 
 	// validate
 	if (id >= kClipboardEnd) {
@@ -477,7 +577,7 @@ CClientProxy1_0::recvClipboard()
 	}
 
 	// save clipboard
-	m_clipboard[id].m_clipboard.unmarshall(data, 0);
+	m_clipboard[id].m_clipboard.unmarshall(CClipboardBlob::adopt(data), 0);
 	m_clipboard[id].m_sequenceNumber = seqNum;
 
 	// notify
@@ -496,7 +596,7 @@ CClientProxy1_0::recvGrabClipboard()
 	// parse message
 	ClipboardID id;
 	UInt32 seqNum;
-	if (!CProtocolUtil::readf(getStream(), kMsgCClipboard + 4, &id, &seqNum)) {
+	if (!readf(kMsgCClipboard + 4, &id, &seqNum)) {
 		return false;
 	}
 	LOG((CLOG_DEBUG "received client \"%s\" grabbed clipboard %d seqnum=%d", getName().c_str(), id, seqNum));
@@ -22,6 +22,7 @@
 #include "CClientProxy.h"
 #include "CClipboard.h"
 #include "ProtocolTypes.h"
+#include "CMetrics.h"
 
 class CEvent;
 class CEventQueueTimer;
@@ -73,6 +74,46 @@ protected:
 	virtual void		addHeartbeatTimer();
 	virtual void		removeHeartbeatTimer();
 
+	//! Finish the handshake
+	/*!
+	Starts parsing messages normally and sends the ready event.
+	*/
+	void				handshakeComplete();
+
+	//! Set client info
+	/*!
+	Sets the client info without querying the client.
+	*/
+	void				setInfo(const CClientInfo& info);
+
+	//! Apply options
+	/*!
+	Applies the options that affect the proxy, without sending them
+	to the client.
+	*/
+	void				applyOptions(const COptionsList& options);
+
+	//! Test if clipboard is dirty
+	bool				isClipboardDirty(ClipboardID) const;
+
+	//! Read message
+	/*!
+	Reads the rest of the message being parsed.  See
+	CProtocolUtil::readf().
+	*/
+	bool				readf(const char* fmt, ...);
+
+	//! Get connection metrics
+	CMetrics::CConnection&	getMetrics();
+
+	//! Marshall clipboard for the client
+	/*!
+	Returns \p clipboard marshalled in the formats the client knows.
+	Clients before protocol 1.7 don't know PNG so it's dropped; the
+	server adds a decoded bitmap when the clipboard changes.
+	*/
+	virtual CClipboardBlob	marshallClipboard(const CClipboard& clipboard) const;
+
 private:
 	void				disconnect();
 	void				removeHandlers();
@@ -103,6 +144,12 @@ private:
 	double				m_heartbeatAlarm;
 	CEventQueueTimer*	m_heartbeatTimer;
 	MessageParser		m_parser;
+
+	// the unparsed part of the packet borrowed from the stream, if any
+	const UInt8*		m_packet;
+	UInt32				m_packetSize;
+
+	CMetrics::CConnection	m_metrics;
 };
 
 #endif
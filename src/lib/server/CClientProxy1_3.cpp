@@ -19,6 +19,8 @@
 #include "CClientProxy1_3.h"
 #include "CProtocolUtil.h"
 #include "CLog.h"
+#include "CArch.h"
+#include "IStream.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
 #include <cstring>
@@ -31,20 +33,92 @@
 CClientProxy1_3::CClientProxy1_3(const CString& name, synergy::IStream* stream) :
 	CClientProxy1_2(name, stream),
 	m_keepAliveRate(kKeepAliveRate),
-	m_keepAliveTimer(NULL)
+	m_keepAliveTimer(NULL),
+	m_keepAliveSent(0.0),
+	m_mouseMoveHeld(false),
+	m_xHeld(0),
+	m_yHeld(0)
 {
 	setHeartbeatRate(kKeepAliveRate, kKeepAliveRate * kKeepAlivesUntilDeath);
+
+	// send held back mouse motion when the client catches up
+	EVENTQUEUE->adoptHandler(stream->getOutputFlushedEvent(),
+							stream->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_3>(this,
+								&CClientProxy1_3::handleOutputFlushed, NULL));
 }
 
 CClientProxy1_3::~CClientProxy1_3()
 {
+	EVENTQUEUE->removeHandler(getStream()->getOutputFlushedEvent(),
+							getStream()->getEventTarget());
+
 	// cannot do this in superclass or our override wouldn't get called
 	removeHeartbeatTimer();
 }
 
+void
+CClientProxy1_3::enter(SInt32 xAbs, SInt32 yAbs,
+				UInt32 seqNum, KeyModifierMask mask, bool forScreensaver)
+{
+	// enter carries the position so a held move is stale
+	m_mouseMoveHeld = false;
+	CClientProxy1_2::enter(xAbs, yAbs, seqNum, mask, forScreensaver);
+}
+
+bool
+CClientProxy1_3::leave()
+{
+	// the mouse isn't on the client any more so don't move it later
+	m_mouseMoveHeld = false;
+	return CClientProxy1_2::leave();
+}
+
+void
+CClientProxy1_3::mouseDown(ButtonID button)
+{
+	// the button must go where the client thinks the mouse is
+	sendHeldMouseMove();
+	CClientProxy1_2::mouseDown(button);
+}
+
+void
+CClientProxy1_3::mouseUp(ButtonID button)
+{
+	sendHeldMouseMove();
+	CClientProxy1_2::mouseUp(button);
+}
+
+void
+CClientProxy1_3::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	// each motion message replaces the last so a client that isn't
+	// keeping up only needs the latest.  don't pile more onto it.
+	if (isCongested()) {
+		if (!m_mouseMoveHeld) {
+			LOG((CLOG_DEBUG1 "client \"%s\" is congested, holding back mouse motion", getName().c_str()));
+		}
+		m_mouseMoveHeld = true;
+		m_xHeld         = xAbs;
+		m_yHeld         = yAbs;
+		return;
+	}
+
+	m_mouseMoveHeld = false;
+	CClientProxy1_2::mouseMove(xAbs, yAbs);
+}
+
+void
+CClientProxy1_3::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	sendHeldMouseMove();
+	CClientProxy1_2::mouseRelativeMove(xRel, yRel);
+}
+
 void
 CClientProxy1_3::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
+	sendHeldMouseMove();
 	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
 	CProtocolUtil::writef(getStream(), kMsgDMouseWheel, xDelta, yDelta);
 }
@@ -54,8 +128,25 @@ CClientProxy1_3::parseMessage(const UInt8* code)
 {
 	// process message
 	if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
+		// the client echoes our keep alives so this is a round trip
+		if (m_keepAliveSent > 0.0) {
+			double rtt      = ARCH->time() - m_keepAliveSent;
+			m_keepAliveSent = 0.0;
+			m_roundTrip.addSample(rtt);
+			getMetrics().addRoundTrip(rtt, m_roundTrip.getSmoothed());
+			LOG((CLOG_DEBUG2 "round trip to \"%s\" %.1f ms, smoothed %.1f ms", getName().c_str(), rtt * 1000.0, m_roundTrip.getSmoothed() * 1000.0));
+
+			// wait longer for a client that is usually slow
+			CClientProxy1_2::setHeartbeatRate(m_keepAliveRate,
+							m_roundTrip.getTimeout(m_keepAliveRate));
+		}
+
 		// reset alarm
 		resetHeartbeatTimer();
+
+		// even a congested client gets the latest position once per
+		// round trip
+		sendHeldMouseMove();
 		return true;
 	}
 	else {
@@ -73,7 +164,7 @@ void
 CClientProxy1_3::setHeartbeatRate(double rate, double)
 {
 	m_keepAliveRate = rate;
-	CClientProxy1_2::setHeartbeatRate(rate, rate * kKeepAlivesUntilDeath);
+	CClientProxy1_2::setHeartbeatRate(rate, m_roundTrip.getTimeout(rate));
 }
 
 void
@@ -113,8 +204,51 @@ CClientProxy1_3::removeHeartbeatTimer()
 	CClientProxy1_2::removeHeartbeatTimer();
 }
 
+bool
+CClientProxy1_3::isCongested() const
+{
+	if (getStream()->getOutputSize() > kCongestedOutputSize) {
+		return true;
+	}
+	if (m_roundTrip.hasSamples() &&
+		m_roundTrip.getSmoothed() > kCongestedRoundTrip) {
+		return true;
+	}
+
+	// a keep alive that's overdue is a round trip that's too long too
+	return (m_keepAliveSent > 0.0 &&
+			ARCH->time() - m_keepAliveSent > kCongestedRoundTrip);
+}
+
+void
+CClientProxy1_3::sendHeldMouseMove()
+{
+	if (m_mouseMoveHeld) {
+		m_mouseMoveHeld = false;
+		CClientProxy1_2::mouseMove(m_xHeld, m_yHeld);
+	}
+}
+
 void
 CClientProxy1_3::handleKeepAlive(const CEvent&, void*)
 {
+	// time the oldest unanswered keep alive so a client that stops
+	// answering looks slower and slower
+	if (m_keepAliveSent == 0.0) {
+		m_keepAliveSent = ARCH->time();
+	}
 	CProtocolUtil::writef(getStream(), kMsgCKeepAlive);
+
+	// don't hold back the mouse forever if motion stops
+	if (m_mouseMoveHeld && !isCongested()) {
+		sendHeldMouseMove();
+	}
+}
+
+void
+CClientProxy1_3::handleOutputFlushed(const CEvent&, void*)
+{
+	if (m_mouseMoveHeld && !isCongested()) {
+		sendHeldMouseMove();
+	}
 }
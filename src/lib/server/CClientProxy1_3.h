@@ -20,6 +20,7 @@
 #define CCLIENTPROXY1_3_H
 
 #include "CClientProxy1_2.h"
+#include "CKeepAliveEstimator.h"
 
 //! Proxy for client implementing protocol version 1.3
 class CClientProxy1_3 : public CClientProxy1_2 {
@@ -28,6 +29,14 @@ public:
 	~CClientProxy1_3();
 
 	// IClient overrides
+	virtual void		enter(SInt32 xAbs, SInt32 yAbs,
+							UInt32 seqNum, KeyModifierMask mask,
+							bool forScreensaver);
+	virtual bool		leave();
+	virtual void		mouseDown(ButtonID);
+	virtual void		mouseUp(ButtonID);
+	virtual void		mouseMove(SInt32 xAbs, SInt32 yAbs);
+	virtual void		mouseRelativeMove(SInt32 xRel, SInt32 yRel);
 	virtual void		mouseWheel(SInt32 xDelta, SInt32 yDelta);
 
 protected:
@@ -40,12 +49,28 @@ protected:
 	virtual void		removeHeartbeatTimer();
 
 private:
+	// true if the client isn't keeping up with what we send it
+	bool				isCongested() const;
+
+	// send the mouse position held back while congested
+	void				sendHeldMouseMove();
+
 	void				handleKeepAlive(const CEvent&, void*);
+	void				handleOutputFlushed(const CEvent&, void*);
 
 
 private:
 	double				m_keepAliveRate;
 	CEventQueueTimer*	m_keepAliveTimer;
+
+	// time the oldest unanswered keep alive was sent, or 0
+	double				m_keepAliveSent;
+	CKeepAliveEstimator	m_roundTrip;
+
+	// mouse position held back while congested
+	bool				m_mouseMoveHeld;
+	SInt32				m_xHeld;
+	SInt32				m_yHeld;
 };
 
 #endif
@@ -92,7 +92,7 @@ CClientProxy1_4::gameDeviceFeedback()
 	// parse
 	GameDeviceID id;
 	UInt16 m1, m2;
-	CProtocolUtil::readf(getStream(), kMsgDGameFeedback + 4, &id, &m1, &m2);
+	readf(kMsgDGameFeedback + 4, &id, &m1, &m2);
 	LOG((CLOG_DEBUG2 "recv game device feedback id=%d m1=%d m2=%d", id, m1, m2));
 
 	// forward
@@ -104,7 +104,7 @@ CClientProxy1_4::gameDeviceTimingResp()
 {
 	// parse
 	UInt16 freq;
-	CProtocolUtil::readf(getStream(), kMsgCGameTimingResp + 4, &freq);
+	readf(kMsgCGameTimingResp + 4, &freq);
 	LOG((CLOG_DEBUG2 "recv game device timing response freq=%dms", freq));
 
 	// forward
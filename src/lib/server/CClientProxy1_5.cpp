@@ -0,0 +1,192 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CClientProxy1_5.h"
+#include "CServer.h"
+#include "CClipboard.h"
+#include "CProtocolUtil.h"
+#include "CLog.h"
+#include <cstring>
+
+//
+// CClientProxy1_5
+//
+
+CClientProxy1_5::CClientProxy1_5(const CString& name, synergy::IStream* stream, CServer* server) :
+	CClientProxy1_4(name, stream, server),
+	m_server(server),
+	m_resumed(false),
+	m_resumeOptions(false),
+	m_resetOptions(false)
+{
+	// do nothing
+}
+
+CClientProxy1_5::~CClientProxy1_5()
+{
+	// do nothing
+}
+
+void
+CClientProxy1_5::resumeClipboard(ClipboardID id, const CString& hash)
+{
+	LOG((CLOG_DEBUG "client \"%s\" already has clipboard %d", getName().c_str(), id));
+	CClientProxy1_4::setClipboardDirty(id, false);
+	m_session.m_clipboardHash[id] = hash;
+}
+
+bool
+CClientProxy1_5::getSession(CClientSession& session) const
+{
+	session = m_session;
+	getShape(session.m_info.m_x, session.m_info.m_y,
+				session.m_info.m_w, session.m_info.m_h);
+	getCursorPos(session.m_info.m_mx, session.m_info.m_my);
+	return true;
+}
+
+bool
+CClientProxy1_5::isSessionResumed() const
+{
+	return m_resumed;
+}
+
+void
+CClientProxy1_5::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+	bool dirty = isClipboardDirty(id);
+	CClientProxy1_4::setClipboard(id, clipboard);
+	if (dirty) {
+		m_session.m_clipboardHash[id] = hashClipboard(id);
+	}
+}
+
+void
+CClientProxy1_5::grabClipboard(ClipboardID id)
+{
+	CClientProxy1_4::grabClipboard(id);
+	m_session.m_clipboardHash[id].clear();
+}
+
+void
+CClientProxy1_5::setClipboardDirty(ClipboardID id, bool dirty)
+{
+	CClientProxy1_4::setClipboardDirty(id, dirty);
+
+	// a clean clipboard is one the client sent us
+	m_session.m_clipboardHash[id] = dirty ? CString() : hashClipboard(id);
+}
+
+void
+CClientProxy1_5::resetOptions()
+{
+	// a client resuming its session still has its options.  wait and
+	// see if they've changed before resetting them.
+	if (m_resumeOptions) {
+		m_resumeOptions = false;
+		m_resetOptions  = true;
+		return;
+	}
+
+	CClientProxy1_4::resetOptions();
+	m_session.m_options.clear();
+}
+
+void
+CClientProxy1_5::setOptions(const COptionsList& options)
+{
+	if (m_resetOptions) {
+		m_resetOptions = false;
+		if (options == m_session.m_options) {
+			LOG((CLOG_DEBUG1 "options for \"%s\" are unchanged", getName().c_str()));
+			resetHeartbeatRate();
+			removeHeartbeatTimer();
+			addHeartbeatTimer();
+			applyOptions(options);
+			return;
+		}
+		resetOptions();
+	}
+
+	CClientProxy1_4::setOptions(options);
+	m_session.m_options.insert(m_session.m_options.end(),
+							options.begin(), options.end());
+}
+
+bool
+CClientProxy1_5::parseHandshakeMessage(const UInt8* code)
+{
+	if (memcmp(code, kMsgDResume, 4) == 0) {
+		return recvResume();
+	}
+	else if (memcmp(code, kMsgDInfo, 4) == 0) {
+		// starting a new session
+		if (!CClientProxy1_4::parseHandshakeMessage(code)) {
+			return false;
+		}
+		sendSession();
+		return true;
+	}
+	else {
+		return CClientProxy1_4::parseHandshakeMessage(code);
+	}
+}
+
+bool
+CClientProxy1_5::recvResume()
+{
+	// parse message
+	CString token;
+	if (!readf(kMsgDResume + 4, &token)) {
+		return false;
+	}
+
+	// resume session or fall back to querying the client's info
+	CClientSession session;
+	if (!m_server->resumeSession(getName(), token, session)) {
+		LOG((CLOG_DEBUG1 "cannot resume session of \"%s\", querying client info", getName().c_str()));
+		CProtocolUtil::writef(getStream(), kMsgQInfo);
+		return true;
+	}
+	LOG((CLOG_DEBUG "client \"%s\" resumed session, shape=%d,%d %dx%d", getName().c_str(), session.m_info.m_x, session.m_info.m_y, session.m_info.m_w, session.m_info.m_h));
+
+	m_session       = session;
+	m_resumed       = true;
+	m_resumeOptions = true;
+	setInfo(m_session.m_info);
+	sendSession();
+	handshakeComplete();
+	return true;
+}
+
+void
+CClientProxy1_5::sendSession()
+{
+	// a new token every time so a token can only be used once
+	m_session.m_token = m_server->newSessionToken();
+	LOG((CLOG_DEBUG1 "send session to \"%s\" resumed=%d", getName().c_str(), m_resumed ? 1 : 0));
+	CProtocolUtil::writef(getStream(), kMsgDSession,
+							&m_session.m_token, m_resumed ? 1 : 0);
+}
+
+CString
+CClientProxy1_5::hashClipboard(ClipboardID id) const
+{
+	CClipboard clipboard;
+	getClipboard(id, &clipboard);
+	return CClientSession::hashClipboard(clipboard.marshallBlob());
+}
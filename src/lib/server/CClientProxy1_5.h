@@ -0,0 +1,66 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CCLIENTPROXY1_5_H
+#define CCLIENTPROXY1_5_H
+
+#include "CClientProxy1_4.h"
+#include "CClientSession.h"
+
+class CServer;
+
+//! Proxy for client implementing protocol version 1.5
+class CClientProxy1_5 : public CClientProxy1_4 {
+public:
+	CClientProxy1_5(const CString& name, synergy::IStream* adoptedStream, CServer* server);
+	~CClientProxy1_5();
+
+	// CBaseClientProxy overrides
+	virtual void		resumeClipboard(ClipboardID id, const CString& hash);
+	virtual bool		getSession(CClientSession& session) const;
+	virtual bool		isSessionResumed() const;
+
+	// IClient overrides
+	virtual void		setClipboard(ClipboardID, const IClipboard*);
+	virtual void		grabClipboard(ClipboardID);
+	virtual void		setClipboardDirty(ClipboardID, bool);
+	virtual void		resetOptions();
+	virtual void		setOptions(const COptionsList& options);
+
+protected:
+	// CClientProxy overrides
+	virtual bool		parseHandshakeMessage(const UInt8* code);
+
+private:
+	// message handlers
+	bool				recvResume();
+
+	// send the session token to the client
+	void				sendSession();
+
+	// hash of our copy of the clipboard
+	CString				hashClipboard(ClipboardID) const;
+
+private:
+	CServer*			m_server;
+	CClientSession		m_session;
+	bool				m_resumed;
+	bool				m_resumeOptions;
+	bool				m_resetOptions;
+};
+
+#endif
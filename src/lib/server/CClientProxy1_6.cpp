@@ -0,0 +1,50 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CClientProxy1_6.h"
+#include "CProtocolUtil.h"
+#include "CLatencyTrace.h"
+#include "CLog.h"
+
+//
+// CClientProxy1_6
+//
+
+CClientProxy1_6::CClientProxy1_6(const CString& name, synergy::IStream* stream, CServer* server) :
+	CClientProxy1_5(name, stream, server)
+{
+	// do nothing
+}
+
+CClientProxy1_6::~CClientProxy1_6()
+{
+	// do nothing
+}
+
+void
+CClientProxy1_6::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	// tell the client which trace the motion belongs to
+	UInt32 id = CLatencyTrace::getID();
+	if (id != 0) {
+		LOG((CLOG_DEBUG2 "send trace %u to \"%s\"", id, getName().c_str()));
+		CProtocolUtil::writef(getStream(), kMsgDTrace, id);
+	}
+
+	CClientProxy1_5::mouseMove(xAbs, yAbs);
+}
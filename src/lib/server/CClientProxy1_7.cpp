@@ -0,0 +1,54 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CClientProxy1_7.h"
+#include "CClipboard.h"
+
+//
+// CClientProxy1_7
+//
+
+CClientProxy1_7::CClientProxy1_7(const CString& name, synergy::IStream* stream, CServer* server) :
+	CClientProxy1_6(name, stream, server)
+{
+	// do nothing
+}
+
+CClientProxy1_7::~CClientProxy1_7()
+{
+	// do nothing
+}
+
+CClipboardBlob
+CClientProxy1_7::marshallClipboard(const CClipboard& clipboard) const
+{
+	clipboard.open(0);
+	bool both = (clipboard.has(IClipboard::kPNG) &&
+					clipboard.has(IClipboard::kBitmap));
+	clipboard.close();
+	if (!both) {
+		return clipboard.marshallBlob();
+	}
+
+	// the client decodes the PNG itself if it needs a bitmap
+	CClipboard compressed;
+	CClipboard::copy(&compressed, &clipboard);
+	compressed.open(0);
+	compressed.remove(IClipboard::kBitmap);
+	compressed.close();
+	return compressed.marshallBlob();
+}
@@ -0,0 +1,34 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CCLIENTPROXY1_7_H
+#define CCLIENTPROXY1_7_H
+
+#include "CClientProxy1_6.h"
+
+//! Proxy for client implementing protocol version 1.7
+class CClientProxy1_7 : public CClientProxy1_6 {
+public:
+	CClientProxy1_7(const CString& name, synergy::IStream* adoptedStream, CServer* server);
+	~CClientProxy1_7();
+
+protected:
+	// CClientProxy1_0 overrides
+	virtual CClipboardBlob	marshallClipboard(const CClipboard& clipboard) const;
+};
+
+#endif
@@ -22,6 +22,9 @@
 #include "CClientProxy1_2.h"
 #include "CClientProxy1_3.h"
 #include "CClientProxy1_4.h"
+#include "CClientProxy1_5.h"
+#include "CClientProxy1_6.h"
+#include "CClientProxy1_7.h"
 #include "ProtocolTypes.h"
 #include "CProtocolUtil.h"
 #include "XSynergy.h"
@@ -237,6 +240,18 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 			case 4:
 				m_proxy = new CClientProxy1_4(name, m_stream, m_server);
 				break;
+
+			case 5:
+				m_proxy = new CClientProxy1_5(name, m_stream, m_server);
+				break;
+
+			case 6:
+				m_proxy = new CClientProxy1_6(name, m_stream, m_server);
+				break;
+
+			case 7:
+				m_proxy = new CClientProxy1_7(name, m_stream, m_server);
+				break;
 			}
 		}
 
@@ -0,0 +1,135 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CClientSession.h"
+#include "osrng.h"
+#include "sha.h"
+#include <cstdio>
+
+//
+// CClientSession
+//
+
+CClientSession::CClientSession() :
+	m_token()
+{
+	m_info.m_x  = 0;
+	m_info.m_y  = 0;
+	m_info.m_w  = 0;
+	m_info.m_h  = 0;
+	m_info.obsolete1 = 0;
+	m_info.m_mx = 0;
+	m_info.m_my = 0;
+}
+
+CString
+CClientSession::hashClipboard(const CString& data)
+{
+	return hashClipboard(data.data(), static_cast<UInt32>(data.size()));
+}
+
+CString
+CClientSession::hashClipboard(const CClipboardBlob& data)
+{
+	return hashClipboard(data.data(), data.size());
+}
+
+CString
+CClientSession::hashClipboard(const char* data, UInt32 size)
+{
+	// a collision would leave the client with the wrong clipboard so
+	// use a cryptographic hash
+	CString hash(CryptoPP::SHA1::DIGESTSIZE, '\0');
+	CryptoPP::SHA1().CalculateDigest(
+							reinterpret_cast<unsigned char*>(&hash[0]),
+							reinterpret_cast<const unsigned char*>(data),
+							size);
+	return hash;
+}
+
+
+//
+// CClientSessions
+//
+
+CClientSessions::CClientSessions(double timeout) :
+	m_timeout(timeout)
+{
+	// do nothing
+}
+
+CString
+CClientSessions::newToken()
+{
+	// anyone who can guess a token can take over a session so it must
+	// come from a real random source.  a token is only made once per
+	// connection so the pool needn't be kept.
+	UInt8 bytes[16];
+	CryptoPP::AutoSeededRandomPool random;
+	random.GenerateBlock(bytes, sizeof(bytes));
+
+	char buffer[33];
+	for (UInt32 i = 0; i < sizeof(bytes); ++i) {
+		sprintf(buffer + 2 * i, "%02x", bytes[i]);
+	}
+	return buffer;
+}
+
+void
+CClientSessions::save(const CString& name,
+				const CClientSession& session, double now)
+{
+	// discard expired sessions
+	for (CSessionMap::iterator i = m_sessions.begin(); i != m_sessions.end(); ) {
+		if (now - i->second.m_time >= m_timeout) {
+			m_sessions.erase(i++);
+		}
+		else {
+			++i;
+		}
+	}
+
+	CSavedSession& saved = m_sessions[name];
+	saved.m_session      = session;
+	saved.m_time         = now;
+}
+
+bool
+CClientSessions::resume(const CString& name, const CString& token,
+				CClientSession& session, double now)
+{
+	CSessionMap::iterator i = m_sessions.find(name);
+	if (i == m_sessions.end()) {
+		return false;
+	}
+
+	// a session can only be resumed once, whether or not the token matches
+	bool valid = (!token.empty() &&
+					token == i->second.m_session.m_token &&
+					now - i->second.m_time < m_timeout);
+	if (valid) {
+		session = i->second.m_session;
+	}
+	m_sessions.erase(i);
+	return valid;
+}
+
+UInt32
+CClientSessions::size() const
+{
+	return static_cast<UInt32>(m_sessions.size());
+}
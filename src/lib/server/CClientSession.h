@@ -0,0 +1,121 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CCLIENTSESSION_H
+#define CCLIENTSESSION_H
+
+#include "ProtocolTypes.h"
+#include "ClipboardTypes.h"
+#include "OptionTypes.h"
+#include "CClipboardBlob.h"
+#include "CString.h"
+#include "stdmap.h"
+
+//! Resumable client session
+/*!
+The state the server needs to resume a client's session when the
+client reconnects:  the client's screen info, a hash of each clipboard
+the client already has (or empty if it doesn't have the server's copy)
+and the options last sent to the client.
+*/
+class CClientSession {
+public:
+	CClientSession();
+
+	//! Hash clipboard data
+	/*!
+	Returns the SHA-1 hash of marshalled clipboard data.  The result is
+	never empty so empty can mean "no clipboard".
+	*/
+	static CString		hashClipboard(const CString& data);
+
+	//! Hash shared clipboard data
+	/*!
+	Same as hashClipboard(const CString&).
+	*/
+	static CString		hashClipboard(const CClipboardBlob& data);
+
+private:
+	static CString		hashClipboard(const char* data, UInt32 size);
+
+public:
+	CString				m_token;
+	CClientInfo			m_info;
+	CString				m_clipboardHash[kClipboardEnd];
+	COptionsList		m_options;
+};
+
+//! Resumable client sessions
+/*!
+Remembers the sessions of recently disconnected clients so a client
+that reconnects within the session timeout can skip the info exchange
+and clipboard resync.  Sessions are indexed by client name and can
+only be resumed once.
+*/
+class CClientSessions {
+public:
+	CClientSessions(double timeout = kSessionTimeout);
+
+	//! @name manipulators
+	//@{
+
+	//! Create session token
+	/*!
+	Returns a new session token of 128 bits from the operating system's
+	random number generator, as 32 hex digits.
+	*/
+	CString				newToken();
+
+	//! Save session
+	/*!
+	Saves \p session for client \p name at time \p now, replacing any
+	session already saved for the client, and discards expired sessions.
+	*/
+	void				save(const CString& name,
+							const CClientSession& session, double now);
+
+	//! Resume session
+	/*!
+	If a session for client \p name with token \p token was saved less
+	than the timeout before \p now then removes it, copies it to
+	\p session and returns true.  Otherwise returns false.
+	*/
+	bool				resume(const CString& name, const CString& token,
+							CClientSession& session, double now);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get number of saved sessions
+	UInt32				size() const;
+
+	//@}
+
+private:
+	class CSavedSession {
+	public:
+		CClientSession	m_session;
+		double			m_time;
+	};
+	typedef std::map<CString, CSavedSession> CSessionMap;
+
+	double				m_timeout;
+	CSessionMap			m_sessions;
+};
+
+#endif
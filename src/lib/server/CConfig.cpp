@@ -912,6 +912,14 @@ CConfig::readSectionScreens(CConfigReadContext& s)
 				addOption(screen, kOptionScreenPreserveFocus,
 					s.parseBoolean(value));
 			}
+			else if (name == "motionRate") {
+				addOption(screen, kOptionMotionRate,
+					s.parseInt(value));
+			}
+			else if (name == "motionInterpolate") {
+				addOption(screen, kOptionMotionInterpolate,
+					s.parseBoolean(value));
+			}
 			else {
 				// unknown argument
 				throw XConfigRead(s, "unknown argument \"%{1}\"", name);
@@ -1368,6 +1376,12 @@ CConfig::getOptionName(OptionID id)
 	if (id == kOptionScreenPreserveFocus) {
 		return "preserveFocus";
 	}
+	if (id == kOptionMotionRate) {
+		return "motionRate";
+	}
+	if (id == kOptionMotionInterpolate) {
+		return "motionInterpolate";
+	}
 	return NULL;
 }
 
@@ -1384,7 +1398,8 @@ CConfig::getOptionValue(OptionID id, OptionValue value)
 		id == kOptionXTestXineramaUnaware ||
 		id == kOptionRelativeMouseMoves ||
 		id == kOptionWin32KeepForeground ||
-		id == kOptionScreenPreserveFocus) {
+		id == kOptionScreenPreserveFocus ||
+		id == kOptionMotionInterpolate) {
 		return (value != 0) ? "true" : "false";
 	}
 	if (id == kOptionModifierMapForShift ||
@@ -1419,7 +1434,8 @@ CConfig::getOptionValue(OptionID id, OptionValue value)
 	if (id == kOptionHeartbeat ||
 		id == kOptionScreenSwitchCornerSize ||
 		id == kOptionScreenSwitchDelay ||
-		id == kOptionScreenSwitchTwoTap) {
+		id == kOptionScreenSwitchTwoTap ||
+		id == kOptionMotionRate) {
 		return CStringUtil::print("%d", value);
 	}
 	if (id == kOptionScreenSwitchCorners) {
@@ -55,6 +55,8 @@ comparing names.  Screen names and their aliases share a
 namespace and must be unique.
 */
 class CConfig {
+	friend class CConfigCache;
+
 public:
 	typedef std::map<OptionID, OptionValue> CScreenOptions;
 	typedef std::pair<float, float> CInterval;
@@ -0,0 +1,498 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CConfigCache.h"
+#include "CConfig.h"
+#include "XSocket.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "stdfstream.h"
+#include "sha.h"
+#include <cstring>
+#include <exception>
+
+// cache file magic and format version.  bump the version whenever the
+// layout changes;  caches with another version are ignored.
+static const char		s_magic[]  = "SYNC";
+static const UInt32		s_version  = 2;
+
+//
+// CConfigCacheWriter
+//
+
+CConfigCacheWriter::CConfigCacheWriter(CString& data) :
+	m_data(data)
+{
+	// do nothing
+}
+
+void
+CConfigCacheWriter::writeUInt8(UInt8 v)
+{
+	m_data += static_cast<char>(v);
+}
+
+void
+CConfigCacheWriter::writeUInt32(UInt32 v)
+{
+	m_data += static_cast<char>((v >> 24) & 0xff);
+	m_data += static_cast<char>((v >> 16) & 0xff);
+	m_data += static_cast<char>((v >>  8) & 0xff);
+	m_data += static_cast<char>( v        & 0xff);
+}
+
+void
+CConfigCacheWriter::writeFloat(float v)
+{
+	UInt32 bits;
+	memcpy(&bits, &v, sizeof(bits));
+	writeUInt32(bits);
+}
+
+void
+CConfigCacheWriter::writeString(const CString& v)
+{
+	writeUInt32(static_cast<UInt32>(v.size()));
+	m_data += v;
+}
+
+
+//
+// CConfigCacheReader
+//
+
+CConfigCacheReader::CConfigCacheReader(const char* data, UInt32 size) :
+	m_data(data),
+	m_end(data + size)
+{
+	// do nothing
+}
+
+UInt8
+CConfigCacheReader::readUInt8()
+{
+	return static_cast<UInt8>(*need(1));
+}
+
+UInt32
+CConfigCacheReader::readUInt32()
+{
+	const unsigned char* ubuf =
+		reinterpret_cast<const unsigned char*>(need(4));
+	return	(static_cast<UInt32>(ubuf[0]) << 24) |
+			(static_cast<UInt32>(ubuf[1]) << 16) |
+			(static_cast<UInt32>(ubuf[2]) <<  8) |
+			 static_cast<UInt32>(ubuf[3]);
+}
+
+float
+CConfigCacheReader::readFloat()
+{
+	UInt32 bits = readUInt32();
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+CString
+CConfigCacheReader::readString()
+{
+	UInt32 n = readUInt32();
+	return CString(need(n), n);
+}
+
+UInt32
+CConfigCacheReader::readEnum(UInt32 max)
+{
+	UInt32 v = readUInt8();
+	if (v > max) {
+		throw XConfigCache("value out of range");
+	}
+	return v;
+}
+
+UInt32
+CConfigCacheReader::readCount(UInt32 minSize)
+{
+	UInt32 n = readUInt32();
+	if (n > static_cast<UInt32>(m_end - m_data) / minSize) {
+		throw XConfigCache("count too large");
+	}
+	return n;
+}
+
+bool
+CConfigCacheReader::atEnd() const
+{
+	return (m_data == m_end);
+}
+
+const char*
+CConfigCacheReader::need(UInt32 n)
+{
+	if (static_cast<UInt32>(m_end - m_data) < n) {
+		throw XConfigCache("truncated");
+	}
+	const char* data = m_data;
+	m_data += n;
+	return data;
+}
+
+
+//
+// CConfigCache
+//
+
+CString
+CConfigCache::getPathname(const CString& pathname)
+{
+	return pathname + ".cache";
+}
+
+bool
+CConfigCache::load(const CString& pathname, CConfig& config)
+{
+	UInt32 mtime, size;
+	CString hash;
+	if (!getFileStatus(pathname, mtime, size, hash)) {
+		return false;
+	}
+
+	// read the whole cache in one go
+	CString cachePathname = getPathname(pathname);
+	std::ifstream stream(cachePathname.c_str(),
+							std::ios::in | std::ios::binary);
+	if (!stream.is_open()) {
+		return false;
+	}
+	stream.seekg(0, std::ios::end);
+	std::streamoff n = stream.tellg();
+	stream.seekg(0, std::ios::beg);
+	if (n <= 0) {
+		return false;
+	}
+	CString data(static_cast<size_t>(n), '\0');
+	if (!stream.read(&data[0], n)) {
+		return false;
+	}
+
+	try {
+		CConfigCacheReader reader(data.data(), static_cast<UInt32>(n));
+		if (!checkHeader(reader, mtime, size, hash)) {
+			LOG((CLOG_DEBUG "configuration cache \"%s\" is stale",
+				cachePathname.c_str()));
+			return false;
+		}
+		unmarshall(config, reader);
+	}
+	catch (XConfigCache& e) {
+		LOG((CLOG_DEBUG "ignoring configuration cache \"%s\": %s",
+			cachePathname.c_str(), e.what()));
+		return false;
+	}
+	catch (std::exception& e) {
+		// the cache is only an optimization so never fail because of it
+		LOG((CLOG_DEBUG "ignoring configuration cache \"%s\": %s",
+			cachePathname.c_str(), e.what()));
+		return false;
+	}
+
+	LOG((CLOG_DEBUG "loaded configuration cache \"%s\"",
+		cachePathname.c_str()));
+	return true;
+}
+
+bool
+CConfigCache::save(const CString& pathname, const CConfig& config)
+{
+	UInt32 mtime, size;
+	CString hash;
+	if (!getFileStatus(pathname, mtime, size, hash)) {
+		return false;
+	}
+
+	CString data;
+	CConfigCacheWriter writer(data);
+	writeHeader(writer, mtime, size, hash);
+	CString body = marshall(config);
+	if (body.empty()) {
+		return false;
+	}
+	data += body;
+
+	CString cachePathname = getPathname(pathname);
+	std::ofstream stream(cachePathname.c_str(),
+							std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open() ||
+		!stream.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+		LOG((CLOG_DEBUG "cannot write configuration cache \"%s\"",
+			cachePathname.c_str()));
+		return false;
+	}
+
+	LOG((CLOG_DEBUG "saved configuration cache \"%s\"",
+		cachePathname.c_str()));
+	return true;
+}
+
+CString
+CConfigCache::marshall(const CConfig& config)
+{
+	CString data;
+	CConfigCacheWriter writer(data);
+
+	// screens and their options
+	writer.writeUInt32(static_cast<UInt32>(config.m_map.size()));
+	for (CConfig::const_iterator screen = config.begin();
+								screen != config.end(); ++screen) {
+		writer.writeString(*screen);
+		const CConfig::CScreenOptions* options = config.getOptions(*screen);
+		writer.writeUInt32(static_cast<UInt32>(options->size()));
+		for (CConfig::CScreenOptions::const_iterator
+								option = options->begin();
+								option != options->end(); ++option) {
+			writer.writeUInt32(option->first);
+			writer.writeUInt32(static_cast<UInt32>(option->second));
+		}
+	}
+
+	// aliases
+	UInt32 numAliases = 0;
+	for (CConfig::all_const_iterator name = config.beginAll();
+								name != config.endAll(); ++name) {
+		if (!config.isCanonicalName(name->first)) {
+			++numAliases;
+		}
+	}
+	writer.writeUInt32(numAliases);
+	for (CConfig::all_const_iterator name = config.beginAll();
+								name != config.endAll(); ++name) {
+		if (!config.isCanonicalName(name->first)) {
+			writer.writeString(name->first);
+			writer.writeString(name->second);
+		}
+	}
+
+	// links
+	for (CConfig::const_iterator screen = config.begin();
+								screen != config.end(); ++screen) {
+		UInt32 numLinks = 0;
+		for (CConfig::link_const_iterator
+								link = config.beginNeighbor(*screen);
+								link != config.endNeighbor(*screen); ++link) {
+			++numLinks;
+		}
+		writer.writeUInt32(numLinks);
+		for (CConfig::link_const_iterator
+								link = config.beginNeighbor(*screen);
+								link != config.endNeighbor(*screen); ++link) {
+			CConfig::CInterval src = link->first.getInterval();
+			CConfig::CInterval dst = link->second.getInterval();
+			writer.writeUInt8(static_cast<UInt8>(link->first.getSide()));
+			writer.writeFloat(src.first);
+			writer.writeFloat(src.second);
+			writer.writeString(link->second.getName());
+			writer.writeFloat(dst.first);
+			writer.writeFloat(dst.second);
+		}
+	}
+
+	// global options
+	writer.writeUInt32(static_cast<UInt32>(config.m_globalOptions.size()));
+	for (CConfig::CScreenOptions::const_iterator
+								option = config.m_globalOptions.begin();
+								option != config.m_globalOptions.end();
+								++option) {
+		writer.writeUInt32(option->first);
+		writer.writeUInt32(static_cast<UInt32>(option->second));
+	}
+
+	// listen address.  it's resolved again when loaded.
+	if (config.m_synergyAddress.isValid()) {
+		writer.writeUInt8(1);
+		writer.writeString(config.m_synergyAddress.getHostname());
+		writer.writeUInt32(config.m_synergyAddress.getPort());
+	}
+	else {
+		writer.writeUInt8(0);
+	}
+
+	// input filter
+	writer.writeUInt8(config.m_hasLockToScreenAction ? 1 : 0);
+	if (!config.m_inputFilter.marshall(writer)) {
+		return CString();
+	}
+
+	return data;
+}
+
+void
+CConfigCache::unmarshall(CConfig& config, const CString& data)
+{
+	CConfigCacheReader reader(data.data(), static_cast<UInt32>(data.size()));
+	unmarshall(config, reader);
+}
+
+void
+CConfigCache::unmarshall(CConfig& config, CConfigCacheReader& reader)
+{
+	CConfig tmp;
+
+	// screens and their options
+	// each screen is at least a name length and an option count
+	std::vector<CString> screens(reader.readCount(8));
+	for (size_t i = 0; i < screens.size(); ++i) {
+		screens[i] = reader.readString();
+		if (!tmp.addScreen(screens[i])) {
+			throw XConfigCache("invalid screen");
+		}
+		UInt32 numOptions = reader.readCount(8);
+		for (UInt32 j = 0; j < numOptions; ++j) {
+			OptionID id       = reader.readUInt32();
+			OptionValue value = static_cast<OptionValue>(reader.readUInt32());
+			tmp.addOption(screens[i], id, value);
+		}
+	}
+
+	// aliases
+	UInt32 numAliases = reader.readCount(8);
+	for (UInt32 i = 0; i < numAliases; ++i) {
+		CString alias     = reader.readString();
+		CString canonical = reader.readString();
+		if (!tmp.addAlias(canonical, alias)) {
+			throw XConfigCache("invalid alias");
+		}
+	}
+
+	// links
+	for (size_t i = 0; i < screens.size(); ++i) {
+		UInt32 numLinks = reader.readCount(21);
+		for (UInt32 j = 0; j < numLinks; ++j) {
+			UInt32 side = reader.readEnum(kLastDirection);
+			if (side < kFirstDirection) {
+				throw XConfigCache("invalid direction");
+			}
+			float srcStart  = reader.readFloat();
+			float srcEnd    = reader.readFloat();
+			CString dstName = reader.readString();
+			float dstStart  = reader.readFloat();
+			float dstEnd    = reader.readFloat();
+			if (!tmp.connect(screens[i], static_cast<EDirection>(side),
+							srcStart, srcEnd, dstName, dstStart, dstEnd)) {
+				throw XConfigCache("invalid link");
+			}
+		}
+	}
+
+	// global options
+	UInt32 numOptions = reader.readCount(8);
+	for (UInt32 i = 0; i < numOptions; ++i) {
+		OptionID id       = reader.readUInt32();
+		OptionValue value = static_cast<OptionValue>(reader.readUInt32());
+		tmp.addOption("", id, value);
+	}
+
+	// listen address
+	if (reader.readUInt8() != 0) {
+		CString hostname = reader.readString();
+		int port         = static_cast<int>(reader.readUInt32());
+		try {
+			tmp.m_synergyAddress = CNetworkAddress(hostname, port);
+			tmp.m_synergyAddress.resolve();
+		}
+		catch (XSocketAddress& e) {
+			throw XConfigCache(CString("invalid address ") + e.what());
+		}
+	}
+
+	// input filter
+	tmp.m_hasLockToScreenAction = (reader.readUInt8() != 0);
+	tmp.m_inputFilter.unmarshall(reader);
+
+	if (!reader.atEnd()) {
+		throw XConfigCache("trailing data");
+	}
+
+	config = tmp;
+}
+
+bool
+CConfigCache::getFileStatus(const CString& pathname,
+				UInt32& mtime, UInt32& size, CString& hash)
+{
+	if (!ARCH->getFileStatus(pathname, mtime, size)) {
+		return false;
+	}
+
+	// mtime has a resolution of a second and an edit may not change the
+	// size so the contents are hashed too.  that's still much cheaper
+	// than parsing them.
+	std::ifstream stream(pathname.c_str(), std::ios::in | std::ios::binary);
+	if (!stream.is_open()) {
+		return false;
+	}
+	CryptoPP::SHA1 sha;
+	char buffer[4096];
+	while (stream.read(buffer, sizeof(buffer)) || stream.gcount() > 0) {
+		sha.Update(reinterpret_cast<const unsigned char*>(buffer),
+							static_cast<size_t>(stream.gcount()));
+	}
+	hash.resize(CryptoPP::SHA1::DIGESTSIZE);
+	sha.Final(reinterpret_cast<unsigned char*>(&hash[0]));
+	return true;
+}
+
+void
+CConfigCache::writeHeader(CConfigCacheWriter& writer,
+				UInt32 mtime, UInt32 size, const CString& hash)
+{
+	for (const char* c = s_magic; *c != '\0'; ++c) {
+		writer.writeUInt8(static_cast<UInt8>(*c));
+	}
+	writer.writeUInt32(s_version);
+	writer.writeUInt32(mtime);
+	writer.writeUInt32(size);
+	writer.writeString(hash);
+}
+
+bool
+CConfigCache::checkHeader(CConfigCacheReader& reader,
+				UInt32 mtime, UInt32 size, const CString& hash)
+{
+	for (const char* c = s_magic; *c != '\0'; ++c) {
+		if (reader.readUInt8() != static_cast<UInt8>(*c)) {
+			throw XConfigCache("not a configuration cache");
+		}
+	}
+	if (reader.readUInt32() != s_version) {
+		return false;
+	}
+	return (reader.readUInt32() == mtime &&
+			reader.readUInt32() == size &&
+			reader.readString() == hash);
+}
+
+
+//
+// XConfigCache
+//
+
+CString
+XConfigCache::getWhat() const throw()
+{
+	return format("XConfigCache", "invalid configuration cache");
+}
@@ -0,0 +1,146 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CCONFIGCACHE_H
+#define CCONFIGCACHE_H
+
+#include "CString.h"
+#include "BasicTypes.h"
+#include "XBase.h"
+
+class CConfig;
+
+//! Configuration cache write buffer
+/*!
+Appends big-endian fixed size values and length prefixed strings to a
+string.
+*/
+class CConfigCacheWriter {
+public:
+	CConfigCacheWriter(CString& data);
+
+	void				writeUInt8(UInt8);
+	void				writeUInt32(UInt32);
+	void				writeFloat(float);
+	void				writeString(const CString&);
+
+private:
+	CString&			m_data;
+};
+
+//! Configuration cache read buffer
+/*!
+Reads values written by CConfigCacheWriter.  Throws XConfigCache if
+the data is truncated.  The data must outlive the reader.
+*/
+class CConfigCacheReader {
+public:
+	CConfigCacheReader(const char* data, UInt32 size);
+
+	UInt8				readUInt8();
+	UInt32				readUInt32();
+	float				readFloat();
+	CString				readString();
+
+	//! Read an enumerant
+	/*!
+	Reads a value and throws XConfigCache if it's larger than \p max.
+	*/
+	UInt32				readEnum(UInt32 max);
+
+	//! Read a count
+	/*!
+	Reads the number of items that follow, each at least \p minSize
+	bytes, and throws XConfigCache if the rest of the data is too
+	short to hold them.  Check counts this way before allocating.
+	*/
+	UInt32				readCount(UInt32 minSize);
+
+	//! Test for end of data
+	bool				atEnd() const;
+
+private:
+	const char*			need(UInt32 n);
+
+private:
+	const char*			m_data;
+	const char*			m_end;
+};
+
+//! Precompiled configuration cache
+/*!
+Saves a validated configuration, including its compiled input filter
+rules, in a compact binary form and loads it back without parsing the
+text configuration.  The cache records the modification time, size
+and SHA-1 hash of the configuration file it was built from and is
+ignored once the configuration file changes.
+*/
+class CConfigCache {
+public:
+	//! Get cache pathname
+	/*!
+	Returns the pathname of the cache for configuration file \p pathname.
+	*/
+	static CString		getPathname(const CString& pathname);
+
+	//! Load cached configuration
+	/*!
+	Loads the cache of configuration file \p pathname into \p config.
+	Returns false, leaving \p config unchanged, if there's no cache or
+	it's stale or invalid.
+	*/
+	static bool			load(const CString& pathname, CConfig& config);
+
+	//! Save configuration to cache
+	/*!
+	Saves \p config as the cache of configuration file \p pathname.
+	Returns false if the cache could not be written.
+	*/
+	static bool			save(const CString& pathname, const CConfig& config);
+
+	//! Serialize configuration
+	static CString		marshall(const CConfig&);
+
+	//! Deserialize configuration
+	/*!
+	Throws XConfigCache if \p data is not a valid serialized
+	configuration.
+	*/
+	static void			unmarshall(CConfig&, const CString& data);
+
+private:
+	// read the configuration following the header
+	static void			unmarshall(CConfig&, CConfigCacheReader&);
+
+	// get the modification time, size and hash of a configuration file
+	static bool			getFileStatus(const CString& pathname,
+							UInt32& mtime, UInt32& size, CString& hash);
+
+	// write/check the header describing the configuration file
+	static void			writeHeader(CConfigCacheWriter&,
+							UInt32 mtime, UInt32 size, const CString& hash);
+	static bool			checkHeader(CConfigCacheReader&,
+							UInt32 mtime, UInt32 size, const CString& hash);
+};
+
+//! Configuration cache exception
+/*!
+Thrown when a configuration cache is truncated or corrupt.
+*/
+XBASE_SUBCLASS_WHAT(XConfigCache, XBase);
+
+#endif
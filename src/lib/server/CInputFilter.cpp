@@ -23,12 +23,55 @@
 #include "CEventQueue.h"
 #include "CLog.h"
 #include "TMethodEventJob.h"
+#include "CConfigCache.h"
 #include <cstdlib>
 #include <cstring>
 
+// configuration cache type tags.  append new tags to keep existing
+// caches readable.
+enum EConditionTag {
+	kKeystrokeConditionTag = 1,
+	kMouseButtonConditionTag,
+	kScreenConnectedConditionTag
+};
+
+enum EActionTag {
+	kLockCursorToScreenActionTag = 1,
+	kSwitchToScreenActionTag,
+	kSwitchInDirectionActionTag,
+	kKeyboardBroadcastActionTag,
+	kKeystrokeActionTag,
+	kMouseButtonActionTag
+};
+
+// modifiers that cannot be combined with a mouse button
+static const KeyModifierMask s_buttonIgnoreMask =
+	KeyModifierAltGr | KeyModifierCapsLock |
+	KeyModifierNumLock | KeyModifierScrollLock;
+
 // -----------------------------------------------------------------------------
 // Input Filter Condition Classes
 // -----------------------------------------------------------------------------
+CInputFilter::CIndexKey::CIndexKey(EKind kind, UInt32 id, KeyModifierMask mask) :
+	m_kind(kind),
+	m_id(id),
+	m_mask(mask)
+{
+	// do nothing
+}
+
+bool
+CInputFilter::CIndexKey::operator<(const CIndexKey& x) const
+{
+	if (m_kind != x.m_kind) {
+		return (m_kind < x.m_kind);
+	}
+	if (m_id != x.m_id) {
+		return (m_id < x.m_id);
+	}
+	return (m_mask < x.m_mask);
+}
+
 CInputFilter::CCondition::CCondition()
 {
 	// do nothing
@@ -39,6 +82,18 @@ CInputFilter::CCondition::~CCondition()
 	// do nothing
 }
 
+CInputFilter::CIndexKey
+CInputFilter::CCondition::getIndexKey() const
+{
+	return CIndexKey();
+}
+
+bool
+CInputFilter::CCondition::marshall(CConfigCacheWriter&) const
+{
+	return false;
+}
+
 void
 CInputFilter::CCondition::enablePrimary(CPrimaryClient*)
 {
@@ -126,6 +181,21 @@ CInputFilter::CKeystrokeCondition::match(const CEvent& event)
 	return status;
 }
 
+CInputFilter::CIndexKey
+CInputFilter::CKeystrokeCondition::getIndexKey() const
+{
+	return CIndexKey(CIndexKey::kHotKey, m_id);
+}
+
+bool
+CInputFilter::CKeystrokeCondition::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kKeystrokeConditionTag);
+	writer.writeUInt32(m_key);
+	writer.writeUInt32(m_mask);
+	return true;
+}
+
 void
 CInputFilter::CKeystrokeCondition::enablePrimary(CPrimaryClient* primary)
 {
@@ -191,10 +261,6 @@ CInputFilter::CMouseButtonCondition::format() const
 CInputFilter::EFilterStatus		
 CInputFilter::CMouseButtonCondition::match(const CEvent& event)
 {
-	static const KeyModifierMask s_ignoreMask =
-		KeyModifierAltGr | KeyModifierCapsLock |
-		KeyModifierNumLock | KeyModifierScrollLock;
-
 	EFilterStatus status;
 
 	// check for hotkey events
@@ -214,13 +280,28 @@ CInputFilter::CMouseButtonCondition::match(const CEvent& event)
 	IPlatformScreen::CButtonInfo* minfo =
 		reinterpret_cast<IPlatformScreen::CButtonInfo*>(event.getData());
 	if (minfo->m_button != m_button ||
-		(minfo->m_mask & ~s_ignoreMask) != m_mask) {
+		(minfo->m_mask & ~s_buttonIgnoreMask) != m_mask) {
 		return kNoMatch;
 	}
 
 	return status;
 }
 
+CInputFilter::CIndexKey
+CInputFilter::CMouseButtonCondition::getIndexKey() const
+{
+	return CIndexKey(CIndexKey::kButton, m_button, m_mask);
+}
+
+bool
+CInputFilter::CMouseButtonCondition::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kMouseButtonConditionTag);
+	writer.writeUInt8(m_button);
+	writer.writeUInt32(m_mask);
+	return true;
+}
+
 CInputFilter::CScreenConnectedCondition::CScreenConnectedCondition(
 				const CString& screen) :
 	m_screen(screen)
@@ -259,6 +340,23 @@ CInputFilter::CScreenConnectedCondition::match(const CEvent& event)
 	return kNoMatch;
 }
 
+CInputFilter::CIndexKey
+CInputFilter::CScreenConnectedCondition::getIndexKey() const
+{
+	// the screen name is checked by match() so all connect conditions
+	// share one key
+	return CIndexKey(CIndexKey::kConnect);
+}
+
+bool
+CInputFilter::CScreenConnectedCondition::marshall(
+				CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kScreenConnectedConditionTag);
+	writer.writeString(m_screen);
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Input Filter Action Classes
 // -----------------------------------------------------------------------------
@@ -272,6 +370,12 @@ CInputFilter::CAction::~CAction()
 	// do nothing
 }
 
+bool
+CInputFilter::CAction::marshall(CConfigCacheWriter&) const
+{
+	return false;
+}
+
 CInputFilter::CLockCursorToScreenAction::CLockCursorToScreenAction(Mode mode) :
 	m_mode(mode)
 {
@@ -315,6 +419,15 @@ CInputFilter::CLockCursorToScreenAction::perform(const CEvent& event)
 								CEvent::kDeliverImmediately));
 }
 
+bool
+CInputFilter::CLockCursorToScreenAction::marshall(
+				CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kLockCursorToScreenActionTag);
+	writer.writeUInt8(static_cast<UInt8>(m_mode));
+	return true;
+}
+
 CInputFilter::CSwitchToScreenAction::CSwitchToScreenAction(
 				const CString& screen) :
 	m_screen(screen)
@@ -360,6 +473,14 @@ CInputFilter::CSwitchToScreenAction::perform(const CEvent& event)
 								CEvent::kDeliverImmediately));
 }
 
+bool
+CInputFilter::CSwitchToScreenAction::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kSwitchToScreenActionTag);
+	writer.writeString(m_screen);
+	return true;
+}
+
 CInputFilter::CSwitchInDirectionAction::CSwitchInDirectionAction(
 				EDirection direction) :
 	m_direction(direction)
@@ -403,6 +524,15 @@ CInputFilter::CSwitchInDirectionAction::perform(const CEvent& event)
 								CEvent::kDeliverImmediately));
 }
 
+bool
+CInputFilter::CSwitchInDirectionAction::marshall(
+				CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kSwitchInDirectionActionTag);
+	writer.writeUInt8(static_cast<UInt8>(m_direction));
+	return true;
+}
+
 CInputFilter::CKeyboardBroadcastAction::CKeyboardBroadcastAction(Mode mode) :
 	m_mode(mode)
 {
@@ -471,6 +601,16 @@ CInputFilter::CKeyboardBroadcastAction::perform(const CEvent& event)
 								CEvent::kDeliverImmediately));
 }
 
+bool
+CInputFilter::CKeyboardBroadcastAction::marshall(
+				CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kKeyboardBroadcastActionTag);
+	writer.writeUInt8(static_cast<UInt8>(m_mode));
+	writer.writeString(m_screens);
+	return true;
+}
+
 CInputFilter::CKeystrokeAction::CKeystrokeAction(
 		IPlatformScreen::CKeyInfo* info, bool press) :
 	m_keyInfo(info),
@@ -550,6 +690,20 @@ CInputFilter::CKeystrokeAction::perform(const CEvent& event)
 								CEvent::kDeliverImmediately));
 }
 
+bool
+CInputFilter::CKeystrokeAction::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kKeystrokeActionTag);
+	writer.writeUInt8(m_press ? 1 : 0);
+	writer.writeUInt32(m_keyInfo->m_key);
+	writer.writeUInt32(m_keyInfo->m_mask);
+	writer.writeUInt32(m_keyInfo->m_button);
+	writer.writeUInt32(static_cast<UInt32>(m_keyInfo->m_count));
+	writer.writeUInt8(m_keyInfo->m_screens != NULL ? 1 : 0);
+	writer.writeString(m_keyInfo->m_screensBuffer);
+	return true;
+}
+
 const char*
 CInputFilter::CKeystrokeAction::formatName() const
 {
@@ -623,6 +777,16 @@ CInputFilter::CMouseButtonAction::perform(const CEvent& event)
 								CEvent::kDontFreeData));
 }
 
+bool
+CInputFilter::CMouseButtonAction::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt8(kMouseButtonActionTag);
+	writer.writeUInt8(m_press ? 1 : 0);
+	writer.writeUInt8(m_buttonInfo->m_button);
+	writer.writeUInt32(m_buttonInfo->m_mask);
+	return true;
+}
+
 const char*
 CInputFilter::CMouseButtonAction::formatName() const
 {
@@ -865,19 +1029,63 @@ CInputFilter::CRule::getAction(bool onActivation, UInt32 index) const
 	}
 }
 
+bool
+CInputFilter::CRule::marshall(CConfigCacheWriter& writer) const
+{
+	// NULL conditions never match so there's no point caching them
+	if (m_condition == NULL || !m_condition->marshall(writer)) {
+		return false;
+	}
+
+	writer.writeUInt32(static_cast<UInt32>(m_activateActions.size()));
+	for (CActionList::const_iterator i = m_activateActions.begin();
+								i != m_activateActions.end(); ++i) {
+		if (!(*i)->marshall(writer)) {
+			return false;
+		}
+	}
+	writer.writeUInt32(static_cast<UInt32>(m_deactivateActions.size()));
+	for (CActionList::const_iterator i = m_deactivateActions.begin();
+								i != m_deactivateActions.end(); ++i) {
+		if (!(*i)->marshall(writer)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+CInputFilter::CRule::unmarshall(CConfigCacheReader& reader)
+{
+	clear();
+	m_condition = unmarshallCondition(reader);
+
+	// each action is at least its type
+	UInt32 n = reader.readCount(1);
+	for (UInt32 i = 0; i < n; ++i) {
+		m_activateActions.push_back(unmarshallAction(reader));
+	}
+	n = reader.readCount(1);
+	for (UInt32 i = 0; i < n; ++i) {
+		m_deactivateActions.push_back(unmarshallAction(reader));
+	}
+}
+
 
 // -----------------------------------------------------------------------------
 // Input Filter Class
 // -----------------------------------------------------------------------------
 CInputFilter::CInputFilter() :
-	m_primaryClient(NULL)
+	m_primaryClient(NULL),
+	m_indexDirty(true)
 {
 	// do nothing
 }
 
 CInputFilter::CInputFilter(const CInputFilter& x) :
 	m_ruleList(x.m_ruleList),
-	m_primaryClient(NULL)
+	m_primaryClient(NULL),
+	m_indexDirty(true)
 {
 	setPrimaryClient(x.m_primaryClient);
 }
@@ -894,7 +1102,8 @@ CInputFilter::operator=(const CInputFilter& x)
 		CPrimaryClient* oldClient = m_primaryClient;
 		setPrimaryClient(NULL);
 
-		m_ruleList = x.m_ruleList;
+		m_ruleList   = x.m_ruleList;
+		m_indexDirty = true;
 
 		setPrimaryClient(oldClient);
 	}
@@ -908,6 +1117,7 @@ CInputFilter::addFilterRule(const CRule& rule)
 	if (m_primaryClient != NULL) {
 		m_ruleList.back().enable(m_primaryClient);
 	}
+	m_indexDirty = true;
 }
 
 void
@@ -917,11 +1127,14 @@ CInputFilter::removeFilterRule(UInt32 index)
 		m_ruleList[index].disable(m_primaryClient);
 	}
 	m_ruleList.erase(m_ruleList.begin() + index);
+	m_indexDirty = true;
 }
 
 CInputFilter::CRule&
 CInputFilter::getRule(UInt32 index)
 {
+	// the caller may change the rule's condition
+	m_indexDirty = true;
 	return m_ruleList[index];
 }
 
@@ -997,6 +1210,9 @@ CInputFilter::setPrimaryClient(CPrimaryClient* client)
 			rule->enable(m_primaryClient);
 		}
 	}
+
+	// hot key ids have changed
+	m_indexDirty = true;
 }
 
 CString
@@ -1018,6 +1234,39 @@ CInputFilter::getNumRules() const
 	return static_cast<UInt32>(m_ruleList.size());
 }
 
+bool
+CInputFilter::marshall(CConfigCacheWriter& writer) const
+{
+	writer.writeUInt32(static_cast<UInt32>(m_ruleList.size()));
+	for (CRuleList::const_iterator i = m_ruleList.begin();
+								i != m_ruleList.end(); ++i) {
+		if (!i->marshall(writer)) {
+			LOG((CLOG_DEBUG "cannot cache rule: %s", i->format().c_str()));
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+CInputFilter::unmarshall(CConfigCacheReader& reader)
+{
+	CPrimaryClient* oldClient = m_primaryClient;
+	setPrimaryClient(NULL);
+
+	m_ruleList.clear();
+
+	// each rule is at least a condition type and two action counts
+	UInt32 n = reader.readCount(9);
+	m_ruleList.resize(n);
+	for (UInt32 i = 0; i < n; ++i) {
+		m_ruleList[i].unmarshall(reader);
+	}
+	m_indexDirty = true;
+
+	setPrimaryClient(oldClient);
+}
+
 bool
 CInputFilter::operator==(const CInputFilter& x) const
 {
@@ -1056,10 +1305,36 @@ CInputFilter::handleEvent(const CEvent& event, void*)
 								event.getFlags() | CEvent::kDontFreeData |
 								CEvent::kDeliverImmediately);
 
-	// let each rule try to match the event until one does
-	for (CRuleList::iterator rule  = m_ruleList.begin();
-							 rule != m_ruleList.end(); ++rule) {
-		if (rule->handleEvent(myEvent)) {
+	if (m_indexDirty) {
+		rebuildIndex();
+	}
+
+	// find the rules indexed under the event's key.  most events (e.g.
+	// plain keystrokes) have no key and no rules to try at all.
+	static const CRuleIndexList s_noRules;
+	const CRuleIndexList* indexed = &s_noRules;
+	CIndexKey key = getEventIndexKey(myEvent);
+	if (key.m_kind != CIndexKey::kNone) {
+		CRuleIndex::const_iterator i = m_ruleIndex.find(key);
+		if (i != m_ruleIndex.end()) {
+			indexed = &i->second;
+		}
+	}
+
+	// let each candidate rule try to match the event, in rule list
+	// order, until one does
+	CRuleIndexList::const_iterator i = indexed->begin();
+	CRuleIndexList::const_iterator j = m_unindexedRules.begin();
+	while (i != indexed->end() || j != m_unindexedRules.end()) {
+		UInt32 index;
+		if (j == m_unindexedRules.end() ||
+			(i != indexed->end() && *i < *j)) {
+			index = *i++;
+		}
+		else {
+			index = *j++;
+		}
+		if (m_ruleList[index].handleEvent(myEvent)) {
 			// handled
 			return;
 		}
@@ -1068,3 +1343,140 @@ CInputFilter::handleEvent(const CEvent& event, void*)
 	// not handled so pass through
 	EVENTQUEUE->addEvent(myEvent);
 }
+
+void
+CInputFilter::rebuildIndex()
+{
+	m_ruleIndex.clear();
+	m_unindexedRules.clear();
+
+	UInt32 n = static_cast<UInt32>(m_ruleList.size());
+	for (UInt32 index = 0; index < n; ++index) {
+		// NULL condition never matches
+		const CCondition* condition = m_ruleList[index].getCondition();
+		if (condition == NULL) {
+			continue;
+		}
+
+		CIndexKey key = condition->getIndexKey();
+		if (key.m_kind == CIndexKey::kNone) {
+			m_unindexedRules.push_back(index);
+		}
+		else {
+			m_ruleIndex[key].push_back(index);
+		}
+	}
+
+	m_indexDirty = false;
+}
+
+CInputFilter::CIndexKey
+CInputFilter::getEventIndexKey(const CEvent& event)
+{
+	CEvent::Type type = event.getType();
+	if (type == IPrimaryScreen::getHotKeyDownEvent() ||
+		type == IPrimaryScreen::getHotKeyUpEvent()) {
+		IPrimaryScreen::CHotKeyInfo* kinfo =
+			reinterpret_cast<IPlatformScreen::CHotKeyInfo*>(event.getData());
+		return CIndexKey(CIndexKey::kHotKey, kinfo->m_id);
+	}
+	else if (type == IPrimaryScreen::getButtonDownEvent() ||
+		type == IPrimaryScreen::getButtonUpEvent()) {
+		IPlatformScreen::CButtonInfo* minfo =
+			reinterpret_cast<IPlatformScreen::CButtonInfo*>(event.getData());
+		return CIndexKey(CIndexKey::kButton, minfo->m_button,
+							minfo->m_mask & ~s_buttonIgnoreMask);
+	}
+	else if (type == CServer::getConnectedEvent()) {
+		return CIndexKey(CIndexKey::kConnect);
+	}
+	return CIndexKey();
+}
+
+CInputFilter::CCondition*
+CInputFilter::unmarshallCondition(CConfigCacheReader& reader)
+{
+	switch (reader.readUInt8()) {
+	case kKeystrokeConditionTag: {
+		KeyID key            = reader.readUInt32();
+		KeyModifierMask mask = reader.readUInt32();
+		return new CKeystrokeCondition(key, mask);
+	}
+
+	case kMouseButtonConditionTag: {
+		ButtonID button      = reader.readUInt8();
+		KeyModifierMask mask = reader.readUInt32();
+		return new CMouseButtonCondition(button, mask);
+	}
+
+	case kScreenConnectedConditionTag:
+		return new CScreenConnectedCondition(reader.readString());
+
+	default:
+		throw XConfigCache("unknown condition");
+	}
+}
+
+CInputFilter::CAction*
+CInputFilter::unmarshallAction(CConfigCacheReader& reader)
+{
+	switch (reader.readUInt8()) {
+	case kLockCursorToScreenActionTag:
+		return new CLockCursorToScreenAction(
+			static_cast<CLockCursorToScreenAction::Mode>(
+				reader.readEnum(CLockCursorToScreenAction::kToggle)));
+
+	case kSwitchToScreenActionTag:
+		return new CSwitchToScreenAction(reader.readString());
+
+	case kSwitchInDirectionActionTag: {
+		UInt32 direction = reader.readEnum(kLastDirection);
+		if (direction < kFirstDirection) {
+			throw XConfigCache("invalid direction");
+		}
+		return new CSwitchInDirectionAction(
+			static_cast<EDirection>(direction));
+	}
+
+	case kKeyboardBroadcastActionTag: {
+		CKeyboardBroadcastAction::Mode mode =
+			static_cast<CKeyboardBroadcastAction::Mode>(
+				reader.readEnum(CKeyboardBroadcastAction::kToggle));
+		std::set<CString> screens;
+		IKeyState::CKeyInfo::split(reader.readString().c_str(), screens);
+		return new CKeyboardBroadcastAction(mode, screens);
+	}
+
+	case kKeystrokeActionTag: {
+		bool press           = (reader.readUInt8() != 0);
+		KeyID key            = reader.readUInt32();
+		KeyModifierMask mask = reader.readUInt32();
+		KeyButton button     = static_cast<KeyButton>(reader.readUInt32());
+		SInt32 count         = static_cast<SInt32>(reader.readUInt32());
+		bool hasScreens      = (reader.readUInt8() != 0);
+		CString screens      = reader.readString();
+		IPlatformScreen::CKeyInfo* info;
+		if (hasScreens) {
+			std::set<CString> destinations;
+			IKeyState::CKeyInfo::split(screens.c_str(), destinations);
+			info = IKeyState::CKeyInfo::alloc(key, mask, button, count,
+								destinations);
+		}
+		else {
+			info = IKeyState::CKeyInfo::alloc(key, mask, button, count);
+		}
+		return new CKeystrokeAction(info, press);
+	}
+
+	case kMouseButtonActionTag: {
+		bool press           = (reader.readUInt8() != 0);
+		ButtonID button      = reader.readUInt8();
+		KeyModifierMask mask = reader.readUInt32();
+		return new CMouseButtonAction(
+			IPrimaryScreen::CButtonInfo::alloc(button, mask), press);
+	}
+
+	default:
+		throw XConfigCache("unknown action");
+	}
+}
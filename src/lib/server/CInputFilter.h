@@ -29,6 +29,8 @@
 
 class CPrimaryClient;
 class CEvent;
+class CConfigCacheWriter;
+class CConfigCacheReader;
 
 class CInputFilter {
 public:
@@ -41,6 +43,28 @@ public:
 		kDeactivate
 	};
 
+	// key used to index rules by the events their condition can match.
+	// an event is only matched against rules with an equal key and rules
+	// whose condition has no key (kNone).
+	class CIndexKey {
+	public:
+		enum EKind {
+			kNone,
+			kHotKey,
+			kButton,
+			kConnect
+		};
+
+		CIndexKey(EKind kind = kNone, UInt32 id = 0, KeyModifierMask mask = 0);
+
+		bool					operator<(const CIndexKey&) const;
+
+	public:
+		EKind					m_kind;
+		UInt32					m_id;
+		KeyModifierMask			m_mask;
+	};
+
 	class CCondition {
 	public:
 		CCondition();
@@ -51,6 +75,15 @@ public:
 
 		virtual EFilterStatus	match(const CEvent&) = 0;
 
+		// get the key of the events this condition can match.  the
+		// default is kNone, which means the condition is tried against
+		// every event.
+		virtual CIndexKey		getIndexKey() const;
+
+		// write the condition to a configuration cache.  returns false
+		// if the condition can't be cached, which is the default.
+		virtual bool			marshall(CConfigCacheWriter&) const;
+
 		virtual void			enablePrimary(CPrimaryClient*);
 		virtual void			disablePrimary(CPrimaryClient*);
 	};
@@ -69,6 +102,8 @@ public:
 		virtual CCondition*		clone() const;
 		virtual CString			format() const;
 		virtual EFilterStatus	match(const CEvent&);
+		virtual CIndexKey		getIndexKey() const;
+		virtual bool			marshall(CConfigCacheWriter&) const;
 		virtual void			enablePrimary(CPrimaryClient*);
 		virtual void			disablePrimary(CPrimaryClient*);
 
@@ -92,6 +127,8 @@ public:
 		virtual CCondition*		clone() const;
 		virtual CString			format() const;
 		virtual EFilterStatus	match(const CEvent&);
+		virtual CIndexKey		getIndexKey() const;
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		ButtonID				m_button;
@@ -108,6 +145,8 @@ public:
 		virtual CCondition*		clone() const;
 		virtual CString			format() const;
 		virtual EFilterStatus	match(const CEvent&);
+		virtual CIndexKey		getIndexKey() const;
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		CString					m_screen;
@@ -126,6 +165,10 @@ public:
 		virtual CString			format() const = 0;
 
         virtual void			perform(const CEvent&) = 0;
+
+		// write the action to a configuration cache.  returns false
+		// if the action can't be cached, which is the default.
+		virtual bool			marshall(CConfigCacheWriter&) const;
     };
 	
 	// CLockCursorToScreenAction
@@ -141,6 +184,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		Mode					m_mode;
@@ -157,6 +201,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		CString					m_screen;
@@ -173,6 +218,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		EDirection				m_direction;
@@ -193,6 +239,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	private:
 		Mode					m_mode;
@@ -214,6 +261,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	protected:
 		virtual const char*		formatName() const;
@@ -238,6 +286,7 @@ public:
 		virtual CAction*		clone() const;
 		virtual CString			format() const;
 		virtual void			perform(const CEvent&);
+		virtual bool			marshall(CConfigCacheWriter&) const;
 
 	protected:
 		virtual const char*		formatName() const;
@@ -289,6 +338,14 @@ public:
 		// get action by index
 		const CAction&	getAction(bool onActivation, UInt32 index) const;
 
+		// write the rule to a configuration cache.  returns false if
+		// the rule can't be cached.
+		bool			marshall(CConfigCacheWriter&) const;
+
+		// replace the rule with one read from a configuration cache.
+		// throws XConfigCache on error.
+		void			unmarshall(CConfigCacheReader&);
+
 	private:
 		void			clear();
 		void			copy(const CRule&);
@@ -331,18 +388,51 @@ public:
 	// get number of rules
 	UInt32				getNumRules() const;
 
+	//! Write rules to a configuration cache
+	/*!
+	Returns false if any rule can't be cached.
+	*/
+	bool				marshall(CConfigCacheWriter&) const;
+
+	//! Read rules from a configuration cache
+	/*!
+	Replaces the rules with those read from a configuration cache.
+	Throws XConfigCache on error.
+	*/
+	void				unmarshall(CConfigCacheReader&);
+
 	//! Compare filters
 	bool				operator==(const CInputFilter&) const;
 	//! Compare filters
 	bool				operator!=(const CInputFilter&) const;
 
 private:
+	typedef std::vector<UInt32> CRuleIndexList;
+	typedef std::map<CIndexKey, CRuleIndexList> CRuleIndex;
+
 	// event handling
 	void				handleEvent(const CEvent&, void*);
 
+	// rebuild the rule index from the rule list
+	void				rebuildIndex();
+
+	// get the index key of an event
+	static CIndexKey	getEventIndexKey(const CEvent&);
+
+	// read a condition or action written by its marshall()
+	static CCondition*	unmarshallCondition(CConfigCacheReader&);
+	static CAction*		unmarshallAction(CConfigCacheReader&);
+
 private:
 	CRuleList			m_ruleList;
 	CPrimaryClient*		m_primaryClient;
+
+	// rule indices by the key of the events they can match, and the
+	// indices of rules that must be tried against every event.  both
+	// lists are sorted so rules are still tried in rule list order.
+	CRuleIndex			m_ruleIndex;
+	CRuleIndexList		m_unindexedRules;
+	bool				m_indexDirty;
 };
 
 #endif
@@ -30,6 +30,7 @@
 #include "XSocket.h"
 #include "IEventQueue.h"
 #include "CLog.h"
+#include "CLatencyTrace.h"
 #include "TMethodEventJob.h"
 #include "CArch.h"
 #include "CKeyState.h"
@@ -93,7 +94,7 @@ CServer::CServer(const CConfig& config, CPrimaryClient* primaryClient, CScreen*
 			clipboard.m_clipboard.empty();
 			clipboard.m_clipboard.close();
 		}
-		clipboard.m_clipboardData   = clipboard.m_clipboard.marshall();
+		clipboard.m_clipboardData   = clipboard.m_clipboard.marshallBlob();
 	}
 
 	// install event handlers
@@ -319,6 +320,11 @@ CServer::adoptClient(CBaseClientProxy* client)
 	}
 	LOG((CLOG_NOTE "client \"%s\" has connected", getName(client).c_str()));
 
+	// a client resuming its session may already have the clipboards
+	if (client->isSessionResumed()) {
+		resumeClipboards(client);
+	}
+
 	// send configuration options to client
 	sendOptions(client);
 
@@ -359,6 +365,19 @@ CServer::gameDeviceFeedback(GameDeviceID id, UInt16 m1, UInt16 m2)
 	m_screen->gameDeviceFeedback(id, m1, m2);
 }
 
+bool
+CServer::resumeSession(const CString& name,
+				const CString& token, CClientSession& session)
+{
+	return m_sessions.resume(name, token, session, ARCH->time());
+}
+
+CString
+CServer::newSessionToken()
+{
+	return m_sessions.newToken();
+}
+
 UInt32
 CServer::getNumClients() const
 {
@@ -1289,7 +1308,7 @@ CServer::handleClipboardGrabbed(const CEvent& event, void* vclient)
 		clipboard.m_clipboard.empty();
 		clipboard.m_clipboard.close();
 	}
-	clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+	clipboard.m_clipboardData = clipboard.m_clipboard.marshallBlob();
 
 	// tell all other screens to take ownership of clipboard.  tell the
 	// grabber that it's clipboard isn't dirty.
@@ -1444,6 +1463,15 @@ CServer::handleClientDisconnected(const CEvent&, void* vclient)
 	// client has disconnected.  it might be an old client or an
 	// active client.  we don't care so just handle it both ways.
 	CBaseClientProxy* client = reinterpret_cast<CBaseClientProxy*>(vclient);
+
+	// save the session of an active client so it can resume it if
+	// it reconnects soon
+	CClientSession session;
+	if (m_clientSet.count(client) > 0 && client->getSession(session)) {
+		LOG((CLOG_DEBUG1 "saving session of \"%s\"", getName(client).c_str()));
+		m_sessions.save(getName(client), session, ARCH->time());
+	}
+
 	removeActiveClient(client);
 	removeOldClient(client);
 	delete client;
@@ -1588,7 +1616,7 @@ CServer::onClipboardChanged(CBaseClientProxy* sender,
 	sender->getClipboard(id, &clipboard.m_clipboard);
 
 	// ignore if data hasn't changed
-	CString data = clipboard.m_clipboard.marshall();
+	CClipboardBlob data = clipboard.m_clipboard.marshallBlob();
 	if (data == clipboard.m_clipboardData) {
 		LOG((CLOG_DEBUG "ignored screen \"%s\" update of clipboard %d (unchanged)", clipboard.m_clipboardOwner.c_str(), id));
 		return;
@@ -1753,6 +1781,7 @@ bool
 CServer::onMouseMovePrimary(SInt32 x, SInt32 y)
 {
 	LOG((CLOG_DEBUG4 "onMouseMovePrimary %d,%d", x, y));
+	CLatencyTrace::mark(CLatencyTrace::kDispatch);
 
 	// mouse move on primary (server's) screen
 	if (m_active != m_primaryClient) {
@@ -1834,6 +1863,7 @@ void
 CServer::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 {
 	LOG((CLOG_DEBUG2 "onMouseMoveSecondary %+d,%+d", dx, dy));
+	CLatencyTrace::mark(CLatencyTrace::kDispatch);
 
 	// mouse move on secondary (client's) screen
 	assert(m_active != NULL);
@@ -2151,6 +2181,27 @@ CServer::closeClients(const CConfig& config)
 	}
 }
 
+void
+CServer::resumeClipboards(CBaseClientProxy* client)
+{
+	CClientSession session;
+	if (!client->getSession(session)) {
+		return;
+	}
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		const CString& clientHash = session.m_clipboardHash[id];
+		if (clientHash.empty()) {
+			continue;
+		}
+
+		CClipboardInfo& clipboard = m_clipboards[id];
+		CString hash = CClientSession::hashClipboard(clipboard.m_clipboardData);
+		if (clientHash == hash) {
+			client->resumeClipboard(id, hash);
+		}
+	}
+}
+
 void
 CServer::removeActiveClient(CBaseClientProxy* client)
 {
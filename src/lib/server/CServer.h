@@ -20,6 +20,7 @@
 #define CSERVER_H
 
 #include "CConfig.h"
+#include "CClientSession.h"
 #include "CClipboard.h"
 #include "ClipboardTypes.h"
 #include "KeyTypes.h"
@@ -137,6 +138,18 @@ public:
 	//! Notify of game device feedback
 	void				gameDeviceFeedback(GameDeviceID id, UInt16 m1, UInt16 m2);
 
+	//! Resume client session
+	/*!
+	If client \p name disconnected recently and \p token is the token
+	of its session then copies the session to \p session and returns
+	true.  A session can only be resumed once.
+	*/
+	bool				resumeSession(const CString& name,
+							const CString& token, CClientSession& session);
+
+	//! Create session token
+	CString				newSessionToken();
+
 	//@}
 	//! @name accessors
 	//@{
@@ -388,6 +401,9 @@ private:
 	// except the primary client
 	void				closeAllClients();
 
+	// skip sending clipboards a client resuming its session already has
+	void				resumeClipboards(CBaseClientProxy*);
+
 	// remove clients from internal state
 	void				removeActiveClient(CBaseClientProxy*);
 	void				removeOldClient(CBaseClientProxy*);
@@ -402,7 +418,7 @@ private:
 
 	public:
 		CClipboard		m_clipboard;
-		CString			m_clipboardData;
+		CClipboardBlob	m_clipboardData;
 		CString			m_clipboardOwner;
 		UInt32			m_clipboardSeqNum;
 	};
@@ -446,6 +462,9 @@ private:
 	// clipboard cache
 	CClipboardInfo		m_clipboards[kClipboardEnd];
 
+	// sessions of recently disconnected clients
+	CClientSessions		m_sessions;
+
 	// state saved when screen saver activates
 	CBaseClientProxy*	m_activeSaver;
 	SInt32				m_xSaver, m_ySaver;
@@ -31,6 +31,8 @@
 #include "CIpcMessage.h"
 #include "Ipc.h"
 #include "CEventQueue.h"
+#include "CLatencyTrace.h"
+#include "CMetrics.h"
 
 #if SYSAPI_WIN32
 #include "CArchMiscWindows.h"
@@ -38,8 +40,10 @@
 #include "TMethodJob.h"
 #endif
 
+#include "stdfstream.h"
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if WINAPI_CARBON
 #include <ApplicationServices/ApplicationServices.h>
@@ -53,7 +57,8 @@ m_args(args),
 m_bye(&exit),
 m_taskBarReceiver(NULL),
 m_suspended(false),
-m_ipcClient(nullptr)
+m_ipcClient(nullptr),
+m_metricsTimer(NULL)
 {
 	assert(s_instance == nullptr);
 	s_instance = this;
@@ -153,6 +158,56 @@ CApp::parseArg(const int& argc, const char* const* argv, int& i)
 		argsBase().m_enableIpc = true;
 	}
 
+	else if (isArg(i, argc, argv, NULL, "--trace-latency")) {
+		argsBase().m_traceLatency = true;
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--headless")) {
+		argsBase().m_headless = true;
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--headless-script", 1)) {
+		argsBase().m_headless       = true;
+		argsBase().m_headlessScript = argv[++i];
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--crypto-pass", 1)) {
+		argsBase().m_cryptoPass = argv[++i];
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--crypto-pass-file", 1)) {
+		// the password is the first line of the file, which keeps it
+		// out of the process list
+		const char* pathname = argv[++i];
+		std::ifstream file(pathname);
+		CString password;
+		std::getline(file, password);
+		if (!password.empty() && password[password.size() - 1] == '\r') {
+			password.erase(password.size() - 1);
+		}
+		if (password.empty()) {
+			LOG((CLOG_PRINT "%s: cannot read password from `%s'" BYE,
+				argsBase().m_pname, pathname, argsBase().m_pname));
+			m_bye(kExitArgs);
+		}
+		argsBase().m_cryptoPass = password;
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--crypto-pass-env", 1)) {
+		const char* name     = argv[++i];
+		const char* password = getenv(name);
+		if (password == NULL || password[0] == '\0') {
+			LOG((CLOG_PRINT "%s: environment variable `%s' is not set" BYE,
+				argsBase().m_pname, name, argsBase().m_pname));
+			m_bye(kExitArgs);
+		}
+		argsBase().m_cryptoPass = password;
+	}
+
+	else if (isArg(i, argc, argv, NULL, "--metrics", 1)) {
+		argsBase().m_metricsInterval = atof(argv[++i]);
+	}
+
 #if VNC_SUPPORT
 	else if (isArg(i, argc, argv, NULL, "--vnc")) {
 		argsBase().m_enableVnc = true;
@@ -291,6 +346,10 @@ CApp::run(int argc, char** argv)
 		LOG((CLOG_CRIT "An unexpected exception occurred.\n"));
 	}
 
+	if (argsBase().m_traceLatency) {
+		CLatencyTrace::dump();
+	}
+
 	appUtil().beforeAppExit();
 	
 	return result;
@@ -340,6 +399,15 @@ CApp::initApp(int argc, const char** argv)
 	// load configuration
 	loadConfig();
 
+	if (argsBase().m_traceLatency) {
+		CLatencyTrace::setEnabled(true);
+		ARCH->setSignalHandler(CArch::kUSER, &dumpLatencySignalHandler, NULL);
+	}
+
+	if (argsBase().m_metricsInterval > 0.0) {
+		CMetrics::setEnabled(true);
+	}
+
 	if (!argsBase().m_disableTray) {
 
 		// create a log buffer so we can show the latest message
@@ -372,6 +440,48 @@ CApp::cleanupIpcClient()
 	delete m_ipcClient;
 }
 
+void
+CApp::initMetrics()
+{
+	if (argsBase().m_metricsInterval <= 0.0) {
+		return;
+	}
+
+	m_metricsTimer = EVENTQUEUE->newTimer(argsBase().m_metricsInterval, NULL);
+	EVENTQUEUE->adoptHandler(CEvent::kTimer, m_metricsTimer,
+		new TMethodEventJob<CApp>(this, &CApp::handleMetricsTimer));
+}
+
+void
+CApp::cleanupMetrics()
+{
+	if (m_metricsTimer == NULL) {
+		return;
+	}
+
+	EVENTQUEUE->removeHandler(CEvent::kTimer, m_metricsTimer);
+	EVENTQUEUE->deleteTimer(m_metricsTimer);
+	m_metricsTimer = NULL;
+
+	// the final totals
+	CMetrics::dump();
+}
+
+void
+CApp::handleMetricsTimer(const CEvent&, void*)
+{
+	CMetrics::dump();
+	if (m_ipcClient != NULL) {
+		m_ipcClient->send(CIpcMetricsMessage(CMetrics::format()));
+	}
+}
+
+void
+CApp::dumpLatencySignalHandler(CArch::ESignal, void*)
+{
+	CLatencyTrace::dump();
+}
+
 void
 CApp::handleIpcMessage(const CEvent& e, void*)
 {
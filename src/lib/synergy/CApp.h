@@ -22,6 +22,7 @@
 #include "CString.h"
 #include "IApp.h"
 #include "CIpcClient.h"
+#include "CArch.h"
 
 #if SYSAPI_WIN32
 #include "CAppUtilWindows.h"
@@ -34,6 +35,7 @@ class CBufferedLogOutputter;
 class ILogOutputter;
 class CFileLogOutputter;
 class CScreen;
+class CEventQueueTimer;
 
 typedef IArchTaskBarReceiver* (*CreateTaskBarReceiverFunc)(const CBufferedLogOutputter*);
 
@@ -96,12 +98,16 @@ public:
 
 private:
 	void				handleIpcMessage(const CEvent&, void*);
+	void				handleMetricsTimer(const CEvent&, void*);
+	static void			dumpLatencySignalHandler(CArch::ESignal, void*);
 
 protected:
 	virtual void parseArgs(int argc, const char* const* argv, int &i);
 	virtual bool parseArg(const int& argc, const char* const* argv, int& i);
 	void				initIpcClient();
 	void				cleanupIpcClient();
+	void				initMetrics();
+	void				cleanupMetrics();
 
 	IArchTaskBarReceiver* m_taskBarReceiver;
 	bool m_suspended;
@@ -113,6 +119,7 @@ private:
 	CreateTaskBarReceiverFunc m_createTaskBarReceiver;
 	ARCH_APP_UTIL m_appUtil;
 	CIpcClient*			m_ipcClient;
+	CEventQueueTimer*	m_metricsTimer;
 };
 
 #define BYE "\nTry `%s --help' for more information."
@@ -132,7 +139,24 @@ private:
 	"  -1, --no-restart         do not try to restart on failure.\n" \
 	"*     --restart            restart the server automatically if it fails.\n" \
 	"  -l  --log <file>         write log messages to file.\n" \
-	"      --no-tray            disable the system tray icon.\n"
+	"      --no-tray            disable the system tray icon.\n" \
+	"      --trace-latency      measure mouse motion latency and log it on exit\n" \
+	"                             (or SIGUSR2 on unix).\n" \
+	"      --headless           use a screen that needs no display, for testing.\n" \
+	"      --headless-script <file>\n" \
+	"                           use a headless screen, generating input from\n" \
+	"                             the script in file.\n" \
+	"      --crypto-pass <password>\n" \
+	"                           encrypt the connection with a key derived from\n" \
+	"                             password, which the other side must share.\n" \
+	"      --crypto-pass-file <file>\n" \
+	"                           like --crypto-pass but read the password from\n" \
+	"                             the first line of file.\n" \
+	"      --crypto-pass-env <variable>\n" \
+	"                           like --crypto-pass but read the password from\n" \
+	"                             the environment variable.\n" \
+	"      --metrics <seconds>  log connection and queue metrics, and send them\n" \
+	"                             to the gui, every so many seconds.\n"
 
 #define HELP_COMMON_INFO_2 \
 	"  -h, --help               display this help and exit.\n" \
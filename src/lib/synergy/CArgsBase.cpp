@@ -39,7 +39,12 @@ m_logFilter(NULL),
 m_logFile(NULL),
 m_display(NULL),
 m_enableVnc(false),
-m_enableIpc(false)
+m_enableIpc(false),
+m_traceLatency(false),
+m_headless(false),
+m_headlessScript(NULL),
+m_cryptoPass(),
+m_metricsInterval(0.0)
 {
 }
 
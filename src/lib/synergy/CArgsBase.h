@@ -37,6 +37,11 @@ public:
 	bool m_disableTray;
 	bool m_enableVnc;
 	bool m_enableIpc;
+	bool m_traceLatency;
+	bool m_headless;
+	const char* m_headlessScript;
+	CString m_cryptoPass;
+	double m_metricsInterval;
 #if SYSAPI_WIN32
 	bool m_debugServiceWait;
 	bool m_pauseOnExit;
@@ -31,12 +31,15 @@
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
 #include "CTCPSocketFactory.h"
+#include "CCryptoStreamFilterFactory.h"
 #include "XScreen.h"
+#include "CHeadlessScreen.h"
 #include "LogOutputters.h"
 #include "CSocketMultiplexer.h"
 #include "CEventQueue.h"
 #include "CThread.h"
 #include "TMethodJob.h"
+#include "osrng.h"
 
 #if SYSAPI_WIN32
 #include "CArchMiscWindows.h"
@@ -60,14 +63,19 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define RETRY_TIME 1.0
+#define MAX_RETRY_TIME 15.0
+#define RETRY_JITTER 0.25
 
 CClientApp::CClientApp(CreateTaskBarReceiverFunc createTaskBarReceiver) :
 CApp(createTaskBarReceiver, new CArgs()),
 s_client(NULL),
 s_clientScreen(NULL),
-m_vncThread(NULL)
+m_vncThread(NULL),
+m_retryTime(0.0),
+m_restartTimer(NULL)
 {
 }
 
@@ -233,6 +241,11 @@ CClientApp::daemonInfo() const
 CScreen*
 CClientApp::createScreen()
 {
+	if (args().m_headless) {
+		return new CScreen(new CHeadlessScreen(
+			false, args().m_headlessScript, *EVENTQUEUE));
+	}
+
 #if WINAPI_MSWINDOWS
 	return new CScreen(new CMSWindowsScreen(
 		false, args().m_noHooks, args().m_gameDevice, args().m_stopOnDeskSwitch));
@@ -265,31 +278,38 @@ CClientApp::updateStatus(const CString& msg)
 void
 CClientApp::resetRestartTimeout()
 {
-	// retry time can nolonger be changed
-	//s_retryTime = 0.0;
+	m_retryTime = 0.0;
 }
 
 
 double
 CClientApp::nextRestartTimeout()
 {
-	// retry at a constant rate (Issue 52)
-	return RETRY_TIME;
-
-	/*
-	// choose next restart timeout.  we start with rapid retries
-	// then slow down.
-	if (s_retryTime < 1.0) {
-	s_retryTime = 1.0;
-	}
-	else if (s_retryTime < 3.0) {
-	s_retryTime = 3.0;
+	// retry quickly at first (Issue 52) then back off exponentially so
+	// a server that's down for a while isn't hammered.
+	if (m_retryTime < RETRY_TIME) {
+		m_retryTime = RETRY_TIME;
 	}
 	else {
-	s_retryTime = 5.0;
+		m_retryTime *= 2.0;
+		if (m_retryTime > MAX_RETRY_TIME) {
+			m_retryTime = MAX_RETRY_TIME;
+		}
 	}
-	return s_retryTime;
-	*/
+
+	// add jitter so clients that lost the server at the same time
+	// don't all retry at the same time.  clients started together
+	// would share a clock based seed so seed from the OS instead.
+	static bool s_seeded = false;
+	if (!s_seeded) {
+		unsigned int seed;
+		CryptoPP::AutoSeededRandomPool random;
+		random.GenerateBlock(reinterpret_cast<byte*>(&seed), sizeof(seed));
+		srand(seed);
+		s_seeded = true;
+	}
+	double jitter = RETRY_JITTER * static_cast<double>(rand()) / RAND_MAX;
+	return m_retryTime * (1.0 - jitter);
 }
 
 
@@ -331,6 +351,9 @@ CClientApp::handleClientRestart(const CEvent&, void* vtimer)
 	CEventQueueTimer* timer = reinterpret_cast<CEventQueueTimer*>(vtimer);
 	EVENTQUEUE->deleteTimer(timer);
 	EVENTQUEUE->removeHandler(CEvent::kTimer, timer);
+	if (m_restartTimer == timer) {
+		m_restartTimer = NULL;
+	}
 
 	// reconnect
 	startClient();
@@ -340,11 +363,26 @@ CClientApp::handleClientRestart(const CEvent&, void* vtimer)
 void
 CClientApp::scheduleClientRestart(double retryTime)
 {
+	// only one retry can be pending
+	cancelClientRestart();
+
 	// install a timer and handler to retry later
-	LOG((CLOG_DEBUG "retry in %.0f seconds", retryTime));
+	LOG((CLOG_DEBUG "retry in %.1f seconds", retryTime));
 	CEventQueueTimer* timer = EVENTQUEUE->newOneShotTimer(retryTime, NULL);
 	EVENTQUEUE->adoptHandler(CEvent::kTimer, timer,
 		new TMethodEventJob<CClientApp>(this, &CClientApp::handleClientRestart, timer));
+	m_restartTimer = timer;
+}
+
+
+void
+CClientApp::cancelClientRestart()
+{
+	if (m_restartTimer != NULL) {
+		EVENTQUEUE->removeHandler(CEvent::kTimer, m_restartTimer);
+		EVENTQUEUE->deleteTimer(m_restartTimer);
+		m_restartTimer = NULL;
+	}
 }
 
 
@@ -352,6 +390,7 @@ void
 CClientApp::handleClientConnected(const CEvent&, void*)
 {
 	LOG((CLOG_NOTE "connected to server"));
+	cancelClientRestart();
 	resetRestartTimeout();
 	updateStatus();
 }
@@ -395,8 +434,15 @@ CClientApp::handleClientDisconnected(const CEvent&, void*)
 CClient*
 CClientApp::openClient(const CString& name, const CNetworkAddress& address, CScreen* screen)
 {
+	IStreamFilterFactory* streamFilterFactory = NULL;
+	if (!args().m_cryptoPass.empty()) {
+		streamFilterFactory =
+			new CCryptoStreamFilterFactory(args().m_cryptoPass, false);
+	}
+
 	CClient* client = new CClient(
-		*EVENTQUEUE, name, address, new CTCPSocketFactory, NULL, screen);
+		*EVENTQUEUE, name, address, new CTCPSocketFactory,
+		streamFilterFactory, screen);
 
 	try {
 		EVENTQUEUE->adoptHandler(
@@ -514,6 +560,7 @@ CClientApp::stopClient()
 	}
 #endif
 
+	cancelClientRestart();
 	closeClient(s_client);
 	closeClientScreen(s_clientScreen);
 	s_client       = NULL;
@@ -536,6 +583,7 @@ CClientApp::mainLoop()
 	if (argsBase().m_enableIpc) {
 		initIpcClient();
 	}
+	initMetrics();
 
 	// load all available plugins.
 	ARCH->plugin().init(s_clientScreen->getEventTarget());
@@ -546,6 +594,7 @@ CClientApp::mainLoop()
 	DAEMON_RUNNING(true);
 	EVENTQUEUE->loop();
 	DAEMON_RUNNING(false);
+	cleanupMetrics();
 
 	// close down
 	LOG((CLOG_DEBUG1 "stopping client"));
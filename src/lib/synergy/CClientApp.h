@@ -26,6 +26,7 @@ class CEvent;
 class CClient;
 class CNetworkAddress;
 class CThread;
+class CEventQueueTimer;
 
 class CClientApp : public CApp {
 public:
@@ -71,6 +72,7 @@ public:
 	void closeClientScreen(CScreen* screen);
 	void handleClientRestart(const CEvent&, void* vtimer);
 	void scheduleClientRestart(double retryTime);
+	void cancelClientRestart();
 	void handleClientConnected(const CEvent&, void*);
 	void handleClientFailed(const CEvent& e, void*);
 	void handleClientDisconnected(const CEvent&, void*);
@@ -91,4 +93,6 @@ private:
 	CClient* s_client;
 	CScreen* s_clientScreen;
 	CThread* m_vncThread;
+	double m_retryTime;
+	CEventQueueTimer* m_restartTimer;
 };
@@ -43,7 +43,7 @@ CClipboard::empty()
 
 	// clear all data
 	for (SInt32 index = 0; index < kNumFormats; ++index) {
-		m_data[index]  = "";
+		m_data[index]  = CClipboardBlob();
 		m_added[index] = false;
 	}
 
@@ -62,10 +62,30 @@ CClipboard::add(EFormat format, const CString& data)
 	assert(m_open);
 	assert(m_owner);
 
+	m_data[format]  = CClipboardBlob(data);
+	m_added[format] = true;
+}
+
+void
+CClipboard::addBlob(EFormat format, const CClipboardBlob& data)
+{
+	assert(m_open);
+	assert(m_owner);
+
 	m_data[format]  = data;
 	m_added[format] = true;
 }
 
+void
+CClipboard::remove(EFormat format)
+{
+	assert(m_open);
+	assert(m_owner);
+
+	m_data[format]  = CClipboardBlob();
+	m_added[format] = false;
+}
+
 bool
 CClipboard::open(Time time) const
 {
@@ -100,6 +120,13 @@ CClipboard::has(EFormat format) const
 
 CString
 CClipboard::get(EFormat format) const
+{
+	assert(m_open);
+	return m_data[format].toString();
+}
+
+CClipboardBlob
+CClipboard::getBlob(EFormat format) const
 {
 	assert(m_open);
 	return m_data[format];
@@ -111,8 +138,74 @@ CClipboard::unmarshall(const CString& data, Time time)
 	IClipboard::unmarshall(this, data, time);
 }
 
+void
+CClipboard::unmarshall(const CClipboardBlob& data, Time time)
+{
+	IClipboard::unmarshall(this, data, time);
+}
+
 CString
 CClipboard::marshall() const
 {
-	return IClipboard::marshall(this);
+	return marshallBlob().toString();
+}
+
+CClipboardBlob
+CClipboard::marshallBlob() const
+{
+	CClipboardBlob whole;
+	if (isMarshalled(whole)) {
+		return whole;
+	}
+
+	// build the buffer then share it.  the layout is always the
+	// same so each format's data starts 8 bytes after its header.
+	CString data = IClipboard::marshall(this);
+	whole        = CClipboardBlob::adopt(data);
+	UInt32 offset = 4;
+	for (SInt32 index = 0; index < kNumFormats; ++index) {
+		if (m_added[index]) {
+			UInt32 size    = m_data[index].size();
+			m_data[index]  = CClipboardBlob(whole, offset + 8, size);
+			offset        += 8 + size;
+		}
+	}
+	return whole;
+}
+
+bool
+CClipboard::isMarshalled(CClipboardBlob& whole) const
+{
+	// find the buffer the first format is a slice of
+	const CClipboardBlob* first = NULL;
+	for (SInt32 index = 0; index < kNumFormats; ++index) {
+		if (m_added[index]) {
+			first = &m_data[index];
+			break;
+		}
+	}
+	if (first == NULL) {
+		return false;
+	}
+	whole = first->getWhole();
+
+	// check the count then each header and that the data follows it
+	const char* buffer = whole.data();
+	UInt32 numFormats  = 0;
+	UInt32 offset      = 4;
+	for (SInt32 index = 0; index < kNumFormats; ++index) {
+		if (!m_added[index]) {
+			continue;
+		}
+		const CClipboardBlob& data = m_data[index];
+		if (!data.shares(whole) ||
+			data.getOffset() != offset + 8 ||
+			readUInt32(buffer + offset) != static_cast<UInt32>(index) ||
+			readUInt32(buffer + offset + 4) != data.size()) {
+			return false;
+		}
+		offset += 8 + data.size();
+		++numFormats;
+	}
+	return (offset == whole.size() && readUInt32(buffer) == numFormats);
 }
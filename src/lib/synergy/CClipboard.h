@@ -40,6 +40,20 @@ public:
 	*/
 	void				unmarshall(const CString& data, Time time);
 
+	//! Unmarshall shared clipboard data
+	/*!
+	Like unmarshall(const CString&, Time) but the clipboard's formats
+	share \p data instead of copying it.
+	*/
+	void				unmarshall(const CClipboardBlob& data, Time time);
+
+	//! Remove data
+	/*!
+	Remove the data in the given format.  May only be called after a
+	successful empty().
+	*/
+	void				remove(EFormat);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -51,16 +65,34 @@ public:
 	*/
 	CString				marshall() const;
 
+	//! Marshall clipboard data into a shared buffer
+	/*!
+	Like marshall() but returns the buffer as a blob.  If the clipboard
+	was unmarshalled (or copied from a clipboard that was) and hasn't
+	changed since then the buffer it was unmarshalled from is returned
+	without copying.  Otherwise a new buffer is built and the clipboard's
+	formats are switched to share it, so marshalling again is free.
+	*/
+	CClipboardBlob		marshallBlob() const;
+
 	//@}
 
 	// IClipboard overrides
 	virtual bool		empty();
 	virtual void		add(EFormat, const CString& data);
+	virtual void		addBlob(EFormat, const CClipboardBlob& data);
 	virtual bool		open(Time) const;
 	virtual void		close() const;
 	virtual Time		getTime() const;
 	virtual bool		has(EFormat) const;
 	virtual CString		get(EFormat) const;
+	virtual CClipboardBlob	getBlob(EFormat) const;
+
+private:
+	// returns true iff every format's data is a slice of one buffer
+	// laid out exactly as marshall() would lay it out.  sets \p whole
+	// to that buffer.
+	bool				isMarshalled(CClipboardBlob& whole) const;
 
 private:
 	mutable bool		m_open;
@@ -68,7 +100,7 @@ private:
 	bool				m_owner;
 	Time				m_timeOwned;
 	bool				m_added[kNumFormats];
-	CString				m_data[kNumFormats];
+	mutable CClipboardBlob	m_data[kNumFormats];
 };
 
 #endif
@@ -0,0 +1,180 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CClipboardBlob.h"
+#include <cstring>
+
+//
+// CClipboardBlob
+//
+
+CClipboardBlob::CClipboardBlob() :
+	m_rep(NULL),
+	m_offset(0),
+	m_size(0)
+{
+	// do nothing
+}
+
+CClipboardBlob::CClipboardBlob(const CString& data) :
+	m_rep(new CRep),
+	m_offset(0),
+	m_size(static_cast<UInt32>(data.size()))
+{
+	m_rep->m_data = data;
+	m_rep->m_refs = 1;
+}
+
+CClipboardBlob::CClipboardBlob(const CClipboardBlob& blob,
+				UInt32 offset, UInt32 size) :
+	m_rep(blob.m_rep),
+	m_offset(blob.m_offset),
+	m_size(0)
+{
+	if (offset > blob.m_size) {
+		offset = blob.m_size;
+	}
+	if (size > blob.m_size - offset) {
+		size = blob.m_size - offset;
+	}
+	m_offset += offset;
+	m_size    = size;
+	ref();
+}
+
+CClipboardBlob::CClipboardBlob(const CClipboardBlob& blob) :
+	m_rep(blob.m_rep),
+	m_offset(blob.m_offset),
+	m_size(blob.m_size)
+{
+	ref();
+}
+
+CClipboardBlob::~CClipboardBlob()
+{
+	unref();
+}
+
+CClipboardBlob&
+CClipboardBlob::operator=(const CClipboardBlob& blob)
+{
+	// ref first in case blob shares our buffer
+	CRep* rep = blob.m_rep;
+	if (rep != NULL) {
+		++rep->m_refs;
+	}
+	unref();
+	m_rep    = rep;
+	m_offset = blob.m_offset;
+	m_size   = blob.m_size;
+	return *this;
+}
+
+CClipboardBlob
+CClipboardBlob::adopt(CString& data)
+{
+	CClipboardBlob blob;
+	blob.m_rep         = new CRep;
+	blob.m_rep->m_refs = 1;
+	blob.m_rep->m_data.swap(data);
+	blob.m_size        = static_cast<UInt32>(blob.m_rep->m_data.size());
+	return blob;
+}
+
+const char*
+CClipboardBlob::data() const
+{
+	if (m_rep == NULL) {
+		return "";
+	}
+	return m_rep->m_data.data() + m_offset;
+}
+
+UInt32
+CClipboardBlob::size() const
+{
+	return m_size;
+}
+
+bool
+CClipboardBlob::empty() const
+{
+	return (m_size == 0);
+}
+
+CString
+CClipboardBlob::toString() const
+{
+	return CString(data(), m_size);
+}
+
+CClipboardBlob
+CClipboardBlob::getWhole() const
+{
+	CClipboardBlob blob(*this);
+	blob.m_offset = 0;
+	blob.m_size   = (m_rep == NULL) ? 0 :
+						static_cast<UInt32>(m_rep->m_data.size());
+	return blob;
+}
+
+UInt32
+CClipboardBlob::getOffset() const
+{
+	return m_offset;
+}
+
+bool
+CClipboardBlob::shares(const CClipboardBlob& blob) const
+{
+	return (m_rep != NULL && m_rep == blob.m_rep);
+}
+
+bool
+CClipboardBlob::operator==(const CClipboardBlob& blob) const
+{
+	if (m_size != blob.m_size) {
+		return false;
+	}
+	if (m_rep == blob.m_rep && m_offset == blob.m_offset) {
+		return true;
+	}
+	return (memcmp(data(), blob.data(), m_size) == 0);
+}
+
+bool
+CClipboardBlob::operator!=(const CClipboardBlob& blob) const
+{
+	return !operator==(blob);
+}
+
+void
+CClipboardBlob::ref()
+{
+	if (m_rep != NULL) {
+		++m_rep->m_refs;
+	}
+}
+
+void
+CClipboardBlob::unref()
+{
+	if (m_rep != NULL && --m_rep->m_refs == 0) {
+		delete m_rep;
+	}
+	m_rep = NULL;
+}
@@ -0,0 +1,125 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CCLIPBOARDBLOB_H
+#define CCLIPBOARDBLOB_H
+
+#include "CString.h"
+#include "BasicTypes.h"
+
+//! Shared clipboard data
+/*!
+An immutable, reference counted slice of a clipboard buffer.  Copying
+a blob or taking a slice of it shares the underlying buffer instead of
+copying the bytes, so one clipboard payload can be held by the server's
+clipboard, each client proxy's clipboard and the marshalled message
+at once while existing only once in memory.
+
+The reference count is not synchronized;  a blob and all blobs that
+share its buffer must only be used by one thread.
+*/
+class CClipboardBlob {
+public:
+	//! Create an empty blob
+	CClipboardBlob();
+	//! Create a blob holding a copy of \p data
+	explicit CClipboardBlob(const CString& data);
+	//! Create a blob sharing \p size bytes of \p blob at \p offset
+	/*!
+	The slice is clamped to the extent of \p blob.
+	*/
+	CClipboardBlob(const CClipboardBlob& blob, UInt32 offset, UInt32 size);
+	CClipboardBlob(const CClipboardBlob&);
+	~CClipboardBlob();
+
+	CClipboardBlob&		operator=(const CClipboardBlob&);
+
+	//! @name manipulators
+	//@{
+
+	//! Create a blob from a string without copying it
+	/*!
+	Returns a blob holding the contents of \p data.  \p data is left
+	empty.
+	*/
+	static CClipboardBlob	adopt(CString& data);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get data
+	/*!
+	Returns a pointer to the first byte of the blob.  The data is not
+	nul terminated.
+	*/
+	const char*			data() const;
+
+	//! Get size
+	UInt32				size() const;
+
+	//! Test for no data
+	bool				empty() const;
+
+	//! Get data as a string
+	/*!
+	Returns a copy of the data.
+	*/
+	CString				toString() const;
+
+	//! Get the whole buffer
+	/*!
+	Returns a blob spanning the entire buffer this blob is a slice of.
+	*/
+	CClipboardBlob		getWhole() const;
+
+	//! Get offset
+	/*!
+	Returns the offset of this blob in the buffer returned by getWhole().
+	*/
+	UInt32				getOffset() const;
+
+	//! Test for a shared buffer
+	/*!
+	Returns true iff this blob and \p blob are slices of the same buffer.
+	*/
+	bool				shares(const CClipboardBlob& blob) const;
+
+	//! Compare data
+	bool				operator==(const CClipboardBlob&) const;
+	//! Compare data
+	bool				operator!=(const CClipboardBlob&) const;
+
+	//@}
+
+private:
+	class CRep {
+	public:
+		CString			m_data;
+		UInt32			m_refs;
+	};
+
+	void				ref();
+	void				unref();
+
+private:
+	CRep*				m_rep;
+	UInt32				m_offset;
+	UInt32				m_size;
+};
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CCryptoStream.h"
+#include "IEventQueue.h"
+#include "CLock.h"
+#include "CLog.h"
+#include "TMethodEventJob.h"
+#include "aes.h"
+#include "eccrypto.h"
+#include "gcm.h"
+#include "hmac.h"
+#include "oids.h"
+#include "osrng.h"
+#include "pwdbased.h"
+#include "sha.h"
+#include <cstring>
+
+// sent by each side before anything else.  the server follows it with
+// its salt and public key, the client with its public key.
+static const char		s_magic[] = "SGC2";
+static const UInt32		s_magicSize = 4;
+
+// an uncompressed P-256 point
+static const UInt32		s_publicKeySize = 65;
+
+// PBKDF2 iterations.  this is paid once per connection by each side.
+static const unsigned int	s_iterations = 100000;
+
+//
+// CCryptoStream::CCiphers
+//
+
+class CCryptoStream::CCiphers {
+public:
+	CCiphers() :
+		m_dh(CryptoPP::ASN1::secp256r1()),
+		m_privateKey(m_dh.PrivateKeyLength()),
+		m_publicKey(m_dh.PublicKeyLength()),
+		m_passwordKey(kKeySize),
+		m_sendSeq(0),
+		m_recvSeq(0)
+	{
+		assert(m_publicKey.size() == s_publicKeySize);
+	}
+
+	// the IV of a record is its sequence number
+	static void			makeIV(UInt8* iv, CryptoPP::word64 seq)
+	{
+		memset(iv, 0, 4);
+		for (int i = 11; i >= 4; --i, seq >>= 8) {
+			iv[i] = static_cast<UInt8>(seq & 0xff);
+		}
+	}
+
+public:
+	CryptoPP::ECDH<CryptoPP::ECP>::Domain		m_dh;
+	CryptoPP::SecByteBlock	m_privateKey;
+	CryptoPP::SecByteBlock	m_publicKey;
+	CryptoPP::SecByteBlock	m_passwordKey;
+	CryptoPP::GCM<CryptoPP::AES>::Encryption	m_encrypt;
+	CryptoPP::GCM<CryptoPP::AES>::Decryption	m_decrypt;
+	CryptoPP::word64	m_sendSeq;
+	CryptoPP::word64	m_recvSeq;
+};
+
+//
+// CCryptoStream
+//
+
+CEvent::Type			CCryptoStream::s_flushEvent = CEvent::kUnknown;
+
+CCryptoStream::CCryptoStream(synergy::IStream* stream, const CString& password,
+				bool isServer, bool adoptStream) :
+	CStreamFilter(stream, adoptStream),
+	m_password(password),
+	m_isServer(isServer),
+	m_state(kWaitHello),
+	m_ciphers(new CCiphers),
+	m_flushPending(false),
+	m_inputShutdown(false),
+	m_record(new UInt8[4 + kMaxRecordSize + kTagSize])
+{
+	CryptoPP::AutoSeededRandomPool random;
+	m_ciphers->m_dh.GenerateKeyPair(random,
+							m_ciphers->m_privateKey, m_ciphers->m_publicKey);
+	memset(m_salt, 0, sizeof(m_salt));
+
+	// flush events are targeted at the ciphers because the filter on
+	// top of us replaces all of the handlers for our event target
+	EVENTQUEUE->adoptHandler(getFlushEvent(), m_ciphers,
+							new TMethodEventJob<CCryptoStream>(this,
+								&CCryptoStream::handleFlush));
+
+	// the server speaks first, and picks the salt, so the client knows
+	// the connection is up when it answers
+	if (m_isServer) {
+		random.GenerateBlock(m_salt, sizeof(m_salt));
+		stretchPassword();
+		writeHello();
+	}
+}
+
+CCryptoStream::~CCryptoStream()
+{
+	if (m_state == kReady) {
+		sealRecords();
+	}
+	EVENTQUEUE->removeHandler(getFlushEvent(), m_ciphers);
+	delete[] m_record;
+	delete m_ciphers;
+}
+
+void
+CCryptoStream::close()
+{
+	if (m_state == kReady) {
+		sealRecords();
+	}
+	CLock lock(&m_mutex);
+	m_input.pop(m_input.getSize());
+	m_plaintext.pop(m_plaintext.getSize());
+	CStreamFilter::close();
+}
+
+UInt32
+CCryptoStream::read(void* buffer, UInt32 n)
+{
+	CLock lock(&m_mutex);
+	if (n > m_plaintext.getSize()) {
+		n = m_plaintext.getSize();
+	}
+	if (n == 0) {
+		return 0;
+	}
+	if (buffer != NULL) {
+		memcpy(buffer, m_plaintext.peek(n), n);
+	}
+	m_plaintext.pop(n);
+
+	if (m_inputShutdown && m_plaintext.getSize() == 0) {
+		EVENTQUEUE->addEvent(CEvent(getInputShutdownEvent(),
+						getEventTarget(), NULL));
+	}
+	return n;
+}
+
+void
+CCryptoStream::write(const void* buffer, UInt32 n)
+{
+	if (n == 0 || m_state == kFailed) {
+		return;
+	}
+	m_pending.append(reinterpret_cast<const char*>(buffer), n);
+
+	// everything written before the keys are agreed goes in the first
+	// records
+	if (m_state != kReady) {
+		return;
+	}
+
+	if (m_pending.size() >= kMaxRecordSize) {
+		sealRecords();
+	}
+	else if (!m_flushPending) {
+		m_flushPending = true;
+		EVENTQUEUE->addEvent(CEvent(getFlushEvent(), m_ciphers));
+	}
+}
+
+void
+CCryptoStream::flush()
+{
+	if (m_state == kReady) {
+		sealRecords();
+	}
+	CStreamFilter::flush();
+}
+
+void
+CCryptoStream::shutdownInput()
+{
+	CLock lock(&m_mutex);
+	m_input.pop(m_input.getSize());
+	m_plaintext.pop(m_plaintext.getSize());
+	CStreamFilter::shutdownInput();
+}
+
+void
+CCryptoStream::shutdownOutput()
+{
+	if (m_state == kReady) {
+		sealRecords();
+	}
+	CStreamFilter::shutdownOutput();
+}
+
+bool
+CCryptoStream::isReady() const
+{
+	CLock lock(&m_mutex);
+	return (m_plaintext.getSize() != 0);
+}
+
+UInt32
+CCryptoStream::getSize() const
+{
+	CLock lock(&m_mutex);
+	return m_plaintext.getSize();
+}
+
+UInt32
+CCryptoStream::getOutputSize() const
+{
+	// plaintext waiting to be sealed counts as unsent
+	return static_cast<UInt32>(m_pending.size()) +
+							CStreamFilter::getOutputSize();
+}
+
+void
+CCryptoStream::filterEvent(const CEvent& event)
+{
+	if (event.getType() == getInputReadyEvent()) {
+		CLock lock(&m_mutex);
+		if (!readMore()) {
+			return;
+		}
+	}
+	else if (event.getType() == getInputShutdownEvent()) {
+		// discard this if we have buffered data
+		CLock lock(&m_mutex);
+		m_inputShutdown = true;
+		if (m_plaintext.getSize() != 0) {
+			return;
+		}
+	}
+
+	// pass event
+	CStreamFilter::filterEvent(event);
+}
+
+bool
+CCryptoStream::readMore()
+{
+	// note -- m_mutex must be locked on entry
+
+	bool wasReady = (m_plaintext.getSize() != 0);
+
+	// read everything the stream has
+	UInt8 buffer[4096];
+	UInt32 n = getStream()->read(buffer, sizeof(buffer));
+	while (n > 0) {
+		m_input.write(buffer, n);
+		n = getStream()->read(buffer, sizeof(buffer));
+	}
+
+	if (m_state == kWaitHello && !readHello()) {
+		return false;
+	}
+	if (m_state == kReady && !openRecords()) {
+		return false;
+	}
+
+	// tell the filter above us if it has something to read now
+	return (!wasReady && m_plaintext.getSize() != 0);
+}
+
+bool
+CCryptoStream::readHello()
+{
+	// note -- m_mutex must be locked on entry
+
+	UInt32 size = s_magicSize + (m_isServer ? 0 : kSaltSize) + s_publicKeySize;
+	if (m_input.getSize() < size) {
+		return true;
+	}
+	const UInt8* data = reinterpret_cast<const UInt8*>(m_input.peek(size));
+	if (memcmp(data, s_magic, s_magicSize) != 0) {
+		fail("peer is not using encryption or is using an older version");
+		return false;
+	}
+
+	const UInt8* peerPublicKey = data + s_magicSize;
+	if (!m_isServer) {
+		memcpy(m_salt, data + s_magicSize, kSaltSize);
+		peerPublicKey += kSaltSize;
+		stretchPassword();
+		writeHello();
+	}
+	bool agreed = deriveKeys(peerPublicKey);
+	m_input.pop(size);
+	if (!agreed) {
+		fail("invalid public key");
+		return false;
+	}
+	m_state = kReady;
+	LOG((CLOG_DEBUG "encryption keys agreed"));
+
+	// send whatever was written while we waited
+	sealRecords();
+	return true;
+}
+
+void
+CCryptoStream::writeHello()
+{
+	UInt8 buffer[s_magicSize + kSaltSize + s_publicKeySize];
+	UInt32 n = 0;
+	memcpy(buffer, s_magic, s_magicSize);
+	n += s_magicSize;
+	if (m_isServer) {
+		memcpy(buffer + n, m_salt, kSaltSize);
+		n += kSaltSize;
+	}
+	memcpy(buffer + n, m_ciphers->m_publicKey, s_publicKeySize);
+	n += s_publicKeySize;
+	getStream()->write(buffer, n);
+}
+
+void
+CCryptoStream::stretchPassword()
+{
+	CryptoPP::PKCS5_PBKDF2_HMAC<CryptoPP::SHA256> pbkdf2;
+	pbkdf2.DeriveKey(m_ciphers->m_passwordKey, kKeySize, 0,
+		reinterpret_cast<const UInt8*>(m_password.data()), m_password.size(),
+		m_salt, kSaltSize, s_iterations);
+
+	// the password isn't needed again
+	m_password.assign(m_password.size(), '\0');
+	m_password.erase();
+}
+
+bool
+CCryptoStream::deriveKeys(const UInt8* peerPublicKey)
+{
+	CCiphers& ciphers = *m_ciphers;
+	CryptoPP::SecByteBlock secret(ciphers.m_dh.AgreedValueLength());
+	try {
+		// this rejects points that aren't on the curve
+		if (!ciphers.m_dh.Agree(secret, ciphers.m_privateKey, peerPublicKey)) {
+			return false;
+		}
+	}
+	catch (CryptoPP::Exception&) {
+		return false;
+	}
+
+	// a key for each direction from the stretched password, the shared
+	// secret and everything else in the handshake
+	const UInt8* serverPublicKey = m_isServer ? ciphers.m_publicKey.data() :
+												peerPublicKey;
+	const UInt8* clientPublicKey = m_isServer ? peerPublicKey :
+												ciphers.m_publicKey.data();
+	UInt8 keys[2][kKeySize];
+	for (int i = 0; i < 2; ++i) {
+		CryptoPP::HMAC<CryptoPP::SHA256> hmac(ciphers.m_passwordKey,
+							ciphers.m_passwordKey.size());
+		hmac.Update(reinterpret_cast<const UInt8*>(
+							(i == 0) ? "server" : "client"), 6);
+		hmac.Update(secret, secret.size());
+		hmac.Update(m_salt, kSaltSize);
+		hmac.Update(serverPublicKey, s_publicKeySize);
+		hmac.Update(clientPublicKey, s_publicKeySize);
+		hmac.Final(keys[i]);
+	}
+
+	// the IV is replaced for every record
+	UInt8 iv[12];
+	CCiphers::makeIV(iv, 0);
+	ciphers.m_encrypt.SetKeyWithIV(keys[m_isServer ? 0 : 1], kKeySize,
+							iv, sizeof(iv));
+	ciphers.m_decrypt.SetKeyWithIV(keys[m_isServer ? 1 : 0], kKeySize,
+							iv, sizeof(iv));
+	memset(keys, 0, sizeof(keys));
+
+	// forget the secrets behind the keys
+	ciphers.m_privateKey.CleanNew(0);
+	ciphers.m_passwordKey.CleanNew(0);
+	return true;
+}
+
+void
+CCryptoStream::sealRecords()
+{
+	// each record is the size of the ciphertext, the ciphertext and
+	// the tag
+	size_t offset = 0;
+	while (offset < m_pending.size()) {
+		UInt32 n = static_cast<UInt32>(m_pending.size() - offset);
+		if (n > kMaxRecordSize) {
+			n = kMaxRecordSize;
+		}
+		UInt32 size = n + kTagSize;
+		m_record[0] = (UInt8)((size >> 24) & 0xff);
+		m_record[1] = (UInt8)((size >> 16) & 0xff);
+		m_record[2] = (UInt8)((size >>  8) & 0xff);
+		m_record[3] = (UInt8)( size        & 0xff);
+
+		UInt8 iv[12];
+		CCiphers::makeIV(iv, m_ciphers->m_sendSeq++);
+		m_ciphers->m_encrypt.EncryptAndAuthenticate(
+			m_record + 4, m_record + 4 + n, kTagSize, iv, sizeof(iv),
+			NULL, 0,
+			reinterpret_cast<const UInt8*>(m_pending.data()) + offset, n);
+
+		getStream()->write(m_record, 4 + size);
+		offset += n;
+	}
+	m_pending.erase();
+}
+
+bool
+CCryptoStream::openRecords()
+{
+	// note -- m_mutex must be locked on entry
+
+	while (m_input.getSize() >= 4) {
+		const UInt8* header = reinterpret_cast<const UInt8*>(m_input.peek(4));
+		UInt32 size = ((UInt32)header[0] << 24) |
+					  ((UInt32)header[1] << 16) |
+					  ((UInt32)header[2] <<  8) |
+					   (UInt32)header[3];
+		if (size < kTagSize || size > kMaxRecordSize + kTagSize) {
+			fail("invalid encrypted record");
+			return false;
+		}
+		if (m_input.getSize() < 4 + size) {
+			break;
+		}
+
+		const UInt8* record = reinterpret_cast<const UInt8*>(
+							m_input.peek(4 + size)) + 4;
+		UInt32 n = size - kTagSize;
+		UInt8 iv[12];
+		CCiphers::makeIV(iv, m_ciphers->m_recvSeq++);
+		if (!m_ciphers->m_decrypt.DecryptAndVerify(
+				m_record, record + n, kTagSize, iv, sizeof(iv),
+				NULL, 0, record, n)) {
+			fail("cannot decrypt data, the passwords probably differ");
+			return false;
+		}
+		m_input.pop(4 + size);
+		m_plaintext.write(m_record, n);
+	}
+	return true;
+}
+
+void
+CCryptoStream::fail(const char* msg)
+{
+	// note -- m_mutex must be locked on entry
+
+	LOG((CLOG_ERR "encrypted connection failed: %s", msg));
+	m_state = kFailed;
+	m_input.pop(m_input.getSize());
+	m_pending.erase();
+	m_inputShutdown = true;
+	if (m_plaintext.getSize() == 0) {
+		EVENTQUEUE->addEvent(CEvent(getInputShutdownEvent(),
+						getEventTarget(), NULL));
+	}
+}
+
+void
+CCryptoStream::handleFlush(const CEvent&, void*)
+{
+	m_flushPending = false;
+	if (m_state == kReady) {
+		sealRecords();
+	}
+}
+
+CEvent::Type
+CCryptoStream::getFlushEvent()
+{
+	return EVENTQUEUE->registerTypeOnce(s_flushEvent,
+							"CCryptoStream::flush");
+}
@@ -0,0 +1,118 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CCRYPTOSTREAM_H
+#define CCRYPTOSTREAM_H
+
+#include "CStreamFilter.h"
+#include "CStreamBuffer.h"
+#include "CMutex.h"
+#include "CString.h"
+
+//! Encrypting stream filter
+/*!
+Encrypts everything written to the stream and decrypts everything read
+from it using AES-256 in GCM mode, so the data is also authenticated.
+Crypto++ uses AES-NI and CLMUL instructions on CPUs that have them.
+
+Once per connection the server sends a random salt and an ephemeral
+P-256 public key and the client answers with its own public key.  The
+password is stretched with PBKDF2-HMAC-SHA256 over the salt and each
+direction's key is an HMAC, keyed with the stretched password, of the
+ECDH shared secret and the handshake.  Recording a session isn't enough
+to test password guesses or to decrypt it once the password is known,
+and a peer without the password can't produce records that verify.
+Records in each direction use their sequence number as the IV.
+
+Writes are batched:  everything written while handling an event goes
+into a single record, which is sealed when the event queue gets to the
+flush event posted by the first write, on flush() or when the record
+is full.
+*/
+class CCryptoStream : public CStreamFilter {
+public:
+	enum {
+		kSaltSize      = 16,
+		kKeySize       = 32,
+		kTagSize       = 16,
+		kMaxRecordSize = 16384
+	};
+
+	/*!
+	Create an encrypting filter on \p stream using the shared password
+	\p password.  \p isServer is true on the accepting side of the
+	connection.
+	*/
+	CCryptoStream(synergy::IStream* stream, const CString& password,
+							bool isServer, bool adoptStream = true);
+	~CCryptoStream();
+
+	// IStream overrides
+	virtual void		close();
+	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual void		write(const void* buffer, UInt32 n);
+	virtual void		flush();
+	virtual void		shutdownInput();
+	virtual void		shutdownOutput();
+	virtual bool		isReady() const;
+	virtual UInt32		getSize() const;
+	virtual UInt32		getOutputSize() const;
+
+protected:
+	// CStreamFilter overrides
+	virtual void		filterEvent(const CEvent&);
+
+private:
+	class CCiphers;
+
+	enum EState {
+		kWaitHello,
+		kReady,
+		kFailed
+	};
+
+	bool				readMore();
+	bool				readHello();
+	void				writeHello();
+	void				stretchPassword();
+	bool				deriveKeys(const UInt8* peerPublicKey);
+	void				sealRecords();
+	bool				openRecords();
+	void				fail(const char* msg);
+	void				handleFlush(const CEvent&, void*);
+
+	static CEvent::Type	getFlushEvent();
+
+private:
+	CMutex				m_mutex;
+	CString				m_password;
+	bool				m_isServer;
+	EState				m_state;
+	UInt8				m_salt[kSaltSize];
+	CCiphers*			m_ciphers;
+	CStreamBuffer		m_input;
+	CStreamBuffer		m_plaintext;
+	CString				m_pending;
+	bool				m_flushPending;
+	bool				m_inputShutdown;
+	UInt8*				m_record;
+
+	static CEvent::Type	s_flushEvent;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CCryptoStreamFilterFactory.h"
+#include "CCryptoStream.h"
+
+//
+// CCryptoStreamFilterFactory
+//
+
+CCryptoStreamFilterFactory::CCryptoStreamFilterFactory(
+				const CString& password, bool isServer) :
+	m_password(password),
+	m_isServer(isServer)
+{
+	// do nothing
+}
+
+CCryptoStreamFilterFactory::~CCryptoStreamFilterFactory()
+{
+	// do nothing
+}
+
+synergy::IStream*
+CCryptoStreamFilterFactory::create(synergy::IStream* stream, bool adoptStream)
+{
+	return new CCryptoStream(stream, m_password, m_isServer, adoptStream);
+}
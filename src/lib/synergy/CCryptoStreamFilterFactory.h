@@ -0,0 +1,45 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CCRYPTOSTREAMFILTERFACTORY_H
+#define CCRYPTOSTREAMFILTERFACTORY_H
+
+#include "IStreamFilterFactory.h"
+#include "CString.h"
+
+//! Stream filter factory for encrypted streams
+/*!
+Creates a CCryptoStream on each new connection.  Each connection
+stretches the password with its own salt so the factory keeps the
+password itself.
+*/
+class CCryptoStreamFilterFactory : public IStreamFilterFactory {
+public:
+	CCryptoStreamFilterFactory(const CString& password, bool isServer);
+	virtual ~CCryptoStreamFilterFactory();
+
+	// IStreamFilterFactory overrides
+	virtual synergy::IStream*	create(synergy::IStream* stream,
+							bool adoptStream);
+
+private:
+	CString				m_password;
+	bool				m_isServer;
+};
+
+#endif
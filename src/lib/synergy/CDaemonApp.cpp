@@ -341,5 +341,10 @@ CDaemonApp::handleIpcMessage(const CEvent& e, void*)
 		case kIpcHello:
 			m_ipcLogOutputter->notifyBuffer();
 			break;
+
+		case kIpcMetrics:
+			// pass the node's metrics on to the gui
+			m_ipcServer->send(*m, kIpcClientGui);
+			break;
 	}
 }
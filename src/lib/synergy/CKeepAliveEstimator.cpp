@@ -0,0 +1,98 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CKeepAliveEstimator.h"
+#include "ProtocolTypes.h"
+
+//
+// CKeepAliveEstimator
+//
+
+CKeepAliveEstimator::CKeepAliveEstimator() :
+	m_hasSamples(false),
+	m_smoothed(0.0),
+	m_variation(0.0)
+{
+	// do nothing
+}
+
+void
+CKeepAliveEstimator::addSample(double delay)
+{
+	if (delay < 0.0) {
+		delay = 0.0;
+	}
+
+	if (!m_hasSamples) {
+		m_hasSamples = true;
+		m_smoothed   = delay;
+		m_variation  = delay / 2.0;
+		return;
+	}
+
+	// gains of 1/4 and 1/8 as in RFC 6298.  the variation uses the old
+	// smoothed delay.
+	double error = delay - m_smoothed;
+	m_variation += 0.25  * ((error < 0.0 ? -error : error) - m_variation);
+	m_smoothed  += 0.125 * error;
+}
+
+void
+CKeepAliveEstimator::reset()
+{
+	m_hasSamples = false;
+	m_smoothed   = 0.0;
+	m_variation  = 0.0;
+}
+
+bool
+CKeepAliveEstimator::hasSamples() const
+{
+	return m_hasSamples;
+}
+
+double
+CKeepAliveEstimator::getSmoothed() const
+{
+	return m_smoothed;
+}
+
+double
+CKeepAliveEstimator::getVariation() const
+{
+	return m_variation;
+}
+
+double
+CKeepAliveEstimator::getTimeout(double rate) const
+{
+	if (rate <= 0.0) {
+		return rate;
+	}
+
+	// without delays to go on allow the fixed number of keep alives.
+	// otherwise wait four variations past the smoothed delay, but never
+	// less than the slack, so a fast peer isn't dropped for a brief stall.
+	if (!m_hasSamples) {
+		return rate * kKeepAlivesUntilDeath;
+	}
+	double slack = m_smoothed + 4.0 * m_variation;
+	if (slack < kKeepAliveMinSlack) {
+		slack = kKeepAliveMinSlack;
+	}
+	return rate + slack;
+}
@@ -0,0 +1,86 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CKEEPALIVEESTIMATOR_H
+#define CKEEPALIVEESTIMATOR_H
+
+#include "BasicTypes.h"
+
+//! Keep alive timeout estimator
+/*!
+Smooths measured keep alive delays the way TCP smooths round trip
+times (RFC 6298) and derives from them how long to wait for a keep
+alive before deciding the peer is dead.  The timeout tracks the
+measured delays, so a dead fast peer is noticed sooner and a slow
+peer is given longer than the fixed \c kKeepAlivesUntilDeath keep
+alives.
+*/
+class CKeepAliveEstimator {
+public:
+	CKeepAliveEstimator();
+
+	//! @name manipulators
+	//@{
+
+	//! Add delay
+	/*!
+	Adds a measured delay of \p delay seconds.
+	*/
+	void				addSample(double delay);
+
+	//! Discard all delays
+	void				reset();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if any delay was added
+	bool				hasSamples() const;
+
+	//! Get smoothed delay
+	/*!
+	Returns the smoothed delay in seconds, or 0 if no delay was added.
+	*/
+	double				getSmoothed() const;
+
+	//! Get delay variation
+	/*!
+	Returns the smoothed mean deviation of the delay in seconds.
+	*/
+	double				getVariation() const;
+
+	//! Get keep alive timeout
+	/*!
+	Returns how long to wait, in seconds, for a keep alive sent every
+	\p rate seconds before deciding the peer is dead.  That's the
+	rate plus four variations past the smoothed delay, or plus
+	\c kKeepAliveMinSlack if that's longer.  Without delays it's
+	\c kKeepAlivesUntilDeath times the rate.  A non-positive \p rate
+	disables keep alives and is returned as is.
+	*/
+	double				getTimeout(double rate) const;
+
+	//@}
+
+private:
+	bool				m_hasSamples;
+	double				m_smoothed;
+	double				m_variation;
+};
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CMotionScheduler.h"
+
+// most absolute moves to hold for interpolation.  a burst bigger than
+// this is out of date by the time we'd get to the end of it anyway.
+static const size_t		s_maxPoints = 32;
+
+//
+// CMotionScheduler
+//
+
+CMotionScheduler::CMotionScheduler() :
+	m_period(0.0),
+	m_interpolate(false),
+	m_started(false),
+	m_last(0.0),
+	m_relative(false),
+	m_dx(0),
+	m_dy(0)
+{
+	// do nothing
+}
+
+void
+CMotionScheduler::setRate(double rate)
+{
+	m_period  = (rate > 0.0) ? 1.0 / rate : 0.0;
+	m_started = false;
+	reset();
+}
+
+void
+CMotionScheduler::setInterpolate(bool interpolate)
+{
+	m_interpolate = interpolate;
+	if (!m_interpolate && m_points.size() > 1) {
+		m_points.erase(m_points.begin(), m_points.end() - 1);
+	}
+}
+
+void
+CMotionScheduler::move(SInt32 x, SInt32 y)
+{
+	// an absolute move makes earlier relative motion moot
+	m_relative = false;
+	m_dx       = 0;
+	m_dy       = 0;
+
+	// without interpolation only the latest position matters
+	if (!m_interpolate) {
+		m_points.clear();
+	}
+	else if (m_points.size() == s_maxPoints) {
+		m_points.pop_front();
+	}
+
+	CPoint point;
+	point.m_x = x;
+	point.m_y = y;
+	m_points.push_back(point);
+}
+
+void
+CMotionScheduler::moveRelative(SInt32 dx, SInt32 dy)
+{
+	if (m_points.empty()) {
+		m_relative = true;
+		m_dx      += dx;
+		m_dy      += dy;
+	}
+	else {
+		// relative to the last absolute move
+		CPoint point = m_points.back();
+		move(point.m_x + dx, point.m_y + dy);
+	}
+}
+
+bool
+CMotionScheduler::next(double now, CMotion& motion)
+{
+	return take(now, false, motion);
+}
+
+bool
+CMotionScheduler::flush(double now, CMotion& motion)
+{
+	return take(now, true, motion);
+}
+
+void
+CMotionScheduler::reset()
+{
+	m_points.clear();
+	m_relative = false;
+	m_dx       = 0;
+	m_dy       = 0;
+}
+
+bool
+CMotionScheduler::isEnabled() const
+{
+	return (m_period > 0.0);
+}
+
+bool
+CMotionScheduler::hasPending() const
+{
+	return (m_relative || !m_points.empty());
+}
+
+double
+CMotionScheduler::getDelay(double now) const
+{
+	if (!hasPending()) {
+		return -1.0;
+	}
+	if (!m_started) {
+		return 0.0;
+	}
+	double delay = m_last + m_period - now;
+	return (delay > 0.0) ? delay : 0.0;
+}
+
+bool
+CMotionScheduler::take(double now, bool all, CMotion& motion)
+{
+	if (!all && getDelay(now) != 0.0) {
+		return false;
+	}
+
+	if (!m_points.empty()) {
+		// take the latest position or, if interpolating a burst, the
+		// one halfway through it
+		CPointList::size_type index = m_points.size() - 1;
+		if (m_interpolate && !all) {
+			index /= 2;
+		}
+		motion.m_absolute = true;
+		motion.m_x        = m_points[index].m_x;
+		motion.m_y        = m_points[index].m_y;
+		m_points.erase(m_points.begin(), m_points.begin() + index + 1);
+	}
+	else if (m_relative) {
+		motion.m_absolute = false;
+		motion.m_x        = m_dx;
+		motion.m_y        = m_dy;
+		m_relative        = false;
+		m_dx              = 0;
+		m_dy              = 0;
+	}
+	else {
+		return false;
+	}
+
+	// start a new frame
+	m_started = true;
+	m_last    = now;
+	return true;
+}
@@ -0,0 +1,139 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CMOTIONSCHEDULER_H
+#define CMOTIONSCHEDULER_H
+
+#include "BasicTypes.h"
+#include "stddeque.h"
+
+//! Mouse motion pacer
+/*!
+Paces faked mouse motion to a frame rate, normally the refresh rate of
+the display.  Motion that arrives at least a frame after the motion
+last taken is due right away.  Motion that arrives sooner is held until
+a frame has passed and merged with whatever motion follows it, so at
+most one move is injected per frame.
+
+With interpolation on, a frame that received a burst of absolute moves
+takes the middle one and leaves the rest for the following frames.  A
+burst of packets then moves the cursor over a few frames instead of in
+one jump followed by frames with no motion at all.
+*/
+class CMotionScheduler {
+public:
+	//! Motion to inject
+	class CMotion {
+	public:
+		//! True for a move to (m_x,m_y), false for a move by (m_x,m_y)
+		bool			m_absolute;
+		SInt32			m_x;
+		SInt32			m_y;
+	};
+
+	CMotionScheduler();
+
+	//! @name manipulators
+	//@{
+
+	//! Set frame rate
+	/*!
+	Sets the frame rate to \p rate frames per second.  A non-positive
+	rate disables pacing and discards pending motion.
+	*/
+	void				setRate(double rate);
+
+	//! Enable or disable interpolation
+	void				setInterpolate(bool interpolate);
+
+	//! Add absolute motion
+	/*!
+	Adds a move to \p x,\p y.  It replaces pending relative motion.
+	*/
+	void				move(SInt32 x, SInt32 y);
+
+	//! Add relative motion
+	/*!
+	Adds a move by \p dx,\p dy.
+	*/
+	void				moveRelative(SInt32 dx, SInt32 dy);
+
+	//! Take due motion
+	/*!
+	If motion is due at time \p now then removes it, saves it in
+	\p motion, starts a new frame and returns true.  Otherwise returns
+	false.
+	*/
+	bool				next(double now, CMotion& motion);
+
+	//! Take all pending motion
+	/*!
+	Like next() but takes all pending motion whether or not it's due.
+	Use this before faking input that must follow the motion.
+	*/
+	bool				flush(double now, CMotion& motion);
+
+	//! Discard pending motion
+	void				reset();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if pacing is enabled
+	bool				isEnabled() const;
+
+	//! Test if motion is pending
+	bool				hasPending() const;
+
+	//! Get time until motion is due
+	/*!
+	Returns the time in seconds from \p now until pending motion is
+	due, 0 if it's due already, or -1 if no motion is pending.
+	*/
+	double				getDelay(double now) const;
+
+	//@}
+
+private:
+	class CPoint {
+	public:
+		SInt32			m_x;
+		SInt32			m_y;
+	};
+	typedef std::deque<CPoint> CPointList;
+
+	bool				take(double now, bool all, CMotion& motion);
+
+private:
+	double				m_period;
+	bool				m_interpolate;
+
+	// time the last motion was taken.  only valid if m_started.
+	bool				m_started;
+	double				m_last;
+
+	// pending absolute moves, oldest first
+	CPointList			m_points;
+
+	// pending relative motion.  only used if m_points is empty.
+	bool				m_relative;
+	SInt32				m_dx;
+	SInt32				m_dy;
+};
+
+#endif
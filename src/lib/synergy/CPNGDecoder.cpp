@@ -0,0 +1,564 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CPNGDecoder.h"
+#include "IClipboard.h"
+#include "CLog.h"
+#include "filters.h"
+#include "zlib.h"
+#include <algorithm>
+#include <cstring>
+
+// 16 megapixels, a 64MB bitmap.  that's enough for a 5K screenshot
+// and every image we decode came over the network.
+const UInt32			CPNGDecoder::kMaxPixels = 16 * 1024 * 1024;
+
+// largest filtered image data:  64 bits per pixel plus a filter byte
+// per row.  fits in 32 bits.
+static const UInt32		s_maxFilteredSize = 9 * (16 * 1024 * 1024);
+
+// the last shared image decoded and the result
+static CClipboardBlob	s_lastPNG;
+static CClipboardBlob	s_lastBitmap;
+static bool				s_lastDecoded = false;
+
+static const UInt8		s_signature[] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+
+// PNG is big-endian
+static inline
+UInt32
+fromBEU32(const UInt8* data)
+{
+	return (static_cast<UInt32>(data[0]) << 24) |
+			(static_cast<UInt32>(data[1]) << 16) |
+			(static_cast<UInt32>(data[2]) <<  8) |
+			 static_cast<UInt32>(data[3]);
+}
+
+// BMP is little-endian
+static inline
+void
+toLE(UInt8*& dst, UInt16 src)
+{
+	dst[0] = static_cast<UInt8>(src & 0xffu);
+	dst[1] = static_cast<UInt8>((src >> 8) & 0xffu);
+	dst += 2;
+}
+
+static inline
+void
+toLE(UInt8*& dst, UInt32 src)
+{
+	dst[0] = static_cast<UInt8>(src & 0xffu);
+	dst[1] = static_cast<UInt8>((src >>  8) & 0xffu);
+	dst[2] = static_cast<UInt8>((src >> 16) & 0xffu);
+	dst[3] = static_cast<UInt8>((src >> 24) & 0xffu);
+	dst += 4;
+}
+
+static inline
+UInt8
+paeth(UInt8 a, UInt8 b, UInt8 c)
+{
+	int p  = static_cast<int>(a) + b - c;
+	int pa = (p > a) ? p - a : a - p;
+	int pb = (p > b) ? p - b : b - p;
+	int pc = (p > c) ? p - c : c - p;
+	if (pa <= pb && pa <= pc) {
+		return a;
+	}
+	return (pb <= pc) ? b : c;
+}
+
+// image header and palette
+class CPNGInfo {
+public:
+	UInt32				m_width;
+	UInt32				m_height;
+	UInt32				m_depth;
+	UInt32				m_colorType;
+	UInt32				m_channels;
+	bool				m_interlaced;
+	UInt8				m_palette[256][4];
+	UInt32				m_paletteSize;
+	bool				m_hasKey;
+	UInt16				m_key[3];
+};
+
+// undo the filters of a (sub)image's rows in place.  returns false if
+// a row has an unknown filter type.
+static
+bool
+unfilter(UInt8* data, UInt32 rows, UInt32 stride, UInt32 bpp)
+{
+	const UInt8* prior = NULL;
+	for (UInt32 y = 0; y < rows; ++y) {
+		UInt8 type = data[0];
+		UInt8* row = data + 1;
+		switch (type) {
+		case 0:
+			break;
+
+		case 1:
+			for (UInt32 x = bpp; x < stride; ++x) {
+				row[x] = static_cast<UInt8>(row[x] + row[x - bpp]);
+			}
+			break;
+
+		case 2:
+			if (prior != NULL) {
+				for (UInt32 x = 0; x < stride; ++x) {
+					row[x] = static_cast<UInt8>(row[x] + prior[x]);
+				}
+			}
+			break;
+
+		case 3:
+			for (UInt32 x = 0; x < stride; ++x) {
+				UInt32 left = (x >= bpp) ? row[x - bpp] : 0;
+				UInt32 up   = (prior != NULL) ? prior[x] : 0;
+				row[x] = static_cast<UInt8>(row[x] + ((left + up) >> 1));
+			}
+			break;
+
+		case 4:
+			for (UInt32 x = 0; x < stride; ++x) {
+				UInt8 left     = (x >= bpp) ? row[x - bpp] : 0;
+				UInt8 up       = (prior != NULL) ? prior[x] : 0;
+				UInt8 upLeft   = (prior != NULL && x >= bpp) ?
+									prior[x - bpp] : 0;
+				row[x] = static_cast<UInt8>(row[x] + paeth(left, up, upLeft));
+			}
+			break;
+
+		default:
+			return false;
+		}
+		prior = row;
+		data += 1 + stride;
+	}
+	return true;
+}
+
+// get sample \p index of an unfiltered row
+static inline
+UInt16
+getSample(const UInt8* row, UInt32 index, UInt32 depth)
+{
+	switch (depth) {
+	case 16:
+		return static_cast<UInt16>((row[2 * index] << 8) | row[2 * index + 1]);
+
+	case 8:
+		return row[index];
+
+	default: {
+		UInt32 bit   = index * depth;
+		UInt32 shift = 8 - depth - (bit & 7);
+		return static_cast<UInt16>((row[bit >> 3] >> shift) &
+									((1u << depth) - 1));
+	}
+	}
+}
+
+// scale a sample to 8 bits
+static inline
+UInt8
+toByte(UInt16 sample, UInt32 depth)
+{
+	switch (depth) {
+	case 16:
+		return static_cast<UInt8>(sample >> 8);
+
+	case 8:
+		return static_cast<UInt8>(sample);
+
+	default:
+		return static_cast<UInt8>(sample * 255 / ((1u << depth) - 1));
+	}
+}
+
+// write the pixels of an unfiltered (sub)image to the bitmap.  pixel
+// (x, y) of the subimage is pixel (x0 + x * dx, y0 + y * dy) of the
+// image.
+static
+void
+convertPixels(const CPNGInfo& info, const UInt8* data,
+				UInt32 width, UInt32 height, UInt32 stride,
+				UInt32 x0, UInt32 y0, UInt32 dx, UInt32 dy, UInt8* pixels)
+{
+	const UInt32 depth = info.m_depth;
+	for (UInt32 y = 0; y < height; ++y) {
+		const UInt8* row = data + y * (1 + stride) + 1;
+
+		// bitmaps are bottom-up
+		UInt8* dst = pixels + 4 * (info.m_height - 1 - (y0 + y * dy)) *
+											info.m_width;
+		for (UInt32 x = 0; x < width; ++x) {
+			UInt32 i = x * info.m_channels;
+			UInt8 r, g, b, a = 255;
+			switch (info.m_colorType) {
+			case 0: {
+				UInt16 gray = getSample(row, i, depth);
+				r = g = b = toByte(gray, depth);
+				if (info.m_hasKey && gray == info.m_key[0]) {
+					a = 0;
+				}
+				break;
+			}
+
+			case 2: {
+				UInt16 s[3];
+				s[0] = getSample(row, i,     depth);
+				s[1] = getSample(row, i + 1, depth);
+				s[2] = getSample(row, i + 2, depth);
+				r = toByte(s[0], depth);
+				g = toByte(s[1], depth);
+				b = toByte(s[2], depth);
+				if (info.m_hasKey && s[0] == info.m_key[0] &&
+					s[1] == info.m_key[1] && s[2] == info.m_key[2]) {
+					a = 0;
+				}
+				break;
+			}
+
+			case 3: {
+				// out of range indexes are black
+				const UInt8* entry = info.m_palette[getSample(row, i, depth)];
+				r = entry[0];
+				g = entry[1];
+				b = entry[2];
+				a = entry[3];
+				break;
+			}
+
+			case 4:
+				r = g = b = toByte(getSample(row, i, depth), depth);
+				a = toByte(getSample(row, i + 1, depth), depth);
+				break;
+
+			case 6:
+			default:
+				r = toByte(getSample(row, i,     depth), depth);
+				g = toByte(getSample(row, i + 1, depth), depth);
+				b = toByte(getSample(row, i + 2, depth), depth);
+				a = toByte(getSample(row, i + 3, depth), depth);
+				break;
+			}
+
+			UInt8* pixel = dst + 4 * (x0 + x * dx);
+			pixel[0] = b;
+			pixel[1] = g;
+			pixel[2] = r;
+			pixel[3] = a;
+		}
+	}
+}
+
+// computes the stride (bytes per row without the filter byte) and the
+// size of the filtered data of a width x height subimage.  returns false
+// if the size exceeds s_maxFilteredSize.  the checks are ordered so no
+// product can overflow.
+static
+bool
+getFilteredSize(UInt32 width, UInt32 height, UInt32 bitsPerPixel,
+				UInt32& stride, UInt32& size)
+{
+	if (width > (s_maxFilteredSize - 7) / bitsPerPixel) {
+		return false;
+	}
+	stride = (width * bitsPerPixel + 7) / 8;
+	if (height > s_maxFilteredSize / (1 + stride)) {
+		return false;
+	}
+	size = height * (1 + stride);
+	return true;
+}
+
+// read the chunks we need.  returns false if the file is malformed.
+static
+bool
+readChunks(const CString& png, CPNGInfo& info, CString& compressed)
+{
+	const UInt8* data = reinterpret_cast<const UInt8*>(png.data());
+	const UInt32 size = static_cast<UInt32>(png.size());
+	if (size < sizeof(s_signature) ||
+		memcmp(data, s_signature, sizeof(s_signature)) != 0) {
+		return false;
+	}
+
+	// the crc of each chunk isn't checked;  the zlib stream has its own
+	// checksum and we don't use the other chunks.
+	bool haveHeader = false;
+	UInt32 offset   = sizeof(s_signature);
+	while (size - offset >= 12) {
+		const UInt32 length = fromBEU32(data + offset);
+		const UInt8* type   = data + offset + 4;
+		const UInt8* chunk  = data + offset + 8;
+		if (length > size - offset - 12) {
+			return false;
+		}
+		offset += 12 + length;
+
+		if (memcmp(type, "IHDR", 4) == 0) {
+			if (length < 13) {
+				return false;
+			}
+			info.m_width      = fromBEU32(chunk);
+			info.m_height     = fromBEU32(chunk + 4);
+			info.m_depth      = chunk[8];
+			info.m_colorType  = chunk[9];
+			info.m_interlaced = (chunk[12] == 1);
+			if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1) {
+				return false;
+			}
+			haveHeader = true;
+		}
+		else if (!haveHeader) {
+			// IHDR must be first
+			return false;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0) {
+			info.m_paletteSize = length / 3;
+			if (info.m_paletteSize > 256) {
+				return false;
+			}
+			for (UInt32 i = 0; i < info.m_paletteSize; ++i) {
+				info.m_palette[i][0] = chunk[3 * i];
+				info.m_palette[i][1] = chunk[3 * i + 1];
+				info.m_palette[i][2] = chunk[3 * i + 2];
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0) {
+			if (info.m_colorType == 3) {
+				for (UInt32 i = 0; i < length && i < 256; ++i) {
+					info.m_palette[i][3] = chunk[i];
+				}
+			}
+			else if (info.m_colorType == 0 && length >= 2) {
+				info.m_key[0] = static_cast<UInt16>((chunk[0] << 8) | chunk[1]);
+				info.m_hasKey = true;
+			}
+			else if (info.m_colorType == 2 && length >= 6) {
+				for (UInt32 i = 0; i < 3; ++i) {
+					info.m_key[i] = static_cast<UInt16>(
+								(chunk[2 * i] << 8) | chunk[2 * i + 1]);
+				}
+				info.m_hasKey = true;
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0) {
+			compressed.append(reinterpret_cast<const char*>(chunk), length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0) {
+			break;
+		}
+	}
+	if (!haveHeader || compressed.empty()) {
+		return false;
+	}
+
+	// check the header
+	switch (info.m_colorType) {
+	case 0:
+		info.m_channels = 1;
+		if (info.m_depth != 1 && info.m_depth != 2 && info.m_depth != 4 &&
+			info.m_depth != 8 && info.m_depth != 16) {
+			return false;
+		}
+		break;
+
+	case 3:
+		info.m_channels = 1;
+		if ((info.m_depth != 1 && info.m_depth != 2 && info.m_depth != 4 &&
+			info.m_depth != 8) || info.m_paletteSize == 0) {
+			return false;
+		}
+		break;
+
+	case 2:
+	case 4:
+	case 6:
+		info.m_channels = (info.m_colorType == 2) ? 3 :
+							((info.m_colorType == 4) ? 2 : 4);
+		if (info.m_depth != 8 && info.m_depth != 16) {
+			return false;
+		}
+		break;
+
+	default:
+		return false;
+	}
+	if (info.m_width == 0 || info.m_height == 0 ||
+		info.m_width > CPNGDecoder::kMaxPixels / info.m_height) {
+		return false;
+	}
+	return true;
+}
+
+//
+// CPNGDecoder
+//
+
+bool
+CPNGDecoder::toBitmap(const CString& png, CString& bitmap)
+{
+	CPNGInfo info;
+	memset(&info, 0, sizeof(info));
+	for (UInt32 i = 0; i < 256; ++i) {
+		info.m_palette[i][3] = 255;
+	}
+
+	CString compressed;
+	if (!readChunks(png, info, compressed)) {
+		LOG((CLOG_DEBUG "invalid or unsupported PNG"));
+		return false;
+	}
+
+	// the image is one subimage or seven for Adam7 interlacing.  these
+	// are the subimage origins and spacing.
+	static const UInt32 s_pass[7][4] = {
+		{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+		{ 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+	};
+	static const UInt32 s_single[1][4] = { { 0, 0, 1, 1 } };
+	const UInt32 (*passes)[4] = info.m_interlaced ? s_pass : s_single;
+	const UInt32 numPasses    = info.m_interlaced ? 7 : 1;
+	const UInt32 bitsPerPixel = info.m_depth * info.m_channels;
+
+	// compute the size of the filtered image data
+	UInt32 expected = 0;
+	for (UInt32 i = 0; i < numPasses; ++i) {
+		const UInt32 x0 = passes[i][0], y0 = passes[i][1];
+		const UInt32 dx = passes[i][2], dy = passes[i][3];
+		if (x0 < info.m_width && y0 < info.m_height) {
+			const UInt32 width  = (info.m_width  - x0 + dx - 1) / dx;
+			const UInt32 height = (info.m_height - y0 + dy - 1) / dy;
+			UInt32 stride, size;
+			if (!getFilteredSize(width, height, bitsPerPixel, stride, size) ||
+				size > s_maxFilteredSize - expected) {
+				LOG((CLOG_DEBUG "PNG image too large"));
+				return false;
+			}
+			expected += size;
+		}
+	}
+
+	// inflate the image data a piece at a time so a malicious stream
+	// can't inflate to much more than the image needs
+	static const UInt32 s_piece = 65536;
+	std::string filtered;
+	try {
+		CryptoPP::ZlibDecompressor inflater(
+							new CryptoPP::StringSink(filtered));
+		const UInt8* src = reinterpret_cast<const UInt8*>(compressed.data());
+		for (size_t n = 0; n < compressed.size(); n += s_piece) {
+			inflater.Put(src + n, std::min<size_t>(s_piece,
+										compressed.size() - n));
+			if (filtered.size() > expected) {
+				break;
+			}
+		}
+		if (filtered.size() <= expected) {
+			inflater.MessageEnd();
+		}
+	}
+	catch (CryptoPP::Exception& e) {
+		LOG((CLOG_DEBUG "invalid PNG data: %s", e.what()));
+		return false;
+	}
+	if (filtered.size() < expected) {
+		LOG((CLOG_DEBUG "invalid PNG data: too short"));
+		return false;
+	}
+
+	// create the bitmap
+	const UInt32 imageSize = 4 * info.m_width * info.m_height;
+	bitmap.resize(40 + imageSize);
+	UInt8* header = reinterpret_cast<UInt8*>(&bitmap[0]);
+	UInt8* dst    = header;
+	toLE(dst, static_cast<UInt32>(40));
+	toLE(dst, info.m_width);
+	toLE(dst, info.m_height);
+	toLE(dst, static_cast<UInt16>(1));
+	toLE(dst, static_cast<UInt16>(32));
+	toLE(dst, static_cast<UInt32>(0));
+	toLE(dst, imageSize);
+	toLE(dst, static_cast<UInt32>(2834));
+	toLE(dst, static_cast<UInt32>(2834));
+	toLE(dst, static_cast<UInt32>(0));
+	toLE(dst, static_cast<UInt32>(0));
+
+	// unfilter and convert each subimage
+	const UInt32 bpp = (bitsPerPixel + 7) / 8;
+	UInt8* data     = reinterpret_cast<UInt8*>(&filtered[0]);
+	UInt32 consumed = 0;
+	for (UInt32 i = 0; i < numPasses; ++i) {
+		const UInt32 x0 = passes[i][0], y0 = passes[i][1];
+		const UInt32 dx = passes[i][2], dy = passes[i][3];
+		if (x0 >= info.m_width || y0 >= info.m_height) {
+			// empty pass
+			continue;
+		}
+		const UInt32 width  = (info.m_width  - x0 + dx - 1) / dx;
+		const UInt32 height = (info.m_height - y0 + dy - 1) / dy;
+		UInt32 stride, size;
+		getFilteredSize(width, height, bitsPerPixel, stride, size);
+		if (!unfilter(data + consumed, height, stride, bpp)) {
+			LOG((CLOG_DEBUG "invalid PNG data"));
+			bitmap.clear();
+			return false;
+		}
+		convertPixels(info, data + consumed, width, height, stride,
+							x0, y0, dx, dy, header + 40);
+		consumed += size;
+	}
+
+	return true;
+}
+
+bool
+CPNGDecoder::addBitmap(IClipboard* clipboard)
+{
+	if (!clipboard->has(IClipboard::kPNG) ||
+		clipboard->has(IClipboard::kBitmap)) {
+		return false;
+	}
+
+	CClipboardBlob bitmap;
+	if (!toBitmap(clipboard->getBlob(IClipboard::kPNG), bitmap)) {
+		return false;
+	}
+	clipboard->addBlob(IClipboard::kBitmap, bitmap);
+	return true;
+}
+
+bool
+CPNGDecoder::toBitmap(const CClipboardBlob& png, CClipboardBlob& bitmap)
+{
+	// s_lastPNG keeps its buffer alive so the same address and size
+	// means the same image
+	if (png.data() != s_lastPNG.data() || png.size() != s_lastPNG.size() ||
+		png.empty()) {
+		CString decoded;
+		s_lastDecoded = toBitmap(png.toString(), decoded);
+		s_lastPNG     = png;
+		s_lastBitmap  = CClipboardBlob::adopt(decoded);
+	}
+	bitmap = s_lastBitmap;
+	return s_lastDecoded;
+}
@@ -0,0 +1,69 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPNGDECODER_H
+#define CPNGDECODER_H
+
+#include "CString.h"
+#include "CClipboardBlob.h"
+#include "BasicTypes.h"
+
+class IClipboard;
+
+//! PNG to clipboard bitmap decoder
+/*!
+Decodes PNG images (the IClipboard::kPNG format) to the
+IClipboard::kBitmap format for screens and clients that only
+understand bitmaps.  All PNG bit depths, color types and interlacing
+are supported.
+*/
+class CPNGDecoder {
+public:
+	//! Decode PNG to bitmap
+	/*!
+	Decodes the PNG file \p png to a 32bpp bottom-up bitmap (an
+	INFOHEADER followed by the pixels) in \p bitmap.  Returns false
+	if \p png isn't a valid PNG file or the image is larger than
+	\c kMaxPixels.
+	*/
+	static bool			toBitmap(const CString& png, CString& bitmap);
+
+	//! Decode shared PNG to bitmap
+	/*!
+	Like toBitmap(const CString&, CString&) but remembers the last
+	image decoded.  Decoding a blob that shares the same buffer again,
+	as every copy of one clipboard does, returns the same bitmap
+	without decoding it again.  The last bitmap is kept until another
+	image is decoded.  Must only be called from the main thread.
+	*/
+	static bool			toBitmap(const CClipboardBlob& png,
+							CClipboardBlob& bitmap);
+
+	//! Add decoded bitmap to clipboard
+	/*!
+	If \p clipboard has a PNG image and no bitmap then decodes the
+	image and adds it as a bitmap.  \p clipboard must be open and
+	owned.  Returns true iff a bitmap was added.  Uses
+	toBitmap(const CClipboardBlob&, CClipboardBlob&).
+	*/
+	static bool			addBitmap(IClipboard* clipboard);
+
+	//! Largest image decoded (in pixels)
+	static const UInt32	kMaxPixels;
+};
+
+#endif
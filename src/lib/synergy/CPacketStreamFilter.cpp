@@ -23,6 +23,14 @@
 #include <cstring>
 #include <memory>
 
+// CMetrics::CConnection::OutputSizeFunc for a packet stream
+static
+UInt32
+sampleOutputSize(const void* stream)
+{
+	return static_cast<const CPacketStreamFilter*>(stream)->getOutputSize();
+}
+
 //
 // CPacketStreamFilter
 //
@@ -30,7 +38,10 @@
 CPacketStreamFilter::CPacketStreamFilter(synergy::IStream* stream, bool adoptStream) :
 	CStreamFilter(stream, adoptStream),
 	m_size(0),
-	m_inputShutdown(false)
+	m_inputShutdown(false),
+	m_borrowed(false),
+	m_nextSize(0),
+	m_metrics(NULL)
 {
 	// do nothing
 }
@@ -44,7 +55,8 @@ void
 CPacketStreamFilter::close()
 {
 	CLock lock(&m_mutex);
-	m_size = 0;
+	m_size     = 0;
+	m_borrowed = false;
 	m_buffer.pop(m_buffer.getSize());
 	CStreamFilter::close();
 }
@@ -58,6 +70,9 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 
 	CLock lock(&m_mutex);
 
+	// discard any packet we lent out
+	releasePacketNoLock();
+
 	// if not enough data yet then give up
 	if (!isReadyNoLock()) {
 		return 0;
@@ -90,23 +105,36 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 void
 CPacketStreamFilter::write(const void* buffer, UInt32 count)
 {
-	// write the length of the payload
-	UInt8 length[4];
-	length[0] = (UInt8)((count >> 24) & 0xff);
-	length[1] = (UInt8)((count >> 16) & 0xff);
-	length[2] = (UInt8)((count >>  8) & 0xff);
-	length[3] = (UInt8)( count        & 0xff);
-	getStream()->write(length, sizeof(length));
+	// most messages are small so coalesce the length and the payload
+	// and write them once.  a large payload is written as is after the
+	// length rather than copied just to prepend four bytes.
+	UInt8 packet[256];
+	packet[0] = (UInt8)((count >> 24) & 0xff);
+	packet[1] = (UInt8)((count >> 16) & 0xff);
+	packet[2] = (UInt8)((count >>  8) & 0xff);
+	packet[3] = (UInt8)( count        & 0xff);
+	if (m_metrics != NULL) {
+		m_metrics->addSent(count);
+	}
 
-	// write the payload
-	getStream()->write(buffer, count);
+	if (count <= sizeof(packet) - 4) {
+		if (count != 0) {
+			memcpy(packet + 4, buffer, count);
+		}
+		getStream()->write(packet, count + 4);
+	}
+	else {
+		getStream()->write(packet, 4);
+		getStream()->write(buffer, count);
+	}
 }
 
 void
 CPacketStreamFilter::shutdownInput()
 {
 	CLock lock(&m_mutex);
-	m_size = 0;
+	m_size     = 0;
+	m_borrowed = false;
 	m_buffer.pop(m_buffer.getSize());
 	CStreamFilter::shutdownInput();
 }
@@ -122,12 +150,83 @@ UInt32
 CPacketStreamFilter::getSize() const
 {
 	CLock lock(&m_mutex);
-	return isReadyNoLock() ? m_size : 0;
+	if (!isReadyNoLock()) {
+		return 0;
+	}
+	return m_borrowed ? m_nextSize : m_size;
+}
+
+const void*
+CPacketStreamFilter::borrowPacket(UInt32& size)
+{
+	CLock lock(&m_mutex);
+
+	// discard the packet we lent last time
+	releasePacketNoLock();
+
+	// if not enough data yet then give up
+	if (!isReadyNoLock()) {
+		return NULL;
+	}
+
+	// lend the packet in place.  include the next packet's size if we
+	// have it so isReady() can tell if there's another packet without
+	// disturbing this one.
+	UInt32 n = m_size;
+	if (m_buffer.getSize() >= m_size + 4) {
+		n += 4;
+	}
+	const UInt8* packet = reinterpret_cast<const UInt8*>(m_buffer.peek(n));
+	if (n != m_size) {
+		const UInt8* next = packet + m_size;
+		m_nextSize = ((UInt32)next[0] << 24) |
+					 ((UInt32)next[1] << 16) |
+					 ((UInt32)next[2] <<  8) |
+					  (UInt32)next[3];
+	}
+	else {
+		m_nextSize = 0;
+	}
+	m_borrowed = true;
+
+	size = m_size;
+	return packet;
+}
+
+void
+CPacketStreamFilter::releasePacket()
+{
+	CLock lock(&m_mutex);
+	releasePacketNoLock();
+}
+
+void
+CPacketStreamFilter::setMetrics(CMetrics::CConnection* metrics)
+{
+	CMetrics::CConnection* old;
+	{
+		CLock lock(&m_mutex);
+		old       = m_metrics;
+		m_metrics = metrics;
+	}
+
+	// the connection samples our output queue when it's formatted
+	if (old != NULL) {
+		old->setOutputSize(NULL, NULL);
+	}
+	if (metrics != NULL) {
+		metrics->setOutputSize(&sampleOutputSize, this);
+	}
 }
 
 bool
 CPacketStreamFilter::isReadyNoLock() const
 {
+	if (m_borrowed) {
+		// ready if the packet after the lent packet is complete
+		return (m_nextSize != 0 &&
+				m_buffer.getSize() >= m_size + 4 + m_nextSize);
+	}
 	return (m_size != 0 && m_buffer.getSize() >= m_size);
 }
 
@@ -144,6 +243,9 @@ CPacketStreamFilter::readPacketSize()
 				 ((UInt32)buffer[1] << 16) |
 				 ((UInt32)buffer[2] <<  8) |
 				  (UInt32)buffer[3];
+		if (m_metrics != NULL) {
+			m_metrics->addReceived(m_size);
+		}
 	}
 }
 
@@ -173,6 +275,26 @@ CPacketStreamFilter::readMore()
 	return (wasReady != isReady);
 }
 
+void
+CPacketStreamFilter::releasePacketNoLock()
+{
+	// note -- m_mutex must be locked on entry
+
+	if (!m_borrowed) {
+		return;
+	}
+
+	m_buffer.pop(m_size);
+	m_size     = 0;
+	m_borrowed = false;
+	readPacketSize();
+
+	if (m_inputShutdown && m_size == 0) {
+		EVENTQUEUE->addEvent(CEvent(getInputShutdownEvent(),
+						getEventTarget(), NULL));
+	}
+}
+
 void
 CPacketStreamFilter::filterEvent(const CEvent& event)
 {
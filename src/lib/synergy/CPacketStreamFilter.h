@@ -39,6 +39,9 @@ public:
 	virtual void		shutdownInput();
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
+	virtual const void*	borrowPacket(UInt32& size);
+	virtual void		releasePacket();
+	virtual void		setMetrics(CMetrics::CConnection*);
 
 protected:
 	// CStreamFilter overrides
@@ -48,12 +51,16 @@ private:
 	bool				isReadyNoLock() const;
 	void				readPacketSize();
 	bool				readMore();
+	void				releasePacketNoLock();
 
 private:
 	CMutex				m_mutex;
 	UInt32				m_size;
 	CStreamBuffer		m_buffer;
 	bool				m_inputShutdown;
+	bool				m_borrowed;
+	UInt32				m_nextSize;
+	CMetrics::CConnection*	m_metrics;
 };
 
 #endif
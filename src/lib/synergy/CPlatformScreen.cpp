@@ -33,6 +33,18 @@ CPlatformScreen::~CPlatformScreen()
 	// do nothing
 }
 
+void
+CPlatformScreen::fakeBatchBegin()
+{
+	// do nothing
+}
+
+void
+CPlatformScreen::fakeBatchEnd()
+{
+	// do nothing
+}
+
 void
 CPlatformScreen::updateKeyMap()
 {
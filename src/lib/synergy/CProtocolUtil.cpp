@@ -45,23 +45,59 @@ CProtocolUtil::writef(synergy::IStream* stream, const char* fmt, ...)
 
 bool
 CProtocolUtil::readf(synergy::IStream* stream, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = vreadf(stream, fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool
+CProtocolUtil::readf(const UInt8*& data, UInt32& size, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = vreadf(data, size, fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool
+CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 {
 	assert(stream != NULL);
 	assert(fmt != NULL);
 	LOG((CLOG_DEBUG2 "readf(%s)", fmt));
 
-	bool result;
-	va_list args;
-	va_start(args, fmt);
 	try {
-		vreadf(stream, fmt, args);
-		result = true;
+		CSource source(stream);
+		vreadf(source, fmt, args);
+		return true;
 	}
 	catch (XIO&) {
-		result = false;
+		return false;
+	}
+}
+
+bool
+CProtocolUtil::vreadf(const UInt8*& data, UInt32& size,
+				const char* fmt, va_list args)
+{
+	assert(data != NULL || size == 0);
+	assert(fmt != NULL);
+	LOG((CLOG_DEBUG2 "readf(%s)", fmt));
+
+	try {
+		CSource source(data, size);
+		vreadf(source, fmt, args);
+		data = source.m_data;
+		size = source.m_size;
+		return true;
+	}
+	catch (XIO&) {
+		return false;
 	}
-	va_end(args);
-	return result;
 }
 
 void
@@ -94,9 +130,8 @@ CProtocolUtil::vwritef(synergy::IStream* stream,
 }
 
 void
-CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
+CProtocolUtil::vreadf(CSource& source, const char* fmt, va_list args)
 {
-	assert(stream != NULL);
 	assert(fmt != NULL);
 
 	// begin scanning
@@ -111,8 +146,8 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				assert(len == 1 || len == 2 || len == 4);
 
 				// read the data
-				UInt8 buffer[4];
-				read(stream, buffer, len);
+				UInt8 scratch[4];
+				const UInt8* buffer = read(source, scratch, len);
 
 				// convert it
 				void* v = va_arg(args, void*);
@@ -150,8 +185,8 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				assert(len == 1 || len == 2 || len == 4);
 
 				// read the vector length
-				UInt8 buffer[4];
-				read(stream, buffer, 4);
+				UInt8 scratch[4];
+				const UInt8* buffer = read(source, scratch, 4);
 				UInt32 n = (static_cast<UInt32>(buffer[0]) << 24) |
 						   (static_cast<UInt32>(buffer[1]) << 16) |
 						   (static_cast<UInt32>(buffer[2]) <<  8) |
@@ -163,7 +198,7 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				case 1:
 					// 1 byte integer
 					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 1);
+						buffer = read(source, scratch, 1);
 						reinterpret_cast<std::vector<UInt8>*>(v)->push_back(
 							buffer[0]);
 						LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, reinterpret_cast<std::vector<UInt8>*>(v)->back(), reinterpret_cast<std::vector<UInt8>*>(v)->back()));
@@ -173,7 +208,7 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				case 2:
 					// 2 byte integer
 					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 2);
+						buffer = read(source, scratch, 2);
 						reinterpret_cast<std::vector<UInt16>*>(v)->push_back(
 							static_cast<UInt16>(
 							(static_cast<UInt16>(buffer[0]) << 8) |
@@ -185,7 +220,7 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				case 4:
 					// 4 byte integer
 					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 4);
+						buffer = read(source, scratch, 4);
 						reinterpret_cast<std::vector<UInt32>*>(v)->push_back(
 							(static_cast<UInt32>(buffer[0]) << 24) |
 							(static_cast<UInt32>(buffer[1]) << 16) |
@@ -203,14 +238,16 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 
 				// read the string length
 				UInt8 buffer[128];
-				read(stream, buffer, 4);
-				UInt32 len = (static_cast<UInt32>(buffer[0]) << 24) |
-							 (static_cast<UInt32>(buffer[1]) << 16) |
-							 (static_cast<UInt32>(buffer[2]) <<  8) |
-							  static_cast<UInt32>(buffer[3]);
+				const UInt8* lBuffer = read(source, buffer, 4);
+				UInt32 len = (static_cast<UInt32>(lBuffer[0]) << 24) |
+							 (static_cast<UInt32>(lBuffer[1]) << 16) |
+							 (static_cast<UInt32>(lBuffer[2]) <<  8) |
+							  static_cast<UInt32>(lBuffer[3]);
 
-				// use a fixed size buffer if its big enough
-				const bool useFixed = (len <= sizeof(buffer));
+				// use a fixed size buffer if its big enough.  data in
+				// memory is used in place.
+				const bool useFixed = (len <= sizeof(buffer) ||
+										source.m_stream == NULL);
 
 				// allocate a buffer to read the data
 				UInt8* sBuffer = buffer;
@@ -219,8 +256,9 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				}
 
 				// read the data
+				const UInt8* sData;
 				try {
-					read(stream, sBuffer, len);
+					sData = read(source, sBuffer, len);
 				}
 				catch (...) {
 					if (!useFixed) {
@@ -228,11 +266,11 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 					}
 					throw;
 				}
-				LOG((CLOG_DEBUG2 "readf: read %d byte string: %.*s", len, len, sBuffer));
+				LOG((CLOG_DEBUG2 "readf: read %d byte string: %.*s", len, len, sData));
 
 				// save the data
 				CString* dst = va_arg(args, CString*);
-				dst->assign((const char*)sBuffer, len);
+				dst->assign((const char*)sData, len);
 
 				// release the buffer
 				if (!useFixed) {
@@ -254,11 +292,11 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 		}
 		else {
 			// read next character
-			char buffer[1];
-			read(stream, buffer, 1);
+			UInt8 scratch[1];
+			const UInt8* buffer = read(source, scratch, 1);
 
 			// verify match
-			if (buffer[0] != *fmt) {
+			if (static_cast<char>(buffer[0]) != *fmt) {
 				LOG((CLOG_DEBUG2 "readf: format mismatch: %c vs %c", *fmt, buffer[0]));
 				throw XIOReadMismatch();
 			}
@@ -530,6 +568,25 @@ CProtocolUtil::read(synergy::IStream* stream, void* vbuffer, UInt32 count)
 	}
 }
 
+const UInt8*
+CProtocolUtil::read(CSource& source, UInt8* buffer, UInt32 count)
+{
+	// read from the stream into the buffer
+	if (source.m_stream != NULL) {
+		read(source.m_stream, buffer, count);
+		return buffer;
+	}
+
+	// use data in memory where it is
+	if (source.m_size < count) {
+		LOG((CLOG_DEBUG2 "unexpected end of data in readf(), %d bytes left", count - source.m_size));
+		throw XIOEndOfStream();
+	}
+	const UInt8* data = source.m_data;
+	source.m_data += count;
+	source.m_size -= count;
+	return data;
+}
 
 //
 // XIOReadMismatch
@@ -72,16 +72,54 @@ public:
 	static bool			readf(synergy::IStream*,
 							const char* fmt, ...);
 
+	//! Read formatted data from memory
+	/*!
+	Same as readf() except it reads from the \p size bytes at \p data,
+	typically a packet borrowed from a stream, instead of copying from
+	a stream.  If successful then \p data and \p size are advanced past
+	the parsed data.
+	*/
+	static bool			readf(const UInt8*& data, UInt32& size,
+							const char* fmt, ...);
+
+	//! Read formatted data
+	/*!
+	Same as readf() except it takes a \c va_list.
+	*/
+	static bool			vreadf(synergy::IStream*,
+							const char* fmt, va_list);
+
+	//! Read formatted data from memory
+	/*!
+	Same as readf() from memory except it takes a \c va_list.
+	*/
+	static bool			vreadf(const UInt8*& data, UInt32& size,
+							const char* fmt, va_list);
+
 private:
+	// where readf() gets its data, a stream or memory
+	class CSource {
+	public:
+		explicit CSource(synergy::IStream* stream) :
+			m_stream(stream), m_data(NULL), m_size(0) { }
+		CSource(const UInt8* data, UInt32 size) :
+			m_stream(NULL), m_data(data), m_size(size) { }
+
+	public:
+		synergy::IStream*	m_stream;
+		const UInt8*	m_data;
+		UInt32			m_size;
+	};
+
 	static void			vwritef(synergy::IStream*,
 							const char* fmt, UInt32 size, va_list);
-	static void			vreadf(synergy::IStream*,
-							const char* fmt, va_list);
+	static void			vreadf(CSource&, const char* fmt, va_list);
 
 	static UInt32		getLength(const char* fmt, va_list);
 	static void			writef(void*, const char* fmt, va_list);
 	static UInt32		eatLength(const char** fmt);
 	static void			read(synergy::IStream*, void*, UInt32);
+	static const UInt8*	read(CSource&, UInt8* buffer, UInt32);
 };
 
 //! Mismatched read exception
@@ -18,6 +18,8 @@
 
 #include "CScreen.h"
 #include "IPlatformScreen.h"
+#include "CClipboard.h"
+#include "CPNGDecoder.h"
 #include "ProtocolTypes.h"
 #include "CLog.h"
 #include "IEventQueue.h"
@@ -157,6 +159,21 @@ CScreen::warpCursor(SInt32 x, SInt32 y)
 void
 CScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
 {
+#if !WINAPI_XWINDOWS
+	// only X11 screens take PNG images directly so give the others a
+	// bitmap.  the copy shares the other formats' data.
+	if (clipboard != NULL) {
+		CClipboard decoded;
+		CClipboard::copy(&decoded, clipboard);
+		decoded.open(decoded.getTime());
+		bool added = CPNGDecoder::addBitmap(&decoded);
+		decoded.close();
+		if (added) {
+			m_screen->setClipboard(id, &decoded);
+			return;
+		}
+	}
+#endif
 	m_screen->setClipboard(id, clipboard);
 }
 
@@ -244,6 +261,20 @@ CScreen::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 	m_screen->fakeMouseWheel(xDelta, yDelta);
 }
 
+void
+CScreen::beginBatch()
+{
+	assert(!m_isPrimary);
+	m_screen->fakeBatchBegin();
+}
+
+void
+CScreen::endBatch()
+{
+	assert(!m_isPrimary);
+	m_screen->fakeBatchEnd();
+}
+
 void
 CScreen::gameDeviceButtons(GameDeviceID id, GameDeviceButton buttons)
 {
@@ -167,6 +167,19 @@ public:
 	*/
 	void				mouseWheel(SInt32 xDelta, SInt32 yDelta);
 
+	//! Begin a batch of synthesized input
+	/*!
+	Input synthesized until the matching endBatch() may be held back
+	and delivered all at once by endBatch().  Calls may be nested.
+	*/
+	void				beginBatch();
+
+	//! End a batch of synthesized input
+	/*!
+	Delivers any input held back since the matching beginBatch().
+	*/
+	void				endBatch();
+
 	//! Notify of game device buttons changed
 	/*!
 	Synthesize game device button states.
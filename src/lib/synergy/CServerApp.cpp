@@ -35,6 +35,7 @@
 #include "CFunctionEventJob.h"
 #include "TMethodJob.h"
 #include "CVncClient.h"
+#include "CConfigCache.h"
 
 #if SYSAPI_WIN32
 #include "CArchMiscWindows.h"
@@ -52,7 +53,9 @@
 #include <stdio.h>
 #include <fstream>
 #include "XScreen.h"
+#include "CHeadlessScreen.h"
 #include "CTCPSocketFactory.h"
+#include "CCryptoStreamFilterFactory.h"
 
 CEvent::Type CServerApp::s_reloadConfigEvent = CEvent::kUnknown;
 
@@ -76,7 +79,8 @@ CServerApp::~CServerApp()
 
 CServerApp::CArgs::CArgs() :
 m_synergyAddress(NULL),
-m_config(NULL)
+m_config(NULL),
+m_configCache(false)
 {
 }
 
@@ -112,6 +116,11 @@ CServerApp::parseArg(const int& argc, const char* const* argv, int& i)
 		args().m_configFile = argv[++i];
 	}
 
+	else if (isArg(i, argc, argv, NULL, "--config-cache")) {
+		// load/save a precompiled copy of the configuration
+		args().m_configCache = true;
+	}
+
 	else {
 		// option not supported here
 		return false;
@@ -163,12 +172,13 @@ CServerApp::help()
 #  define WINAPI_INFO
 #endif
 
-	char buffer[2000];
+	char buffer[3000];
 	sprintf(
 		buffer,
 		"Usage: %s"
 		" [--address <address>]"
 		" [--config <pathname>]"
+		" [--config-cache]"
 		WINAPI_ARGS
 		HELP_SYS_ARGS
 		HELP_COMMON_ARGS
@@ -177,6 +187,8 @@ CServerApp::help()
 		"\n"
 		"  -a, --address <address>  listen for clients on the given address.\n"
 		"  -c, --config <pathname>  use the named configuration file instead.\n"
+		"      --config-cache       keep a precompiled copy of the configuration\n"
+		"                             in <pathname>.cache for faster startup.\n"
 		HELP_COMMON_INFO_1
 		WINAPI_INFO
 		HELP_SYS_INFO
@@ -267,6 +279,12 @@ bool
 CServerApp::loadConfig(const CString& pathname)
 {
 	try {
+		// use the precompiled configuration if it's up to date
+		if (args().m_configCache &&
+			CConfigCache::load(pathname, *args().m_config)) {
+			return true;
+		}
+
 		// load configuration
 		LOG((CLOG_DEBUG "opening configuration \"%s\"", pathname.c_str()));
 		std::ifstream configStream(pathname.c_str());
@@ -280,6 +298,10 @@ CServerApp::loadConfig(const CString& pathname)
 		}
 		configStream >> *args().m_config;
 		LOG((CLOG_DEBUG "configuration read successfully"));
+
+		if (args().m_configCache) {
+			CConfigCache::save(pathname, *args().m_config);
+		}
 		return true;
 	}
 	catch (XConfigRead& e) {
@@ -645,6 +667,11 @@ CServerApp::startServer()
 CScreen* 
 CServerApp::createScreen()
 {
+	if (args().m_headless) {
+		return new CScreen(new CHeadlessScreen(
+			true, args().m_headlessScript, *EVENTQUEUE));
+	}
+
 #if WINAPI_MSWINDOWS
 	return new CScreen(new CMSWindowsScreen(
 		true, args().m_noHooks, args().m_gameDevice, args().m_stopOnDeskSwitch));
@@ -694,8 +721,15 @@ CServerApp::handleResume(const CEvent&, void*)
 CClientListener*
 CServerApp::openClientListener(const CNetworkAddress& address)
 {
+	IStreamFilterFactory* streamFilterFactory = NULL;
+	if (!args().m_cryptoPass.empty()) {
+		streamFilterFactory =
+			new CCryptoStreamFilterFactory(args().m_cryptoPass, true);
+	}
+
 	CClientListener* listen =
-		new CClientListener(address, new CTCPSocketFactory, NULL);
+		new CClientListener(address, new CTCPSocketFactory,
+							streamFilterFactory);
 	EVENTQUEUE->adoptHandler(CClientListener::getConnectedEvent(), listen,
 		new TMethodEventJob<CServerApp>(
 		this, &CServerApp::handleClientConnected, listen));
@@ -791,6 +825,7 @@ CServerApp::mainLoop()
 	if (argsBase().m_enableIpc) {
 		initIpcClient();
 	}
+	initMetrics();
 
 	// load all available plugins.
 	ARCH->plugin().init(s_serverScreen->getEventTarget());
@@ -819,6 +854,7 @@ CServerApp::mainLoop()
 	DAEMON_RUNNING(true);
 	EVENTQUEUE->loop();
 	DAEMON_RUNNING(false);
+	cleanupMetrics();
 
 	// close down
 	LOG((CLOG_DEBUG1 "stopping server"));
@@ -54,6 +54,7 @@ public:
 		CString	m_configFile;
 		CNetworkAddress* m_synergyAddress;
 		CConfig* m_config;
+		bool m_configCache;
 	};
 
 	CServerApp(CreateTaskBarReceiverFunc createTaskBarReceiver);
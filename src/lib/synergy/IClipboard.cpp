@@ -23,6 +23,19 @@
 // IClipboard
 //
 
+void
+IClipboard::addBlob(EFormat format, const CClipboardBlob& data)
+{
+	add(format, data.toString());
+}
+
+CClipboardBlob
+IClipboard::getBlob(EFormat format) const
+{
+	CString data = get(format);
+	return CClipboardBlob::adopt(data);
+}
+
 void
 IClipboard::unmarshall(IClipboard* clipboard, const CString& data, Time time)
 {
@@ -62,6 +75,48 @@ IClipboard::unmarshall(IClipboard* clipboard, const CString& data, Time time)
 	clipboard->close();
 }
 
+void
+IClipboard::unmarshall(IClipboard* clipboard,
+				const CClipboardBlob& data, Time time)
+{
+	assert(clipboard != NULL);
+
+	const char* buffer = data.data();
+	const UInt32 end   = data.size();
+
+	// clear existing data
+	clipboard->open(time);
+	clipboard->empty();
+
+	// read the number of formats
+	UInt32 offset = 0;
+	UInt32 numFormats = 0;
+	if (end >= 4) {
+		numFormats = readUInt32(buffer);
+		offset    += 4;
+	}
+
+	// read each format
+	for (UInt32 i = 0; i < numFormats && end - offset >= 8; ++i) {
+		IClipboard::EFormat format =
+			static_cast<IClipboard::EFormat>(readUInt32(buffer + offset));
+		UInt32 size = readUInt32(buffer + offset + 4);
+		offset     += 8;
+		if (size > end - offset) {
+			break;
+		}
+
+		// see unmarshall(IClipboard*, const CString&, Time)
+		if (format < IClipboard::kNumFormats) {
+			clipboard->addBlob(format, CClipboardBlob(data, offset, size));
+		}
+		offset += size;
+	}
+
+	// done
+	clipboard->close();
+}
+
 CString
 IClipboard::marshall(const IClipboard* clipboard)
 {
@@ -69,7 +124,7 @@ IClipboard::marshall(const IClipboard* clipboard)
 
 	CString data;
 
-	std::vector<CString> formatData;
+	std::vector<CClipboardBlob> formatData;
 	formatData.resize(IClipboard::kNumFormats);
 	// FIXME -- use current time
 	clipboard->open(0);
@@ -81,7 +136,7 @@ IClipboard::marshall(const IClipboard* clipboard)
 		if (clipboard->has(static_cast<IClipboard::EFormat>(format))) {
 			++numFormats;
 			formatData[format] =
-				clipboard->get(static_cast<IClipboard::EFormat>(format));
+				clipboard->getBlob(static_cast<IClipboard::EFormat>(format));
 			size += 4 + 4 + (UInt32)formatData[format].size();
 		}
 	}
@@ -95,7 +150,7 @@ IClipboard::marshall(const IClipboard* clipboard)
 		if (clipboard->has(static_cast<IClipboard::EFormat>(format))) {
 			writeUInt32(&data, format);
 			writeUInt32(&data, (UInt32)formatData[format].size());
-			data += formatData[format];
+			data.append(formatData[format].data(), formatData[format].size());
 		}
 	}
 	clipboard->close();
@@ -126,7 +181,7 @@ IClipboard::copy(IClipboard* dst, const IClipboard* src, Time time)
 								format != IClipboard::kNumFormats; ++format) {
 					IClipboard::EFormat eFormat = (IClipboard::EFormat)format;
 					if (src->has(eFormat)) {
-						dst->add(eFormat, src->get(eFormat));
+						dst->addBlob(eFormat, src->getBlob(eFormat));
 					}
 				}
 				success = true;
@@ -20,6 +20,7 @@
 #define ICLIPBOARD_H
 
 #include "IInterface.h"
+#include "CClipboardBlob.h"
 #include "CString.h"
 #include "BasicTypes.h"
 
@@ -55,11 +56,16 @@ public:
 	\c kHTML is a text format encoded in UTF-8 and containing a valid
 	HTML fragment (but not necessarily a complete HTML document).
 	Newlines are LF.
+
+	\c kPNG is a compressed image format.  The data is a complete PNG
+	file.  It's only sent to peers using protocol 1.7 or later;  older
+	peers get the image decoded to \c kBitmap instead.
 	*/
 	enum EFormat {
 		kText,			//!< Text format, UTF-8, newline is LF
 		kBitmap,		//!< Bitmap format, BMP 24/32bpp, BI_RGB
 		kHTML,			//!< HTML format, HTML fragment, UTF-8, newline is LF
+		kPNG,			//!< Image format, PNG file
 		kNumFormats		//!< The number of clipboard formats
 	};
 
@@ -82,6 +88,13 @@ public:
 	*/
 	virtual void		add(EFormat, const CString& data) = 0;
 
+	//! Add shared data
+	/*!
+	Like add() but the clipboard may keep a reference to \p data
+	instead of copying it.  The default copies the data via add().
+	*/
+	virtual void		addBlob(EFormat, const CClipboardBlob& data);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -128,6 +141,14 @@ public:
 	*/
 	virtual CString		get(EFormat) const = 0;
 
+	//! Get shared data
+	/*!
+	Like get() but the returned blob may share the clipboard's own
+	buffer instead of copying it.  The default wraps the result of
+	get().  Must be called between a successful open() and close().
+	*/
+	virtual CClipboardBlob	getBlob(EFormat) const;
+
 	//! Marshall clipboard data
 	/*!
 	Merge \p clipboard's data into a single buffer that can be later
@@ -143,6 +164,15 @@ public:
 	static void			unmarshall(IClipboard* clipboard,
 							const CString& data, Time time);
 
+	//! Unmarshall shared clipboard data
+	/*!
+	Like unmarshall() but each format's data is passed to \p clipboard
+	as a slice of \p data so clipboards that keep blobs share it.
+	Truncated data is ignored from the first incomplete format.
+	*/
+	static void			unmarshall(IClipboard* clipboard,
+							const CClipboardBlob& data, Time time);
+
 	//! Copy clipboard
 	/*!
 	Transfers all the data in one clipboard to another.  The
@@ -164,7 +194,7 @@ public:
 
 	//@}
 
-private:
+protected:
 	static UInt32		readUInt32(const char*);
 	static void			writeUInt32(CString*, UInt32);
 };
@@ -57,6 +57,20 @@ public:
 	Synthesize a mouse wheel event of amount \c xDelta and \c yDelta.
 	*/
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const = 0;
+
+	//! Begin a batch of faked input
+	/*!
+	Input faked until the matching fakeBatchEnd() may be queued and only
+	delivered by fakeBatchEnd().  Calls may be nested;  only the
+	outermost have an effect.
+	*/
+	virtual void		fakeBatchBegin() = 0;
+
+	//! End a batch of faked input
+	/*!
+	Delivers any input queued since the matching fakeBatchBegin().
+	*/
+	virtual void		fakeBatchEnd() = 0;
 	
 	//! Fake game device buttons
 	/*!
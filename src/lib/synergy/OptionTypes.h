@@ -68,6 +68,8 @@ static const OptionID	kOptionXTestXineramaUnaware   = OPTION_CODE("XTXU");
 static const OptionID	kOptionScreenPreserveFocus    = OPTION_CODE("SFOC");
 static const OptionID	kOptionRelativeMouseMoves     = OPTION_CODE("MDLT");
 static const OptionID	kOptionWin32KeepForeground    = OPTION_CODE("_KFW");
+static const OptionID	kOptionMotionRate             = OPTION_CODE("MRAT");
+static const OptionID	kOptionMotionInterpolate      = OPTION_CODE("MINT");
 //@}
 
 //! @name Screen switch corner enumeration
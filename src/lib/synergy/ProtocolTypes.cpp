@@ -44,8 +44,12 @@ const char*				kMsgDMouseRelMove	= "DMRM%2i%2i";
 const char*				kMsgDMouseWheel		= "DMWM%2i%2i";
 const char*				kMsgDMouseWheel1_0	= "DMWM%2i";
 const char*				kMsgDClipboard		= "DCLP%1i%4i%s";
+const char*				kMsgDClipboardBytes	= "DCLP%1i%4i%S";
 const char*				kMsgDInfo			= "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*				kMsgDSetOptions		= "DSOP%4I";
+const char*				kMsgDResume			= "DRSM%s";
+const char*				kMsgDSession		= "DSES%s%1i";
+const char*				kMsgDTrace			= "DTRC%4i";
 const char*				kMsgDGameButtons	= "DGBT%1i%2i";
 const char*				kMsgDGameSticks		= "DGST%1i%2i%2i%2i%2i";
 const char*				kMsgDGameTriggers	= "DGTR%1i%1i%1i";
@@ -28,8 +28,11 @@
 // 1.3:  adds keep alive and deprecates heartbeats,
 //       adds horizontal mouse scrolling
 // 1.4:  adds game device support
+// 1.5:  adds session resumption
+// 1.6:  adds latency trace ids
+// 1.7:  adds PNG clipboard format
 static const SInt16		kProtocolMajorVersion = 1;
-static const SInt16		kProtocolMinorVersion = 4;
+static const SInt16		kProtocolMinorVersion = 7;
 
 // default contact port number
 static const UInt16		kDefaultPort = 24800;
@@ -45,6 +48,23 @@ static const double		kKeepAliveRate = 3.0;
 // number of skipped kMsgCKeepAlive messages that indicates a problem
 static const double		kKeepAlivesUntilDeath = 3.0;
 
+// least time (in seconds) past the keep alive rate to wait for a keep
+// alive from a peer with measured delays.  it must cover a stall
+// behind a full send buffer, which a quiet network doesn't measure.
+static const double		kKeepAliveMinSlack = 2.0;
+
+// a client with more than this many bytes waiting to be sent, or with a
+// round trip time (in seconds) longer than this, is congested.  the
+// server holds back mouse motion for a congested client, sending only
+// the latest position once it catches up.
+static const UInt32		kCongestedOutputSize = 65536;
+static const double		kCongestedRoundTrip = 1.0;
+
+// time (in seconds) the server remembers the session of a client that
+// has disconnected.  a client that reconnects within this time can
+// resume its session.
+static const double		kSessionTimeout = 30.0;
+
 // obsolete heartbeat stuff
 static const double		kHeartRate = -1.0;
 static const double		kHeartBeatsUntilDeath = 3.0;
@@ -262,6 +282,11 @@ extern const char*		kMsgDGameFeedback;
 // identifier.
 extern const char*		kMsgDClipboard;
 
+// clipboard data:  primary <-> secondary
+// the same message as kMsgDClipboard but written from a byte count
+// and pointer instead of a CString.
+extern const char*		kMsgDClipboardBytes;
+
 // client data:  secondary -> primary
 // $1 = coordinate of leftmost pixel on secondary screen,
 // $2 = coordinate of topmost pixel on secondary screen,
@@ -283,6 +308,30 @@ extern const char*		kMsgDInfo;
 // pairs.
 extern const char*		kMsgDSetOptions;
 
+// resume session:  secondary -> primary
+// $1 = session token from the most recent kMsgDSession.  a secondary
+// screen that has a session token may send this message instead of
+// kMsgDInfo in response to the first kMsgQInfo, but only if its screen
+// info hasn't changed since the session started.  if the primary can't
+// resume the session it sends another kMsgQInfo and the secondary
+// must reply with a kMsgDInfo.
+extern const char*		kMsgDResume;
+
+// session:  primary -> secondary
+// $1 = session token, $2 = 1 if the secondary resumed its previous
+// session, 0 if this is a new session.  sent when the handshake
+// completes.  when the session is resumed the handshake is complete,
+// the secondary keeps its options and clipboard state and the primary
+// only sends options that have changed.  the secondary must discard
+// its clipboard state when starting a new session.
+extern const char*		kMsgDSession;
+
+// latency trace:  primary -> secondary
+// $1 = trace id.  the next message belongs to latency trace $1.  only
+// sent when the primary is tracing latency.  secondary screens that
+// aren't tracing latency should ignore it.
+extern const char*		kMsgDTrace;
+
 //
 // query codes
 //
@@ -221,7 +221,6 @@ static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 			// Send reply failed, let's try to reconnect
 			sTrace(context, "SendReply failed, trying to reconnect in a second");
 			context->m_connected = USYNERGY_FALSE;
-			context->m_sleepFunc(context->m_cookie, 1000);
 		}
 		else
 		{
@@ -466,6 +465,116 @@ static void sSetDisconnected(uSynergyContext *context)
 	context->m_isCaptured		= USYNERGY_FALSE;
 	context->m_replyCur			= context->m_replyBuffer + 4;
 	context->m_sequenceNumber	= 0;
+	context->m_receiveOfs		= 0;
+	context->m_skipLength		= 0;
+}
+
+
+
+/**
+@brief Parse all complete packets in a buffer
+
+Packets are parsed in place by moving a cursor over the buffer, so the buffer is never shifted while parsing.
+Stops at the first incomplete packet or when the context gets disconnected. The remainder of a packet too big
+for the receive buffer is discarded as it arrives.
+
+@returns			Number of bytes consumed from the front of the buffer
+**/
+static int sProcessPackets(uSynergyContext *context, const uint8_t *buffer, int length)
+{
+	const uint8_t	*cur	= buffer;
+	int				left	= length;
+	uint32_t		packlen;
+
+	while (context->m_connected)
+	{
+		/* Discard the tail end of an oversized packet */
+		if (context->m_skipLength > 0)
+		{
+			int skip = context->m_skipLength < (uint32_t)left ? (int)context->m_skipLength : left;
+			cur += skip;
+			left -= skip;
+			context->m_skipLength -= skip;
+			if (context->m_skipLength > 0)
+				break;
+		}
+
+		/* Grab packet length and bail out if the packet goes beyond the end of the buffer */
+		if (left < 4)
+			break;
+		packlen = (uint32_t)sNetToNative32(cur);
+		if (packlen > (uint32_t)(left - 4))
+		{
+			/* A length no server sends means the stream is corrupt */
+			if (packlen > USYNERGY_MAX_PACKET_SIZE)
+			{
+				char text[128];
+				sprintf(text, "Invalid packet length %u, disconnecting", packlen);
+				sTrace(context, text);
+				context->m_connected = USYNERGY_FALSE;
+				break;
+			}
+
+			/* Throw away over-sized packets */
+			if (packlen > USYNERGY_RECEIVE_BUFFER_SIZE - 4)
+			{
+				char text[128];
+				sprintf(text, "Oversized packet: '%c%c%c%c' (length %u)", left > 4 ? cur[4] : '?', left > 5 ? cur[5] : '?', left > 6 ? cur[6] : '?', left > 7 ? cur[7] : '?', packlen);
+				sTrace(context, text);
+				context->m_skipLength = packlen + 4;
+				continue;
+			}
+			break;
+		}
+
+		/* Process message */
+		sProcessMessage(context, cur);
+		cur += packlen + 4;
+		left -= packlen + 4;
+	}
+	return (int)(cur - buffer);
+}
+
+
+
+/**
+@brief Parse the receive buffer and move the incomplete packet, if any, to the front of it
+**/
+static void sProcessReceiveBuffer(uSynergyContext *context)
+{
+	int consumed = sProcessPackets(context, context->m_receiveBuffer, context->m_receiveOfs);
+	if (!context->m_connected)
+		return;
+
+	/* Single compaction per update */
+	context->m_receiveOfs -= consumed;
+	if (consumed > 0 && context->m_receiveOfs > 0)
+		memmove(context->m_receiveBuffer, context->m_receiveBuffer + consumed, context->m_receiveOfs);
+}
+
+
+
+/**
+@brief Check for a connection that went quiet
+**/
+static void sCheckTimeout(uSynergyContext *context, uSynergyBool received)
+{
+	uint32_t cur_time;
+	if (!context->m_hasReceivedHello)
+		return;
+
+	cur_time = context->m_getTimeFunc();
+	if (!received)
+	{
+		/* Timeout after 2 secs of inactivity (we received no CALV) */
+		if ((cur_time - context->m_lastMessageTime) > USYNERGY_IDLE_TIMEOUT)
+		{
+			sTrace(context, "Connection timed out");
+			context->m_connected = USYNERGY_FALSE;
+		}
+	}
+	else
+		context->m_lastMessageTime = cur_time;
 }
 
 
@@ -478,8 +587,7 @@ static void sUpdateContext(uSynergyContext *context)
 	/* Receive data (blocking) */
 	int receive_size = USYNERGY_RECEIVE_BUFFER_SIZE - context->m_receiveOfs;
 	int num_received = 0;
-	int packlen = 0;
-	if (context->m_receiveFunc(context->m_cookie, context->m_receiveBuffer, receive_size, &num_received) == USYNERGY_FALSE)
+	if (context->m_receiveFunc(context->m_cookie, context->m_receiveBuffer + context->m_receiveOfs, receive_size, &num_received) == USYNERGY_FALSE)
 	{
 		/* Receive failed, let's try to reconnect */
 		char buffer[128];
@@ -497,63 +605,22 @@ static void sUpdateContext(uSynergyContext *context)
 	if (num_received == 0)
 		context->m_sleepFunc(context->m_cookie, 500);
 
-	/* Check for timeouts */
-	if (context->m_hasReceivedHello)
+	/* Check for timeouts and reconnect straight away */
+	sCheckTimeout(context, num_received != 0);
+	if (!context->m_connected)
 	{
-		uint32_t cur_time = context->m_getTimeFunc();
-		if (num_received == 0)
-		{
-			/* Timeout after 2 secs of inactivity (we received no CALV) */
-			if ((cur_time - context->m_lastMessageTime) > USYNERGY_IDLE_TIMEOUT)
-				sSetDisconnected(context);
-		}
-		else
-			context->m_lastMessageTime = cur_time;
+		sSetDisconnected(context);
+		return;
 	}
 
 	/* Eat packets */
-	for (;;)
-	{
-		/* Grab packet length and bail out if the packet goes beyond the end of the buffer */
-		packlen = sNetToNative32(context->m_receiveBuffer);
-		if (packlen+4 > context->m_receiveOfs)
-			break;
-
-		/* Process message */
-		sProcessMessage(context, context->m_receiveBuffer);
-
-		/* Move packet to front of buffer */
-		memmove(context->m_receiveBuffer, context->m_receiveBuffer+packlen+4, context->m_receiveOfs-packlen-4);
-		context->m_receiveOfs -= packlen+4;
-	}
+	sProcessReceiveBuffer(context);
 
-	/* Throw away over-sized packets */
-	if (packlen > USYNERGY_RECEIVE_BUFFER_SIZE)
+	/* Send reply failed or the stream is corrupt, reconnect in a second */
+	if (!context->m_connected)
 	{
-		/* Oversized packet, ditch tail end */
-		char buffer[128];
-		sprintf(buffer, "Oversized packet: '%c%c%c%c' (length %d)", context->m_receiveBuffer[4], context->m_receiveBuffer[5], context->m_receiveBuffer[6], context->m_receiveBuffer[7], packlen);
-		sTrace(context, buffer);
-		num_received = context->m_receiveOfs-4; // 4 bytes for the size field
-		while (num_received != packlen)
-		{
-			int buffer_left = packlen - num_received;
-			int to_receive = buffer_left < USYNERGY_RECEIVE_BUFFER_SIZE ? buffer_left : USYNERGY_RECEIVE_BUFFER_SIZE;
-			int ditch_received = 0;
-			if (context->m_receiveFunc(context->m_cookie, context->m_receiveBuffer, to_receive, &ditch_received) == USYNERGY_FALSE)
-			{
-				/* Receive failed, let's try to reconnect */
-				sTrace(context, "Receive failed, trying to reconnect in a second");
-				sSetDisconnected(context);
-				context->m_sleepFunc(context->m_cookie, 1000);
-				break;
-			}
-			else
-			{
-				num_received += ditch_received;
-			}
-		}
-		context->m_receiveOfs = 0;
+		sSetDisconnected(context);
+		context->m_sleepFunc(context->m_cookie, 1000);
 	}
 }
 
@@ -597,6 +664,60 @@ void uSynergyUpdate(uSynergyContext *context)
 
 
 
+/**
+@brief Process data received from the server
+**/
+uSynergyBool uSynergyProcessData(uSynergyContext *context, const uint8_t *data, int length)
+{
+	int consumed;
+
+	/* The caller owns the connection */
+	context->m_connected = USYNERGY_TRUE;
+	sCheckTimeout(context, length != 0);
+
+	/* Complete the packet left over from last time */
+	while (length > 0 && context->m_receiveOfs > 0 && context->m_connected)
+	{
+		int space	= USYNERGY_RECEIVE_BUFFER_SIZE - context->m_receiveOfs;
+		int n		= length < space ? length : space;
+		memcpy(context->m_receiveBuffer + context->m_receiveOfs, data, n);
+		context->m_receiveOfs += n;
+		data += n;
+		length -= n;
+		sProcessReceiveBuffer(context);
+	}
+
+	/* Parse the rest in place and keep the incomplete packet at the end, which always fits */
+	if (length > 0 && context->m_connected)
+	{
+		consumed = sProcessPackets(context, data, length);
+		if (context->m_connected)
+		{
+			memcpy(context->m_receiveBuffer, data + consumed, length - consumed);
+			context->m_receiveOfs = length - consumed;
+		}
+	}
+
+	if (!context->m_connected)
+	{
+		sSetDisconnected(context);
+		return USYNERGY_FALSE;
+	}
+	return USYNERGY_TRUE;
+}
+
+
+
+/**
+@brief Reset after the connection is lost
+**/
+void uSynergyDisconnect(uSynergyContext *context)
+{
+	sSetDisconnected(context);
+}
+
+
+
 /**
 @brief Send clipboard data
 **/
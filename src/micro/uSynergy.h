@@ -108,6 +108,7 @@ enum uSynergyClipboardFormat
 #define				USYNERGY_TRACE_BUFFER_SIZE		1024			/* Maximum length of traced message */
 #define				USYNERGY_REPLY_BUFFER_SIZE		1024			/* Maximum size of a reply packet */
 #define				USYNERGY_RECEIVE_BUFFER_SIZE	4096			/* Maximum size of an incoming packet */
+#define				USYNERGY_MAX_PACKET_SIZE		0x1000000		/* Packets longer than this are a protocol error, shorter ones that don't fit are skipped */
 
 
 
@@ -344,6 +345,7 @@ typedef struct
 	uint32_t						m_sequenceNumber;								/* Packet sequence number */
 	uint8_t							m_receiveBuffer[USYNERGY_RECEIVE_BUFFER_SIZE];	/* Receive buffer */
 	int								m_receiveOfs;									/* Receive buffer offset */
+	uint32_t						m_skipLength;									/* Bytes left to discard of an oversized packet */
 	uint8_t							m_replyBuffer[USYNERGY_REPLY_BUFFER_SIZE];		/* Reply buffer */
 	uint8_t*						m_replyCur;										/* Write offset into reply buffer */
 	uint16_t						m_mouseX;										/* Mouse X position */
@@ -398,6 +400,39 @@ extern void		uSynergyUpdate(uSynergyContext *context);
 
 
 
+/**
+@brief Process data received from the server
+
+This function is the non-blocking alternative to uSynergyUpdate for clients that run their own event loop
+and own the connection to the server. Pass every block of data received from the server as it arrives, in
+any size. Complete packets are parsed in place and callbacks and replies are made before returning; only an
+incomplete packet at the end is copied into the context. It never calls the receive, connect or sleep
+functions and it doesn't do any memory allocations.
+
+Call it with a @a length of 0 when polling times out so the idle timeout can be detected.
+
+@param context	Context to process data with
+@param data		Data received from the server
+@param length	Length of @a data in bytes, 0 if nothing was received
+@returns		USYNERGY_FALSE if a reply failed or the server timed out, in which case the caller should
+				reconnect, USYNERGY_TRUE otherwise
+**/
+extern uSynergyBool uSynergyProcessData(uSynergyContext *context, const uint8_t *data, int length);
+
+
+
+/**
+@brief Reset after the connection is lost
+
+When using uSynergyProcessData, call this function when the connection to the server is lost so that data
+left over from the old connection isn't parsed as part of the new one.
+
+@param context	Context to reset
+**/
+extern void		uSynergyDisconnect(uSynergyContext *context);
+
+
+
 /**
 @brief Send clipboard data
 
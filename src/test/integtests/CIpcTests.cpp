@@ -49,6 +49,8 @@ public:
 	void				sendMessageToServer_serverHandleMessageReceived(const CEvent&, void*);
 	void				sendMessageToClient_serverHandleClientConnected(const CEvent&, void*);
 	void				sendMessageToClient_clientHandleMessageReceived(const CEvent&, void*);
+	void				sendLogBatchToClient_serverHandleClientConnected(const CEvent&, void*);
+	void				sendLogBatchToClient_clientHandleMessageReceived(const CEvent&, void*);
 	void				handleQuitTimeout(const CEvent&, void* vclient);
 	void				raiseQuitEvent();
 	void				initQuitTimeout(double timeout);
@@ -68,6 +70,8 @@ public:
 	CString				m_sendMessageToClient_receivedString;
 	CIpcClient*			m_sendMessageToServer_client;
 	CIpcServer*			m_sendMessageToClient_server;
+	std::vector<CString>	m_sendLogBatchToClient_receivedLines;
+	CIpcServer*			m_sendLogBatchToClient_server;
 
 };
 
@@ -146,13 +150,46 @@ TEST_F(CIpcTests, sendMessageToClient)
 	EXPECT_EQ("test", m_sendMessageToClient_receivedString);
 }
 
+TEST_F(CIpcTests, sendLogBatchToClient)
+{
+	CIpcServer server(TEST_IPC_PORT);
+	server.listen();
+	m_sendLogBatchToClient_server = &server;
+
+	// event handler sends a batch of log lines to client.
+	m_events.adoptHandler(
+		CIpcServer::getMessageReceivedEvent(), &server,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::sendLogBatchToClient_serverHandleClientConnected));
+
+	CIpcClient client(TEST_IPC_PORT);
+	client.connect();
+	
+	m_events.adoptHandler(
+		CIpcClient::getMessageReceivedEvent(), &client,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::sendLogBatchToClient_clientHandleMessageReceived));
+
+	initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(CIpcServer::getMessageReceivedEvent(), &server);
+	m_events.removeHandler(CIpcClient::getMessageReceivedEvent(), &client);
+	cleanupQuitTimeout();
+
+	ASSERT_EQ(3, m_sendLogBatchToClient_receivedLines.size());
+	EXPECT_EQ("first", m_sendLogBatchToClient_receivedLines[0]);
+	EXPECT_EQ("", m_sendLogBatchToClient_receivedLines[1]);
+	EXPECT_EQ("multi\nline", m_sendLogBatchToClient_receivedLines[2]);
+}
+
 CIpcTests::CIpcTests() :
 m_quitTimeoutTimer(nullptr),
 m_connectToServer_helloMessageReceived(false),
 m_connectToServer_hasClientNode(false),
 m_connectToServer_server(nullptr),
 m_sendMessageToClient_server(nullptr),
-m_sendMessageToServer_client(nullptr)
+m_sendMessageToServer_client(nullptr),
+m_sendLogBatchToClient_server(nullptr)
 {
 }
 
@@ -212,6 +249,37 @@ CIpcTests::sendMessageToClient_clientHandleMessageReceived(const CEvent& e, void
 	}
 }
 
+void
+CIpcTests::sendLogBatchToClient_serverHandleClientConnected(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->m_type == kIpcHello) {
+		LOG((CLOG_DEBUG "client said hello, sending log batch to client"));
+		CIpcLogBatchMessage m;
+		m.append("first", 5);
+		m.append("", 0);
+		m.append("multi\nline", 10);
+		m_sendLogBatchToClient_server->send(m, kIpcClientNode);
+	}
+}
+
+void
+CIpcTests::sendLogBatchToClient_clientHandleMessageReceived(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->m_type == kIpcLogBatch) {
+		CIpcLogBatchMessage* lbm = static_cast<CIpcLogBatchMessage*>(m);
+		UInt32 offset = 0;
+		const char* line;
+		UInt32 length;
+		while (lbm->getLine(offset, line, length)) {
+			m_sendLogBatchToClient_receivedLines.push_back(
+				CString(line, length));
+		}
+		raiseQuitEvent();
+	}
+}
+
 void
 CIpcTests::raiseQuitEvent() 
 {
@@ -0,0 +1,95 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CUnicode.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+
+#define TEXT_SIZE		(8 * 1024 * 1024)
+#define NUM_RUNS		5
+
+// clipboard sized UTF-8 text built from repeating \p sample
+static CString
+makeText(const char* sample)
+{
+	CString text;
+	text.reserve(TEXT_SIZE + 256);
+	while (text.size() < TEXT_SIZE) {
+		text += sample;
+	}
+	return text;
+}
+
+// converts \p utf8 to UTF-16 and back and checks the round trip.
+// logs the throughput of each direction in MB of UTF-8 per second.
+static void
+run(const char* name, const CString& utf8)
+{
+	CString utf16;
+	CStopwatch toUTF16(false);
+	for (UInt32 i = 0; i < NUM_RUNS; ++i) {
+		utf16 = CUnicode::UTF8ToUTF16(utf8);
+	}
+	double toUTF16Elapsed = toUTF16.getTime() / NUM_RUNS;
+
+	CString back;
+	CStopwatch toUTF8(false);
+	for (UInt32 i = 0; i < NUM_RUNS; ++i) {
+		back = CUnicode::UTF16ToUTF8(utf16);
+	}
+	double toUTF8Elapsed = toUTF8.getTime() / NUM_RUNS;
+
+	CStopwatch validate(false);
+	bool valid = true;
+	for (UInt32 i = 0; i < NUM_RUNS; ++i) {
+		valid = valid && CUnicode::isUTF8(utf8);
+	}
+	double validateElapsed = validate.getTime() / NUM_RUNS;
+
+	double mb = utf8.size() / (1024.0 * 1024.0);
+	LOG((CLOG_INFO "%s text %d bytes: UTF-8 to UTF-16 %.0f MB/s, "
+		"UTF-16 to UTF-8 %.0f MB/s, validate %.0f MB/s",
+		name, (int)utf8.size(), mb / toUTF16Elapsed, mb / toUTF8Elapsed,
+		mb / validateElapsed));
+	EXPECT_TRUE(valid);
+	EXPECT_TRUE(back == utf8);
+}
+
+TEST(CUnicodePerfTests, convert_ascii)
+{
+	run("ascii", makeText(
+		"The quick brown fox jumps over the lazy dog.  0123456789\n"));
+}
+
+TEST(CUnicodePerfTests, convert_mixedScripts)
+{
+	// mostly ASCII prose with accented latin, cyrillic, CJK and emoji
+	run("mixed", makeText(
+		"Caf\xc3\xa9 r\xc3\xa9sum\xc3\xa9 na\xc3\xafve, "
+		"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+		"\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c "
+		"\xf0\x9f\x98\x80 the quick brown fox jumps over the lazy dog.\n"));
+}
+
+TEST(CUnicodePerfTests, convert_cjk)
+{
+	run("cjk", makeText(
+		"\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c\xe3\x80\x82"
+		"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87"
+		"\xe7\xab\xa0\xe3\x80\x82\n"));
+}
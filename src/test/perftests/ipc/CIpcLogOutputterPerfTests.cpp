@@ -0,0 +1,193 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CIpcServer.h"
+#include "CIpcClient.h"
+#include "CIpcClientProxy.h"
+#include "CIpcLogOutputter.h"
+#include "CIpcMessage.h"
+#include "CSocketMultiplexer.h"
+#include "CEventQueue.h"
+#include "TMethodEventJob.h"
+#include "TMethodJob.h"
+#include "CThread.h"
+#include "CStopwatch.h"
+#include "CArch.h"
+#include "CLog.h"
+
+#define TEST_IPC_PORT	24803
+#define NUM_LINES		200000
+
+// lines in flight before the writer waits for the reader, which keeps
+// the outputter from dropping batches when the reader falls behind.
+#define MAX_IN_FLIGHT	20000
+
+// a typical DEBUG2 log line
+static const char*		s_line =
+	"2012-10-12T10:46:07 DEBUG2: writef(IKEY%2i%2i%2i%2i) "
+	"/home/user/synergy/src/lib/synergy/CProtocolUtil.cpp,69";
+
+class CIpcLogOutputterPerfTests : public ::testing::Test
+{
+public:
+	CIpcLogOutputterPerfTests();
+
+	void				handleServerMessage(const CEvent&, void*);
+	void				handleClientMessage(const CEvent&, void*);
+	void				handleTimeout(const CEvent&, void*);
+	void				writerThread(void*);
+
+public:
+	CSocketMultiplexer	m_multiplexer;
+	CEventQueue			m_events;
+	CIpcServer*			m_server;
+	CIpcLogOutputter*	m_outputter;
+	CThread*			m_writer;
+	CStopwatch			m_stopwatch;
+	volatile UInt32		m_numLines;
+	UInt32				m_numBytes;
+	UInt32				m_numBatches;
+};
+
+TEST_F(CIpcLogOutputterPerfTests, write_debug2Lines)
+{
+	CIpcServer server(TEST_IPC_PORT);
+	server.listen();
+	m_server = &server;
+
+	CIpcLogOutputter outputter(server);
+	m_outputter = &outputter;
+
+	m_events.adoptHandler(
+		CIpcServer::getMessageReceivedEvent(), &server,
+		new TMethodEventJob<CIpcLogOutputterPerfTests>(
+		this, &CIpcLogOutputterPerfTests::handleServerMessage));
+
+	CIpcClient client(TEST_IPC_PORT);
+	client.connect();
+
+	m_events.adoptHandler(
+		CIpcClient::getMessageReceivedEvent(), &client,
+		new TMethodEventJob<CIpcLogOutputterPerfTests>(
+		this, &CIpcLogOutputterPerfTests::handleClientMessage));
+
+	CEventQueueTimer* timer = m_events.newOneShotTimer(30, NULL);
+	m_events.adoptHandler(CEvent::kTimer, timer,
+		new TMethodEventJob<CIpcLogOutputterPerfTests>(
+		this, &CIpcLogOutputterPerfTests::handleTimeout));
+
+	m_events.loop();
+	double elapsed = m_stopwatch.getTime();
+
+	m_events.removeHandler(CEvent::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.removeHandler(CIpcServer::getMessageReceivedEvent(), &server);
+	m_events.removeHandler(CIpcClient::getMessageReceivedEvent(), &client);
+
+	if (m_writer != NULL) {
+		m_writer->cancel();
+		m_writer->wait();
+		delete m_writer;
+	}
+
+	LOG((CLOG_INFO "%d log lines (%d bytes) in %d batches: %.3f ms, "
+		"%.0f lines/sec, %.1f MB/sec",
+		m_numLines, m_numBytes, m_numBatches, elapsed * 1000.0,
+		m_numLines / elapsed, m_numBytes / elapsed / (1024.0 * 1024.0)));
+	EXPECT_EQ(NUM_LINES, m_numLines);
+}
+
+CIpcLogOutputterPerfTests::CIpcLogOutputterPerfTests() :
+m_server(NULL),
+m_outputter(NULL),
+m_writer(NULL),
+m_stopwatch(true),
+m_numLines(0),
+m_numBytes(0),
+m_numBatches(0)
+{
+}
+
+void
+CIpcLogOutputterPerfTests::handleServerMessage(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->m_type != kIpcHello || m_writer != NULL) {
+		return;
+	}
+
+	// the test client says it's a node;  pretend it's the gui so it
+	// gets the log.
+	CArchMutexLock lock(m_server->m_clientsMutex);
+	for (CIpcServer::CClientList::iterator i = m_server->m_clients.begin();
+							i != m_server->m_clients.end(); ++i) {
+		(*i)->m_clientType = kIpcClientGui;
+	}
+
+	m_stopwatch.start();
+	m_stopwatch.reset();
+	m_writer = new CThread(new TMethodJob<CIpcLogOutputterPerfTests>(
+		this, &CIpcLogOutputterPerfTests::writerThread));
+}
+
+void
+CIpcLogOutputterPerfTests::handleClientMessage(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->m_type != kIpcLogBatch) {
+		return;
+	}
+
+	CIpcLogBatchMessage* lbm = static_cast<CIpcLogBatchMessage*>(m);
+	UInt32 offset = 0;
+	const char* line;
+	UInt32 length;
+	while (lbm->getLine(offset, line, length)) {
+		m_numBytes += length;
+		m_numLines  = m_numLines + 1;
+	}
+	++m_numBatches;
+
+	if (m_numLines >= NUM_LINES) {
+		m_stopwatch.stop();
+		m_events.addEvent(CEvent(CEvent::kQuit));
+	}
+}
+
+void
+CIpcLogOutputterPerfTests::handleTimeout(const CEvent&, void*)
+{
+	LOG((CLOG_ERR "timeout"));
+	m_stopwatch.stop();
+	m_events.addEvent(CEvent(CEvent::kQuit));
+}
+
+void
+CIpcLogOutputterPerfTests::writerThread(void*)
+{
+	for (UInt32 i = 0; i < NUM_LINES; ++i) {
+		while (i - m_numLines >= MAX_IN_FLIGHT) {
+			ARCH->sleep(0.001);
+		}
+		m_outputter->write(kDEBUG2, s_line);
+	}
+}
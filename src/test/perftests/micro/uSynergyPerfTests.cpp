@@ -0,0 +1,366 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "uSynergy.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "stdvector.h"
+#include <cstring>
+
+#define NUM_MOVES			500000
+
+// a key press every so many moves and a keep alive and clipboard every
+// so many more
+#define KEY_INTERVAL		50
+#define KEEP_ALIVE_INTERVAL	5000
+#define CLIPBOARD_INTERVAL	100000
+#define CLIPBOARD_SIZE		8192
+
+typedef std::vector<uint8_t> CStreamData;
+
+// what a server sends a protocol 1.4 client in a busy session:  the
+// handshake, then mostly mouse motion with some typing, keep alives
+// and the odd clipboard, which is too big for the receive buffer.
+class CRecordedStream {
+public:
+	CRecordedStream();
+
+	void				beginMessage(const char* code);
+	void				endMessage();
+	void				add8(uint8_t);
+	void				add16(uint16_t);
+	void				add32(uint32_t);
+
+public:
+	CStreamData			m_data;
+	size_t				m_start;
+	UInt32				m_numMoves;
+};
+
+class CuSynergyPerfTests : public ::testing::Test
+{
+public:
+	CuSynergyPerfTests();
+
+	void				init(uSynergyContext& context);
+	void				report(const char* name, double elapsed);
+
+
+public:
+	CRecordedStream		m_stream;
+	size_t				m_offset;
+	size_t				m_readSize;
+	UInt32				m_numMouse;
+	UInt32				m_numKeys;
+	UInt32				m_numReplies;
+	UInt32				m_numSleeps;
+};
+
+// uSynergy callbacks.  the cookie is the test.
+static uSynergyBool		connectFunc(uSynergyCookie);
+static uSynergyBool		sendFunc(uSynergyCookie, const uint8_t*, int);
+static uSynergyBool		receiveFunc(uSynergyCookie, uint8_t*, int, int*);
+static void				sleepFunc(uSynergyCookie, int);
+static uint32_t			getTimeFunc();
+static void				mouseCallback(uSynergyCookie, uint16_t, uint16_t,
+							int16_t, int16_t, uSynergyBool,
+							uSynergyBool, uSynergyBool);
+static void				keyboardCallback(uSynergyCookie, uint16_t, uint16_t,
+							uSynergyBool, uSynergyBool);
+
+// the stream as it comes off the network:  one segment at a time
+TEST_F(CuSynergyPerfTests, processData_segments)
+{
+	uSynergyContext context;
+	init(context);
+
+	CStopwatch stopwatch(false);
+	for (size_t i = 0; i < m_stream.m_data.size(); i += 1460) {
+		size_t n = m_stream.m_data.size() - i;
+		if (n > 1460) {
+			n = 1460;
+		}
+		ASSERT_TRUE(uSynergyProcessData(&context, &m_stream.m_data[i], (int)n));
+	}
+	report("segments", stopwatch.getTime());
+}
+
+// a slow link, where almost every packet is split between reads
+TEST_F(CuSynergyPerfTests, processData_smallReads)
+{
+	uSynergyContext context;
+	init(context);
+
+	CStopwatch stopwatch(false);
+	for (size_t i = 0; i < m_stream.m_data.size(); i += 5) {
+		size_t n = m_stream.m_data.size() - i;
+		if (n > 5) {
+			n = 5;
+		}
+		ASSERT_TRUE(uSynergyProcessData(&context, &m_stream.m_data[i], (int)n));
+	}
+	report("small reads", stopwatch.getTime());
+}
+
+// the blocking api, reading as much as fits in the receive buffer
+TEST_F(CuSynergyPerfTests, update_fullReads)
+{
+	uSynergyContext context;
+	init(context);
+	m_readSize = USYNERGY_RECEIVE_BUFFER_SIZE;
+
+	CStopwatch stopwatch(false);
+	while (m_offset < m_stream.m_data.size()) {
+		uSynergyUpdate(&context);
+	}
+	report("blocking", stopwatch.getTime());
+	EXPECT_EQ(0, m_numSleeps);
+}
+
+// a corrupt length word must disconnect, not skip forever
+TEST_F(CuSynergyPerfTests, processData_invalidLength_disconnects)
+{
+	uSynergyContext context;
+	init(context);
+	const uint8_t data[] = { 0xff, 0xff, 0xff, 0xff, 'D', 'M', 'M', 'V' };
+
+	EXPECT_FALSE(uSynergyProcessData(&context, data, sizeof(data)));
+	EXPECT_FALSE(context.m_connected);
+}
+
+TEST_F(CuSynergyPerfTests, update_invalidLength_disconnects)
+{
+	uSynergyContext context;
+	init(context);
+	m_readSize = USYNERGY_RECEIVE_BUFFER_SIZE;
+	m_stream.m_data.clear();
+	m_stream.add32(0xfffffffc);
+	m_stream.add32(0);
+
+	// connect, then read
+	uSynergyUpdate(&context);
+	uSynergyUpdate(&context);
+	EXPECT_FALSE(context.m_connected);
+	EXPECT_EQ(1, m_numSleeps);
+}
+
+CRecordedStream::CRecordedStream() :
+	m_start(0),
+	m_numMoves(0)
+{
+	m_data.reserve(NUM_MOVES * 12 + NUM_MOVES / KEY_INTERVAL * 28);
+
+	// hello is "Synergy%2i%2i"
+	beginMessage("Synergy");
+	add16(1);
+	add16(4);
+	endMessage();
+	beginMessage("QINF");
+	endMessage();
+	beginMessage("CIAK");
+	endMessage();
+	beginMessage("CROP");
+	endMessage();
+	beginMessage("DSOP");
+	add32(0);
+	endMessage();
+	beginMessage("CINN");
+	add16(0);
+	add16(384);
+	add32(1);
+	add16(0);
+	endMessage();
+
+	std::string clipboard(CLIPBOARD_SIZE, 'x');
+	for (UInt32 i = 0; i < NUM_MOVES; ++i) {
+		beginMessage("DMMV");
+		add16((uint16_t)(i % 1024));
+		add16(384);
+		endMessage();
+		++m_numMoves;
+
+		if ((i % KEY_INTERVAL) == 0) {
+			beginMessage("DKDN");
+			add16('a');
+			add16(0);
+			add16(38);
+			endMessage();
+			beginMessage("DKUP");
+			add16('a');
+			add16(0);
+			add16(38);
+			endMessage();
+		}
+		if ((i % KEEP_ALIVE_INTERVAL) == 0) {
+			beginMessage("CALV");
+			endMessage();
+		}
+		if ((i % CLIPBOARD_INTERVAL) == 0) {
+			beginMessage("DCLP");
+			add8(0);
+			add32(1);
+			add32(4 + 4 + 4 + CLIPBOARD_SIZE);
+			add32(1);
+			add32(USYNERGY_CLIPBOARD_FORMAT_TEXT);
+			add32(CLIPBOARD_SIZE);
+			m_data.insert(m_data.end(), clipboard.begin(), clipboard.end());
+			endMessage();
+		}
+	}
+}
+
+void
+CRecordedStream::beginMessage(const char* code)
+{
+	m_start = m_data.size();
+	add32(0);
+	m_data.insert(m_data.end(), code, code + strlen(code));
+}
+
+void
+CRecordedStream::endMessage()
+{
+	uint32_t size = (uint32_t)(m_data.size() - m_start - 4);
+	m_data[m_start + 0] = (uint8_t)(size >> 24);
+	m_data[m_start + 1] = (uint8_t)(size >> 16);
+	m_data[m_start + 2] = (uint8_t)(size >> 8);
+	m_data[m_start + 3] = (uint8_t)size;
+}
+
+void
+CRecordedStream::add8(uint8_t value)
+{
+	m_data.push_back(value);
+}
+
+void
+CRecordedStream::add16(uint16_t value)
+{
+	m_data.push_back((uint8_t)(value >> 8));
+	m_data.push_back((uint8_t)value);
+}
+
+void
+CRecordedStream::add32(uint32_t value)
+{
+	m_data.push_back((uint8_t)(value >> 24));
+	m_data.push_back((uint8_t)(value >> 16));
+	m_data.push_back((uint8_t)(value >> 8));
+	m_data.push_back((uint8_t)value);
+}
+
+CuSynergyPerfTests::CuSynergyPerfTests() :
+	m_offset(0),
+	m_readSize(0),
+	m_numMouse(0),
+	m_numKeys(0),
+	m_numReplies(0),
+	m_numSleeps(0)
+{
+}
+
+void
+CuSynergyPerfTests::init(uSynergyContext& context)
+{
+	uSynergyInit(&context);
+	context.m_connectFunc		= &connectFunc;
+	context.m_sendFunc			= &sendFunc;
+	context.m_receiveFunc		= &receiveFunc;
+	context.m_sleepFunc			= &sleepFunc;
+	context.m_getTimeFunc		= &getTimeFunc;
+	context.m_clientName		= "micro";
+	context.m_clientWidth		= 1024;
+	context.m_clientHeight		= 768;
+	context.m_cookie			= reinterpret_cast<uSynergyCookie>(this);
+	context.m_mouseCallback		= &mouseCallback;
+	context.m_keyboardCallback	= &keyboardCallback;
+}
+
+void
+CuSynergyPerfTests::report(const char* name, double elapsed)
+{
+	size_t size = m_stream.m_data.size();
+	LOG((CLOG_INFO "uSynergy %s: %d bytes, %d mouse and %d key events, "
+		"%d replies in %.3f ms, %.1f MB/sec",
+		name, size, m_numMouse, m_numKeys, m_numReplies, elapsed * 1000.0,
+		size / elapsed / (1024.0 * 1024.0)));
+	EXPECT_EQ(m_stream.m_numMoves, m_numMouse);
+	EXPECT_EQ(2 * ((NUM_MOVES + KEY_INTERVAL - 1) / KEY_INTERVAL), m_numKeys);
+}
+
+static uSynergyBool
+connectFunc(uSynergyCookie)
+{
+	return USYNERGY_TRUE;
+}
+
+static uSynergyBool
+sendFunc(uSynergyCookie cookie, const uint8_t*, int)
+{
+	reinterpret_cast<CuSynergyPerfTests*>(cookie)->m_numReplies++;
+	return USYNERGY_TRUE;
+}
+
+static uSynergyBool
+receiveFunc(uSynergyCookie cookie,
+				uint8_t* buffer, int maxLength, int* outLength)
+{
+	CuSynergyPerfTests* test = reinterpret_cast<CuSynergyPerfTests*>(cookie);
+	size_t n = test->m_stream.m_data.size() - test->m_offset;
+	if (n > test->m_readSize) {
+		n = test->m_readSize;
+	}
+	if (n > (size_t)maxLength) {
+		n = maxLength;
+	}
+	memcpy(buffer, &test->m_stream.m_data[test->m_offset], n);
+	test->m_offset += n;
+	*outLength      = (int)n;
+	return USYNERGY_TRUE;
+}
+
+static void
+sleepFunc(uSynergyCookie cookie, int)
+{
+	reinterpret_cast<CuSynergyPerfTests*>(cookie)->m_numSleeps++;
+}
+
+static uint32_t
+getTimeFunc()
+{
+	return 0;
+}
+
+static void
+mouseCallback(uSynergyCookie cookie, uint16_t, uint16_t,
+				int16_t, int16_t, uSynergyBool, uSynergyBool, uSynergyBool)
+{
+	reinterpret_cast<CuSynergyPerfTests*>(cookie)->m_numMouse++;
+}
+
+static void
+keyboardCallback(uSynergyCookie cookie, uint16_t, uint16_t,
+				uSynergyBool, uSynergyBool)
+{
+	reinterpret_cast<CuSynergyPerfTests*>(cookie)->m_numKeys++;
+}
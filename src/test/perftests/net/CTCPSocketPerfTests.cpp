@@ -0,0 +1,184 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "CTCPSocket.h"
+#include "CTCPListenSocket.h"
+#include "CNetworkAddress.h"
+#include "CSocketMultiplexer.h"
+#include "CEventQueue.h"
+#include "TMethodEventJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+
+#define TEST_PORT		24804
+#define NUM_MESSAGES	20000
+#define MESSAGE_SIZE	8
+
+// round trips small messages, the size of a mouse motion message, over
+// a loopback connection.
+class CTCPSocketPerfTests : public ::testing::Test
+{
+public:
+	CTCPSocketPerfTests();
+
+	void				handleAccept(const CEvent&, void*);
+	void				handleConnected(const CEvent&, void*);
+	void				handleServerData(const CEvent&, void*);
+	void				handleClientData(const CEvent&, void*);
+	void				handleTimeout(const CEvent&, void*);
+
+	void				sendMessage();
+
+public:
+	CSocketMultiplexer	m_multiplexer;
+	CEventQueue			m_events;
+	CTCPListenSocket*	m_listen;
+	CTCPSocket*			m_client;
+	IDataSocket*		m_server;
+	CStopwatch			m_stopwatch;
+	UInt32				m_numMessages;
+	UInt32				m_received;
+};
+
+TEST_F(CTCPSocketPerfTests, write_smallMessages_roundTripLatency)
+{
+	CNetworkAddress address("127.0.0.1", TEST_PORT);
+	address.resolve();
+
+	CTCPListenSocket listen;
+	listen.bind(address);
+	m_listen = &listen;
+	m_events.adoptHandler(IListenSocket::getConnectingEvent(), &listen,
+		new TMethodEventJob<CTCPSocketPerfTests>(
+		this, &CTCPSocketPerfTests::handleAccept));
+
+	CTCPSocket client;
+	m_client = &client;
+	m_events.adoptHandler(IDataSocket::getConnectedEvent(), &client,
+		new TMethodEventJob<CTCPSocketPerfTests>(
+		this, &CTCPSocketPerfTests::handleConnected));
+	m_events.adoptHandler(client.getInputReadyEvent(), &client,
+		new TMethodEventJob<CTCPSocketPerfTests>(
+		this, &CTCPSocketPerfTests::handleClientData));
+	client.connect(address);
+
+	CEventQueueTimer* timer = m_events.newOneShotTimer(30, NULL);
+	m_events.adoptHandler(CEvent::kTimer, timer,
+		new TMethodEventJob<CTCPSocketPerfTests>(
+		this, &CTCPSocketPerfTests::handleTimeout));
+
+	m_events.loop();
+	double elapsed = m_stopwatch.getTime();
+
+	m_events.removeHandler(CEvent::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.removeHandlers(&listen);
+	m_events.removeHandlers(&client);
+	if (m_server != NULL) {
+		m_events.removeHandlers(m_server->getEventTarget());
+		delete m_server;
+	}
+
+	LOG((CLOG_INFO "%d round trips of %d bytes: %.3f ms, %.1f us per round trip",
+		m_numMessages, MESSAGE_SIZE, elapsed * 1000.0,
+		elapsed * 1.0e6 / (m_numMessages != 0 ? m_numMessages : 1)));
+	EXPECT_EQ(NUM_MESSAGES, m_numMessages);
+}
+
+CTCPSocketPerfTests::CTCPSocketPerfTests() :
+m_listen(NULL),
+m_client(NULL),
+m_server(NULL),
+m_stopwatch(true),
+m_numMessages(0),
+m_received(0)
+{
+}
+
+void
+CTCPSocketPerfTests::handleAccept(const CEvent&, void*)
+{
+	m_server = m_listen->accept();
+	if (m_server == NULL) {
+		return;
+	}
+	m_events.adoptHandler(m_server->getInputReadyEvent(),
+		m_server->getEventTarget(),
+		new TMethodEventJob<CTCPSocketPerfTests>(
+		this, &CTCPSocketPerfTests::handleServerData));
+}
+
+void
+CTCPSocketPerfTests::handleConnected(const CEvent&, void*)
+{
+	m_stopwatch.start();
+	m_stopwatch.reset();
+	sendMessage();
+}
+
+void
+CTCPSocketPerfTests::handleServerData(const CEvent&, void*)
+{
+	// echo
+	UInt8 buffer[4096];
+	UInt32 n = m_server->read(buffer, sizeof(buffer));
+	while (n > 0) {
+		m_server->write(buffer, n);
+		n = m_server->read(buffer, sizeof(buffer));
+	}
+}
+
+void
+CTCPSocketPerfTests::handleClientData(const CEvent&, void*)
+{
+	UInt8 buffer[4096];
+	UInt32 n = m_client->read(buffer, sizeof(buffer));
+	while (n > 0) {
+		m_received += n;
+		n = m_client->read(buffer, sizeof(buffer));
+	}
+
+	while (m_received >= MESSAGE_SIZE) {
+		m_received -= MESSAGE_SIZE;
+		if (++m_numMessages == NUM_MESSAGES) {
+			m_stopwatch.stop();
+			m_events.addEvent(CEvent(CEvent::kQuit));
+			return;
+		}
+		sendMessage();
+	}
+}
+
+void
+CTCPSocketPerfTests::handleTimeout(const CEvent&, void*)
+{
+	LOG((CLOG_ERR "timeout"));
+	m_stopwatch.stop();
+	m_events.addEvent(CEvent(CEvent::kQuit));
+}
+
+void
+CTCPSocketPerfTests::sendMessage()
+{
+	static const UInt8 s_message[MESSAGE_SIZE] = {
+		'D', 'M', 'M', 'V', 0x01, 0x00, 0x02, 0x00
+	};
+	m_client->write(s_message, sizeof(s_message));
+}
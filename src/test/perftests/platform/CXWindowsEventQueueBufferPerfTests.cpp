@@ -0,0 +1,162 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "CXWindowsEventQueueBuffer.h"
+#include "CEvent.h"
+#include "CThread.h"
+#include "TMethodJob.h"
+#include "CStopwatch.h"
+#include "CArch.h"
+#include "CLog.h"
+#include <sys/resource.h>
+
+#define NUM_EVENTS		100
+#define IDLE_TIME		2.0
+
+// how often an idle event queue buffer wakes up and how long an event
+// posted from another thread takes to get to the waiting thread.  needs
+// an X display;  without one the tests pass without measuring anything.
+class CXWindowsEventQueueBufferPerfTests : public ::testing::Test
+{
+public:
+	CXWindowsEventQueueBufferPerfTests();
+
+	virtual void		SetUp();
+	virtual void		TearDown();
+
+	void				posterThread(void*);
+
+	static long			getContextSwitches();
+
+public:
+	Display*			m_display;
+	Window				m_window;
+	CXWindowsEventQueueBuffer*	m_buffer;
+	volatile double		m_postTime;
+	UInt32				m_dataID;
+};
+
+TEST_F(CXWindowsEventQueueBufferPerfTests, waitForEvent_idle_wakeups)
+{
+	if (m_buffer == NULL) {
+		LOG((CLOG_WARN "no X display, skipping"));
+		return;
+	}
+
+	long before = getContextSwitches();
+	CStopwatch stopwatch(false);
+	m_buffer->waitForEvent(IDLE_TIME);
+	double elapsed = stopwatch.getTime();
+	long wakeups = getContextSwitches() - before;
+
+	LOG((CLOG_INFO "idle for %.3f s: %ld wakeups, %.1f wakeups/sec",
+		elapsed, wakeups, wakeups / elapsed));
+	EXPECT_GE(elapsed, IDLE_TIME * 0.9);
+}
+
+TEST_F(CXWindowsEventQueueBufferPerfTests, waitForEvent_postedEvent_latency)
+{
+	if (m_buffer == NULL) {
+		LOG((CLOG_WARN "no X display, skipping"));
+		return;
+	}
+
+	double total = 0.0;
+	double worst = 0.0;
+	for (UInt32 i = 0; i < NUM_EVENTS; ++i) {
+		m_postTime = 0.0;
+		m_dataID   = i;
+		CThread poster(new TMethodJob<CXWindowsEventQueueBufferPerfTests>(
+			this, &CXWindowsEventQueueBufferPerfTests::posterThread));
+
+		// the poster may not have posted yet when we return the first
+		// time so wait again
+		while (m_buffer->isEmpty()) {
+			m_buffer->waitForEvent(1.0);
+		}
+		double latency = ARCH->time() - m_postTime;
+		poster.wait();
+
+		CEvent event;
+		UInt32 dataID;
+		EXPECT_EQ(IEventQueueBuffer::kUser, m_buffer->getEvent(event, dataID));
+		EXPECT_EQ(i, dataID);
+
+		total += latency;
+		if (latency > worst) {
+			worst = latency;
+		}
+	}
+
+	LOG((CLOG_INFO "%d posted events: mean %.3f ms, worst %.3f ms",
+		NUM_EVENTS, 1000.0 * total / NUM_EVENTS, 1000.0 * worst));
+}
+
+CXWindowsEventQueueBufferPerfTests::CXWindowsEventQueueBufferPerfTests() :
+	m_display(NULL),
+	m_window(None),
+	m_buffer(NULL),
+	m_postTime(0.0),
+	m_dataID(0)
+{
+}
+
+void
+CXWindowsEventQueueBufferPerfTests::SetUp()
+{
+	m_display = XOpenDisplay(NULL);
+	if (m_display == NULL) {
+		return;
+	}
+
+	XSetWindowAttributes attr;
+	attr.override_redirect = True;
+	m_window = XCreateWindow(m_display, DefaultRootWindow(m_display),
+		0, 0, 1, 1, 0, 0, InputOnly, CopyFromParent,
+		CWOverrideRedirect, &attr);
+	m_buffer = new CXWindowsEventQueueBuffer(m_display, m_window);
+}
+
+void
+CXWindowsEventQueueBufferPerfTests::TearDown()
+{
+	if (m_display != NULL) {
+		delete m_buffer;
+		XDestroyWindow(m_display, m_window);
+		XCloseDisplay(m_display);
+	}
+}
+
+void
+CXWindowsEventQueueBufferPerfTests::posterThread(void*)
+{
+	// give the main thread time to block
+	ARCH->sleep(0.01);
+	m_postTime = ARCH->time();
+	m_buffer->addEvent(m_dataID);
+}
+
+long
+CXWindowsEventQueueBufferPerfTests::getContextSwitches()
+{
+	// each time the waiting thread blocks and wakes it gives up the cpu
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_nvcsw;
+}
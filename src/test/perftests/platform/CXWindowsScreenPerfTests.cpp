@@ -0,0 +1,66 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "CXWindowsScreen.h"
+#include "CEventQueue.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+
+// how long a primary screen takes to start watching the display as the
+// number of windows grows.  needs an X display;  without one the test
+// passes without measuring anything.
+TEST(CXWindowsScreenPerfTests, ctor_primary_timeByWindowCount)
+{
+	Display* display = XOpenDisplay(NULL);
+	if (display == NULL) {
+		LOG((CLOG_WARN "no X display, skipping"));
+		return;
+	}
+
+	CEventQueue events;
+	Window root = DefaultRootWindow(display);
+	std::vector<Window> windows;
+	static const UInt32 s_counts[] = { 0, 1000, 4000 };
+	for (size_t i = 0; i < sizeof(s_counts) / sizeof(s_counts[0]); ++i) {
+		// top level windows with a few children each, like an app's
+		// frame, client and widgets
+		while (windows.size() < s_counts[i]) {
+			Window parent = XCreateWindow(display, root, 0, 0, 10, 10, 0,
+								0, InputOnly, CopyFromParent, 0, NULL);
+			windows.push_back(parent);
+			for (UInt32 j = 0; j < 9; ++j) {
+				windows.push_back(XCreateWindow(display, parent, 0, 0, 1, 1,
+								0, 0, InputOnly, CopyFromParent, 0, NULL));
+			}
+		}
+		XSync(display, False);
+
+		CStopwatch stopwatch;
+		{
+			CXWindowsScreen screen(NULL, true, false, 0, events);
+			LOG((CLOG_INFO "%d windows: primary screen ready in %.3f ms",
+				(int)windows.size(), 1000.0 * stopwatch.getTime()));
+		}
+	}
+
+	for (size_t i = 0; i < windows.size(); i += 10) {
+		XDestroyWindow(display, windows[i]);
+	}
+	XCloseDisplay(display);
+}
@@ -0,0 +1,106 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CConfig.h"
+#include "CConfigCache.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "stdsstream.h"
+
+#define NUM_SCREENS		100
+#define NUM_HOTKEYS		1000
+#define NUM_LOADS		20
+
+// a large generated config:  a row of screens, each with an alias and
+// links to its neighbors, and lots of hot keys.
+static CString
+generateConfig()
+{
+	static const char* s_modifiers[] = {
+		"control", "alt", "shift", "super",
+		"control+alt", "control+shift", "alt+shift", "control+alt+shift"
+	};
+	static const char* s_keys[] = {
+		"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+		"n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+		"F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "F10",
+		"F11", "F12", "Home", "End", "Insert", "Delete", "PageUp", "PageDown"
+	};
+	static const UInt32 s_numModifiers = sizeof(s_modifiers) / sizeof(s_modifiers[0]);
+	static const UInt32 s_numKeys      = sizeof(s_keys) / sizeof(s_keys[0]);
+
+	CString s = "section: screens\n";
+	for (UInt32 i = 0; i < NUM_SCREENS; ++i) {
+		s += CStringUtil::print("\tscreen%d:\n\t\thalfDuplexCapsLock = true\n", i);
+	}
+	s += "end\nsection: aliases\n";
+	for (UInt32 i = 0; i < NUM_SCREENS; ++i) {
+		s += CStringUtil::print("\tscreen%d:\n\t\thost%d.example.com\n", i, i);
+	}
+	s += "end\nsection: links\n";
+	for (UInt32 i = 0; i < NUM_SCREENS; ++i) {
+		s += CStringUtil::print("\tscreen%d:\n", i);
+		if (i > 0) {
+			s += CStringUtil::print("\t\tleft = screen%d\n", i - 1);
+		}
+		if (i + 1 < NUM_SCREENS) {
+			s += CStringUtil::print("\t\tright = screen%d\n", i + 1);
+		}
+	}
+	s += "end\nsection: options\n";
+	for (UInt32 i = 0; i < NUM_HOTKEYS; ++i) {
+		s += CStringUtil::print(
+			"\tkeystroke(%s+%s) = switchToScreen(screen%d), "
+			"keystroke(control+%s,screen%d)\n",
+			s_modifiers[i % s_numModifiers],
+			s_keys[(i / s_numModifiers) % s_numKeys],
+			i % NUM_SCREENS, s_keys[i % s_numKeys], i % NUM_SCREENS);
+	}
+	s += "end\n";
+	return s;
+}
+
+TEST(CConfigCachePerfTests, load_largeConfig)
+{
+	CString text = generateConfig();
+
+	CConfig parsed;
+	CStopwatch parseTime(false);
+	for (UInt32 i = 0; i < NUM_LOADS; ++i) {
+		std::istringstream stream(text);
+		stream >> parsed;
+	}
+	double parseElapsed = parseTime.getTime() / NUM_LOADS;
+
+	CString data = CConfigCache::marshall(parsed);
+	ASSERT_FALSE(data.empty());
+
+	CConfig loaded;
+	CStopwatch loadTime(false);
+	for (UInt32 i = 0; i < NUM_LOADS; ++i) {
+		CConfigCache::unmarshall(loaded, data);
+	}
+	double loadElapsed = loadTime.getTime() / NUM_LOADS;
+
+	LOG((CLOG_INFO "config with %d screens, %d rules: "
+		"text %d bytes parsed in %.3f ms, cache %d bytes loaded in %.3f ms",
+		NUM_SCREENS, parsed.getInputFilter()->getNumRules(),
+		(int)text.size(), parseElapsed * 1000.0,
+		(int)data.size(), loadElapsed * 1000.0));
+	EXPECT_TRUE(loaded == parsed);
+}
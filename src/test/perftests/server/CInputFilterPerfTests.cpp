@@ -0,0 +1,90 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CInputFilter.h"
+#include "CEventQueue.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "IPrimaryScreen.h"
+
+#define NUM_RULES	500
+#define NUM_EVENTS	200000
+
+class CNullAction : public CInputFilter::CAction {
+public:
+	virtual CInputFilter::CAction*	clone() const { return new CNullAction; }
+	virtual CString			format() const { return "null"; }
+	virtual void			perform(const CEvent&) { }
+};
+
+// a kiosk style config: several hundred hotkeys plus a few mouse button
+// and connect rules.  events are a mix of hotkeys spread over the whole
+// rule list and plain keystrokes that no rule matches.
+TEST(CInputFilterPerfTests, handleEvent_manyHotKeyRules)
+{
+	CEventQueue eventQueue;
+	CInputFilter filter;
+	for (UInt32 i = 0; i < NUM_RULES; ++i) {
+		CInputFilter::CRule rule(
+			new CInputFilter::CKeystrokeCondition(kKeyNone, 0));
+		rule.adoptAction(new CNullAction, true);
+		filter.addFilterRule(rule);
+	}
+	for (ButtonID button = kButtonLeft; button <= kButtonExtra0; ++button) {
+		CInputFilter::CRule rule(
+			new CInputFilter::CMouseButtonCondition(button, KeyModifierAlt));
+		rule.adoptAction(new CNullAction, true);
+		filter.addFilterRule(rule);
+	}
+
+	// hot key ids are normally assigned by the primary screen when the
+	// filter is enabled
+	for (UInt32 i = 0; i < NUM_RULES; ++i) {
+		CInputFilter::CRule& rule = filter.getRule(i);
+		static_cast<CInputFilter::CKeystrokeCondition*>(
+								rule.m_condition)->m_id = i + 1;
+	}
+
+	IPlatformScreen::CHotKeyInfo hotKey = { 0 };
+	CEvent hotKeyEvent(IPrimaryScreen::getHotKeyDownEvent(),
+								NULL, &hotKey, CEvent::kDontFreeData);
+	IPlatformScreen::CButtonInfo button = { kButtonLeft, KeyModifierAlt };
+	CEvent buttonEvent(IPrimaryScreen::getButtonDownEvent(),
+								NULL, &button, CEvent::kDontFreeData);
+
+	CStopwatch stopwatch(false);
+	for (UInt32 i = 0; i < NUM_EVENTS; ++i) {
+		if ((i & 1) == 0) {
+			hotKey.m_id = 1 + (i * 7919) % NUM_RULES;
+			filter.handleEvent(hotKeyEvent, NULL);
+		}
+		else {
+			filter.handleEvent(buttonEvent, NULL);
+		}
+	}
+	double elapsed = stopwatch.getTime();
+
+	LOG((CLOG_INFO "%d events over %d rules: %.3f ms, %.3f us/event",
+		NUM_EVENTS, filter.getNumRules(), elapsed * 1000.0,
+		elapsed * 1.0e6 / NUM_EVENTS));
+	EXPECT_FALSE(filter.m_indexDirty);
+}
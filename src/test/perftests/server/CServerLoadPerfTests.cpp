@@ -0,0 +1,657 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CServer.h"
+#include "CConfig.h"
+#include "CClientListener.h"
+#include "CClientProxy.h"
+#include "CPrimaryClient.h"
+#include "CScreen.h"
+#include "CHeadlessScreen.h"
+#include "CTCPSocket.h"
+#include "CTCPSocketFactory.h"
+#include "CNetworkAddress.h"
+#include "CPacketStreamFilter.h"
+#include "CProtocolUtil.h"
+#include "ProtocolTypes.h"
+#include "CClipboard.h"
+#include "CLatencyHistogram.h"
+#include "CSocketMultiplexer.h"
+#include "CEventQueue.h"
+#include "CThread.h"
+#include "TMethodEventJob.h"
+#include "TMethodJob.h"
+#include "CStringUtil.h"
+#include "CArch.h"
+#include "CLog.h"
+#include "stdvector.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_PORT		24805
+
+// tells the client process how many clients to run and which pipes
+// to use
+#define CLIENTS_ENV		"SYNERGY_LOAD_CLIENTS"
+#define LOAD_TIME		2.0
+
+// pixels the mouse moves each step
+#define STEP_SIZE		8
+
+// steps between keystrokes
+#define KEY_INTERVAL	16
+
+// times a client is entered between clipboard grabs
+#define CLIPBOARD_INTERVAL	4
+#define CLIPBOARD_SIZE	1024
+
+class CServerLoadPerfTests;
+
+// what the client process tells the server process
+struct CLoadReport {
+	enum EType { kReady, kReceived, kDone };
+
+	UInt32				m_type;
+	UInt32				m_numMessages;
+	UInt32				m_numBytes;
+	double				m_time;
+	double				m_readerCPU;
+};
+
+// a protocol 1.4 client that answers the handshake and keep alives
+// and reports the motion it receives.  its screen is 1024x768.
+class CSimulatedClient {
+public:
+	CSimulatedClient(CServerLoadPerfTests* test, const CString& name);
+	~CSimulatedClient();
+
+	void				connect(const CNetworkAddress& address);
+	void				handleData(const CEvent&, void*);
+	void				handleMessage(const UInt8* data, UInt32 size);
+	void				sendClipboard(UInt32 seqNum);
+
+public:
+	CServerLoadPerfTests*	m_test;
+	CString				m_name;
+	CTCPSocket*			m_socket;
+	CPacketStreamFilter*	m_stream;
+	UInt32				m_numEnters;
+};
+
+// runs a server with a headless primary screen and simulated clients
+// on loopback.  the mouse moves right across every client's screen in
+// turn and the next motion is generated when the client gets the last
+// one, so the latency is the time from the primary screen's event to
+// the client receiving the message.
+//
+// the clients run in another process so the server's cpu time can be
+// measured on its own.  CEventQueue and CSocketMultiplexer are per
+// process so a client thread won't do, and threads don't survive a
+// fork() so the child runs this binary again, like a gtest death test.
+// the clients report back over a pipe, read by a thread in the server
+// process whose cpu time is left out.
+class CServerLoadPerfTests : public ::testing::Test
+{
+public:
+	CServerLoadPerfTests();
+
+	void				run(UInt32 numClients);
+	void				runClients();
+	void				readReports(void*);
+	void				sendReport(CLoadReport::EType type, double time);
+
+	void				handleClientConnected(const CEvent&, void*);
+	void				handleReport(const CEvent&, void*);
+	void				handleStepDone(const CEvent&, void*);
+	void				handleTimeout(const CEvent&, void*);
+
+	void				onClientReady();
+	void				onClientClosed();
+	void				onStepReceived();
+	void				startLoad();
+	void				step();
+
+	static double		getProcessCPU();
+	static double		getThreadCPU();
+
+public:
+	typedef std::vector<CSimulatedClient*> CClientList;
+
+	CEventQueue*		m_events;
+	CServer*			m_server;
+	CClientListener*	m_listener;
+	CHeadlessScreen*	m_screen;
+	CNetworkAddress		m_address;
+	CClientList			m_clients;
+	CEvent::Type		m_reportEvent;
+	CEvent::Type		m_stepDoneEvent;
+	CEventQueueTimer*	m_loadTimer;
+	int					m_goPipe[2];
+	int					m_reportPipe[2];
+	UInt32				m_numClients;
+	UInt32				m_numReady;
+	UInt32				m_numClosed;
+	bool				m_running;
+	double				m_start;
+	double				m_stepTime;
+	double				m_elapsed;
+	double				m_cpuStart;
+	double				m_cpuTime;
+	double				m_readerStart;
+	double				m_readerCPU;
+	UInt32				m_numSteps;
+	UInt32				m_numMessages;
+	UInt32				m_numBytes;
+	CLatencyHistogram	m_latency;
+};
+
+TEST_F(CServerLoadPerfTests, run_1Client)
+{
+	run(1);
+}
+
+TEST_F(CServerLoadPerfTests, run_8Clients)
+{
+	run(8);
+}
+
+TEST_F(CServerLoadPerfTests, run_32Clients)
+{
+	run(32);
+}
+
+// the client process.  only run() runs this.
+TEST_F(CServerLoadPerfTests, DISABLED_clients)
+{
+	const char* env = getenv(CLIENTS_ENV);
+	if (env == NULL || sscanf(env, "%u %d %d", &m_numClients,
+					&m_goPipe[0], &m_reportPipe[1]) != 3) {
+		return;
+	}
+	runClients();
+	EXPECT_EQ(m_numClients, m_numReady);
+}
+
+void
+CServerLoadPerfTests::run(UInt32 numClients)
+{
+	m_numClients = numClients;
+
+	// the server's screen then each client in turn, wrapping around
+	CConfig config;
+	config.addScreen("server");
+	for (UInt32 i = 0; i < numClients; ++i) {
+		config.addScreen(CStringUtil::print("client%d", i));
+	}
+	config.connect("server", kRight, 0.0f, 1.0f, "client0", 0.0f, 1.0f);
+	for (UInt32 i = 0; i < numClients; ++i) {
+		config.connect(CStringUtil::print("client%d", i), kRight, 0.0f, 1.0f,
+			(i + 1 < numClients) ? CStringUtil::print("client%d", i + 1) :
+			CString("server"), 0.0f, 1.0f);
+	}
+
+	m_address = CNetworkAddress("127.0.0.1", TEST_PORT);
+	m_address.resolve();
+
+	// start the client process.  its test output would be noise.
+	ASSERT_EQ(0, pipe(m_goPipe));
+	ASSERT_EQ(0, pipe(m_reportPipe));
+	CString self = ::testing::internal::GetArgvs()[0].c_str();
+	const char* argv[] = {
+		self.c_str(),
+		"--gtest_filter=CServerLoadPerfTests.DISABLED_clients",
+		"--gtest_also_run_disabled_tests",
+		NULL
+	};
+	setenv(CLIENTS_ENV, CStringUtil::print("%d %d %d", numClients,
+		m_goPipe[0], m_reportPipe[1]).c_str(), 1);
+	pid_t pid = fork();
+	if (pid == 0) {
+		close(m_goPipe[1]);
+		close(m_reportPipe[0]);
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, 1);
+		execv(argv[0], const_cast<char* const*>(argv));
+		_exit(127);
+	}
+	unsetenv(CLIENTS_ENV);
+	close(m_goPipe[0]);
+	close(m_reportPipe[1]);
+	ASSERT_LT(0, pid);
+
+	CSocketMultiplexer multiplexer;
+	CEventQueue events;
+	m_events = &events;
+
+	m_screen = new CHeadlessScreen(true, NULL, events);
+	CScreen* screen = new CScreen(m_screen);
+	CPrimaryClient* primaryClient = new CPrimaryClient("server", screen);
+	m_listener = new CClientListener(m_address, new CTCPSocketFactory, NULL);
+	m_server   = new CServer(config, primaryClient, screen);
+	m_listener->setServer(m_server);
+	events.adoptHandler(CClientListener::getConnectedEvent(), m_listener,
+		new TMethodEventJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::handleClientConnected));
+
+	m_reportEvent = events.registerType("CServerLoadPerfTests::report");
+	events.adoptHandler(m_reportEvent, this,
+		new TMethodEventJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::handleReport));
+	m_stepDoneEvent = events.registerType("CServerLoadPerfTests::stepDone");
+	events.adoptHandler(m_stepDoneEvent, this,
+		new TMethodEventJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::handleStepDone));
+
+	// the server is listening.  let the clients connect.
+	CThread reader(new TMethodJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::readReports));
+	char go = 'g';
+	write(m_goPipe[1], &go, 1);
+	close(m_goPipe[1]);
+
+	CEventQueueTimer* timer = events.newOneShotTimer(30, NULL);
+	events.adoptHandler(CEvent::kTimer, timer,
+		new TMethodEventJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::handleTimeout));
+
+	events.loop();
+
+	events.removeHandler(CEvent::kTimer, timer);
+	events.deleteTimer(timer);
+	if (m_loadTimer != NULL) {
+		events.removeHandler(CEvent::kTimer, m_loadTimer);
+		events.deleteTimer(m_loadTimer);
+		m_loadTimer = NULL;
+	}
+	events.removeHandler(m_stepDoneEvent, this);
+	events.removeHandlers(m_listener);
+	delete m_listener;
+	delete m_server;
+	delete primaryClient;
+	delete screen;
+
+	// the clients exit once the server has said goodbye, which ends
+	// the reports
+	int status;
+	waitpid(pid, &status, 0);
+	reader.wait();
+	events.removeHandler(m_reportEvent, this);
+	close(m_reportPipe[0]);
+	m_events = NULL;
+
+	ASSERT_EQ(numClients, m_numReady);
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	// just the server's share.  the clients ran in the other process
+	// and the report reader's time is left out.
+	double cpuTime = m_cpuTime - (m_readerCPU - m_readerStart);
+	LOG((CLOG_INFO "%d clients: %d steps, %.0f messages/sec, %.1f KB/sec, "
+		"latency p50 %d us p99 %d us max %d us, "
+		"%.2f%% server cpu, %.2f%% per client",
+		numClients, m_numSteps, m_numMessages / m_elapsed,
+		m_numBytes / m_elapsed / 1024.0,
+		m_latency.getPercentile(50.0), m_latency.getPercentile(99.0),
+		m_latency.getMax(), 100.0 * cpuTime / m_elapsed,
+		100.0 * cpuTime / m_elapsed / numClients));
+	EXPECT_LT(0, m_latency.getCount());
+}
+
+void
+CServerLoadPerfTests::runClients()
+{
+	m_address = CNetworkAddress("127.0.0.1", TEST_PORT);
+	m_address.resolve();
+
+	// wait for the server to listen
+	char go;
+	if (read(m_goPipe[0], &go, 1) != 1) {
+		return;
+	}
+	close(m_goPipe[0]);
+
+	{
+		CSocketMultiplexer multiplexer;
+		CEventQueue events;
+		m_events = &events;
+
+		// the listener's backlog is small so clients connect one at a time
+		for (UInt32 i = 0; i < m_numClients; ++i) {
+			m_clients.push_back(new CSimulatedClient(this,
+				CStringUtil::print("client%d", i)));
+		}
+		m_clients[0]->connect(m_address);
+
+		// in case the server never says goodbye
+		CEventQueueTimer* timer = events.newOneShotTimer(60, NULL);
+		events.adoptHandler(CEvent::kTimer, timer,
+			new TMethodEventJob<CServerLoadPerfTests>(
+			this, &CServerLoadPerfTests::handleTimeout));
+		events.loop();
+		events.removeHandler(CEvent::kTimer, timer);
+		events.deleteTimer(timer);
+
+		for (UInt32 i = 0; i < m_numClients; ++i) {
+			delete m_clients[i];
+		}
+		m_clients.clear();
+		m_events = NULL;
+	}
+
+	sendReport(CLoadReport::kDone, 0.0);
+	close(m_reportPipe[1]);
+}
+
+void
+CServerLoadPerfTests::readReports(void*)
+{
+	CLoadReport report;
+	for (;;) {
+		// reports are shorter than PIPE_BUF so each arrives whole
+		if (read(m_reportPipe[0], &report, sizeof(report)) !=
+								(ssize_t)sizeof(report)) {
+			return;
+		}
+		if (report.m_type == CLoadReport::kDone) {
+			m_numMessages = report.m_numMessages;
+			m_numBytes    = report.m_numBytes;
+			continue;
+		}
+
+		CLoadReport* data =
+			static_cast<CLoadReport*>(malloc(sizeof(CLoadReport)));
+		*data             = report;
+		data->m_readerCPU = getThreadCPU();
+		m_events->addEvent(CEvent(m_reportEvent, this, data));
+	}
+}
+
+void
+CServerLoadPerfTests::sendReport(CLoadReport::EType type, double time)
+{
+	CLoadReport report;
+	report.m_type        = type;
+	report.m_numMessages = m_numMessages;
+	report.m_numBytes    = m_numBytes;
+	report.m_time        = time;
+	report.m_readerCPU   = 0.0;
+	write(m_reportPipe[1], &report, sizeof(report));
+}
+
+double
+CServerLoadPerfTests::getProcessCPU()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+		1.0e-6 * (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+double
+CServerLoadPerfTests::getThreadCPU()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+CServerLoadPerfTests::CServerLoadPerfTests() :
+m_events(NULL),
+m_server(NULL),
+m_listener(NULL),
+m_screen(NULL),
+m_reportEvent(CEvent::kUnknown),
+m_stepDoneEvent(CEvent::kUnknown),
+m_loadTimer(NULL),
+m_numClients(0),
+m_numReady(0),
+m_numClosed(0),
+m_running(false),
+m_start(0.0),
+m_stepTime(0.0),
+m_elapsed(0.0),
+m_cpuStart(0.0),
+m_cpuTime(0.0),
+m_readerStart(0.0),
+m_readerCPU(0.0),
+m_numSteps(0),
+m_numMessages(0),
+m_numBytes(0)
+{
+}
+
+void
+CServerLoadPerfTests::handleClientConnected(const CEvent&, void*)
+{
+	CClientProxy* client = m_listener->getNextClient();
+	if (client != NULL) {
+		m_server->adoptClient(client);
+	}
+}
+
+void
+CServerLoadPerfTests::handleReport(const CEvent& event, void*)
+{
+	const CLoadReport* report =
+		static_cast<const CLoadReport*>(event.getData());
+	m_readerCPU = report->m_readerCPU;
+	if (report->m_type == CLoadReport::kReady) {
+		m_numReady    = m_numClients;
+		m_readerStart = report->m_readerCPU;
+		startLoad();
+	}
+	else {
+		// on Unix ARCH->time() is CLOCK_MONOTONIC, which is the same
+		// in both processes
+		m_latency.add(static_cast<UInt32>(
+							(report->m_time - m_stepTime) * 1.0e6));
+		if (m_running) {
+			step();
+		}
+	}
+}
+
+void
+CServerLoadPerfTests::handleStepDone(const CEvent&, void*)
+{
+	// the mouse only crosses the server's own screen on its way back to
+	// the first client and no client hears about that, so skip across.
+	if (m_running && m_screen->m_isOnScreen) {
+		SInt32 x, y, w, h;
+		m_screen->getShape(x, y, w, h);
+		m_screen->warpCursor(w - 1, h / 2);
+		step();
+	}
+}
+
+void
+CServerLoadPerfTests::handleTimeout(const CEvent&, void*)
+{
+	if (m_running) {
+		m_running = false;
+		m_elapsed = ARCH->time() - m_start;
+		m_cpuTime = getProcessCPU() - m_cpuStart;
+	}
+	else {
+		LOG((CLOG_ERR "timeout, %d of %d clients ready", m_numReady, m_numClients));
+	}
+	m_events->addEvent(CEvent(CEvent::kQuit));
+}
+
+void
+CServerLoadPerfTests::onClientReady()
+{
+	if (++m_numReady < m_numClients) {
+		m_clients[m_numReady]->connect(m_address);
+		return;
+	}
+
+	// everybody's connected.  count traffic from here on.
+	m_numMessages = 0;
+	m_numBytes    = 0;
+	sendReport(CLoadReport::kReady, 0.0);
+}
+
+void
+CServerLoadPerfTests::onClientClosed()
+{
+	if (++m_numClosed == m_numReady) {
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+}
+
+void
+CServerLoadPerfTests::onStepReceived()
+{
+	sendReport(CLoadReport::kReceived, ARCH->time());
+}
+
+void
+CServerLoadPerfTests::startLoad()
+{
+	m_loadTimer = m_events->newOneShotTimer(LOAD_TIME, NULL);
+	m_events->adoptHandler(CEvent::kTimer, m_loadTimer,
+		new TMethodEventJob<CServerLoadPerfTests>(
+		this, &CServerLoadPerfTests::handleTimeout));
+
+	m_running  = true;
+	m_start    = ARCH->time();
+	m_cpuStart = getProcessCPU();
+	SInt32 x, y, w, h;
+	m_screen->getShape(x, y, w, h);
+	m_screen->warpCursor(w - 1, h / 2);
+	step();
+}
+
+void
+CServerLoadPerfTests::step()
+{
+	++m_numSteps;
+	m_stepTime = ARCH->time();
+	if ((m_numSteps % KEY_INTERVAL) == 0) {
+		m_screen->onKey('a', true);
+		m_screen->onKey('a', false);
+	}
+	SInt32 x, y;
+	m_screen->getCursorPos(x, y);
+	m_screen->onMouseMove(x + STEP_SIZE, y);
+	m_events->addEvent(CEvent(m_stepDoneEvent, this));
+}
+
+//
+// CSimulatedClient
+//
+
+CSimulatedClient::CSimulatedClient(CServerLoadPerfTests* test,
+				const CString& name) :
+	m_test(test),
+	m_name(name),
+	m_numEnters(0)
+{
+	m_socket = new CTCPSocket;
+	m_stream = new CPacketStreamFilter(m_socket, true);
+	m_test->m_events->adoptHandler(m_stream->getInputReadyEvent(),
+		m_stream->getEventTarget(),
+		new TMethodEventJob<CSimulatedClient>(
+		this, &CSimulatedClient::handleData));
+}
+
+CSimulatedClient::~CSimulatedClient()
+{
+	m_test->m_events->removeHandlers(m_stream->getEventTarget());
+	delete m_stream;
+}
+void
+CSimulatedClient::connect(const CNetworkAddress& address)
+{
+	m_socket->connect(address);
+}
+
+void
+CSimulatedClient::handleData(const CEvent&, void*)
+{
+	UInt32 size;
+	const void* data;
+	while ((data = m_stream->borrowPacket(size)) != NULL) {
+		m_test->m_numMessages += 1;
+		m_test->m_numBytes    += size + 4;
+		handleMessage(static_cast<const UInt8*>(data), size);
+	}
+}
+
+void
+CSimulatedClient::handleMessage(const UInt8* data, UInt32 size)
+{
+	if (size >= 7 && memcmp(data, "Synergy", 7) == 0) {
+		CProtocolUtil::writef(m_stream, kMsgHelloBack, 1, 4, &m_name);
+	}
+	else if (size < 4) {
+		// ignore
+	}
+	else if (memcmp(data, kMsgQInfo, 4) == 0) {
+		CProtocolUtil::writef(m_stream, kMsgDInfo,
+							0, 0, 1024, 768, 0, 512, 384);
+	}
+	else if (memcmp(data, kMsgCInfoAck, 4) == 0) {
+		m_test->onClientReady();
+	}
+	else if (memcmp(data, kMsgCClose, 4) == 0) {
+		m_test->onClientClosed();
+	}
+	else if (memcmp(data, kMsgCKeepAlive, 4) == 0) {
+		CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+	}
+	else if (memcmp(data, kMsgCEnter, 4) == 0) {
+		SInt16 x, y;
+		UInt32 seqNum;
+		UInt16 mask;
+		data += 4;
+		size -= 4;
+		CProtocolUtil::readf(data, size, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+		if ((++m_numEnters % CLIPBOARD_INTERVAL) == 0) {
+			sendClipboard(seqNum);
+		}
+		m_test->onStepReceived();
+	}
+	else if (memcmp(data, kMsgDMouseMove, 4) == 0) {
+		m_test->onStepReceived();
+	}
+}
+
+void
+CSimulatedClient::sendClipboard(UInt32 seqNum)
+{
+	CClipboard clipboard;
+	clipboard.open(0);
+	clipboard.add(IClipboard::kText, CString(CLIPBOARD_SIZE, 'x'));
+	clipboard.close();
+	CString data = clipboard.marshall();
+	CProtocolUtil::writef(m_stream, kMsgCClipboard, kClipboardClipboard, seqNum);
+	CProtocolUtil::writef(m_stream, kMsgDClipboard, kClipboardClipboard, seqNum, &data);
+}
@@ -0,0 +1,219 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "CCryptoStreamFilterFactory.h"
+#include "CPacketStreamFilter.h"
+#include "CTCPSocket.h"
+#include "CTCPListenSocket.h"
+#include "CNetworkAddress.h"
+#include "CSocketMultiplexer.h"
+#include "CEventQueue.h"
+#include "TMethodEventJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+
+#define TEST_PORT		24806
+#define NUM_MESSAGES	20000
+#define MESSAGE_SIZE	8
+
+// round trips mouse motion sized packets over a loopback connection,
+// with and without encryption, to show what encryption adds to latency.
+class CCryptoStreamPerfTests : public ::testing::Test
+{
+public:
+	CCryptoStreamPerfTests();
+
+	void				run(const char* password);
+
+	void				handleAccept(const CEvent&, void*);
+	void				handleConnected(const CEvent&, void*);
+	void				handleServerData(const CEvent&, void*);
+	void				handleClientData(const CEvent&, void*);
+	void				handleTimeout(const CEvent&, void*);
+
+	synergy::IStream*	wrap(IDataSocket*, bool isServer);
+	void				sendMessage();
+
+public:
+	CSocketMultiplexer	m_multiplexer;
+	CEventQueue			m_events;
+	CTCPListenSocket*	m_listen;
+	IStreamFilterFactory*	m_serverFilters;
+	IStreamFilterFactory*	m_clientFilters;
+	synergy::IStream*	m_client;
+	synergy::IStream*	m_server;
+	CStopwatch			m_stopwatch;
+	UInt32				m_numMessages;
+};
+
+TEST_F(CCryptoStreamPerfTests, write_plain_roundTripLatency)
+{
+	run(NULL);
+}
+
+TEST_F(CCryptoStreamPerfTests, write_encrypted_roundTripLatency)
+{
+	run("password");
+}
+
+CCryptoStreamPerfTests::CCryptoStreamPerfTests() :
+m_listen(NULL),
+m_serverFilters(NULL),
+m_clientFilters(NULL),
+m_client(NULL),
+m_server(NULL),
+m_stopwatch(true),
+m_numMessages(0)
+{
+}
+
+void
+CCryptoStreamPerfTests::run(const char* password)
+{
+	if (password != NULL) {
+		m_serverFilters = new CCryptoStreamFilterFactory(password, true);
+		m_clientFilters = new CCryptoStreamFilterFactory(password, false);
+	}
+
+	CNetworkAddress address("127.0.0.1", TEST_PORT);
+	address.resolve();
+
+	CTCPListenSocket listen;
+	listen.bind(address);
+	m_listen = &listen;
+	m_events.adoptHandler(IListenSocket::getConnectingEvent(), &listen,
+		new TMethodEventJob<CCryptoStreamPerfTests>(
+		this, &CCryptoStreamPerfTests::handleAccept));
+
+	CTCPSocket* socket = new CTCPSocket;
+	m_client = wrap(socket, false);
+	m_events.adoptHandler(IDataSocket::getConnectedEvent(),
+		m_client->getEventTarget(),
+		new TMethodEventJob<CCryptoStreamPerfTests>(
+		this, &CCryptoStreamPerfTests::handleConnected));
+	m_events.adoptHandler(m_client->getInputReadyEvent(),
+		m_client->getEventTarget(),
+		new TMethodEventJob<CCryptoStreamPerfTests>(
+		this, &CCryptoStreamPerfTests::handleClientData));
+	socket->connect(address);
+
+	CEventQueueTimer* timer = m_events.newOneShotTimer(30, NULL);
+	m_events.adoptHandler(CEvent::kTimer, timer,
+		new TMethodEventJob<CCryptoStreamPerfTests>(
+		this, &CCryptoStreamPerfTests::handleTimeout));
+
+	m_events.loop();
+	double elapsed = m_stopwatch.getTime();
+
+	m_events.removeHandler(CEvent::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.removeHandlers(&listen);
+	m_events.removeHandlers(m_client->getEventTarget());
+	delete m_client;
+	if (m_server != NULL) {
+		m_events.removeHandlers(m_server->getEventTarget());
+		delete m_server;
+	}
+	delete m_serverFilters;
+	delete m_clientFilters;
+
+	LOG((CLOG_INFO "%s: %d round trips of %d bytes: %.3f ms, %.1f us per round trip",
+		(password != NULL) ? "encrypted" : "plain",
+		m_numMessages, MESSAGE_SIZE, elapsed * 1000.0,
+		elapsed * 1.0e6 / (m_numMessages != 0 ? m_numMessages : 1)));
+	EXPECT_EQ(NUM_MESSAGES, m_numMessages);
+}
+
+synergy::IStream*
+CCryptoStreamPerfTests::wrap(IDataSocket* socket, bool isServer)
+{
+	// the same layering as the client and server
+	synergy::IStream* stream = socket;
+	IStreamFilterFactory* filters = isServer ? m_serverFilters : m_clientFilters;
+	if (filters != NULL) {
+		stream = filters->create(stream, true);
+	}
+	return new CPacketStreamFilter(stream, true);
+}
+
+void
+CCryptoStreamPerfTests::handleAccept(const CEvent&, void*)
+{
+	IDataSocket* socket = m_listen->accept();
+	if (socket == NULL) {
+		return;
+	}
+	m_server = wrap(socket, true);
+	m_events.adoptHandler(m_server->getInputReadyEvent(),
+		m_server->getEventTarget(),
+		new TMethodEventJob<CCryptoStreamPerfTests>(
+		this, &CCryptoStreamPerfTests::handleServerData));
+}
+
+void
+CCryptoStreamPerfTests::handleConnected(const CEvent&, void*)
+{
+	m_stopwatch.start();
+	m_stopwatch.reset();
+	sendMessage();
+}
+
+void
+CCryptoStreamPerfTests::handleServerData(const CEvent&, void*)
+{
+	// echo
+	UInt8 buffer[MESSAGE_SIZE];
+	while (m_server->isReady()) {
+		UInt32 n = m_server->read(buffer, sizeof(buffer));
+		m_server->write(buffer, n);
+	}
+}
+
+void
+CCryptoStreamPerfTests::handleClientData(const CEvent&, void*)
+{
+	UInt8 buffer[MESSAGE_SIZE];
+	while (m_client->isReady()) {
+		m_client->read(buffer, sizeof(buffer));
+		if (++m_numMessages == NUM_MESSAGES) {
+			m_stopwatch.stop();
+			m_events.addEvent(CEvent(CEvent::kQuit));
+			return;
+		}
+		sendMessage();
+	}
+}
+
+void
+CCryptoStreamPerfTests::handleTimeout(const CEvent&, void*)
+{
+	LOG((CLOG_ERR "timeout"));
+	m_stopwatch.stop();
+	m_events.addEvent(CEvent(CEvent::kQuit));
+}
+
+void
+CCryptoStreamPerfTests::sendMessage()
+{
+	static const UInt8 s_message[MESSAGE_SIZE] = {
+		'D', 'M', 'M', 'V', 0x01, 0x00, 0x02, 0x00
+	};
+	m_client->write(s_message, sizeof(s_message));
+}
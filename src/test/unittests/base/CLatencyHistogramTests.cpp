@@ -0,0 +1,80 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include "CLatencyHistogram.h"
+
+TEST(CLatencyHistogramTests, getPercentile_noValues_returnsZero)
+{
+	CLatencyHistogram histogram;
+
+	EXPECT_EQ(0, histogram.getCount());
+	EXPECT_EQ(0, histogram.getPercentile(50.0));
+	EXPECT_EQ(0.0, histogram.getMean());
+}
+
+TEST(CLatencyHistogramTests, getPercentile_smallValues_exact)
+{
+	CLatencyHistogram histogram;
+	for (UInt32 i = 1; i <= 8; ++i) {
+		histogram.add(i);
+	}
+
+	EXPECT_EQ(8, histogram.getCount());
+	EXPECT_EQ(4, histogram.getPercentile(50.0));
+	EXPECT_EQ(8, histogram.getPercentile(100.0));
+	EXPECT_EQ(8, histogram.getMax());
+	EXPECT_DOUBLE_EQ(4.5, histogram.getMean());
+}
+
+TEST(CLatencyHistogramTests, getPercentile_largeValues_within12Percent)
+{
+	CLatencyHistogram histogram;
+	for (UInt32 i = 1; i <= 1000; ++i) {
+		histogram.add(i * 1000);
+	}
+
+	UInt32 p50 = histogram.getPercentile(50.0);
+	UInt32 p99 = histogram.getPercentile(99.0);
+	EXPECT_GE(p50, 500000u);
+	EXPECT_LE(p50, 562500u);
+	EXPECT_GE(p99, 990000u);
+	EXPECT_LE(p99, 1000000u);
+	EXPECT_EQ(1000000, histogram.getPercentile(100.0));
+}
+
+TEST(CLatencyHistogramTests, add_largestValue_counted)
+{
+	CLatencyHistogram histogram;
+	histogram.add(0xffffffffu);
+	histogram.add(0);
+
+	EXPECT_EQ(2, histogram.getCount());
+	EXPECT_EQ(0, histogram.getPercentile(50.0));
+	EXPECT_EQ(0xffffffffu, histogram.getPercentile(100.0));
+}
+
+TEST(CLatencyHistogramTests, reset_afterAdd_empty)
+{
+	CLatencyHistogram histogram;
+	histogram.add(10);
+	histogram.reset();
+
+	EXPECT_EQ(0, histogram.getCount());
+	EXPECT_EQ(0, histogram.getMax());
+}
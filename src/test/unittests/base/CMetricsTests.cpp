@@ -0,0 +1,97 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include "CMetrics.h"
+
+static UInt32
+getTestOutputSize(const void* context)
+{
+	return *static_cast<const UInt32*>(context);
+}
+
+TEST(CMetricsTests, getPercentile_powersOfTwo_endOfBucket)
+{
+	CMetrics::CHistogram histogram;
+	histogram.add(0);
+	histogram.add(3);
+	histogram.add(100);
+	histogram.add(1000);
+
+	EXPECT_EQ(4, histogram.getCount());
+	EXPECT_EQ(3, histogram.getPercentile(50.0));
+	EXPECT_EQ(127, histogram.getPercentile(75.0));
+	EXPECT_EQ(1000, histogram.getPercentile(100.0));
+	EXPECT_DOUBLE_EQ(275.75, histogram.getMean());
+}
+
+TEST(CMetricsTests, add_disabled_ignored)
+{
+	CMetrics::setEnabled(false);
+	CMetrics::CConnection connection;
+	double before = CMetrics::get(CMetrics::kSocketBytesSent);
+
+	CMetrics::add(CMetrics::kSocketBytesSent, 10.0);
+	connection.addSent(10);
+
+	EXPECT_EQ(before, CMetrics::get(CMetrics::kSocketBytesSent));
+	EXPECT_EQ(0.0, connection.m_messagesSent);
+}
+
+TEST(CMetricsTests, format_namedConnection_included)
+{
+	CMetrics::setEnabled(true);
+	{
+		CMetrics::CConnection connection;
+		connection.setName("client.test");
+		connection.addSent(8);
+		connection.addSent(8);
+		connection.addReceived(4);
+
+		CString metrics = CMetrics::format();
+		EXPECT_NE(CString::npos, metrics.find("socket.bytes-sent="));
+		EXPECT_NE(CString::npos, metrics.find("client.test.messages-sent=2\n"));
+		EXPECT_NE(CString::npos, metrics.find("client.test.bytes-sent=16\n"));
+		EXPECT_NE(CString::npos,
+			metrics.find("client.test.messages-received=1\n"));
+	}
+	EXPECT_EQ(CString::npos, CMetrics::format().find("client.test."));
+	CMetrics::setEnabled(false);
+}
+
+TEST(CMetricsTests, format_outputSize_sampled)
+{
+	CMetrics::setEnabled(true);
+	{
+		UInt32 size = 42;
+		CMetrics::CConnection connection;
+		connection.setName("client.queue");
+		connection.setOutputSize(&getTestOutputSize, &size);
+		EXPECT_NE(CString::npos,
+			CMetrics::format().find("client.queue.output-queue=42\n"));
+
+		size = 7;
+		EXPECT_NE(CString::npos,
+			CMetrics::format().find("client.queue.output-queue=7\n"));
+
+		connection.setOutputSize(NULL, NULL);
+		EXPECT_EQ(CString::npos,
+			CMetrics::format().find("client.queue.output-queue="));
+	}
+	CMetrics::setEnabled(false);
+}
@@ -0,0 +1,166 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CUnicode.h"
+#include "stdvector.h"
+#include <cstring>
+
+// native endian UTF-16 of the given words
+static CString
+makeUTF16(const std::vector<UInt16>& words)
+{
+	CString s;
+	for (size_t i = 0; i < words.size(); ++i) {
+		s.append(reinterpret_cast<const char*>(&words[i]), 2);
+	}
+	return s;
+}
+
+// ASCII long enough to cross several vector widths, with a character
+// that isn't ASCII at \p where (if it's in range)
+static CString
+makeText(UInt32 length, UInt32 where, const char* utf8)
+{
+	CString s;
+	for (UInt32 i = 0; i < length; ++i) {
+		if (i == where) {
+			s += utf8;
+		}
+		s += static_cast<char>('a' + (i % 26));
+	}
+	return s;
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_longASCII_wordsValid)
+{
+	CString text = makeText(100, 100, "");
+	std::vector<UInt16> expected;
+	for (UInt32 i = 0; i < text.size(); ++i) {
+		expected.push_back(static_cast<UInt16>(text[i]));
+	}
+
+	CString actual = CUnicode::UTF8ToUTF16(text);
+
+	EXPECT_EQ(makeUTF16(expected), actual);
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_mixedScripts_wordsValid)
+{
+	// e acute, cyrillic be, CJK "middle", an emoji
+	CString text = makeText(70, 37, "\xc3\xa9\xd0\xb1\xe4\xb8\xad\xf0\x9f\x98\x80");
+
+	CString actual = CUnicode::UTF8ToUTF16(text);
+
+	std::vector<UInt16> expected;
+	for (UInt32 i = 0; i < 70; ++i) {
+		if (i == 37) {
+			expected.push_back(0x00e9);
+			expected.push_back(0x0431);
+			expected.push_back(0x4e2d);
+			expected.push_back(0xd83d);
+			expected.push_back(0xde00);
+		}
+		expected.push_back(static_cast<UInt16>('a' + (i % 26)));
+	}
+	EXPECT_EQ(makeUTF16(expected), actual);
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_invalidByte_replaced)
+{
+	CString text = makeText(50, 33, "\xff");
+
+	CString actual = CUnicode::UTF8ToUTF16(text);
+
+	ASSERT_EQ(2U * 51, actual.size());
+	UInt16 c;
+	memcpy(&c, actual.data() + 2 * 33, 2);
+	EXPECT_EQ(0xfffd, c);
+}
+
+TEST(CUnicodeTests, UTF16ToUTF8_mixedScripts_roundTrips)
+{
+	CString text = makeText(200, 129, "\xc3\xa9\xd0\xb1\xe4\xb8\xad\xf0\x9f\x98\x80");
+	bool errors = true;
+
+	CString actual = CUnicode::UTF16ToUTF8(CUnicode::UTF8ToUTF16(text), &errors);
+
+	EXPECT_EQ(text, actual);
+	EXPECT_FALSE(errors);
+}
+
+TEST(CUnicodeTests, UTF16ToUTF8_byteSwapped_converted)
+{
+	// BOM then "ab" then e acute, all big endian
+	CString text("\xfe\xff\x00\x61\x00\x62\x00\xe9", 8);
+	UInt16 bom = 0xfeff;
+	if (memcmp(&bom, "\xfe\xff", 2) == 0) {
+		// big endian host so make it little endian
+		text = CString("\xff\xfe\x61\x00\x62\x00\xe9\x00", 8);
+	}
+
+	CString actual = CUnicode::UTF16ToUTF8(text);
+
+	EXPECT_EQ("ab\xc3\xa9", actual);
+}
+
+TEST(CUnicodeTests, UTF16ToUTF8_unpairedSurrogate_replacedAndError)
+{
+	std::vector<UInt16> words;
+	words.push_back('a');
+	words.push_back(0xd800);
+	words.push_back('b');
+	bool errors = false;
+
+	CString actual = CUnicode::UTF16ToUTF8(makeUTF16(words), &errors);
+
+	EXPECT_EQ("a\xef\xbf\xbd" "b", actual);
+	EXPECT_TRUE(errors);
+}
+
+TEST(CUnicodeTests, UCS2ToUTF8_longASCII_copied)
+{
+	CString text = makeText(100, 100, "");
+
+	CString actual = CUnicode::UCS2ToUTF8(CUnicode::UTF8ToUCS2(text));
+
+	EXPECT_EQ(text, actual);
+}
+
+TEST(CUnicodeTests, UCS4ToUTF8_mixedScripts_roundTrips)
+{
+	CString text = makeText(90, 40, "\xd0\xb1\xe4\xb8\xad\xf0\x9f\x98\x80");
+
+	CString actual = CUnicode::UCS4ToUTF8(CUnicode::UTF8ToUCS4(text));
+
+	EXPECT_EQ(text, actual);
+}
+
+TEST(CUnicodeTests, isUTF8_valid_returnsTrue)
+{
+	CString text = makeText(100, 64, "\xe4\xb8\xad");
+
+	EXPECT_TRUE(CUnicode::isUTF8(text));
+}
+
+TEST(CUnicodeTests, isUTF8_overlong_returnsFalse)
+{
+	// overlong encoding of '/'
+	CString text = makeText(100, 64, "\xc0\xaf");
+
+	EXPECT_FALSE(CUnicode::isUTF8(text));
+}
@@ -0,0 +1,256 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CHeadlessScreen.h"
+#include "CHeadlessKeyState.h"
+#include "CEventQueue.h"
+#include "CClipboard.h"
+#include "XScreen.h"
+#include "stdsstream.h"
+
+static void
+loadScript(CHeadlessScreen& screen, const char* script)
+{
+	std::istringstream stream(script);
+	screen.loadScript(stream);
+}
+
+TEST(CHeadlessScreenTests, loadScript_validScript_parsesAllCommands)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+
+	loadScript(screen,
+		"# comment\n"
+		"\n"
+		"wait 0.5\n"
+		"move 10 20\n"
+		"  rmove -5 5\n"
+		"down 1\n"
+		"up 1\n"
+		"wheel 0 120\n"
+		"keydown Shift_L\n"
+		"keyup a\n"
+		"clipboard hello world\n"
+		"loop\n");
+
+	ASSERT_EQ(10, screen.m_script.size());
+	EXPECT_EQ(CHeadlessScreen::CCommand::kWait, screen.m_script[0].m_type);
+	EXPECT_DOUBLE_EQ(0.5, screen.m_script[0].m_time);
+	EXPECT_EQ(CHeadlessScreen::CCommand::kRelativeMove, screen.m_script[2].m_type);
+	EXPECT_EQ(-5, screen.m_script[2].m_x);
+	EXPECT_EQ(kKeyShift_L, screen.m_script[6].m_key);
+	EXPECT_EQ('a', screen.m_script[7].m_key);
+	EXPECT_EQ("hello world", screen.m_script[8].m_text);
+	EXPECT_EQ(CHeadlessScreen::CCommand::kLoop, screen.m_script[9].m_type);
+}
+
+TEST(CHeadlessScreenTests, loadScript_invalidCommand_throws)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+
+	EXPECT_THROW(loadScript(screen, "move 10\n"), XScreenOpenFailure);
+	EXPECT_THROW(loadScript(screen, "down 9\n"), XScreenOpenFailure);
+	EXPECT_THROW(loadScript(screen, "keydown NoSuchKey\n"), XScreenOpenFailure);
+	EXPECT_THROW(loadScript(screen, "wait 0\n"), XScreenOpenFailure);
+	EXPECT_THROW(loadScript(screen, "jump\n"), XScreenOpenFailure);
+}
+
+TEST(CHeadlessScreenTests, loadScript_loopWithoutWait_throws)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+
+	EXPECT_THROW(loadScript(screen, "rmove 1 0\nloop\n"), XScreenOpenFailure);
+}
+
+TEST(CHeadlessScreenTests, runScript_moveOnScreen_sendsMotionOnPrimary)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	loadScript(screen, "move 100 200\n");
+
+	screen.runScript();
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IPrimaryScreen::getMotionOnPrimaryEvent(), event.getType());
+	IPrimaryScreen::CMotionInfo* info =
+		static_cast<IPrimaryScreen::CMotionInfo*>(event.getData());
+	EXPECT_EQ(100, info->m_x);
+	EXPECT_EQ(200, info->m_y);
+	CEvent::deleteData(event);
+}
+
+TEST(CHeadlessScreenTests, runScript_moveOffScreen_sendsMotionOnSecondary)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	screen.leave();
+	SInt32 x, y;
+	screen.getCursorPos(x, y);
+	loadScript(screen, "rmove 3 -4\n");
+
+	screen.runScript();
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IPrimaryScreen::getMotionOnSecondaryEvent(), event.getType());
+	IPrimaryScreen::CMotionInfo* info =
+		static_cast<IPrimaryScreen::CMotionInfo*>(event.getData());
+	EXPECT_EQ(3, info->m_x);
+	EXPECT_EQ(-4, info->m_y);
+	CEvent::deleteData(event);
+}
+
+TEST(CHeadlessScreenTests, runScript_wait_stopsUntilTimer)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	loadScript(screen, "wait 10\nmove 1 1\n");
+
+	screen.runScript();
+
+	EXPECT_EQ(1, screen.m_nextCommand);
+	EXPECT_TRUE(screen.m_scriptTimer != NULL);
+	EXPECT_TRUE(eventQueue.isEmpty());
+}
+
+TEST(CHeadlessScreenTests, runScript_clipboard_grabsClipboardWithText)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	loadScript(screen, "clipboard some text\n");
+
+	screen.runScript();
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IScreen::getClipboardGrabbedEvent(), event.getType());
+	CEvent::deleteData(event);
+
+	CClipboard clipboard;
+	ASSERT_TRUE(screen.getClipboard(kClipboardClipboard, &clipboard));
+	clipboard.open(0);
+	EXPECT_EQ("some text", clipboard.get(IClipboard::kText));
+	clipboard.close();
+}
+
+TEST(CHeadlessScreenTests, fakeInput_secondary_recordsInjectedInput)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(false, NULL, eventQueue);
+
+	screen.fakeMouseMove(10, 20);
+	screen.fakeMouseRelativeMove(5, -5);
+	screen.fakeMouseButton(kButtonLeft, true);
+	screen.fakeKeyDown('a', 0, 1);
+	screen.fakeKeyUp(1);
+
+	screen.fakeMouseWheel(0, -120);
+
+	SInt32 x, y;
+	screen.getCursorPos(x, y);
+	EXPECT_EQ(15, x);
+	EXPECT_EQ(15, y);
+	EXPECT_EQ(2, screen.m_numMotions);
+	EXPECT_TRUE(screen.isAnyMouseButtonDown());
+	EXPECT_EQ(2, screen.m_keyState->getNumFakedKeys());
+
+	typedef CHeadlessScreen::CInjectedEvent CInjectedEvent;
+	const CHeadlessScreen::CInjectedEventList& events =
+		screen.getInjectedEvents();
+	ASSERT_EQ(6, events.size());
+	EXPECT_EQ(CInjectedEvent::kMotion, events[0].m_type);
+	EXPECT_EQ(10, events[0].m_x);
+	EXPECT_EQ(20, events[0].m_y);
+	EXPECT_EQ(CInjectedEvent::kMotion, events[1].m_type);
+	EXPECT_EQ(15, events[1].m_x);
+	EXPECT_EQ(15, events[1].m_y);
+	EXPECT_EQ(CInjectedEvent::kButtonDown, events[2].m_type);
+	EXPECT_EQ(kButtonLeft, events[2].m_button);
+	EXPECT_EQ(CInjectedEvent::kKeyDown, events[3].m_type);
+	EXPECT_EQ('a', events[3].m_key);
+	EXPECT_EQ(1, events[3].m_keyButton);
+	EXPECT_EQ(CInjectedEvent::kKeyUp, events[4].m_type);
+	EXPECT_EQ(1, events[4].m_keyButton);
+	EXPECT_EQ(CInjectedEvent::kWheel, events[5].m_type);
+	EXPECT_EQ(-120, events[5].m_y);
+
+	screen.clearInjectedEvents();
+	EXPECT_TRUE(screen.getInjectedEvents().empty());
+}
+
+TEST(CHeadlessScreenTests, runScript_hotKey_sendsHotKeyEvents)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	UInt32 id = screen.registerHotKey('a', KeyModifierShift);
+	ASSERT_NE(0, id);
+	loadScript(screen, "keydown Shift_L\nkeydown a\nkeyup Shift_L\nkeyup a\n");
+
+	screen.runScript();
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IKeyState::getKeyDownEvent(eventQueue), event.getType());
+	CEvent::deleteData(event);
+
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IPrimaryScreen::getHotKeyDownEvent(), event.getType());
+	EXPECT_EQ(id, static_cast<IPrimaryScreen::CHotKeyInfo*>(
+							event.getData())->m_id);
+	CEvent::deleteData(event);
+
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IKeyState::getKeyUpEvent(eventQueue), event.getType());
+	CEvent::deleteData(event);
+
+	// released even though shift is already up
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IPrimaryScreen::getHotKeyUpEvent(), event.getType());
+	EXPECT_EQ(id, static_cast<IPrimaryScreen::CHotKeyInfo*>(
+							event.getData())->m_id);
+	CEvent::deleteData(event);
+
+	EXPECT_TRUE(eventQueue.isEmpty());
+}
+
+TEST(CHeadlessScreenTests, registerHotKey_duplicateOrUnregistered_noHotKey)
+{
+	CEventQueue eventQueue;
+	CHeadlessScreen screen(true, NULL, eventQueue);
+	UInt32 id = screen.registerHotKey('b', 0);
+	ASSERT_NE(0, id);
+	EXPECT_EQ(0, screen.registerHotKey('b', 0));
+
+	screen.unregisterHotKey(id);
+	loadScript(screen, "keydown b\n");
+	screen.runScript();
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	EXPECT_EQ(IKeyState::getKeyDownEvent(eventQueue), event.getType());
+	CEvent::deleteData(event);
+}
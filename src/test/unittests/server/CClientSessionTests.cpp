@@ -0,0 +1,111 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CClientSession.h"
+
+static CClientSession
+makeSession(CClientSessions& sessions)
+{
+	CClientSession session;
+	session.m_token            = sessions.newToken();
+	session.m_info.m_w         = 1024;
+	session.m_info.m_h         = 768;
+	session.m_clipboardHash[0] = CClientSession::hashClipboard("data");
+	session.m_options.push_back(1);
+	session.m_options.push_back(2);
+	return session;
+}
+
+TEST(CClientSessionTests, newToken_calledTwice_tokensDiffer)
+{
+	CClientSessions sessions;
+
+	CString token1 = sessions.newToken();
+	CString token2 = sessions.newToken();
+
+	EXPECT_EQ(32, token1.size());
+	EXPECT_NE(token1, token2);
+}
+
+TEST(CClientSessionTests, hashClipboard_anyData_neverEmpty)
+{
+	EXPECT_FALSE(CClientSession::hashClipboard("").empty());
+	EXPECT_EQ(CClientSession::hashClipboard("data"),
+				CClientSession::hashClipboard("data"));
+	EXPECT_NE(CClientSession::hashClipboard("data"),
+				CClientSession::hashClipboard("date"));
+}
+
+TEST(CClientSessionTests, resume_withinTimeout_restoresSession)
+{
+	CClientSessions sessions(30.0);
+	CClientSession saved = makeSession(sessions);
+	sessions.save("client", saved, 100.0);
+
+	CClientSession session;
+	EXPECT_TRUE(sessions.resume("client", saved.m_token, session, 110.0));
+
+	EXPECT_EQ(saved.m_token, session.m_token);
+	EXPECT_EQ(1024, session.m_info.m_w);
+	EXPECT_EQ(768, session.m_info.m_h);
+	EXPECT_EQ(saved.m_clipboardHash[0], session.m_clipboardHash[0]);
+	EXPECT_TRUE(saved.m_options == session.m_options);
+	EXPECT_EQ(0, sessions.size());
+}
+
+TEST(CClientSessionTests, resume_afterTimeout_fails)
+{
+	CClientSessions sessions(30.0);
+	CClientSession saved = makeSession(sessions);
+	sessions.save("client", saved, 100.0);
+
+	CClientSession session;
+	EXPECT_FALSE(sessions.resume("client", saved.m_token, session, 130.0));
+}
+
+TEST(CClientSessionTests, resume_wrongToken_failsAndForgetsSession)
+{
+	CClientSessions sessions;
+	CClientSession saved = makeSession(sessions);
+	sessions.save("client", saved, 100.0);
+
+	CClientSession session;
+	EXPECT_FALSE(sessions.resume("client", "guess", session, 101.0));
+	EXPECT_FALSE(sessions.resume("client", saved.m_token, session, 101.0));
+}
+
+TEST(CClientSessionTests, resume_otherClient_fails)
+{
+	CClientSessions sessions;
+	CClientSession saved = makeSession(sessions);
+	sessions.save("client", saved, 100.0);
+
+	CClientSession session;
+	EXPECT_FALSE(sessions.resume("other", saved.m_token, session, 101.0));
+	EXPECT_EQ(1, sessions.size());
+}
+
+TEST(CClientSessionTests, save_expiredSessions_discarded)
+{
+	CClientSessions sessions(30.0);
+	sessions.save("client1", makeSession(sessions), 100.0);
+	sessions.save("client2", makeSession(sessions), 120.0);
+	sessions.save("client3", makeSession(sessions), 140.0);
+
+	EXPECT_EQ(2, sessions.size());
+}
@@ -0,0 +1,123 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CConfig.h"
+#include "CConfigCache.h"
+#include "stdsstream.h"
+#include "stdfstream.h"
+#include <cstdio>
+
+static const char* s_config =
+	"section: screens\n"
+	"	server:\n"
+	"		halfDuplexCapsLock = true\n"
+	"	client:\n"
+	"		switchCorners = top-left\n"
+	"end\n"
+	"section: aliases\n"
+	"	client:\n"
+	"		client.local\n"
+	"end\n"
+	"section: links\n"
+	"	server:\n"
+	"		right(0,50) = client(50,100)\n"
+	"	client:\n"
+	"		left = server\n"
+	"end\n"
+	"section: options\n"
+	"	heartbeat = 5000\n"
+	"	keystroke(control+alt+left) = switchInDirection(left)\n"
+	"	keystroke(control+alt+k) = keystroke(alt+F4,client), "
+									"keyboardBroadcast(toggle,server:client)\n"
+	"	keystroke(f12) = lockCursorToScreen(toggle)\n"
+	"	mousebutton(shift+2) = mouseDown(3); mouseUp(3)\n"
+	"	connect(client) = switchToScreen(client)\n"
+	"end\n";
+
+static void
+readConfig(CConfig& config, const char* text)
+{
+	std::istringstream stream(text);
+	stream >> config;
+}
+
+static void
+writeFile(const char* pathname, const CString& text)
+{
+	std::ofstream stream(pathname, std::ios::out | std::ios::binary);
+	stream << text;
+}
+
+TEST(CConfigCacheTests, unmarshall_marshalledConfig_equalsOriginal)
+{
+	CConfig original;
+	readConfig(original, s_config);
+
+	CConfig loaded;
+	CConfigCache::unmarshall(loaded, CConfigCache::marshall(original));
+
+	EXPECT_TRUE(loaded == original);
+	EXPECT_EQ(original.getInputFilter()->format(""),
+				loaded.getInputFilter()->format(""));
+	EXPECT_TRUE(loaded.hasLockToScreenAction());
+}
+
+TEST(CConfigCacheTests, unmarshall_truncatedData_throwsAndLeavesConfig)
+{
+	CConfig original;
+	readConfig(original, s_config);
+	CString data = CConfigCache::marshall(original);
+
+	CConfig loaded;
+	EXPECT_THROW(CConfigCache::unmarshall(loaded,
+					data.substr(0, data.size() - 1)), XConfigCache);
+	EXPECT_TRUE(loaded == CConfig());
+}
+
+TEST(CConfigCacheTests, unmarshall_hugeCount_throwsWithoutAllocating)
+{
+	// a screen count far larger than the data could hold
+	CString data("\xff\xff\xff\xff", 4);
+
+	CConfig loaded;
+	EXPECT_THROW(CConfigCache::unmarshall(loaded, data), XConfigCache);
+	EXPECT_TRUE(loaded == CConfig());
+}
+
+TEST(CConfigCacheTests, load_sameSizeEdit_stale)
+{
+	const char* pathname = "CConfigCacheTests.conf";
+	CString cachePathname = CConfigCache::getPathname(pathname);
+	CConfig original;
+	readConfig(original, s_config);
+
+	// an edit that keeps the size, most likely within the same second
+	CString text(s_config);
+	writeFile(pathname, text);
+	ASSERT_TRUE(CConfigCache::save(pathname, original));
+	text[text.find("5000")] = '6';
+	writeFile(pathname, text);
+
+	CConfig loaded;
+	bool actual = CConfigCache::load(pathname, loaded);
+	std::remove(pathname);
+	std::remove(cachePathname.c_str());
+
+	EXPECT_FALSE(actual);
+	EXPECT_TRUE(loaded == CConfig());
+}
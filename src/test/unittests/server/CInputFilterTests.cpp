@@ -0,0 +1,154 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CInputFilter.h"
+#include "CServer.h"
+#include "CEventQueue.h"
+#include "IPrimaryScreen.h"
+
+// counts how often a rule's actions were performed
+class CCountingAction : public CInputFilter::CAction {
+public:
+	CCountingAction(int* count) : m_count(count) { }
+
+	virtual CInputFilter::CAction*	clone() const { return new CCountingAction(m_count); }
+	virtual CString			format() const { return "count"; }
+	virtual void			perform(const CEvent&) { ++*m_count; }
+
+private:
+	int*					m_count;
+};
+
+// event types are registered once per process so all tests must share
+// one event queue.
+class CInputFilterTests : public ::testing::Test {
+public:
+	static void			SetUpTestCase() { s_eventQueue = new CEventQueue; }
+	static void			TearDownTestCase() { delete s_eventQueue; }
+
+	static void			addHotKeyRule(CInputFilter& filter, int* count);
+
+	// hot key ids are normally assigned by the primary screen when the
+	// filter is enabled, and are lost when a rule is copied, so they're
+	// set after all rules have been added.
+	static void			setHotKeyId(CInputFilter& filter, UInt32 index, UInt32 id);
+
+	static CEventQueue*	s_eventQueue;
+};
+
+CEventQueue*			CInputFilterTests::s_eventQueue = NULL;
+
+void
+CInputFilterTests::addHotKeyRule(CInputFilter& filter, int* count)
+{
+	CInputFilter::CRule rule(new CInputFilter::CKeystrokeCondition(kKeyNone, 0));
+	rule.adoptAction(new CCountingAction(count), true);
+	filter.addFilterRule(rule);
+}
+
+void
+CInputFilterTests::setHotKeyId(CInputFilter& filter, UInt32 index, UInt32 id)
+{
+	CInputFilter::CRule& rule = filter.getRule(index);
+	static_cast<CInputFilter::CKeystrokeCondition*>(rule.m_condition)->m_id = id;
+}
+
+TEST_F(CInputFilterTests, handleEvent_hotKey_onlyMatchingRulePerformed)
+{
+	CInputFilter filter;
+	int counts[3] = { 0, 0, 0 };
+	addHotKeyRule(filter, &counts[0]);
+	addHotKeyRule(filter, &counts[1]);
+	addHotKeyRule(filter, &counts[2]);
+	setHotKeyId(filter, 0, 1);
+	setHotKeyId(filter, 1, 2);
+	setHotKeyId(filter, 2, 3);
+
+	IPlatformScreen::CHotKeyInfo info = { 2 };
+	filter.handleEvent(CEvent(IPrimaryScreen::getHotKeyDownEvent(),
+								NULL, &info, CEvent::kDontFreeData), NULL);
+
+	EXPECT_EQ(0, counts[0]);
+	EXPECT_EQ(1, counts[1]);
+	EXPECT_EQ(0, counts[2]);
+}
+
+TEST_F(CInputFilterTests, handleEvent_mouseButton_ignoresLockModifiers)
+{
+	CInputFilter filter;
+	int count = 0;
+	CInputFilter::CRule rule(
+		new CInputFilter::CMouseButtonCondition(kButtonLeft, KeyModifierControl));
+	rule.adoptAction(new CCountingAction(&count), true);
+	filter.addFilterRule(rule);
+
+	IPlatformScreen::CButtonInfo info = { kButtonLeft,
+							KeyModifierControl | KeyModifierNumLock };
+	filter.handleEvent(CEvent(IPrimaryScreen::getButtonDownEvent(),
+								NULL, &info, CEvent::kDontFreeData), NULL);
+
+	EXPECT_EQ(1, count);
+}
+
+TEST_F(CInputFilterTests, handleEvent_connect_firstRuleInListWins)
+{
+	CInputFilter filter;
+	int counts[2] = { 0, 0 };
+	CInputFilter::CRule anyScreen(
+		new CInputFilter::CScreenConnectedCondition(""));
+	anyScreen.adoptAction(new CCountingAction(&counts[0]), true);
+	CInputFilter::CRule oneScreen(
+		new CInputFilter::CScreenConnectedCondition("client"));
+	oneScreen.adoptAction(new CCountingAction(&counts[1]), true);
+	addHotKeyRule(filter, &counts[1]);
+	filter.addFilterRule(anyScreen);
+	filter.addFilterRule(oneScreen);
+	setHotKeyId(filter, 0, 1);
+
+	CServer::CScreenConnectedInfo info("client");
+	filter.handleEvent(CEvent(CServer::getConnectedEvent(),
+								NULL, &info, CEvent::kDontFreeData), NULL);
+
+	EXPECT_EQ(1, counts[0]);
+	EXPECT_EQ(0, counts[1]);
+}
+
+TEST_F(CInputFilterTests, handleEvent_ruleRemoved_indexUpdated)
+{
+	CInputFilter filter;
+	int counts[2] = { 0, 0 };
+	addHotKeyRule(filter, &counts[0]);
+	addHotKeyRule(filter, &counts[1]);
+	setHotKeyId(filter, 0, 1);
+	setHotKeyId(filter, 1, 2);
+
+	IPlatformScreen::CHotKeyInfo info = { 2 };
+	CEvent event(IPrimaryScreen::getHotKeyDownEvent(),
+								NULL, &info, CEvent::kDontFreeData);
+	filter.handleEvent(event, NULL);
+	filter.removeFilterRule(0);
+	setHotKeyId(filter, 0, 2);
+	filter.handleEvent(event, NULL);
+
+	EXPECT_EQ(0, counts[0]);
+	EXPECT_EQ(2, counts[1]);
+}
@@ -0,0 +1,93 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CClipboardBlob.h"
+
+TEST(CClipboardBlobTests, ctor_default_isEmpty)
+{
+	CClipboardBlob blob;
+
+	EXPECT_TRUE(blob.empty());
+	EXPECT_EQ(0U, blob.size());
+	EXPECT_EQ("", blob.toString());
+}
+
+TEST(CClipboardBlobTests, adopt_string_takesData)
+{
+	CString data("synergy rocks!");
+
+	CClipboardBlob blob = CClipboardBlob::adopt(data);
+
+	EXPECT_EQ("synergy rocks!", blob.toString());
+	EXPECT_TRUE(data.empty());
+}
+
+TEST(CClipboardBlobTests, copy_blob_sharesBuffer)
+{
+	CClipboardBlob blob(CString("synergy rocks!"));
+
+	CClipboardBlob copy(blob);
+
+	EXPECT_TRUE(copy.shares(blob));
+	EXPECT_EQ(blob.data(), copy.data());
+}
+
+TEST(CClipboardBlobTests, slice_inRange_sharesBuffer)
+{
+	CClipboardBlob blob(CString("synergy rocks!"));
+
+	CClipboardBlob slice(blob, 8, 5);
+
+	EXPECT_TRUE(slice.shares(blob));
+	EXPECT_EQ("rocks", slice.toString());
+	EXPECT_EQ(8U, slice.getOffset());
+	EXPECT_EQ(blob.toString(), slice.getWhole().toString());
+}
+
+TEST(CClipboardBlobTests, slice_pastEnd_isClamped)
+{
+	CClipboardBlob blob(CString("synergy rocks!"));
+
+	CClipboardBlob slice(blob, 8, 100);
+	CClipboardBlob past(blob, 100, 1);
+
+	EXPECT_EQ("rocks!", slice.toString());
+	EXPECT_TRUE(past.empty());
+}
+
+TEST(CClipboardBlobTests, assign_outlivesSource_keepsData)
+{
+	CClipboardBlob copy;
+	{
+		CClipboardBlob blob(CString("synergy rocks!"));
+		copy = CClipboardBlob(blob, 0, 7);
+	}
+
+	EXPECT_EQ("synergy", copy.toString());
+}
+
+TEST(CClipboardBlobTests, equals_differentBuffers_comparesData)
+{
+	CClipboardBlob blob1(CString("synergy rocks!"));
+	CClipboardBlob blob2(CString("synergy rocks!"));
+	CClipboardBlob blob3(CString("synergy rolls!"));
+
+	EXPECT_TRUE(blob1 == blob2);
+	EXPECT_FALSE(blob1.shares(blob2));
+	EXPECT_TRUE(blob1 != blob3);
+}
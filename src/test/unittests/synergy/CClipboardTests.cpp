@@ -401,3 +401,87 @@ TEST(CClipboardTests, copy_withSingleText_clipboardsAreEqual)
 	CString actual = clipboard2.get(CClipboard::kText);
 	EXPECT_EQ("synergy rocks!", actual);
 }
+
+TEST(CClipboardTests, copy_withSingleText_sharesData)
+{
+	CClipboard clipboard1;
+	clipboard1.open(0);
+	clipboard1.add(CClipboard::kText, "synergy rocks!");
+	clipboard1.close();
+
+	CClipboard clipboard2;
+	CClipboard::copy(&clipboard2, &clipboard1);
+
+	clipboard1.open(0);
+	clipboard2.open(0);
+	EXPECT_TRUE(clipboard2.getBlob(CClipboard::kText).shares(
+							clipboard1.getBlob(CClipboard::kText)));
+}
+
+TEST(CClipboardTests, marshallBlob_afterUnmarshall_returnsSameBuffer)
+{
+	CClipboard source;
+	source.open(0);
+	source.add(CClipboard::kText, "synergy rocks!");
+	source.add(CClipboard::kHTML, "html sucks");
+	source.close();
+	CClipboardBlob data(source.marshall());
+
+	CClipboard clipboard;
+	clipboard.unmarshall(data, 0);
+
+	CClipboardBlob actual = clipboard.marshallBlob();
+	EXPECT_TRUE(actual.shares(data));
+	EXPECT_EQ(data.toString(), actual.toString());
+}
+
+TEST(CClipboardTests, marshallBlob_afterCopy_returnsSourceBuffer)
+{
+	CClipboard clipboard1;
+	clipboard1.open(0);
+	clipboard1.add(CClipboard::kText, "synergy rocks!");
+	clipboard1.close();
+	CClipboardBlob data = clipboard1.marshallBlob();
+
+	CClipboard clipboard2;
+	CClipboard::copy(&clipboard2, &clipboard1);
+
+	EXPECT_TRUE(clipboard2.marshallBlob().shares(data));
+}
+
+TEST(CClipboardTests, marshallBlob_afterAdd_returnsNewBuffer)
+{
+	CClipboard clipboard;
+	clipboard.open(0);
+	clipboard.add(CClipboard::kText, "synergy rocks!");
+	clipboard.close();
+	CClipboardBlob data = clipboard.marshallBlob();
+
+	clipboard.open(0);
+	clipboard.empty();
+	clipboard.add(CClipboard::kText, "synergy rocks!");
+	clipboard.add(CClipboard::kHTML, "html sucks");
+	clipboard.close();
+
+	CClipboardBlob actual = clipboard.marshallBlob();
+	EXPECT_FALSE(actual.shares(data));
+	EXPECT_EQ(clipboard.marshall(), actual.toString());
+}
+
+TEST(CClipboardTests, unmarshall_truncatedBlob_keepsCompleteFormats)
+{
+	CClipboard source;
+	source.open(0);
+	source.add(CClipboard::kText, "synergy rocks!");
+	source.add(CClipboard::kHTML, "html sucks");
+	source.close();
+	CString data = source.marshall();
+	data.resize(data.size() - 1);
+
+	CClipboard clipboard;
+	clipboard.unmarshall(CClipboardBlob::adopt(data), 0);
+
+	clipboard.open(0);
+	EXPECT_EQ("synergy rocks!", clipboard.get(CClipboard::kText));
+	EXPECT_FALSE(clipboard.has(CClipboard::kHTML));
+}
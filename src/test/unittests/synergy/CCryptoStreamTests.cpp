@@ -0,0 +1,230 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CCryptoStream.h"
+#include "CMockStream.h"
+#include "CEventQueue.h"
+#include "CString.h"
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::AnyNumber;
+
+// what each side has written and the other has yet to read
+static CString			s_toClient;
+static CString			s_toServer;
+
+static UInt32
+take(CString& data, void* buffer, UInt32 n)
+{
+	if (n > data.size()) {
+		n = static_cast<UInt32>(data.size());
+	}
+	memcpy(buffer, data.data(), n);
+	data.erase(0, n);
+	return n;
+}
+
+static UInt32
+serverRead(void* buffer, UInt32 n)
+{
+	return take(s_toServer, buffer, n);
+}
+
+static void
+serverWrite(const void* buffer, UInt32 n)
+{
+	s_toClient.append(static_cast<const char*>(buffer), n);
+}
+
+static UInt32
+clientRead(void* buffer, UInt32 n)
+{
+	return take(s_toClient, buffer, n);
+}
+
+static void
+clientWrite(const void* buffer, UInt32 n)
+{
+	s_toServer.append(static_cast<const char*>(buffer), n);
+}
+
+static void
+setupStreams(CMockStream& server, CMockStream& client)
+{
+	s_toClient.clear();
+	s_toServer.clear();
+	EXPECT_CALL(server, getEventTarget()).Times(AnyNumber());
+	EXPECT_CALL(client, getEventTarget()).Times(AnyNumber());
+	ON_CALL(server, read(_, _)).WillByDefault(Invoke(serverRead));
+	ON_CALL(server, write(_, _)).WillByDefault(Invoke(serverWrite));
+	ON_CALL(client, read(_, _)).WillByDefault(Invoke(clientRead));
+	ON_CALL(client, write(_, _)).WillByDefault(Invoke(clientWrite));
+}
+
+// deliver whatever is waiting for the filter
+static void
+receive(CCryptoStream& filter)
+{
+	filter.filterEvent(CEvent(filter.getInputReadyEvent(), NULL));
+}
+
+TEST(CCryptoStreamTests, read_afterHandshake_decryptsWrite)
+{
+	CEventQueue eventQueue;
+	CMockStream serverStream(eventQueue);
+	CMockStream clientStream(eventQueue);
+	setupStreams(serverStream, clientStream);
+	CCryptoStream server(&serverStream, "password", true, false);
+	CCryptoStream client(&clientStream, "password", false, false);
+
+	receive(client);
+	receive(server);
+	client.write("hello", 5);
+	client.flush();
+	EXPECT_EQ(CString::npos, s_toServer.find("hello"));
+	receive(server);
+
+	char buffer[16];
+	ASSERT_TRUE(server.isReady());
+	EXPECT_EQ(5, server.read(buffer, sizeof(buffer)));
+	EXPECT_EQ("hello", CString(buffer, 5));
+	EXPECT_FALSE(server.isReady());
+}
+
+TEST(CCryptoStreamTests, write_beforeHandshake_sentWhenKeysAgreed)
+{
+	CEventQueue eventQueue;
+	CMockStream serverStream(eventQueue);
+	CMockStream clientStream(eventQueue);
+	setupStreams(serverStream, clientStream);
+	CCryptoStream server(&serverStream, "password", true, false);
+	CCryptoStream client(&clientStream, "password", false, false);
+
+	server.write("early", 5);
+	receive(client);
+	receive(server);
+	receive(client);
+
+	char buffer[16];
+	EXPECT_EQ(5, client.read(buffer, sizeof(buffer)));
+	EXPECT_EQ("early", CString(buffer, 5));
+}
+
+TEST(CCryptoStreamTests, write_severalTimes_oneRecordOnFlushEvent)
+{
+	CEventQueue eventQueue;
+	CMockStream serverStream(eventQueue);
+	CMockStream clientStream(eventQueue);
+	setupStreams(serverStream, clientStream);
+	CCryptoStream server(&serverStream, "password", true, false);
+	CCryptoStream client(&clientStream, "password", false, false);
+	receive(client);
+	receive(server);
+
+	client.write("DMMV", 4);
+	client.write("DMMV", 4);
+	client.write("DMMV", 4);
+	EXPECT_TRUE(s_toServer.empty());
+
+	CEvent event;
+	ASSERT_TRUE(eventQueue.getEvent(event, 0.0));
+	eventQueue.dispatchEvent(event);
+	EXPECT_EQ(4 + 12 + CCryptoStream::kTagSize, s_toServer.size());
+
+	receive(server);
+	EXPECT_EQ(12, server.getSize());
+}
+
+TEST(CCryptoStreamTests, read_differentPasswords_inputShutdown)
+{
+	CEventQueue eventQueue;
+	CMockStream serverStream(eventQueue);
+	CMockStream clientStream(eventQueue);
+	setupStreams(serverStream, clientStream);
+	CCryptoStream server(&serverStream, "one", true, false);
+	CCryptoStream client(&clientStream, "two", false, false);
+
+	receive(client);
+	receive(server);
+	client.write("hello", 5);
+	client.flush();
+	receive(server);
+
+	EXPECT_FALSE(server.isReady());
+	bool shutdown = false;
+	CEvent event;
+	while (eventQueue.getEvent(event, 0.0)) {
+		if (event.getType() == server.getInputShutdownEvent()) {
+			shutdown = true;
+		}
+	}
+	EXPECT_TRUE(shutdown);
+}
+
+TEST(CCryptoStreamTests, write_samePassword_differentKeysEachConnection)
+{
+	CEventQueue eventQueue;
+	CString records[2];
+	for (int i = 0; i < 2; ++i) {
+		CMockStream serverStream(eventQueue);
+		CMockStream clientStream(eventQueue);
+		setupStreams(serverStream, clientStream);
+		CCryptoStream server(&serverStream, "password", true, false);
+		CCryptoStream client(&clientStream, "password", false, false);
+		receive(client);
+		receive(server);
+
+		client.write("hello", 5);
+		client.flush();
+		records[i] = s_toServer;
+	}
+
+	ASSERT_EQ(records[0].size(), records[1].size());
+	EXPECT_NE(records[0], records[1]);
+}
+
+TEST(CCryptoStreamTests, read_invalidPublicKey_inputShutdown)
+{
+	CEventQueue eventQueue;
+	CMockStream serverStream(eventQueue);
+	CMockStream clientStream(eventQueue);
+	setupStreams(serverStream, clientStream);
+	CCryptoStream server(&serverStream, "password", true, false);
+
+	// an uncompressed point that isn't on the curve
+	s_toServer = "SGC2";
+	s_toServer.append(1, '\x04');
+	s_toServer.append(64, '\x01');
+	receive(server);
+
+	bool shutdown = false;
+	CEvent event;
+	while (eventQueue.getEvent(event, 0.0)) {
+		if (event.getType() == server.getInputShutdownEvent()) {
+			shutdown = true;
+		}
+	}
+	EXPECT_TRUE(shutdown);
+}
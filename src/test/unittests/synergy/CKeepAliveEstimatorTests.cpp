@@ -0,0 +1,77 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CKeepAliveEstimator.h"
+#include "ProtocolTypes.h"
+
+TEST(CKeepAliveEstimatorTests, getTimeout_noSamples_fixedKeepAlives)
+{
+	CKeepAliveEstimator estimator;
+
+	EXPECT_FALSE(estimator.hasSamples());
+	EXPECT_DOUBLE_EQ(3.0 * kKeepAlivesUntilDeath, estimator.getTimeout(3.0));
+	EXPECT_DOUBLE_EQ(-1.0, estimator.getTimeout(-1.0));
+}
+
+TEST(CKeepAliveEstimatorTests, getTimeout_fastPeer_minSlack)
+{
+	CKeepAliveEstimator estimator;
+	for (int i = 0; i < 10; ++i) {
+		estimator.addSample(0.001);
+	}
+
+	EXPECT_NEAR(0.001, estimator.getSmoothed(), 1.0e-9);
+	EXPECT_DOUBLE_EQ(3.0 + kKeepAliveMinSlack, estimator.getTimeout(3.0));
+	EXPECT_LT(estimator.getTimeout(3.0), 3.0 * kKeepAlivesUntilDeath);
+}
+
+TEST(CKeepAliveEstimatorTests, getTimeout_jitteryPeer_fourVariations)
+{
+	CKeepAliveEstimator estimator;
+	for (int i = 0; i < 50; ++i) {
+		estimator.addSample((i & 1) != 0 ? 0.5 : 1.5);
+	}
+
+	double expected = 3.0 + estimator.getSmoothed() +
+						4.0 * estimator.getVariation();
+	EXPECT_GT(expected, 3.0 + kKeepAliveMinSlack);
+	EXPECT_DOUBLE_EQ(expected, estimator.getTimeout(3.0));
+}
+
+TEST(CKeepAliveEstimatorTests, getTimeout_slowJitteryPeer_waitsLonger)
+{
+	CKeepAliveEstimator estimator;
+	for (int i = 0; i < 50; ++i) {
+		estimator.addSample((i & 1) != 0 ? 2.0 : 6.0);
+	}
+
+	EXPECT_NEAR(4.0, estimator.getSmoothed(), 0.4);
+	EXPECT_NEAR(2.0, estimator.getVariation(), 0.4);
+	EXPECT_GT(estimator.getTimeout(3.0), 3.0 * kKeepAlivesUntilDeath);
+}
+
+TEST(CKeepAliveEstimatorTests, reset_afterSamples_fixedKeepAlives)
+{
+	CKeepAliveEstimator estimator;
+	estimator.addSample(0.2);
+	estimator.reset();
+
+	EXPECT_FALSE(estimator.hasSamples());
+	EXPECT_DOUBLE_EQ(0.0, estimator.getSmoothed());
+	EXPECT_DOUBLE_EQ(3.0 * kKeepAlivesUntilDeath, estimator.getTimeout(3.0));
+}
@@ -0,0 +1,152 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CMotionScheduler.h"
+
+TEST(CMotionSchedulerTests, setRate_nonPositive_disabled)
+{
+	CMotionScheduler scheduler;
+	EXPECT_FALSE(scheduler.isEnabled());
+
+	scheduler.setRate(60.0);
+	EXPECT_TRUE(scheduler.isEnabled());
+
+	scheduler.move(1, 2);
+	scheduler.setRate(0.0);
+	EXPECT_FALSE(scheduler.isEnabled());
+	EXPECT_FALSE(scheduler.hasPending());
+}
+
+TEST(CMotionSchedulerTests, next_idle_dueImmediately)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	CMotionScheduler::CMotion motion;
+
+	EXPECT_DOUBLE_EQ(-1.0, scheduler.getDelay(5.0));
+	EXPECT_FALSE(scheduler.next(5.0, motion));
+
+	scheduler.move(10, 20);
+	EXPECT_DOUBLE_EQ(0.0, scheduler.getDelay(5.0));
+	ASSERT_TRUE(scheduler.next(5.0, motion));
+	EXPECT_TRUE(motion.m_absolute);
+	EXPECT_EQ(10, motion.m_x);
+	EXPECT_EQ(20, motion.m_y);
+	EXPECT_FALSE(scheduler.hasPending());
+
+	// a frame later it's due right away again
+	scheduler.move(11, 21);
+	EXPECT_DOUBLE_EQ(0.0, scheduler.getDelay(5.5));
+	EXPECT_TRUE(scheduler.next(5.5, motion));
+}
+
+TEST(CMotionSchedulerTests, next_withinFrame_mergedAtNextFrame)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	CMotionScheduler::CMotion motion;
+	scheduler.move(0, 0);
+	ASSERT_TRUE(scheduler.next(1.0, motion));
+
+	scheduler.move(1, 1);
+	scheduler.move(2, 2);
+	scheduler.move(3, 3);
+
+	EXPECT_NEAR(0.006, scheduler.getDelay(1.004), 1.0e-9);
+	EXPECT_FALSE(scheduler.next(1.004, motion));
+	ASSERT_TRUE(scheduler.next(1.011, motion));
+	EXPECT_EQ(3, motion.m_x);
+	EXPECT_EQ(3, motion.m_y);
+	EXPECT_FALSE(scheduler.hasPending());
+}
+
+TEST(CMotionSchedulerTests, next_relative_summed)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	CMotionScheduler::CMotion motion;
+	scheduler.move(0, 0);
+	ASSERT_TRUE(scheduler.next(1.0, motion));
+
+	scheduler.moveRelative(1, -2);
+	scheduler.moveRelative(3, 4);
+
+	ASSERT_TRUE(scheduler.next(1.02, motion));
+	EXPECT_FALSE(motion.m_absolute);
+	EXPECT_EQ(4, motion.m_x);
+	EXPECT_EQ(2, motion.m_y);
+}
+
+TEST(CMotionSchedulerTests, next_mixed_absoluteWins)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	CMotionScheduler::CMotion motion;
+	scheduler.move(0, 0);
+	ASSERT_TRUE(scheduler.next(1.0, motion));
+
+	scheduler.moveRelative(5, 5);
+	scheduler.move(100, 100);
+	scheduler.moveRelative(1, 2);
+
+	ASSERT_TRUE(scheduler.next(1.02, motion));
+	EXPECT_TRUE(motion.m_absolute);
+	EXPECT_EQ(101, motion.m_x);
+	EXPECT_EQ(102, motion.m_y);
+}
+
+TEST(CMotionSchedulerTests, next_interpolateBurst_spreadOverFrames)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	scheduler.setInterpolate(true);
+	CMotionScheduler::CMotion motion;
+	scheduler.move(0, 0);
+	ASSERT_TRUE(scheduler.next(1.0, motion));
+
+	for (SInt32 i = 1; i <= 4; ++i) {
+		scheduler.move(i, 0);
+	}
+
+	ASSERT_TRUE(scheduler.next(1.01, motion));
+	EXPECT_EQ(2, motion.m_x);
+	EXPECT_GT(scheduler.getDelay(1.01), 0.0);
+	ASSERT_TRUE(scheduler.next(1.02, motion));
+	EXPECT_EQ(3, motion.m_x);
+	ASSERT_TRUE(scheduler.next(1.03, motion));
+	EXPECT_EQ(4, motion.m_x);
+	EXPECT_FALSE(scheduler.hasPending());
+}
+
+TEST(CMotionSchedulerTests, flush_notDue_takesLatest)
+{
+	CMotionScheduler scheduler;
+	scheduler.setRate(100.0);
+	scheduler.setInterpolate(true);
+	CMotionScheduler::CMotion motion;
+	scheduler.move(0, 0);
+	ASSERT_TRUE(scheduler.next(1.0, motion));
+
+	scheduler.move(1, 1);
+	scheduler.move(2, 2);
+
+	ASSERT_TRUE(scheduler.flush(1.001, motion));
+	EXPECT_EQ(2, motion.m_x);
+	EXPECT_FALSE(scheduler.hasPending());
+	EXPECT_FALSE(scheduler.flush(1.002, motion));
+}
@@ -0,0 +1,170 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "CPNGDecoder.h"
+#include "CClipboard.h"
+
+// 2x2 RGB, rows filtered with sub and up
+static const char s_rgb[] =
+	"\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52"
+	"\x00\x00\x00\x02\x00\x00\x00\x02\x08\x02\x00\x00\x00\xfd\xd4\x9a"
+	"\x73\x00\x00\x00\x16\x49\x44\x41\x54\x78\x9c\x63\xfc\xcf\xc0\xc0"
+	"\xf8\x9f\x81\x89\x91\xe1\xff\x7f\x86\xff\x00\x1e\x1c\x05\x01\x3b"
+	"\x46\x0b\x07\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82";
+// 3x3 2 bit palette, Adam7 interlaced, palette entry 2 is transparent
+static const char s_palette[] =
+	"\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52"
+	"\x00\x00\x00\x03\x00\x00\x00\x03\x02\x03\x00\x00\x01\x5c\x41\x6d"
+	"\xba\x00\x00\x00\x0c\x50\x4c\x54\x45\x00\x00\x00\xff\x00\x00\x00"
+	"\xff\x00\x00\x00\xff\x9b\xc0\x13\xdc\x00\x00\x00\x03\x74\x52\x4e"
+	"\x53\xff\xff\x00\xd7\xca\x0d\x41\x00\x00\x00\x12\x49\x44\x41\x54"
+	"\x78\x9c\x63\x60\x60\x68\x00\x42\x07\x86\x03\x0c\x47\x00\x0c\x50"
+	"\x02\xc5\x7c\x58\x72\x55\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42"
+	"\x60\x82";
+
+// 2^26 x 1 16 bit RGBA, the row size in bits overflows 32 bits
+static const char s_wide[] =
+	"\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52"
+	"\x04\x00\x00\x00\x00\x00\x00\x01\x10\x06\x00\x00\x00\x00\x00\x00"
+	"\x00\x00\x00\x00\x08\x49\x44\x41\x54\x78\x9c\x03\x00\x00\x00\x00"
+	"\x01\x00\x00\x00\x00\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60"
+	"\x82";
+
+static CString
+makePNG(const char* data, size_t size)
+{
+	// size of a string literal includes the nul
+	return CString(data, size - 1);
+}
+
+// returns the BGRA pixel at x,y of a bottom-up 32bpp bitmap
+static CString
+getPixel(const CString& bitmap, UInt32 width, UInt32 height,
+				UInt32 x, UInt32 y)
+{
+	return bitmap.substr(40 + 4 * ((height - 1 - y) * width + x), 4);
+}
+
+TEST(CPNGDecoderTests, toBitmap_rgb_headerValid)
+{
+	CString bitmap;
+
+	bool actual = CPNGDecoder::toBitmap(makePNG(s_rgb, sizeof(s_rgb)), bitmap);
+
+	EXPECT_TRUE(actual);
+	ASSERT_EQ(40U + 2 * 2 * 4, bitmap.size());
+	EXPECT_EQ(40, (int)bitmap[0]);
+	EXPECT_EQ(2, (int)bitmap[4]);
+	EXPECT_EQ(2, (int)bitmap[8]);
+	EXPECT_EQ(32, (int)bitmap[14]);
+}
+
+TEST(CPNGDecoderTests, toBitmap_rgb_pixelsUnfiltered)
+{
+	CString bitmap;
+
+	CPNGDecoder::toBitmap(makePNG(s_rgb, sizeof(s_rgb)), bitmap);
+
+	EXPECT_EQ(CString("\x00\x00\xff\xff", 4), getPixel(bitmap, 2, 2, 0, 0));
+	EXPECT_EQ(CString("\x00\xff\x00\xff", 4), getPixel(bitmap, 2, 2, 1, 0));
+	EXPECT_EQ(CString("\xff\x00\x00\xff", 4), getPixel(bitmap, 2, 2, 0, 1));
+	EXPECT_EQ(CString("\xff\xff\xff\xff", 4), getPixel(bitmap, 2, 2, 1, 1));
+}
+
+TEST(CPNGDecoderTests, toBitmap_interlacedPalette_pixelsValid)
+{
+	CString bitmap;
+
+	bool actual = CPNGDecoder::toBitmap(
+							makePNG(s_palette, sizeof(s_palette)), bitmap);
+
+	EXPECT_TRUE(actual);
+	ASSERT_EQ(40U + 3 * 3 * 4, bitmap.size());
+	EXPECT_EQ(CString("\x00\x00\x00\xff", 4), getPixel(bitmap, 3, 3, 0, 0));
+	EXPECT_EQ(CString("\x00\x00\xff\xff", 4), getPixel(bitmap, 3, 3, 1, 0));
+	EXPECT_EQ(CString("\x00\xff\x00\x00", 4), getPixel(bitmap, 3, 3, 2, 0));
+	EXPECT_EQ(CString("\xff\x00\x00\xff", 4), getPixel(bitmap, 3, 3, 0, 1));
+	EXPECT_EQ(CString("\x00\x00\x00\xff", 4), getPixel(bitmap, 3, 3, 2, 2));
+}
+
+TEST(CPNGDecoderTests, toBitmap_badSignature_returnsFalse)
+{
+	CString png = makePNG(s_rgb, sizeof(s_rgb));
+	png[1] = 'Q';
+	CString bitmap;
+
+	EXPECT_FALSE(CPNGDecoder::toBitmap(png, bitmap));
+}
+
+TEST(CPNGDecoderTests, toBitmap_truncated_returnsFalse)
+{
+	CString png = makePNG(s_rgb, sizeof(s_rgb));
+	png.resize(png.size() - 20);
+	CString bitmap;
+
+	EXPECT_FALSE(CPNGDecoder::toBitmap(png, bitmap));
+}
+
+TEST(CPNGDecoderTests, toBitmap_rowSizeOverflows_returnsFalse)
+{
+	CString bitmap;
+
+	bool actual = CPNGDecoder::toBitmap(
+							makePNG(s_wide, sizeof(s_wide)), bitmap);
+
+	EXPECT_FALSE(actual);
+	EXPECT_TRUE(bitmap.empty());
+}
+
+TEST(CPNGDecoderTests, addBitmap_pngOnly_addsBitmap)
+{
+	CClipboard clipboard;
+	clipboard.open(0);
+	clipboard.add(IClipboard::kPNG, makePNG(s_rgb, sizeof(s_rgb)));
+
+	bool actual = CPNGDecoder::addBitmap(&clipboard);
+
+	EXPECT_TRUE(actual);
+	EXPECT_TRUE(clipboard.has(IClipboard::kBitmap));
+	EXPECT_TRUE(clipboard.has(IClipboard::kPNG));
+}
+
+TEST(CPNGDecoderTests, addBitmap_hasBitmap_returnsFalse)
+{
+	CClipboard clipboard;
+	clipboard.open(0);
+	clipboard.add(IClipboard::kPNG, makePNG(s_rgb, sizeof(s_rgb)));
+	clipboard.add(IClipboard::kBitmap, "bitmap");
+
+	bool actual = CPNGDecoder::addBitmap(&clipboard);
+
+	EXPECT_FALSE(actual);
+	EXPECT_EQ("bitmap", clipboard.get(IClipboard::kBitmap));
+}
+
+TEST(CPNGDecoderTests, toBitmap_samePNGBlob_sharesBitmap)
+{
+	CClipboardBlob png(makePNG(s_rgb, sizeof(s_rgb)));
+	CClipboardBlob first, second;
+
+	EXPECT_TRUE(CPNGDecoder::toBitmap(png, first));
+	EXPECT_TRUE(CPNGDecoder::toBitmap(CClipboardBlob(png), second));
+
+	EXPECT_TRUE(second.shares(first));
+	EXPECT_EQ(first, second);
+}
@@ -0,0 +1,197 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#define TEST_ENV
+#include "Global.h"
+
+#include "CPacketStreamFilter.h"
+#include "CProtocolUtil.h"
+#include "ProtocolTypes.h"
+#include "CMockStream.h"
+#include "CEventQueue.h"
+#include "CString.h"
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::AnyNumber;
+
+static CString			s_upstream;
+static CString			s_downstream;
+static int				s_writes = 0;
+static const void*		s_lastWrite = NULL;
+
+static UInt32
+readUpstream(void* buffer, UInt32 n)
+{
+	if (n > s_upstream.size()) {
+		n = static_cast<UInt32>(s_upstream.size());
+	}
+	memcpy(buffer, s_upstream.data(), n);
+	s_upstream.erase(0, n);
+	return n;
+}
+
+static void
+writeDownstream(const void* buffer, UInt32 n)
+{
+	s_downstream.append(static_cast<const char*>(buffer), n);
+	s_lastWrite = buffer;
+	++s_writes;
+}
+
+// feed the upstream data to the filter as if it had just arrived
+static void
+receive(CPacketStreamFilter& filter, const CString& data)
+{
+	s_upstream = data;
+	filter.filterEvent(CEvent(filter.getInputReadyEvent(), NULL));
+}
+
+static CString
+packet(const CString& payload)
+{
+	UInt32 n = static_cast<UInt32>(payload.size());
+	CString data;
+	data += static_cast<char>((n >> 24) & 0xff);
+	data += static_cast<char>((n >> 16) & 0xff);
+	data += static_cast<char>((n >>  8) & 0xff);
+	data += static_cast<char>( n        & 0xff);
+	return data + payload;
+}
+
+TEST(CPacketStreamFilterTests, write_payload_lengthAndPayloadInOneWrite)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, write(_, _)).WillByDefault(Invoke(writeDownstream));
+	CPacketStreamFilter filter(&stream, false);
+	s_downstream.clear();
+	s_writes = 0;
+
+	filter.write("DMMV\x00\x0a\x00\x14", 8);
+
+	EXPECT_EQ(1, s_writes);
+	EXPECT_EQ(packet(CString("DMMV\x00\x0a\x00\x14", 8)), s_downstream);
+}
+
+TEST(CPacketStreamFilterTests, write_largePayload_payloadWrittenUncopied)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, write(_, _)).WillByDefault(Invoke(writeDownstream));
+	CPacketStreamFilter filter(&stream, false);
+	s_downstream.clear();
+	s_writes = 0;
+	CString payload(1000, 'x');
+
+	filter.write(payload.data(), static_cast<UInt32>(payload.size()));
+
+	EXPECT_EQ(2, s_writes);
+	EXPECT_EQ(payload.data(), s_lastWrite);
+	EXPECT_EQ(packet(payload), s_downstream);
+}
+
+TEST(CPacketStreamFilterTests, borrowPacket_twoPackets_lentInOrder)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readUpstream));
+	CPacketStreamFilter filter(&stream, false);
+
+	receive(filter, packet("first") + packet("second"));
+
+	UInt32 size;
+	const char* data = static_cast<const char*>(filter.borrowPacket(size));
+	ASSERT_TRUE(data != NULL);
+	EXPECT_EQ("first", CString(data, size));
+	EXPECT_TRUE(filter.isReady());
+
+	data = static_cast<const char*>(filter.borrowPacket(size));
+	ASSERT_TRUE(data != NULL);
+	EXPECT_EQ("second", CString(data, size));
+	EXPECT_FALSE(filter.isReady());
+
+	EXPECT_TRUE(filter.borrowPacket(size) == NULL);
+}
+
+TEST(CPacketStreamFilterTests, borrowPacket_partialPacket_returnsNull)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readUpstream));
+	CPacketStreamFilter filter(&stream, false);
+	CString data = packet("message");
+
+	receive(filter, data.substr(0, 6));
+	UInt32 size;
+	EXPECT_TRUE(filter.borrowPacket(size) == NULL);
+
+	receive(filter, data.substr(6));
+	EXPECT_TRUE(filter.borrowPacket(size) != NULL);
+	EXPECT_EQ(7, size);
+}
+
+TEST(CPacketStreamFilterTests, releasePacket_thenRead_readsNextPacket)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readUpstream));
+	CPacketStreamFilter filter(&stream, false);
+
+	receive(filter, packet("first") + packet("second"));
+
+	UInt32 size;
+	filter.borrowPacket(size);
+	filter.releasePacket();
+
+	char buffer[16];
+	UInt32 n = filter.read(buffer, sizeof(buffer));
+	EXPECT_EQ("second", CString(buffer, n));
+	EXPECT_EQ(0, filter.read(buffer, sizeof(buffer)));
+}
+
+TEST(CPacketStreamFilterTests, readf_borrowedMouseMove_parsedInPlace)
+{
+	CEventQueue eventQueue;
+	CMockStream stream(eventQueue);
+	EXPECT_CALL(stream, getEventTarget()).Times(AnyNumber());
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readUpstream));
+	CPacketStreamFilter filter(&stream, false);
+
+	receive(filter, packet(CString("DMMV\x00\x0a\xff\xec", 8)));
+
+	UInt32 size;
+	const UInt8* data = static_cast<const UInt8*>(filter.borrowPacket(size));
+	ASSERT_TRUE(data != NULL);
+	SInt16 x, y;
+	EXPECT_TRUE(CProtocolUtil::readf(data, size, kMsgDMouseMove, &x, &y));
+	EXPECT_EQ(10, x);
+	EXPECT_EQ(-20, y);
+	EXPECT_EQ(0, size);
+
+	// reading past the end of the packet fails
+	EXPECT_FALSE(CProtocolUtil::readf(data, size, "%2i", &x));
+}